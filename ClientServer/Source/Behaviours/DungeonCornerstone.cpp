@@ -46,7 +46,7 @@ void DungeonCornerstone::Update(Scene* Scene, double DeltaTime)
 
 }
 
-void DungeonCornerstone::AddBlock(AABB block, Material mat)
+void DungeonCornerstone::AddBlock(AABB block, MaterialHandle mat)
 {
     GraphicsModule* Graphics = GraphicsModule::Get();
 
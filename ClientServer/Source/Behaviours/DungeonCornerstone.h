@@ -11,13 +11,13 @@ public:
 
 private:
 
-    void AddBlock(AABB block, Material mat);
+    void AddBlock(AABB block, MaterialHandle mat);
     void AddHallway(AABB hallway, bool xDirection);
 
     Scene* ContainingScene = nullptr;
 
-    Material GroundMat;
-    Material CeilingMat;
+    MaterialHandle GroundMat;
+    MaterialHandle CeilingMat;
     AABB CornerstoneAABB;
 
     float FloorHeight;
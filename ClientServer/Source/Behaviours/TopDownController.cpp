@@ -100,5 +100,9 @@ void TopDownController::Update(Scene* Scene, double DeltaTime)
     Scene->GetCamera()->SetPosition(m_Model->GetTransform().GetPosition() + Vec3f(0.0f, -5.0f, 7.5f));
     Scene->GetCamera()->SetDirection(Math::normalize(m_Model->GetTransform().GetPosition() - Scene->GetCamera()->GetPosition()));
 
-    UI->TextButton("Yesyseysey", Vec2f(40.0f, 40.0f), 12.f);
+    // Dedicated servers run behaviours without a UI
+    if (UI)
+    {
+        UI->TextButton("Yesyseysey", Vec2f(40.0f, 40.0f), 12.f);
+    }
 }
@@ -5,6 +5,21 @@
 
 REGISTER_BEHAVIOUR(TopDownPlayer);
 
+void TopDownPlayer::Initialize(Scene* Scene)
+{
+    GraphicsModule& Graphics = *GraphicsModule::Get();
+    CollisionModule& Collisions = *CollisionModule::Get();
+    AssetRegistry* Registry = AssetRegistry::Get();
+
+    // Loaded here rather than in Update, which can run on the scene pipeline's worker thread
+    GhostModelPrototype = Graphics.CreateModel(TexturedMesh(*Registry->LoadStaticMesh("models/Ghost.obj"), Graphics.CreateMaterial(*Registry->LoadTexture("textures/Ghost.png"))));
+    BulletModelPrototype = Graphics.CreateModel(TexturedMesh(*Registry->LoadStaticMesh("models/Buckyball.obj"), Graphics.CreateMaterial(*Registry->LoadTexture("textures/transpink.png"))));
+
+    // Ghosts and bullets get ray cast against, make sure their collision mesh isn't generated mid update
+    Collisions.GetCollisionMeshFromMesh(GhostModelPrototype.m_TexturedMeshes[0].m_Mesh);
+    Collisions.GetCollisionMeshFromMesh(BulletModelPrototype.m_TexturedMeshes[0].m_Mesh);
+}
+
 void TopDownPlayer::Update(Scene* Scene, double DeltaTime)
 {
     if (Health <= 0)
@@ -22,15 +37,6 @@ void TopDownPlayer::Update(Scene* Scene, double DeltaTime)
     //std::string TimeAliveString = "Time Alive: " + std::to_string(TimeAlive);
     //UI.Text(TimeAliveString, Vec2f(0.0f, 50.0f));
     //UI.TextButton(TimeAliveString, Rect(Vec2f(50.0f, 50.0f), Vec2f(100.0f, 100.0f)), 2.0f);
-    if (!Started)
-    {
-        AssetRegistry* Registry = AssetRegistry::Get();
-        GhostModelPrototype = Graphics.CreateModel(TexturedMesh(*Registry->LoadStaticMesh("models/Ghost.obj"), Graphics.CreateMaterial(*Registry->LoadTexture("textures/Ghost.png"))));
-        BulletModelPrototype = Graphics.CreateModel(TexturedMesh(*Registry->LoadStaticMesh("models/Buckyball.obj"), Graphics.CreateMaterial(*Registry->LoadTexture("textures/transpink.png"))));
-
-        Started = true;
-    }
-
     GhostSpawnTimer -= DeltaTime;
 
     while (GhostSpawnTimer <= 0.0f)
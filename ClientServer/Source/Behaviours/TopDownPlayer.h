@@ -7,6 +7,7 @@ public:
 
     DEFINE_BEHAVIOUR(TopDownPlayer);
 
+    void Initialize(Scene* Scene) override;
     void Update(Scene* Scene, double DeltaTime) override;
 
     void Hurt();
@@ -24,8 +25,6 @@ private:
 
     float Speed = 10.0f;
 
-    bool Started = false;
-
     const double GhostSpawnPeriod = 0.05f;
     double GhostSpawnTimer = GhostSpawnPeriod;
 
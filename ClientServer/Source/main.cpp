@@ -17,9 +17,30 @@ void Initialize(ArgsList args)
     //Registry->LoadStaticMesh("models/RotationHoop.obj");
 
 
-    if (args == "-server")
+    bool IsServer = false;
+    std::string StartLevel = "";
+
+    std::vector<std::string> Args = StringUtils::Split(args, " ");
+    for (size_t i = 0; i < Args.size(); ++i)
+    {
+        if (Args[i] == "-server")
+        {
+            IsServer = true;
+        }
+        else if (Args[i] == "-level" && i + 1 < Args.size())
+        {
+            StartLevel = Args[++i];
+        }
+    }
+
+#ifdef DEDICATED_SERVER
+    // Nothing else a dedicated server build can be
+    IsServer = true;
+#endif
+
+    if (IsServer)
     {
-        ServerGameState* ServerState = new ServerGameState();
+        ServerGameState* ServerState = new ServerGameState(StartLevel);
         Machine.PushState(ServerState);
     }
     else
@@ -1,6 +1,7 @@
 #include "AssetRegistry.h"
 
 #include "Modules/GraphicsModule.h"
+#include "Profiling/Profiler.h"
 
 AssetRegistry::AssetRegistry(GraphicsModule* InGraphicsModule)
     : m_GraphicsModule(InGraphicsModule)
@@ -39,6 +40,9 @@ Texture* AssetRegistry::LoadTexture(FilePath Path)
     {
         return &it->second;
     }
+
+    PROFILE_SCOPE("Asset::LoadTexture");
+
     m_LoadedTextures[Path.GetFullPath()] = m_GraphicsModule->LoadTexture(Path.GetFullPath());
     return &m_LoadedTextures[Path.GetFullPath()];
 }
@@ -50,6 +54,9 @@ StaticMesh* AssetRegistry::LoadStaticMesh(FilePath Path)
     {
         return &it->second;
     }
+
+    PROFILE_SCOPE("Asset::LoadStaticMesh");
+
     m_LoadedStaticMeshes[Path.GetFullPath()] = m_GraphicsModule->LoadMesh(Path.GetFullPath());
     return &m_LoadedStaticMeshes[Path.GetFullPath()];
 }
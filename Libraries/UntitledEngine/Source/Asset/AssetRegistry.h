@@ -30,11 +30,31 @@ public:
     }
 };
 
+// Full detail plus this many simplified versions at most
+#define MAX_MESH_LODS 4
+
+// A simplified version of a static mesh
+struct StaticMeshLOD
+{
+    StaticMesh_ID Id = 0;
+
+    // Roughly how far its surface is from the full detail mesh's, in the mesh's own units
+    float Error = 0.0f;
+};
+
 class StaticMesh : public Asset
 {
 public:
     StaticMesh_ID Id;
 
+    // Simplified versions of the mesh, each coarser than the last. Id itself is LOD 0 and isn't in here
+    StaticMeshLOD LODs[MAX_MESH_LODS - 1];
+    int LODCount = 0;
+
+    // Bounding sphere in the mesh's own space, for working out how big the mesh is on screen
+    Vec3f BoundsCenter;
+    float BoundsRadius = 0.0f;
+
     friend bool operator<(const StaticMesh& lhs, const StaticMesh& rhs)
     {
         return lhs.Id < rhs.Id;
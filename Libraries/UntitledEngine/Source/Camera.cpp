@@ -75,6 +75,11 @@ void Camera::SetScreenSize(Vec2f screenSize)
     m_ProjectionMatrixNeedsUpdate = true;
 }
 
+Vec2f Camera::GetScreenSize() const
+{
+    return m_ScreenSize;
+}
+
 void Camera::SetNearPlane(float nearPlane)
 {
     m_NearClippingPlane = nearPlane;
@@ -87,6 +92,21 @@ void Camera::SetFarPlane(float farPlane)
     m_ProjectionMatrixNeedsUpdate = true;
 }
 
+float Camera::GetNearPlane() const
+{
+    return m_NearClippingPlane;
+}
+
+float Camera::GetFarPlane() const
+{
+    return m_FarClippingPlane;
+}
+
+Projection Camera::GetProjectionType() const
+{
+    return m_ProjectionType;
+}
+
 Mat4x4f Camera::GetCamMatrix()
 {
     Mat4x4f ProjMatrix = GetProjectionMatrix();
@@ -43,9 +43,14 @@ public:
     float GetFieldOfView() const;
 
     void SetScreenSize(Vec2f screenSize);
+    Vec2f GetScreenSize() const;
     
     void SetNearPlane(float nearPlane);
     void SetFarPlane(float farPlane);
+    float GetNearPlane() const;
+    float GetFarPlane() const;
+
+    Projection GetProjectionType() const;
 
     Mat4x4f GetCamMatrix();
     Mat4x4f GetInvCamMatrix();
@@ -1,117 +1,460 @@
 #include "FileLoader.h"
 
+#include "Profiling/Profiler.h"
+#include "Rendering/MeshOptimizer.h"
 #include "StringUtils.h"
+#include "Utils/Hash.h"
+#include "Utils/Parallel.h"
 
+#include <charconv>
+#include <cstring>
 #include <fstream>
 #include <stack>
+#include <unordered_map>
 
-StaticMesh_ID FileLoader::LoadOBJFile(std::string filePath, Renderer& renderer)
+// OBJ files are split into chunks of at least this many bytes that are parsed on separate threads, smaller files are parsed in one go
+#define OBJ_MIN_CHUNK_SIZE (256 * 1024)
+
+namespace
 {
-    std::ifstream objFile(filePath);
-    std::string line;
+    // The position/uv/normal indices a face corner refers to, corners with the same ones share a vertex.
+    // Indices are 1-based like in the file, 0 means the corner doesn't have one
+    struct OBJCorner
+    {
+        int32_t Position;
+        int32_t UV;
+        int32_t Normal;
 
-    VertexBufferFormat vertFormat({ VertAttribute::Vec3f, VertAttribute::Vec3f, VertAttribute::Vec4f, VertAttribute::Vec2f });
-    std::vector<float> vertices;
-    std::vector<ElementIndex> indices;
+        bool operator==(const OBJCorner& Other) const
+        {
+            return Position == Other.Position && UV == Other.UV && Normal == Other.Normal;
+        }
+    };
+
+    struct OBJCornerHasher
+    {
+        size_t operator()(const OBJCorner& Corner) const
+        {
+            size_t h = Hash::Hash_Value(Corner.Position);
+            h = Hash::Combine(h, Hash::Hash_Value(Corner.UV));
+            return Hash::Combine(h, Hash::Hash_Value(Corner.Normal));
+        }
+    };
+
+    // Which of a corner's indices were written relative to the end of the list (negative in the file)
+    enum OBJRelativeFlags : uint8_t
+    {
+        OBJ_RELATIVE_POSITION = 1,
+        OBJ_RELATIVE_UV = 2,
+        OBJ_RELATIVE_NORMAL = 4,
+    };
+
+    struct OBJChunkCorner
+    {
+        OBJCorner Corner;
+        uint8_t Relative = 0;
+    };
+
+    // Everything read from one chunk of the file. A chunk doesn't know how many positions/uvs/normals came before it,
+    // so relative indices are stored counting from the start of the chunk (possibly <= 0) and resolved when the chunks are merged
+    struct OBJChunk
+    {
+        std::vector<Vec3f> Positions;
+        std::vector<Vec2f> UVs;
+        std::vector<Vec3f> Normals;
+
+        std::vector<OBJChunkCorner> Corners;
+
+        // How many corners each face has, the faces' corners are one after the other in Corners
+        std::vector<uint32_t> FaceSizes;
+
+        size_t InvalidLines = 0;
+    };
+
+    inline const char* SkipSpaces(const char* p, const char* End)
+    {
+        while (p < End && (*p == ' ' || *p == '\t'))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    inline const char* NextLine(const char* p, const char* End)
+    {
+        const char* NewLine = (const char*)memchr(p, '\n', End - p);
+        return NewLine ? NewLine + 1 : End;
+    }
+
+    bool ParseFloat(const char*& p, const char* End, float& Out)
+    {
+        p = SkipSpaces(p, End);
+
+        // from_chars doesn't take a leading +, some exporters write one anyway
+        if (p < End && *p == '+')
+        {
+            ++p;
+        }
+
+        std::from_chars_result Result = std::from_chars(p, End, Out);
+        if (Result.ec == std::errc::result_out_of_range)
+        {
+            // Too big or too small for a float, but Out isn't touched in that case. Going through a double
+            // gives +-inf for overflow and a denormal or +-0 for underflow, anything a double can't hold fails the load
+            double Wide;
+            Result = std::from_chars(p, End, Wide);
+            if (Result.ec != std::errc())
+            {
+                return false;
+            }
+            Out = (float)Wide;
+        }
+        else if (Result.ec != std::errc())
+        {
+            return false;
+        }
 
-    unsigned int index = 0;
+        p = Result.ptr;
+        return true;
+    }
 
-    if (objFile.is_open())
+    // Reads an index and turns a relative one into a 1-based index from the start of the chunk, Count being how many there are so far
+    bool ParseIndex(const char*& p, const char* End, size_t Count, uint8_t RelativeFlag, int32_t& Out, uint8_t& OutRelative)
     {
-        std::vector<Vec3f> vecs;
-        std::vector<Vec2f> uvs;
-        std::vector<Vec3f> norms;
+        std::from_chars_result Result = std::from_chars(p, End, Out);
+        if (Result.ec != std::errc())
+        {
+            return false;
+        }
+        p = Result.ptr;
 
-        while (getline(objFile, line))
+        if (Out < 0)
         {
-            std::vector<std::string> words = StringUtils::Split(line, " ");
+            Out = (int32_t)Count + Out + 1;
+            OutRelative |= RelativeFlag;
+        }
+        return true;
+    }
 
-            // Empty line, go to the next one
-            if (words.size() == 0) continue;
+    // Reads one "v", "v/vt", "v//vn" or "v/vt/vn" face corner
+    bool ParseCorner(const char*& p, const char* End, const OBJChunk& Chunk, OBJChunkCorner& Out)
+    {
+        Out = OBJChunkCorner{ { 0, 0, 0 }, 0 };
 
-            // Lines starting with # are comments
-            if (words[0] == "#") continue;
+        if (!ParseIndex(p, End, Chunk.Positions.size(), OBJ_RELATIVE_POSITION, Out.Corner.Position, Out.Relative))
+        {
+            return false;
+        }
 
-            if (words[0] == "v")
+        if (p < End && *p == '/')
+        {
+            ++p;
+            if (p < End && *p != '/' && !ParseIndex(p, End, Chunk.UVs.size(), OBJ_RELATIVE_UV, Out.Corner.UV, Out.Relative))
             {
-                Vec3f newVec;
-                newVec.x = std::stof(words[1]);
-                newVec.y = std::stof(words[2]);
-                newVec.z = std::stof(words[3]);
-                vecs.push_back(newVec);
+                return false;
             }
 
-            if (words[0] == "vt")
+            if (p < End && *p == '/')
             {
-                Vec2f newUv;
-                newUv.x = std::stof(words[1]);
-                newUv.y = std::stof(words[2]);
-                uvs.push_back(newUv);
+                ++p;
+                if (!ParseIndex(p, End, Chunk.Normals.size(), OBJ_RELATIVE_NORMAL, Out.Corner.Normal, Out.Relative))
+                {
+                    return false;
+                }
             }
+        }
 
-            if (words[0] == "vn")
+        return true;
+    }
+
+    inline bool IsLineEnd(const char* p, const char* End)
+    {
+        return p >= End || *p == '\n' || *p == '\r' || *p == '#';
+    }
+
+    // Parses every line that starts in [Begin, End), the last one can run past End
+    void ParseOBJChunk(const char* Begin, const char* End, const char* FileEnd, OBJChunk& Chunk)
+    {
+        const char* p = Begin;
+        while (p < End)
+        {
+            const char* LineEnd = (const char*)memchr(p, '\n', FileEnd - p);
+            if (!LineEnd)
             {
-                Vec3f newNorm;
-                newNorm.x = std::stof(words[1]);
-                newNorm.y = std::stof(words[2]);
-                newNorm.z = std::stof(words[3]);
-                norms.push_back(newNorm);
+                LineEnd = FileEnd;
             }
 
-            if (words[0] == "f")
+            p = SkipSpaces(p, LineEnd);
+
+            bool Valid = true;
+            if (p + 1 < LineEnd && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                p++;
+                Vec3f Position;
+                Valid = ParseFloat(p, LineEnd, Position.x) && ParseFloat(p, LineEnd, Position.y) && ParseFloat(p, LineEnd, Position.z);
+                Chunk.Positions.push_back(Position);
+            }
+            else if (p + 2 < LineEnd && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+            {
+                p += 2;
+                Vec2f UV;
+                Valid = ParseFloat(p, LineEnd, UV.x) && ParseFloat(p, LineEnd, UV.y);
+                Chunk.UVs.push_back(UV);
+            }
+            else if (p + 2 < LineEnd && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+            {
+                p += 2;
+                Vec3f Normal;
+                Valid = ParseFloat(p, LineEnd, Normal.x) && ParseFloat(p, LineEnd, Normal.y) && ParseFloat(p, LineEnd, Normal.z);
+                Chunk.Normals.push_back(Normal);
+            }
+            else if (p + 1 < LineEnd && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
             {
-                std::vector<std::string> LineWords(words.begin() + 1, words.end());
+                p++;
+                size_t FirstCorner = Chunk.Corners.size();
 
-                if (LineWords.size() > 4)
+                p = SkipSpaces(p, LineEnd);
+                while (Valid && !IsLineEnd(p, LineEnd))
                 {
-                    LineWords = std::vector<std::string>(LineWords.begin(), LineWords.begin() + 4);
+                    OBJChunkCorner Corner;
+                    Valid = ParseCorner(p, LineEnd, Chunk, Corner);
+                    Chunk.Corners.push_back(Corner);
+                    p = SkipSpaces(p, LineEnd);
                 }
 
-                if (LineWords.size() == 4)
+                if (Valid)
+                {
+                    Chunk.FaceSizes.push_back((uint32_t)(Chunk.Corners.size() - FirstCorner));
+                }
+                else
                 {
-                    std::vector<std::string> TempLineWords = {
-                        LineWords[0], LineWords[1], LineWords[2],
-                        LineWords[0], LineWords[2], LineWords[3]
-                    };
-                    LineWords = TempLineWords;
+                    Chunk.Corners.resize(FirstCorner);
                 }
+            }
+            // Anything else (comments, objects, groups, smoothing groups, materials) doesn't matter for a single mesh
+
+            if (!Valid)
+            {
+                Chunk.InvalidLines++;
+            }
+
+            p = LineEnd < FileEnd ? LineEnd + 1 : FileEnd;
+        }
+    }
+
+    // Turns a chunk's index into one counting from the start of the file, or 0 if it's out of range
+    inline int32_t ResolveIndex(int32_t Index, bool Relative, size_t Base, size_t Count)
+    {
+        int64_t Resolved = Relative ? (int64_t)Base + Index : (int64_t)Index;
+        return (Resolved > 0 && Resolved <= (int64_t)Count) ? (int32_t)Resolved : 0;
+    }
+}
+
+StaticMesh_ID FileLoader::LoadOBJFile(std::string filePath, Renderer& renderer)
+{
+    std::vector<float> vertices;
+    std::vector<ElementIndex> indices;
+
+    LoadOBJData(filePath, vertices, indices);
+
+    return renderer.LoadMesh(GetOBJVertexFormat(), vertices, indices);
+}
+
+VertexBufferFormat FileLoader::GetOBJVertexFormat()
+{
+    return VertexBufferFormat({ VertAttribute::Vec3f, VertAttribute::Vec3f, VertAttribute::Vec4f, VertAttribute::Vec2f });
+}
+
+bool FileLoader::LoadOBJData(std::string filePath, std::vector<float>& vertices, std::vector<ElementIndex>& indices, OBJLoadStats* outStats)
+{
+    PROFILE_SCOPE("FileLoader::LoadOBJFile");
+
+    vertices.clear();
+    indices.clear();
+
+    int64_t startTime = Profiler::GetTime();
+
+    Engine::MappedFile file;
+    if (!Engine::MapFile(filePath, file))
+    {
+        return false;
+    }
+
+    // Split the file into roughly even chunks, each one starts at the first line that starts inside it
+    size_t chunkCount = Parallel::GetRangeCount(file.Size, OBJ_MIN_CHUNK_SIZE);
+    std::vector<OBJChunk> chunks(chunkCount);
+
+    const char* fileEnd = file.Data + file.Size;
+    Parallel::ForRanges(file.Size, chunkCount, [&](size_t chunkIndex, size_t begin, size_t end)
+    {
+        PROFILE_SCOPE("FileLoader::ParseOBJChunk");
+
+        const char* chunkBegin = file.Data + begin;
+        const char* chunkEnd = file.Data + end;
+        if (begin > 0 && chunkBegin[-1] != '\n')
+        {
+            chunkBegin = NextLine(chunkBegin, fileEnd);
+        }
+
+        ParseOBJChunk(chunkBegin, chunkEnd, fileEnd, chunks[chunkIndex]);
+    });
+
+    size_t fileSize = file.Size;
+    Engine::UnmapFile(file);
+
+    // Put the chunks back together. Positions/uvs/normals are the chunks' one after the other, so each chunk's
+    // relative indices just need offsetting by however many came before it
+    size_t positionCount = 0, uvCount = 0, normalCount = 0, cornerCount = 0, invalidLines = 0;
+    for (const OBJChunk& chunk : chunks)
+    {
+        positionCount += chunk.Positions.size();
+        uvCount += chunk.UVs.size();
+        normalCount += chunk.Normals.size();
+        cornerCount += chunk.Corners.size();
+        invalidLines += chunk.InvalidLines;
+    }
+
+    std::vector<Vec3f> vecs;
+    std::vector<Vec2f> uvs;
+    std::vector<Vec3f> norms;
+    vecs.reserve(positionCount);
+    uvs.reserve(uvCount);
+    norms.reserve(normalCount);
+    for (const OBJChunk& chunk : chunks)
+    {
+        vecs.insert(vecs.end(), chunk.Positions.begin(), chunk.Positions.end());
+        uvs.insert(uvs.end(), chunk.UVs.begin(), chunk.UVs.end());
+        norms.insert(norms.end(), chunk.Normals.begin(), chunk.Normals.end());
+    }
 
-                for (int i = (int)LineWords.size() - 1; i >= 0; --i)
+    size_t stride = GetOBJVertexFormat().GetVertexStride() / sizeof(float);
+
+    std::unordered_map<OBJCorner, ElementIndex, OBJCornerHasher> cornerVertices;
+    cornerVertices.reserve(positionCount);
+    indices.reserve(cornerCount * 3);
+    vertices.reserve(positionCount * stride);
+
+    size_t triangulatedCorners = 0;
+    size_t skippedFaces = 0;
+
+    std::vector<ElementIndex> faceVertices;
+
+    size_t positionBase = 0, uvBase = 0, normalBase = 0;
+    for (const OBJChunk& chunk : chunks)
+    {
+        const OBJChunkCorner* faceCorners = chunk.Corners.data();
+        for (uint32_t faceSize : chunk.FaceSizes)
+        {
+            const OBJChunkCorner* nextFace = faceCorners + faceSize;
+            if (faceSize < 3)
+            {
+                skippedFaces++;
+                faceCorners = nextFace;
+                continue;
+            }
+
+            faceVertices.clear();
+            bool valid = true;
+            for (const OBJChunkCorner* chunkCorner = faceCorners; chunkCorner != nextFace && valid; ++chunkCorner)
+            {
+                // Missing or broken uvs and normals are left at 0, but a corner without a position can't be drawn
+                OBJCorner corner;
+                corner.Position = ResolveIndex(chunkCorner->Corner.Position, chunkCorner->Relative & OBJ_RELATIVE_POSITION, positionBase, positionCount);
+                corner.UV = ResolveIndex(chunkCorner->Corner.UV, chunkCorner->Relative & OBJ_RELATIVE_UV, uvBase, uvCount);
+                corner.Normal = ResolveIndex(chunkCorner->Corner.Normal, chunkCorner->Relative & OBJ_RELATIVE_NORMAL, normalBase, normalCount);
+
+                if (corner.Position == 0)
                 {
-                    std::vector<std::string> indexes;
-                    indexes = StringUtils::Split(LineWords[i], "/");
+                    valid = false;
+                    break;
+                }
 
+                auto inserted = cornerVertices.emplace(corner, (ElementIndex)cornerVertices.size());
+                if (inserted.second)
+                {
                     Vertex newVert;
-                    newVert.position = vecs[std::stoul(indexes[0]) - 1];
-                    newVert.uv = uvs[std::stoul(indexes[1]) - 1];
-                    if (indexes.size() > 2)
+                    newVert.position = vecs[corner.Position - 1];
+                    if (corner.UV > 0)
+                    {
+                        newVert.uv = uvs[corner.UV - 1];
+                    }
+                    if (corner.Normal > 0)
                     {
-                        newVert.normal = norms[std::stoul(indexes[2]) - 1];
+                        newVert.normal = norms[corner.Normal - 1];
                     }
 
                     newVert.colour = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
 
-                    vertices.insert(vertices.end(), { 
+                    vertices.insert(vertices.end(), {
                         newVert.position.x, newVert.position.y, newVert.position.z,
                         newVert.normal.x, newVert.normal.y, newVert.normal.z,
                         newVert.colour.x, newVert.colour.y, newVert.colour.z, newVert.colour.w,
                         newVert.uv.x, newVert.uv.y
                     });
+                }
 
-                    // TODO(fraser): here there is no indexed rendering (ie. no exploitation of duplicated vertex data in a mesh)
-                    // Come back to this if there are memory concerns
-                    indices.push_back(index++);
+                faceVertices.push_back(inserted.first->second);
+            }
 
-                }
+            if (!valid)
+            {
+                skippedFaces++;
+                faceCorners = nextFace;
+                continue;
             }
+
+            // Fan out from the first corner. This assumes the face is convex (which is what exporters write),
+            // a concave face will get triangles outside of it
+            // Corners go in backwards, the engine winds front faces the other way to OBJ files
+            for (size_t i = 1; i + 1 < faceVertices.size(); ++i)
+            {
+                indices.insert(indices.end(), { faceVertices[i + 1], faceVertices[i], faceVertices[0] });
+            }
+            triangulatedCorners += (faceVertices.size() - 2) * 3;
+
+            faceCorners = nextFace;
         }
 
+        positionBase += chunk.Positions.size();
+        uvBase += chunk.UVs.size();
+        normalBase += chunk.Normals.size();
     }
-    objFile.close();
 
-    return renderer.LoadMesh(vertFormat, vertices, indices);
-}
+    if (invalidLines > 0 || skippedFaces > 0)
+    {
+        Engine::DEBUGPrint(filePath + ": skipped " + std::to_string(invalidLines) + " malformed lines and " + std::to_string(skippedFaces) + " faces that couldn't be drawn");
+    }
+
+    int64_t parsedTime = Profiler::GetTime();
+
+    size_t vertexCount = vertices.size() / stride;
+    float loadedACMR = 0.0f;
+    float optimizedACMR = 0.0f;
 
+    if (!indices.empty())
+    {
+        loadedACMR = MeshOptimizer::CalculateACMR(indices, vertexCount);
+
+        MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+        MeshOptimizer::OptimizeVertexFetch(vertices, stride, indices);
+
+        optimizedACMR = MeshOptimizer::CalculateACMR(indices, vertexCount);
+    }
+
+    if (outStats)
+    {
+        outStats->FileSize = fileSize;
+        outStats->CornerCount = triangulatedCorners;
+        outStats->VertexCount = vertices.size() / stride;
+        outStats->TriangleCount = indices.size() / 3;
+        outStats->LoadedACMR = loadedACMR;
+        outStats->OptimizedACMR = optimizedACMR;
+        outStats->ParseMilliseconds = (parsedTime - startTime) / 1000000.0;
+        outStats->OptimizeMilliseconds = (Profiler::GetTime() - parsedTime) / 1000000.0;
+    }
+
+    return true;
+}
 
 Token GetTokenFromString(std::string str)
 {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Platform\RendererPlatform.h"
+#include "Platform/RendererPlatform.h"
 
 enum class Token
 {
@@ -17,10 +17,34 @@ enum class ParseState
     Static_Mesh
 };
 
+// What loading an OBJ file found and how long it took
+struct OBJLoadStats
+{
+    size_t FileSize = 0;
+
+    // Triangle corners before corners with the same position/uv/normal were shared, and vertices after
+    size_t CornerCount = 0;
+    size_t VertexCount = 0;
+    size_t TriangleCount = 0;
+
+    // Before and after the triangles were reordered
+    float LoadedACMR = 0.0f;
+    float OptimizedACMR = 0.0f;
+
+    double ParseMilliseconds = 0.0;
+    double OptimizeMilliseconds = 0.0;
+};
+
 class FileLoader
 {
 public:
     static StaticMesh_ID LoadOBJFile(std::string filePath, Renderer& renderer);
+
+    // Reads an OBJ file without uploading it, vertices are laid out as in GetOBJVertexFormat.
+    // The file is memory mapped and big ones are parsed in chunks on several threads. Faces with more than three corners are split into triangles.
+    // Face corners with the same position/uv/normal share a vertex, and the triangles and vertices are reordered to draw faster
+    static bool LoadOBJData(std::string filePath, std::vector<float>& OutVertices, std::vector<ElementIndex>& OutIndices, OBJLoadStats* OutStats = nullptr);
+    static VertexBufferFormat GetOBJVertexFormat();
     //static Scene LoadScene(std::string sceneFilePath, Renderer* renderer);
 
 private:
@@ -1,17 +1,5 @@
 #pragma once
 
-#include <stack>
-
+// Renderer handles are generational slot map handles (see Utils/SlotMap.h), 
+// the slot index is in the low bits and the generation in the high bits
 #define GUID unsigned int
-
-class GUIDGen
-{
-
-public:
-    static GUID Generate();
-    static void FreeID(GUID inID);
-private:
-    static GUID currentGUID;
-
-    static std::stack<GUID> freedGUIDs;
-};
\ No newline at end of file
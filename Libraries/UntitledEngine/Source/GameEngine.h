@@ -10,6 +10,8 @@
 
 #include "Modules/ModuleManager.h"
 
+#include "Profiling/Profiler.h"
+
 #include "Behaviour/Behaviour.h"
 
 #include "Scene.h"
@@ -0,0 +1,1655 @@
+#include "LevelFile.h"
+
+#include "Profiling/Profiler.h"
+#include "Utils/Hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+// Roughly how much of a JSON level there is for each float and index of generated geometry in it, when it's mostly generated meshes
+#define LEVEL_JSON_BYTES_PER_VERTEX_FLOAT 12
+#define LEVEL_JSON_BYTES_PER_INDEX 32
+
+namespace
+{
+    // Vertices of generated meshes are always full Vertex structs (the textured mesh format)
+    const size_t LevelVertexFloats = sizeof(Vertex) / sizeof(float);
+
+    // Sections can be in any order and any of them can be missing (it's just empty then), ones a reader doesn't know about are skipped
+    enum class LevelSectionType : uint32_t
+    {
+        Strings,
+        Materials,
+        Meshes,
+        Models,
+        Behaviours,
+        Brushes,
+        BrushVertices,
+        BrushFaces,
+        BrushFaceIndices,
+        PointLights,
+        Vertices,
+        Indices
+    };
+
+    struct LevelFileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t SectionCount;
+        uint32_t Reserved;
+    };
+
+    // The section table comes straight after the header
+    struct LevelSectionHeader
+    {
+        uint32_t Type;
+        uint32_t Reserved;
+        // From the start of the file
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    // Strings are all stored as offsets into the string section, which is null terminated strings one after the other.
+    // Offset 0 is always the empty string
+    struct LevelMaterialRecord
+    {
+        uint32_t Albedo;
+        uint32_t Normal;
+        uint32_t Roughness;
+        uint32_t Metallic;
+        uint32_t AO;
+    };
+
+    // Meshes without a path are generated, their geometry is in the vertex and index sections
+    struct LevelMeshRecord
+    {
+        uint32_t Path;
+        uint32_t Reserved;
+        uint64_t Hash;
+        uint64_t FirstVertexFloat;
+        uint64_t VertexFloatCount;
+        uint64_t FirstIndex;
+        uint64_t IndexCount;
+    };
+
+    struct LevelModelRecord
+    {
+        float Transform[16];
+        uint32_t Mesh;
+        uint32_t Material;
+        uint32_t Type;
+        uint32_t Visibility;
+        // Range of the behaviours section, which is string offsets
+        uint32_t FirstBehaviour;
+        uint32_t BehaviourCount;
+    };
+
+    struct LevelBrushRecord
+    {
+        uint32_t Material;
+        uint32_t FirstVertex;
+        uint32_t VertexCount;
+        uint32_t FirstFace;
+        uint32_t FaceCount;
+    };
+
+    struct LevelBrushFaceRecord
+    {
+        uint32_t FirstIndex;
+        uint32_t IndexCount;
+    };
+
+    struct LevelPointLightRecord
+    {
+        float Position[3];
+        float Colour[3];
+        float Intensity;
+        float Radius;
+        uint32_t CastsShadows;
+    };
+
+    // These are what's in the files, they can't change size without bumping the version
+    static_assert(sizeof(LevelFileHeader) == 16);
+    static_assert(sizeof(LevelSectionHeader) == 24);
+    static_assert(sizeof(LevelMaterialRecord) == 20);
+    static_assert(sizeof(LevelMeshRecord) == 48);
+    static_assert(sizeof(LevelModelRecord) == 88);
+    static_assert(sizeof(LevelBrushRecord) == 20);
+    static_assert(sizeof(LevelBrushFaceRecord) == 8);
+    static_assert(sizeof(LevelPointLightRecord) == 36);
+    static_assert(sizeof(Mat4x4f) == 16 * sizeof(float));
+    static_assert(sizeof(Vec3f) == 3 * sizeof(float));
+    static_assert(sizeof(ElementIndex) == sizeof(uint32_t));
+
+    class LevelStringTable
+    {
+    public:
+        LevelStringTable()
+        {
+            Add("");
+        }
+
+        // Each different string is only stored once
+        uint32_t Add(const std::string& String)
+        {
+            auto it = m_Offsets.find(String);
+            if (it != m_Offsets.end())
+            {
+                return it->second;
+            }
+
+            uint32_t Offset = (uint32_t)m_Data.size();
+            m_Data.insert(m_Data.end(), String.begin(), String.end());
+            m_Data.push_back('\0');
+
+            m_Offsets.emplace(String, Offset);
+            return Offset;
+        }
+
+        const std::vector<char>& GetData() const
+        {
+            return m_Data;
+        }
+
+    private:
+        std::vector<char> m_Data;
+        std::unordered_map<std::string, uint32_t> m_Offsets;
+    };
+
+    class LevelBinaryWriter
+    {
+    public:
+        template <typename T>
+        void AddSection(LevelSectionType Type, const std::vector<T>& Records)
+        {
+            AddSection(Type, Records.data(), Records.size() * sizeof(T));
+        }
+
+        // Data has to stay alive until Write
+        void AddSection(LevelSectionType Type, const void* Data, size_t Size)
+        {
+            if (Size == 0)
+            {
+                return;
+            }
+
+            LevelSectionHeader Section = {};
+            Section.Type = (uint32_t)Type;
+            Section.Size = Size;
+
+            m_Sections.push_back(Section);
+            m_SectionData.push_back(Data);
+        }
+
+        bool Write(const std::string& FileName)
+        {
+            LevelFileHeader Header = {};
+            Header.Magic = LEVEL_BINARY_MAGIC;
+            Header.Version = LEVEL_BINARY_VERSION;
+            Header.SectionCount = (uint32_t)m_Sections.size();
+
+            uint64_t Offset = sizeof(LevelFileHeader) + m_Sections.size() * sizeof(LevelSectionHeader);
+            for (LevelSectionHeader& Section : m_Sections)
+            {
+                Offset = Align(Offset);
+                Section.Offset = Offset;
+                Offset += Section.Size;
+            }
+
+            std::ofstream File(FileName, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+            if (!File.is_open())
+            {
+                return false;
+            }
+
+            File.write((const char*)&Header, sizeof(Header));
+            File.write((const char*)m_Sections.data(), m_Sections.size() * sizeof(LevelSectionHeader));
+
+            uint64_t Written = sizeof(LevelFileHeader) + m_Sections.size() * sizeof(LevelSectionHeader);
+            for (size_t i = 0; i < m_Sections.size(); ++i)
+            {
+                const char Padding[LEVEL_BINARY_SECTION_ALIGNMENT] = {};
+                File.write(Padding, m_Sections[i].Offset - Written);
+
+                File.write((const char*)m_SectionData[i], m_Sections[i].Size);
+                Written = m_Sections[i].Offset + m_Sections[i].Size;
+            }
+
+            return File.good();
+        }
+
+    private:
+        static uint64_t Align(uint64_t Offset)
+        {
+            return (Offset + LEVEL_BINARY_SECTION_ALIGNMENT - 1) / LEVEL_BINARY_SECTION_ALIGNMENT * LEVEL_BINARY_SECTION_ALIGNMENT;
+        }
+
+        std::vector<LevelSectionHeader> m_Sections;
+        std::vector<const void*> m_SectionData;
+    };
+
+    // Reads sections in place from a mapped file, checking nothing points outside of it
+    class LevelBinaryReader
+    {
+    public:
+        LevelBinaryReader(const char* Data, size_t Size)
+            : m_Data(Data)
+            , m_Size(Size)
+        {
+        }
+
+        bool ReadHeader(std::string& OutError)
+        {
+            if (m_Size < sizeof(LevelFileHeader))
+            {
+                OutError = "too small to be a level";
+                return false;
+            }
+
+            LevelFileHeader Header;
+            memcpy(&Header, m_Data, sizeof(Header));
+
+            if (Header.Magic != LEVEL_BINARY_MAGIC)
+            {
+                OutError = "not a binary level";
+                return false;
+            }
+            if (Header.Version != LEVEL_BINARY_VERSION)
+            {
+                OutError = "saved with format version " + std::to_string(Header.Version) + ", this build reads version " + std::to_string(LEVEL_BINARY_VERSION);
+                return false;
+            }
+            if ((m_Size - sizeof(LevelFileHeader)) / sizeof(LevelSectionHeader) < Header.SectionCount)
+            {
+                OutError = "section table runs past the end of the file";
+                return false;
+            }
+
+            m_Sections = (const LevelSectionHeader*)(m_Data + sizeof(LevelFileHeader));
+            m_SectionCount = Header.SectionCount;
+
+            for (uint32_t i = 0; i < m_SectionCount; ++i)
+            {
+                const LevelSectionHeader& Section = m_Sections[i];
+                if (Section.Offset % LEVEL_BINARY_SECTION_ALIGNMENT != 0 || Section.Offset > m_Size || Section.Size > m_Size - Section.Offset)
+                {
+                    OutError = "section " + std::to_string(i) + " isn't inside the file";
+                    return false;
+                }
+            }
+
+            const char* Strings;
+            if (!GetSection(LevelSectionType::Strings, Strings, m_StringsSize))
+            {
+                OutError = "bad string section";
+                return false;
+            }
+            m_Strings = Strings;
+
+            return true;
+        }
+
+        // Missing sections are just empty
+        template <typename T>
+        bool GetSection(LevelSectionType Type, const T*& OutRecords, size_t& OutCount) const
+        {
+            OutRecords = nullptr;
+            OutCount = 0;
+
+            for (uint32_t i = 0; i < m_SectionCount; ++i)
+            {
+                if (m_Sections[i].Type == (uint32_t)Type)
+                {
+                    if (m_Sections[i].Size % sizeof(T) != 0)
+                    {
+                        return false;
+                    }
+
+                    OutRecords = (const T*)(m_Data + m_Sections[i].Offset);
+                    OutCount = (size_t)(m_Sections[i].Size / sizeof(T));
+                    return true;
+                }
+            }
+
+            return true;
+        }
+
+        bool GetString(uint32_t Offset, std::string& OutString) const
+        {
+            if (Offset >= m_StringsSize)
+            {
+                return false;
+            }
+
+            const char* End = (const char*)memchr(m_Strings + Offset, '\0', m_StringsSize - Offset);
+            if (!End)
+            {
+                return false;
+            }
+
+            OutString.assign(m_Strings + Offset, End);
+            return true;
+        }
+
+    private:
+        const char* m_Data;
+        size_t m_Size;
+
+        const LevelSectionHeader* m_Sections = nullptr;
+        uint32_t m_SectionCount = 0;
+
+        const char* m_Strings = nullptr;
+        size_t m_StringsSize = 0;
+    };
+
+    void SaveJsonTransform(json& JsonObject, const Mat4x4f& TransMat)
+    {
+        const Vec4f* Trans = TransMat.m_Rows;
+        JsonObject = {
+            Trans[0].x, Trans[0].y, Trans[0].z, Trans[0].w,
+            Trans[1].x, Trans[1].y, Trans[1].z, Trans[1].w,
+            Trans[2].x, Trans[2].y, Trans[2].z, Trans[2].w,
+            Trans[3].x, Trans[3].y, Trans[3].z, Trans[3].w,
+        };
+    }
+
+    // Where in a JSON level the parser is, each nested object or array it's inside of has one of these
+    enum class LevelJsonScope
+    {
+        Root,
+        Textures,
+        Texture,
+        StaticMeshes,
+        StaticMesh,
+        GeneratedMeshes,
+        PointLights,
+        PointLight,
+        LightPosition,
+        LightColour,
+        Models,
+        Model,
+        Transform,
+        Behaviours,
+        Buffer,
+        BufferVertices,
+        BufferIndices,
+        Brushes,
+        Brush,
+        BrushVertices,
+        BrushFaces,
+        BrushFace,
+        // Anything the loader doesn't know about, along with everything inside it
+        Skip
+    };
+
+    // How a model in a JSON level says which mesh it uses
+    enum class LevelJsonMeshRef
+    {
+        // MeshID, an index into StaticMeshes
+        Static,
+        // MeshHash, a key in GeneratedMeshes
+        Hashed,
+        // Buffer, older levels wrote generated meshes out in full with every model using them
+        Inline
+    };
+
+    // Fields objects have to have, older levels were saved before the rest existed
+    enum LevelJsonField : unsigned int
+    {
+        FIELD_MATERIAL = 1 << 0,
+        FIELD_MESH = 1 << 1,
+        FIELD_TRANSFORM = 1 << 2,
+        FIELD_VERTICES = 1 << 3,
+        FIELD_POSITION = 1 << 4,
+        FIELD_COLOUR = 1 << 5,
+        FIELD_INTENSITY = 1 << 6,
+
+        MODEL_FIELDS = FIELD_MATERIAL | FIELD_MESH | FIELD_TRANSFORM,
+        BRUSH_FIELDS = FIELD_MATERIAL | FIELD_VERTICES,
+        POINT_LIGHT_FIELDS = FIELD_POSITION | FIELD_COLOUR | FIELD_INTENSITY
+    };
+
+    // Builds a LevelData straight from the parser's events as it goes through the file once. Nothing is kept that isn't part of the
+    // level except where the parser currently is, generated meshes' numbers go straight into the level's geometry (and are taken back
+    // off again if the mesh turns out to be a duplicate).
+    class LevelJsonHandler : public nlohmann::json_sax<json>
+    {
+    public:
+        LevelJsonHandler(LevelData& OutLevel)
+            : m_Level(OutLevel)
+        {
+        }
+
+        // Empty if the file just wasn't valid JSON
+        const std::string& GetError() const
+        {
+            return m_Error;
+        }
+
+        bool null() override
+        {
+            // Empty lists of brushes get saved as null
+            return IsSkipping() || Top().Scope == LevelJsonScope::Root || Unexpected("null");
+        }
+
+        bool boolean(bool Value) override
+        {
+            if (IsSkipping())
+            {
+                return true;
+            }
+
+            if (Top().Scope == LevelJsonScope::PointLight && m_Key == "CastsShadows")
+            {
+                m_Level.PointLights.back().castsShadows = Value;
+                return true;
+            }
+
+            return Unexpected("boolean");
+        }
+
+        bool number_integer(number_integer_t Value) override
+        {
+            return Number((double)Value);
+        }
+
+        bool number_unsigned(number_unsigned_t Value) override
+        {
+            return Number((double)Value);
+        }
+
+        bool number_float(number_float_t Value, const string_t&) override
+        {
+            return Number(Value);
+        }
+
+        bool string(string_t& Value) override
+        {
+            if (IsSkipping())
+            {
+                return true;
+            }
+
+            LevelJsonFrame& Frame = Top();
+            size_t Position = Frame.Count++;
+
+            switch (Frame.Scope)
+            {
+            case LevelJsonScope::Texture:
+            {
+                LevelMaterial& Mat = m_Level.Materials.back();
+                std::string* Textures[] = { &Mat.Albedo, &Mat.Normal, &Mat.Roughness, &Mat.Metallic, &Mat.AO };
+                if (Position < 5)
+                {
+                    *Textures[Position] = std::move(Value);
+                    return true;
+                }
+                return Fail("too many textures in a material");
+            }
+            case LevelJsonScope::StaticMesh:
+                if (Position == 0)
+                {
+                    m_Level.Meshes.back().Path = std::move(Value);
+                }
+                return true;
+            case LevelJsonScope::Behaviours:
+                m_Level.Models.back().Behaviours.push_back(std::move(Value));
+                return true;
+            case LevelJsonScope::Model:
+                if (m_Key == "MeshHash")
+                {
+                    Frame.Found |= FIELD_MESH;
+                    m_MeshRefs.back() = LevelJsonMeshRef::Hashed;
+                    m_MeshKeys.back() = std::move(Value);
+                    return true;
+                }
+                return Unexpected("string");
+            default:
+                return Unexpected("string");
+            }
+        }
+
+        bool binary(binary_t&) override
+        {
+            return IsSkipping() || Unexpected("binary value");
+        }
+
+        bool start_object(std::size_t) override
+        {
+            if (m_Stack.empty())
+            {
+                return Push(LevelJsonScope::Root);
+            }
+
+            if (IsSkipping())
+            {
+                return Push(LevelJsonScope::Skip);
+            }
+
+            Top().Count++;
+
+            switch (Top().Scope)
+            {
+            case LevelJsonScope::Root:
+                if (m_Key == "GeneratedMeshes")
+                {
+                    return Push(LevelJsonScope::GeneratedMeshes);
+                }
+                return Unexpected("object") && Push(LevelJsonScope::Skip);
+            case LevelJsonScope::PointLights:
+                m_Level.PointLights.emplace_back();
+                return Push(LevelJsonScope::PointLight);
+            case LevelJsonScope::Models:
+                m_Level.Models.emplace_back();
+                m_MeshRefs.push_back(LevelJsonMeshRef::Static);
+                m_MeshKeys.emplace_back();
+                return Push(LevelJsonScope::Model);
+            case LevelJsonScope::Brushes:
+                m_Level.Brushes.emplace_back();
+                return Push(LevelJsonScope::Brush);
+            default:
+                return Unexpected("object") && Push(LevelJsonScope::Skip);
+            }
+        }
+
+        bool key(string_t& Value) override
+        {
+            if (!IsSkipping())
+            {
+                m_Key = std::move(Value);
+            }
+            return true;
+        }
+
+        bool end_object() override
+        {
+            LevelJsonFrame Frame = Top();
+            m_Stack.pop_back();
+
+            switch (Frame.Scope)
+            {
+            case LevelJsonScope::Root:
+                return Finish();
+            case LevelJsonScope::PointLight:
+                return (Frame.Found & POINT_LIGHT_FIELDS) == POINT_LIGHT_FIELDS || Fail("point light is missing its position, colour or intensity");
+            case LevelJsonScope::Model:
+                return (Frame.Found & MODEL_FIELDS) == MODEL_FIELDS || Fail("model is missing its material, mesh or transform");
+            case LevelJsonScope::Brush:
+                return (Frame.Found & BRUSH_FIELDS) == BRUSH_FIELDS || Fail("brush is missing its material or vertices");
+            default:
+                return true;
+            }
+        }
+
+        bool start_array(std::size_t) override
+        {
+            if (m_Stack.empty())
+            {
+                return Fail("level isn't an object");
+            }
+
+            if (IsSkipping())
+            {
+                return Push(LevelJsonScope::Skip);
+            }
+
+            LevelJsonFrame& Frame = Top();
+            size_t Position = Frame.Count++;
+
+            switch (Frame.Scope)
+            {
+            case LevelJsonScope::Root:
+                if (m_Key == "Textures")
+                {
+                    return Push(LevelJsonScope::Textures);
+                }
+                if (m_Key == "StaticMeshes")
+                {
+                    return Push(LevelJsonScope::StaticMeshes);
+                }
+                if (m_Key == "PointLights")
+                {
+                    return Push(LevelJsonScope::PointLights);
+                }
+                if (m_Key == "Models")
+                {
+                    return Push(LevelJsonScope::Models);
+                }
+                if (m_Key == "Brushes")
+                {
+                    return Push(LevelJsonScope::Brushes);
+                }
+                return Unexpected("array") && Push(LevelJsonScope::Skip);
+            case LevelJsonScope::Textures:
+                m_Level.Materials.emplace_back();
+                return Push(LevelJsonScope::Texture);
+            case LevelJsonScope::StaticMeshes:
+                m_StaticMeshes.push_back(m_Level.Meshes.size());
+                m_Level.Meshes.emplace_back();
+                return Push(LevelJsonScope::StaticMesh);
+            case LevelJsonScope::GeneratedMeshes:
+                m_MeshKey = m_Key;
+                return StartGeneratedMesh();
+            case LevelJsonScope::PointLight:
+                if (m_Key == "Position")
+                {
+                    Frame.Found |= FIELD_POSITION;
+                    return Push(LevelJsonScope::LightPosition);
+                }
+                if (m_Key == "Colour")
+                {
+                    Frame.Found |= FIELD_COLOUR;
+                    return Push(LevelJsonScope::LightColour);
+                }
+                return Unexpected("array") && Push(LevelJsonScope::Skip);
+            case LevelJsonScope::Model:
+                if (m_Key == "Transform")
+                {
+                    Frame.Found |= FIELD_TRANSFORM;
+                    return Push(LevelJsonScope::Transform);
+                }
+                if (m_Key == "Behaviours")
+                {
+                    return Push(LevelJsonScope::Behaviours);
+                }
+                if (m_Key == "Buffer")
+                {
+                    Frame.Found |= FIELD_MESH;
+                    m_MeshRefs.back() = LevelJsonMeshRef::Inline;
+                    return StartGeneratedMesh();
+                }
+                return Unexpected("array") && Push(LevelJsonScope::Skip);
+            case LevelJsonScope::Buffer:
+                if (Position == 0)
+                {
+                    return Push(LevelJsonScope::BufferVertices);
+                }
+                if (Position == 1)
+                {
+                    return Push(LevelJsonScope::BufferIndices);
+                }
+                return Push(LevelJsonScope::Skip);
+            case LevelJsonScope::Brush:
+                if (m_Key == "Verts")
+                {
+                    Frame.Found |= FIELD_VERTICES;
+                    return Push(LevelJsonScope::BrushVertices);
+                }
+                if (m_Key == "Faces")
+                {
+                    return Push(LevelJsonScope::BrushFaces);
+                }
+                return Unexpected("array") && Push(LevelJsonScope::Skip);
+            case LevelJsonScope::BrushFaces:
+                m_Level.Brushes.back().Faces.emplace_back();
+                return Push(LevelJsonScope::BrushFace);
+            default:
+                return Fail("unexpected array");
+            }
+        }
+
+        bool end_array() override
+        {
+            LevelJsonFrame Frame = Top();
+            m_Stack.pop_back();
+
+            switch (Frame.Scope)
+            {
+            case LevelJsonScope::Texture:
+                return Frame.Count == 5 || Fail("material doesn't have 5 textures");
+            case LevelJsonScope::StaticMesh:
+                return Frame.Count > 0 || Fail("static mesh has no path");
+            case LevelJsonScope::LightPosition:
+            case LevelJsonScope::LightColour:
+                return Frame.Count == 3 || Fail("point light position or colour doesn't have 3 components");
+            case LevelJsonScope::Transform:
+            {
+                if (Frame.Count != 16)
+                {
+                    return Fail("transform doesn't have 16 values");
+                }
+                Mat4x4f& Trans = m_Level.Models.back().Transform;
+                for (int Row = 0; Row < 4; ++Row)
+                {
+                    Trans[Row] = { m_Transform[Row * 4], m_Transform[Row * 4 + 1], m_Transform[Row * 4 + 2], m_Transform[Row * 4 + 3] };
+                }
+                return true;
+            }
+            case LevelJsonScope::BufferVertices:
+                m_GeneratedMesh.VertexFloatCount = Frame.Count;
+                return true;
+            case LevelJsonScope::BufferIndices:
+                m_GeneratedMesh.IndexCount = Frame.Count;
+                return true;
+            case LevelJsonScope::Buffer:
+            {
+                size_t Mesh = m_Level.AddGeneratedMesh(m_GeneratedMesh);
+                if (Top().Scope == LevelJsonScope::GeneratedMeshes)
+                {
+                    m_MeshesByKey[m_MeshKey] = Mesh;
+                }
+                else
+                {
+                    m_Level.Models.back().Mesh = Mesh;
+                }
+                return true;
+            }
+            default:
+                return true;
+            }
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override
+        {
+            return false;
+        }
+
+    private:
+        struct LevelJsonFrame
+        {
+            LevelJsonScope Scope;
+
+            // Values and containers seen in it so far
+            size_t Count = 0;
+
+            // LevelJsonFields seen so far, for objects
+            unsigned int Found = 0;
+        };
+
+        LevelJsonFrame& Top()
+        {
+            return m_Stack.back();
+        }
+
+        bool Push(LevelJsonScope Scope)
+        {
+            m_Stack.push_back({ Scope });
+            return true;
+        }
+
+        bool IsSkipping()
+        {
+            return !m_Stack.empty() && m_Stack.back().Scope == LevelJsonScope::Skip;
+        }
+
+        static bool IsObject(LevelJsonScope Scope)
+        {
+            return Scope == LevelJsonScope::Root || Scope == LevelJsonScope::GeneratedMeshes || Scope == LevelJsonScope::PointLight || Scope == LevelJsonScope::Model ||
+                Scope == LevelJsonScope::Brush;
+        }
+
+        // Keys other than these are from something newer and are just skipped, but these have to hold what's expected
+        bool IsKnownKey()
+        {
+            switch (Top().Scope)
+            {
+            case LevelJsonScope::Root:
+                return m_Key == "Textures" || m_Key == "StaticMeshes" || m_Key == "GeneratedMeshes" || m_Key == "PointLights" || m_Key == "Models" || m_Key == "Brushes";
+            case LevelJsonScope::GeneratedMeshes:
+                // Every key is a mesh
+                return true;
+            case LevelJsonScope::PointLight:
+                return m_Key == "Position" || m_Key == "Colour" || m_Key == "Intensity" || m_Key == "Radius" || m_Key == "CastsShadows";
+            case LevelJsonScope::Model:
+                return m_Key == "Transform" || m_Key == "Behaviours" || m_Key == "Buffer" || m_Key == "MatID" || m_Key == "MeshID" || m_Key == "MeshHash" || m_Key == "Type" || m_Key == "Vis";
+            case LevelJsonScope::Brush:
+                return m_Key == "Verts" || m_Key == "Faces" || m_Key == "MatID";
+            default:
+                return false;
+            }
+        }
+
+        bool Fail(const std::string& Error)
+        {
+            m_Error = Error;
+            return false;
+        }
+
+        // Fine as the value of a key that isn't known, as long as it's in an object
+        bool Unexpected(const std::string& What)
+        {
+            return (IsObject(Top().Scope) && !IsKnownKey()) || Fail("unexpected " + What + (IsObject(Top().Scope) ? " for " + m_Key : ""));
+        }
+
+        bool Number(double Value)
+        {
+            if (IsSkipping())
+            {
+                return true;
+            }
+
+            LevelJsonFrame& Frame = Top();
+            size_t Position = Frame.Count++;
+
+            switch (Frame.Scope)
+            {
+            case LevelJsonScope::BufferVertices:
+                m_Level.Vertices.push_back((float)Value);
+                return true;
+            case LevelJsonScope::BufferIndices:
+                m_Level.Indices.push_back((ElementIndex)Value);
+                return true;
+            case LevelJsonScope::Transform:
+                if (Position < 16)
+                {
+                    m_Transform[Position] = (float)Value;
+                }
+                return true;
+            case LevelJsonScope::BrushVertices:
+            {
+                // Flat list of positions
+                LevelBrush& Brush = m_Level.Brushes.back();
+                if (Position % 3 == 0)
+                {
+                    Brush.Vertices.emplace_back((float)Value, 0.0f, 0.0f);
+                }
+                else if (Position % 3 == 1)
+                {
+                    Brush.Vertices.back().y = (float)Value;
+                }
+                else
+                {
+                    Brush.Vertices.back().z = (float)Value;
+                }
+                return true;
+            }
+            case LevelJsonScope::BrushFace:
+                m_Level.Brushes.back().Faces.back().push_back((unsigned int)Value);
+                return true;
+            case LevelJsonScope::LightPosition:
+            case LevelJsonScope::LightColour:
+            {
+                if (Position >= 3)
+                {
+                    return Fail("point light position or colour has too many components");
+                }
+                PointLight& PLight = m_Level.PointLights.back();
+                Vec3f& Vec = Frame.Scope == LevelJsonScope::LightPosition ? PLight.position : PLight.colour;
+                (Position == 0 ? Vec.x : Position == 1 ? Vec.y : Vec.z) = (float)Value;
+                return true;
+            }
+            case LevelJsonScope::PointLight:
+            {
+                PointLight& PLight = m_Level.PointLights.back();
+                if (m_Key == "Intensity")
+                {
+                    Frame.Found |= FIELD_INTENSITY;
+                    PLight.intensity = (float)Value;
+                }
+                else if (m_Key == "Radius")
+                {
+                    PLight.radius = (float)Value;
+                }
+                return true;
+            }
+            case LevelJsonScope::Model:
+            {
+                LevelModel& Model = m_Level.Models.back();
+                if (m_Key == "MatID")
+                {
+                    Frame.Found |= FIELD_MATERIAL;
+                    Model.Material = (size_t)Value;
+                }
+                else if (m_Key == "MeshID")
+                {
+                    Frame.Found |= FIELD_MESH;
+                    m_MeshRefs.back() = LevelJsonMeshRef::Static;
+                    Model.Mesh = (size_t)Value;
+                }
+                else if (m_Key == "Type")
+                {
+                    Model.Type = (ModelType)(int)Value;
+                }
+                else if (m_Key == "Vis")
+                {
+                    Model.Visibility = (unsigned int)Value;
+                }
+                return true;
+            }
+            case LevelJsonScope::Brush:
+                if (m_Key == "MatID")
+                {
+                    Frame.Found |= FIELD_MATERIAL;
+                    m_Level.Brushes.back().Material = (size_t)Value;
+                }
+                return true;
+            default:
+                return Unexpected("number");
+            }
+        }
+
+        // Its geometry goes on the end of the level's as it's read
+        bool StartGeneratedMesh()
+        {
+            m_GeneratedMesh = LevelMesh();
+            m_GeneratedMesh.FirstVertexFloat = m_Level.Vertices.size();
+            m_GeneratedMesh.FirstIndex = m_Level.Indices.size();
+            return Push(LevelJsonScope::Buffer);
+        }
+
+        // Meshes can be listed after the models using them, so models only get pointed at them once everything's been read
+        bool Finish()
+        {
+            for (size_t i = 0; i < m_Level.Models.size(); ++i)
+            {
+                LevelModel& Model = m_Level.Models[i];
+
+                if (m_MeshRefs[i] == LevelJsonMeshRef::Static)
+                {
+                    if (Model.Mesh >= m_StaticMeshes.size())
+                    {
+                        return Fail("model refers to static mesh " + std::to_string(Model.Mesh) + " which doesn't exist");
+                    }
+                    Model.Mesh = m_StaticMeshes[Model.Mesh];
+                }
+                else if (m_MeshRefs[i] == LevelJsonMeshRef::Hashed)
+                {
+                    auto it = m_MeshesByKey.find(m_MeshKeys[i]);
+                    if (it == m_MeshesByKey.end())
+                    {
+                        return Fail("model refers to generated mesh " + m_MeshKeys[i] + " which doesn't exist");
+                    }
+                    Model.Mesh = it->second;
+                }
+            }
+
+            return true;
+        }
+
+        LevelData& m_Level;
+
+        std::vector<LevelJsonFrame> m_Stack;
+
+        // Last key seen in the innermost object
+        std::string m_Key;
+
+        // Where each entry in StaticMeshes went in the level's meshes
+        std::vector<size_t> m_StaticMeshes;
+
+        // The generated mesh being read, and its key if it's in GeneratedMeshes
+        LevelMesh m_GeneratedMesh;
+        std::string m_MeshKey;
+
+        std::unordered_map<std::string, size_t> m_MeshesByKey;
+
+        // For every model so far
+        std::vector<LevelJsonMeshRef> m_MeshRefs;
+        std::vector<std::string> m_MeshKeys;
+
+        float m_Transform[16];
+
+        std::string m_Error;
+    };
+}
+
+LevelData::~LevelData()
+{
+    Engine::UnmapFile(Mapping);
+}
+
+void LevelData::Clear()
+{
+    Materials.clear();
+    Meshes.clear();
+    Models.clear();
+    Brushes.clear();
+    PointLights.clear();
+    Vertices.clear();
+    Indices.clear();
+    GeneratedMeshesByHash.clear();
+
+    Engine::UnmapFile(Mapping);
+    MappedVertices = nullptr;
+    MappedVertexCount = 0;
+    MappedIndices = nullptr;
+    MappedIndexCount = 0;
+}
+
+const float* LevelData::GetVertices(const LevelMesh& Mesh) const
+{
+    return (Mapping.Data ? MappedVertices : Vertices.data()) + Mesh.FirstVertexFloat;
+}
+
+const ElementIndex* LevelData::GetIndices(const LevelMesh& Mesh) const
+{
+    return (Mapping.Data ? MappedIndices : Indices.data()) + Mesh.FirstIndex;
+}
+
+size_t LevelData::GetVertexFloatCount() const
+{
+    return Mapping.Data ? MappedVertexCount : Vertices.size();
+}
+
+size_t LevelData::GetIndexCount() const
+{
+    return Mapping.Data ? MappedIndexCount : Indices.size();
+}
+
+size_t LevelData::FindGeneratedMesh(uint64_t Hash, const float* MeshVertices, size_t VertexFloatCount, const ElementIndex* MeshIndices, size_t IndexCount) const
+{
+    size_t Found = Meshes.size();
+
+    // Different geometry can hash the same, so it has to be checked
+    auto Range = GeneratedMeshesByHash.equal_range(Hash);
+    for (auto it = Range.first; it != Range.second; ++it)
+    {
+        const LevelMesh& Mesh = Meshes[it->second];
+        if (it->second < Found && Mesh.VertexFloatCount == VertexFloatCount && Mesh.IndexCount == IndexCount &&
+            memcmp(GetVertices(Mesh), MeshVertices, VertexFloatCount * sizeof(float)) == 0 &&
+            memcmp(GetIndices(Mesh), MeshIndices, IndexCount * sizeof(ElementIndex)) == 0)
+        {
+            Found = it->second;
+        }
+    }
+
+    return Found;
+}
+
+size_t LevelData::AddGeneratedMesh(const float* MeshVertices, size_t VertexFloatCount, const ElementIndex* MeshIndices, size_t IndexCount)
+{
+    LevelMesh Mesh;
+    Mesh.FirstVertexFloat = Vertices.size();
+    Mesh.VertexFloatCount = VertexFloatCount;
+    Mesh.FirstIndex = Indices.size();
+    Mesh.IndexCount = IndexCount;
+
+    Vertices.insert(Vertices.end(), MeshVertices, MeshVertices + VertexFloatCount);
+    Indices.insert(Indices.end(), MeshIndices, MeshIndices + IndexCount);
+
+    return AddGeneratedMesh(Mesh);
+}
+
+size_t LevelData::AddGeneratedMesh(LevelMesh Mesh)
+{
+    const float* MeshVertices = Vertices.data() + Mesh.FirstVertexFloat;
+    const ElementIndex* MeshIndices = Indices.data() + Mesh.FirstIndex;
+
+    Mesh.Path.clear();
+    Mesh.Hash = LevelFile::HashMesh(MeshVertices, Mesh.VertexFloatCount, MeshIndices, Mesh.IndexCount);
+
+    size_t Existing = FindGeneratedMesh(Mesh.Hash, MeshVertices, Mesh.VertexFloatCount, MeshIndices, Mesh.IndexCount);
+    if (Existing < Meshes.size())
+    {
+        Vertices.resize(Mesh.FirstVertexFloat);
+        Indices.resize(Mesh.FirstIndex);
+        return Existing;
+    }
+
+    GeneratedMeshesByHash.emplace(Mesh.Hash, Meshes.size());
+    Meshes.push_back(Mesh);
+    return Meshes.size() - 1;
+}
+
+bool LevelFile::IsBinary(const std::string& FileName)
+{
+    std::ifstream File(FileName, std::ifstream::in | std::ifstream::binary);
+
+    uint32_t Magic = 0;
+    File.read((char*)&Magic, sizeof(Magic));
+
+    return File.good() && Magic == LEVEL_BINARY_MAGIC;
+}
+
+bool LevelFile::IsLegacy(const std::string& FileName)
+{
+    std::ifstream File(FileName);
+
+    // They always start with the list of textures
+    std::string FirstLine;
+    std::getline(File, FirstLine);
+
+    return FirstLine.rfind("Textures:", 0) == 0;
+}
+
+bool LevelFile::Load(const std::string& FileName, LevelData& OutLevel)
+{
+    return IsBinary(FileName) ? LoadBinary(FileName, OutLevel) : LoadJson(FileName, OutLevel);
+}
+
+bool LevelFile::Save(const std::string& FileName, const LevelData& Level, LevelFormat Format)
+{
+    return Format == LevelFormat::Binary ? SaveBinary(FileName, Level) : SaveJson(FileName, Level);
+}
+
+uint64_t LevelFile::HashMesh(const float* Vertices, size_t VertexFloatCount, const ElementIndex* Indices, size_t IndexCount)
+{
+    uint64_t Hash = Hash::Hash_Bytes(Vertices, VertexFloatCount * sizeof(float));
+    return Hash::Hash_Bytes(Indices, IndexCount * sizeof(ElementIndex), Hash);
+}
+
+bool LevelFile::LoadJson(const std::string& FileName, LevelData& OutLevel)
+{
+    PROFILE_SCOPE("LevelFile::LoadJson");
+
+    OutLevel.Clear();
+
+    Engine::MappedFile File;
+    if (!Engine::MapFile(FileName, File))
+    {
+        return false;
+    }
+
+    // A guess at how much generated geometry there is, so the buffers don't keep getting copied as they grow
+    OutLevel.Vertices.reserve(File.Size / LEVEL_JSON_BYTES_PER_VERTEX_FLOAT);
+    OutLevel.Indices.reserve(File.Size / LEVEL_JSON_BYTES_PER_INDEX);
+
+    // Checks it's valid JSON while building the level, if it isn't it could be a legacy level so that's not worth printing
+    LevelJsonHandler Handler(OutLevel);
+    bool Parsed = json::sax_parse(File.Data, File.Data + File.Size, &Handler);
+
+    Engine::UnmapFile(File);
+
+    if (!Parsed)
+    {
+        if (!Handler.GetError().empty())
+        {
+            Engine::DEBUGPrint(FileName + ": " + Handler.GetError());
+        }
+        OutLevel.Clear();
+        return false;
+    }
+
+    std::string Error;
+    if (!Validate(OutLevel, Error))
+    {
+        Engine::DEBUGPrint(FileName + ": " + Error);
+        OutLevel.Clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool LevelFile::LoadBinary(const std::string& FileName, LevelData& OutLevel)
+{
+    PROFILE_SCOPE("LevelFile::LoadBinary");
+
+    OutLevel.Clear();
+
+    Engine::MappedFile File;
+    if (!Engine::MapFile(FileName, File))
+    {
+        return false;
+    }
+
+    // Hand the mapping over straight away so it gets unmapped however this goes
+    OutLevel.Mapping = File;
+
+    LevelBinaryReader Reader(File.Data, File.Size);
+
+    std::string Error;
+    if (!Reader.ReadHeader(Error))
+    {
+        Engine::DEBUGPrint(FileName + ": " + Error);
+        OutLevel.Clear();
+        return false;
+    }
+
+    const LevelMaterialRecord* Materials;
+    const LevelMeshRecord* Meshes;
+    const LevelModelRecord* Models;
+    const uint32_t* Behaviours;
+    const LevelBrushRecord* Brushes;
+    const Vec3f* BrushVertices;
+    const LevelBrushFaceRecord* BrushFaces;
+    const uint32_t* BrushFaceIndices;
+    const LevelPointLightRecord* PointLights;
+    size_t MaterialCount, MeshCount, ModelCount, BehaviourCount, BrushCount, BrushVertexCount, BrushFaceCount, BrushFaceIndexCount, PointLightCount;
+
+    bool SectionsValid =
+        Reader.GetSection(LevelSectionType::Materials, Materials, MaterialCount) &&
+        Reader.GetSection(LevelSectionType::Meshes, Meshes, MeshCount) &&
+        Reader.GetSection(LevelSectionType::Models, Models, ModelCount) &&
+        Reader.GetSection(LevelSectionType::Behaviours, Behaviours, BehaviourCount) &&
+        Reader.GetSection(LevelSectionType::Brushes, Brushes, BrushCount) &&
+        Reader.GetSection(LevelSectionType::BrushVertices, BrushVertices, BrushVertexCount) &&
+        Reader.GetSection(LevelSectionType::BrushFaces, BrushFaces, BrushFaceCount) &&
+        Reader.GetSection(LevelSectionType::BrushFaceIndices, BrushFaceIndices, BrushFaceIndexCount) &&
+        Reader.GetSection(LevelSectionType::PointLights, PointLights, PointLightCount) &&
+        Reader.GetSection(LevelSectionType::Vertices, OutLevel.MappedVertices, OutLevel.MappedVertexCount) &&
+        Reader.GetSection(LevelSectionType::Indices, OutLevel.MappedIndices, OutLevel.MappedIndexCount);
+
+    if (!SectionsValid)
+    {
+        Engine::DEBUGPrint(FileName + ": a section's size doesn't match what's meant to be in it");
+        OutLevel.Clear();
+        return false;
+    }
+
+    bool StringsValid = true;
+
+    OutLevel.Materials.resize(MaterialCount);
+    for (size_t i = 0; i < MaterialCount; ++i)
+    {
+        LevelMaterial& Mat = OutLevel.Materials[i];
+        StringsValid &= Reader.GetString(Materials[i].Albedo, Mat.Albedo);
+        StringsValid &= Reader.GetString(Materials[i].Normal, Mat.Normal);
+        StringsValid &= Reader.GetString(Materials[i].Roughness, Mat.Roughness);
+        StringsValid &= Reader.GetString(Materials[i].Metallic, Mat.Metallic);
+        StringsValid &= Reader.GetString(Materials[i].AO, Mat.AO);
+    }
+
+    OutLevel.Meshes.resize(MeshCount);
+    for (size_t i = 0; i < MeshCount; ++i)
+    {
+        LevelMesh& Mesh = OutLevel.Meshes[i];
+        StringsValid &= Reader.GetString(Meshes[i].Path, Mesh.Path);
+        Mesh.Hash = Meshes[i].Hash;
+        Mesh.FirstVertexFloat = (size_t)Meshes[i].FirstVertexFloat;
+        Mesh.VertexFloatCount = (size_t)Meshes[i].VertexFloatCount;
+        Mesh.FirstIndex = (size_t)Meshes[i].FirstIndex;
+        Mesh.IndexCount = (size_t)Meshes[i].IndexCount;
+
+        // The hash isn't checked against the geometry, that would mean reading all of it here. A wrong one only stops meshes being shared
+        if (Mesh.Path.empty())
+        {
+            OutLevel.GeneratedMeshesByHash.emplace(Mesh.Hash, i);
+        }
+    }
+
+    OutLevel.Models.resize(ModelCount);
+    for (size_t i = 0; i < ModelCount; ++i)
+    {
+        const LevelModelRecord& Record = Models[i];
+        LevelModel& Model = OutLevel.Models[i];
+
+        memcpy(&Model.Transform, Record.Transform, sizeof(Record.Transform));
+        Model.Mesh = Record.Mesh;
+        Model.Material = Record.Material;
+        Model.Type = (ModelType)Record.Type;
+        Model.Visibility = Record.Visibility;
+
+        if ((size_t)Record.FirstBehaviour + Record.BehaviourCount > BehaviourCount)
+        {
+            StringsValid = false;
+            continue;
+        }
+
+        Model.Behaviours.resize(Record.BehaviourCount);
+        for (uint32_t b = 0; b < Record.BehaviourCount; ++b)
+        {
+            StringsValid &= Reader.GetString(Behaviours[Record.FirstBehaviour + b], Model.Behaviours[b]);
+        }
+    }
+
+    if (!StringsValid)
+    {
+        Engine::DEBUGPrint(FileName + ": refers to strings that aren't in the string section");
+        OutLevel.Clear();
+        return false;
+    }
+
+    OutLevel.Brushes.resize(BrushCount);
+    for (size_t i = 0; i < BrushCount; ++i)
+    {
+        const LevelBrushRecord& Record = Brushes[i];
+        LevelBrush& Brush = OutLevel.Brushes[i];
+
+        if ((size_t)Record.FirstVertex + Record.VertexCount > BrushVertexCount || (size_t)Record.FirstFace + Record.FaceCount > BrushFaceCount)
+        {
+            Engine::DEBUGPrint(FileName + ": brush " + std::to_string(i) + " isn't inside the brush sections");
+            OutLevel.Clear();
+            return false;
+        }
+
+        Brush.Material = Record.Material;
+        Brush.Vertices.assign(BrushVertices + Record.FirstVertex, BrushVertices + Record.FirstVertex + Record.VertexCount);
+
+        Brush.Faces.resize(Record.FaceCount);
+        for (uint32_t f = 0; f < Record.FaceCount; ++f)
+        {
+            const LevelBrushFaceRecord& Face = BrushFaces[Record.FirstFace + f];
+            if ((size_t)Face.FirstIndex + Face.IndexCount > BrushFaceIndexCount)
+            {
+                Engine::DEBUGPrint(FileName + ": brush " + std::to_string(i) + " has a face that isn't inside the brush sections");
+                OutLevel.Clear();
+                return false;
+            }
+
+            Brush.Faces[f].assign(BrushFaceIndices + Face.FirstIndex, BrushFaceIndices + Face.FirstIndex + Face.IndexCount);
+        }
+    }
+
+    OutLevel.PointLights.resize(PointLightCount);
+    for (size_t i = 0; i < PointLightCount; ++i)
+    {
+        const LevelPointLightRecord& Record = PointLights[i];
+        PointLight& PLight = OutLevel.PointLights[i];
+
+        PLight.position = Vec3f(Record.Position[0], Record.Position[1], Record.Position[2]);
+        PLight.colour = Vec3f(Record.Colour[0], Record.Colour[1], Record.Colour[2]);
+        PLight.intensity = Record.Intensity;
+        PLight.radius = Record.Radius;
+        PLight.castsShadows = Record.CastsShadows != 0;
+    }
+
+    if (!Validate(OutLevel, Error))
+    {
+        Engine::DEBUGPrint(FileName + ": " + Error);
+        OutLevel.Clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool LevelFile::SaveJson(const std::string& FileName, const LevelData& Level)
+{
+    PROFILE_SCOPE("LevelFile::SaveJson");
+
+    std::ofstream File(FileName, std::ofstream::out | std::ofstream::trunc);
+
+    if (!File.is_open())
+    {
+        return false;
+    }
+
+    json SceneJson;
+
+    json TextureList;
+    json StaticMeshList;
+    json GeneratedMeshList = json::object();
+    json PointLightList;
+    json ModelList;
+    json BrushList;
+
+    int Index = 0;
+    for (const LevelMaterial& Mat : Level.Materials)
+    {
+        json& JsonObject = TextureList[Index++];
+        JsonObject[0] = Mat.Albedo;
+        JsonObject[1] = Mat.Normal;
+        JsonObject[2] = Mat.Roughness;
+        JsonObject[3] = Mat.Metallic;
+        JsonObject[4] = Mat.AO;
+    }
+
+    // Meshes loaded from file are listed in order, models refer to them by their index in the list.
+    // Generated ones are stored under their hash and models refer to them by that
+    std::vector<int64_t> StaticMeshIndices(Level.Meshes.size(), -1);
+    std::vector<std::string> GeneratedMeshKeys(Level.Meshes.size());
+    Index = 0;
+    for (size_t i = 0; i < Level.Meshes.size(); ++i)
+    {
+        const LevelMesh& Mesh = Level.Meshes[i];
+        if (!Mesh.Path.empty())
+        {
+            StaticMeshIndices[i] = Index;
+            StaticMeshList[Index++] = { Mesh.Path };
+            continue;
+        }
+
+        std::ostringstream Key;
+        Key << std::hex << std::setw(16) << std::setfill('0') << Mesh.Hash;
+
+        // Different meshes with the same hash can't share a key. The key's only used to find the mesh when loading
+        std::string UniqueKey = Key.str();
+        for (int Suffix = 1; GeneratedMeshList.contains(UniqueKey); ++Suffix)
+        {
+            UniqueKey = Key.str() + "-" + std::to_string(Suffix);
+        }
+        GeneratedMeshKeys[i] = UniqueKey;
+
+        const float* Vertices = Level.GetVertices(Mesh);
+        const ElementIndex* Indices = Level.GetIndices(Mesh);
+
+        json& JsonObject = GeneratedMeshList[UniqueKey];
+        JsonObject[0] = std::vector<float>(Vertices, Vertices + Mesh.VertexFloatCount);
+        JsonObject[1] = std::vector<unsigned int>(Indices, Indices + Mesh.IndexCount);
+    }
+
+    Index = 0;
+    for (const PointLight& PLight : Level.PointLights)
+    {
+        json& JsonObject = PointLightList[Index++];
+        JsonObject["Position"] = { PLight.position.x, PLight.position.y, PLight.position.z };
+        JsonObject["Colour"] = { PLight.colour.x, PLight.colour.y, PLight.colour.z };
+        JsonObject["Intensity"] = PLight.intensity;
+        JsonObject["Radius"] = PLight.radius;
+        JsonObject["CastsShadows"] = PLight.castsShadows;
+    }
+
+    Index = 0;
+    for (const LevelModel& Model : Level.Models)
+    {
+        json& JsonObject = ModelList[Index++];
+
+        if (Level.Meshes[Model.Mesh].Path.empty())
+        {
+            JsonObject["MeshHash"] = GeneratedMeshKeys[Model.Mesh];
+        }
+        else
+        {
+            JsonObject["MeshID"] = StaticMeshIndices[Model.Mesh];
+        }
+
+        JsonObject["MatID"] = Model.Material;
+        SaveJsonTransform(JsonObject["Transform"], Model.Transform);
+        JsonObject["Behaviours"] = Model.Behaviours;
+        JsonObject["Type"] = Model.Type;
+        JsonObject["Vis"] = Model.Visibility;
+    }
+
+    Index = 0;
+    for (const LevelBrush& Brush : Level.Brushes)
+    {
+        json& JsonObject = BrushList[Index++];
+        JsonObject["MatID"] = Brush.Material;
+
+        std::vector<float> VertVec;
+        for (const Vec3f& Vert : Brush.Vertices)
+        {
+            VertVec.insert(VertVec.end(), { Vert.x, Vert.y, Vert.z });
+        }
+        JsonObject["Verts"] = VertVec;
+
+        for (size_t i = 0; i < Brush.Faces.size(); i++)
+        {
+            JsonObject["Faces"][i] = Brush.Faces[i];
+        }
+    }
+
+    SceneJson["Textures"] = TextureList;
+    SceneJson["StaticMeshes"] = StaticMeshList;
+    SceneJson["GeneratedMeshes"] = GeneratedMeshList;
+    SceneJson["PointLights"] = PointLightList;
+    SceneJson["Models"] = ModelList;
+    SceneJson["Brushes"] = BrushList;
+
+    // Pretty printed so levels are easy to read and diff, binary levels are the ones that should be quick to load
+    File << std::setw(4) << SceneJson;
+
+    File.close();
+
+    return File.good();
+}
+
+bool LevelFile::SaveBinary(const std::string& FileName, const LevelData& Level)
+{
+    PROFILE_SCOPE("LevelFile::SaveBinary");
+
+    LevelStringTable Strings;
+
+    std::vector<LevelMaterialRecord> Materials;
+    Materials.reserve(Level.Materials.size());
+    for (const LevelMaterial& Mat : Level.Materials)
+    {
+        Materials.push_back({ Strings.Add(Mat.Albedo), Strings.Add(Mat.Normal), Strings.Add(Mat.Roughness), Strings.Add(Mat.Metallic), Strings.Add(Mat.AO) });
+    }
+
+    std::vector<LevelMeshRecord> Meshes;
+    Meshes.reserve(Level.Meshes.size());
+    for (const LevelMesh& Mesh : Level.Meshes)
+    {
+        LevelMeshRecord Record = {};
+        Record.Path = Strings.Add(Mesh.Path);
+        Record.Hash = Mesh.Hash;
+        Record.FirstVertexFloat = Mesh.FirstVertexFloat;
+        Record.VertexFloatCount = Mesh.VertexFloatCount;
+        Record.FirstIndex = Mesh.FirstIndex;
+        Record.IndexCount = Mesh.IndexCount;
+        Meshes.push_back(Record);
+    }
+
+    std::vector<LevelModelRecord> Models;
+    std::vector<uint32_t> Behaviours;
+    Models.reserve(Level.Models.size());
+    for (const LevelModel& Model : Level.Models)
+    {
+        LevelModelRecord Record = {};
+        memcpy(Record.Transform, &Model.Transform, sizeof(Record.Transform));
+        Record.Mesh = (uint32_t)Model.Mesh;
+        Record.Material = (uint32_t)Model.Material;
+        Record.Type = (uint32_t)Model.Type;
+        Record.Visibility = Model.Visibility;
+        Record.FirstBehaviour = (uint32_t)Behaviours.size();
+        Record.BehaviourCount = (uint32_t)Model.Behaviours.size();
+
+        for (const std::string& Behaviour : Model.Behaviours)
+        {
+            Behaviours.push_back(Strings.Add(Behaviour));
+        }
+
+        Models.push_back(Record);
+    }
+
+    std::vector<LevelBrushRecord> Brushes;
+    std::vector<Vec3f> BrushVertices;
+    std::vector<LevelBrushFaceRecord> BrushFaces;
+    std::vector<uint32_t> BrushFaceIndices;
+    Brushes.reserve(Level.Brushes.size());
+    for (const LevelBrush& Brush : Level.Brushes)
+    {
+        LevelBrushRecord Record = {};
+        Record.Material = (uint32_t)Brush.Material;
+        Record.FirstVertex = (uint32_t)BrushVertices.size();
+        Record.VertexCount = (uint32_t)Brush.Vertices.size();
+        Record.FirstFace = (uint32_t)BrushFaces.size();
+        Record.FaceCount = (uint32_t)Brush.Faces.size();
+
+        BrushVertices.insert(BrushVertices.end(), Brush.Vertices.begin(), Brush.Vertices.end());
+        for (const std::vector<unsigned int>& Face : Brush.Faces)
+        {
+            BrushFaces.push_back({ (uint32_t)BrushFaceIndices.size(), (uint32_t)Face.size() });
+            BrushFaceIndices.insert(BrushFaceIndices.end(), Face.begin(), Face.end());
+        }
+
+        Brushes.push_back(Record);
+    }
+
+    std::vector<LevelPointLightRecord> PointLights;
+    PointLights.reserve(Level.PointLights.size());
+    for (const PointLight& PLight : Level.PointLights)
+    {
+        LevelPointLightRecord Record = {};
+        Record.Position[0] = PLight.position.x;
+        Record.Position[1] = PLight.position.y;
+        Record.Position[2] = PLight.position.z;
+        Record.Colour[0] = PLight.colour.x;
+        Record.Colour[1] = PLight.colour.y;
+        Record.Colour[2] = PLight.colour.z;
+        Record.Intensity = PLight.intensity;
+        Record.Radius = PLight.radius;
+        Record.CastsShadows = PLight.castsShadows ? 1 : 0;
+        PointLights.push_back(Record);
+    }
+
+    LevelBinaryWriter Writer;
+    Writer.AddSection(LevelSectionType::Strings, Strings.GetData());
+    Writer.AddSection(LevelSectionType::Materials, Materials);
+    Writer.AddSection(LevelSectionType::Meshes, Meshes);
+    Writer.AddSection(LevelSectionType::Models, Models);
+    Writer.AddSection(LevelSectionType::Behaviours, Behaviours);
+    Writer.AddSection(LevelSectionType::Brushes, Brushes);
+    Writer.AddSection(LevelSectionType::BrushVertices, BrushVertices);
+    Writer.AddSection(LevelSectionType::BrushFaces, BrushFaces);
+    Writer.AddSection(LevelSectionType::BrushFaceIndices, BrushFaceIndices);
+    Writer.AddSection(LevelSectionType::PointLights, PointLights);
+
+    // Geometry goes last, it's the bulk of the file and the loader only ever reads it in place
+    Writer.AddSection(LevelSectionType::Vertices, Level.Mapping.Data ? Level.MappedVertices : Level.Vertices.data(), Level.GetVertexFloatCount() * sizeof(float));
+    Writer.AddSection(LevelSectionType::Indices, Level.Mapping.Data ? Level.MappedIndices : Level.Indices.data(), Level.GetIndexCount() * sizeof(ElementIndex));
+
+    return Writer.Write(FileName);
+}
+
+bool LevelFile::Validate(const LevelData& Level, std::string& OutError)
+{
+    size_t VertexFloatCount = Level.GetVertexFloatCount();
+    size_t IndexCount = Level.GetIndexCount();
+
+    for (size_t i = 0; i < Level.Meshes.size(); ++i)
+    {
+        const LevelMesh& Mesh = Level.Meshes[i];
+        if (!Mesh.Path.empty())
+        {
+            continue;
+        }
+
+        if (Mesh.FirstVertexFloat > VertexFloatCount || Mesh.VertexFloatCount > VertexFloatCount - Mesh.FirstVertexFloat ||
+            Mesh.FirstIndex > IndexCount || Mesh.IndexCount > IndexCount - Mesh.FirstIndex)
+        {
+            OutError = "mesh " + std::to_string(i) + " isn't inside the level's geometry";
+            return false;
+        }
+
+        if (Mesh.VertexFloatCount % LevelVertexFloats != 0)
+        {
+            OutError = "mesh " + std::to_string(i) + " doesn't have a whole number of vertices";
+            return false;
+        }
+
+        size_t MeshVertexCount = Mesh.VertexFloatCount / LevelVertexFloats;
+        const ElementIndex* Indices = Level.GetIndices(Mesh);
+        for (size_t j = 0; j < Mesh.IndexCount; ++j)
+        {
+            if (Indices[j] >= MeshVertexCount)
+            {
+                OutError = "mesh " + std::to_string(i) + " indexes past its vertices";
+                return false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < Level.Models.size(); ++i)
+    {
+        const LevelModel& Model = Level.Models[i];
+        if (Model.Mesh >= Level.Meshes.size() || Model.Material >= Level.Materials.size())
+        {
+            OutError = "model " + std::to_string(i) + " refers to a mesh or material that doesn't exist";
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < Level.Brushes.size(); ++i)
+    {
+        const LevelBrush& Brush = Level.Brushes[i];
+        if (Brush.Material >= Level.Materials.size())
+        {
+            OutError = "brush " + std::to_string(i) + " refers to a material that doesn't exist";
+            return false;
+        }
+
+        for (const std::vector<unsigned int>& Face : Brush.Faces)
+        {
+            for (unsigned int Vert : Face)
+            {
+                if (Vert >= Brush.Vertices.size())
+                {
+                    OutError = "brush " + std::to_string(i) + " has a face using a vertex it doesn't have";
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
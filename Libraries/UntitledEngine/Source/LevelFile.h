@@ -0,0 +1,156 @@
+#pragma once
+
+// Reading and writing level (.lvl) files, without loading anything they refer to into the engine.
+// Levels come in two formats that hold the same data:
+// - JSON, easy to read and diff but slow to parse and big when there are generated meshes in it (every float is written out as text).
+//   It's parsed in one pass straight into the level, without building a document first
+// - Binary, a header and a table of sections (materials, meshes, models, brushes, point lights, behaviours...) at aligned offsets.
+//   The file is memory mapped and records are read in place, generated meshes' vertices and indices are never copied on the way to the GPU.
+//   Numbers are stored little-endian, like every platform the engine runs on
+// Either kind is loaded into a LevelData, which the scene turns into models and lights (see Scene::Load/Save).
+// Generated meshes are content addressed: each is stored once under the hash of its vertices and indices however many models use it,
+// and models using the same one share a single StaticMesh once loaded.
+
+#include "Modules/GraphicsModule.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// "ULVL", the first four bytes of every binary level
+#define LEVEL_BINARY_MAGIC 0x4C564C55
+
+// Bump whenever the layout of anything below changes
+#define LEVEL_BINARY_VERSION 2
+
+// Every section starts on a multiple of this, so vertex data can go straight from the mapping to the GPU
+#define LEVEL_BINARY_SECTION_ALIGNMENT 16
+
+enum class LevelFormat
+{
+    Json,
+    Binary
+};
+
+// Texture paths relative to Assets/, in the order Material takes them
+struct LevelMaterial
+{
+    std::string Albedo;
+    std::string Normal;
+    std::string Roughness;
+    std::string Metallic;
+    std::string AO;
+};
+
+struct LevelMesh
+{
+    // Relative to Assets/, empty for generated meshes
+    std::string Path;
+
+    // LevelFile::HashMesh of a generated mesh's contents
+    uint64_t Hash = 0;
+
+    // Where a generated mesh's vertices (in the textured mesh format) and indices are in the level's geometry
+    size_t FirstVertexFloat = 0;
+    size_t VertexFloatCount = 0;
+    size_t FirstIndex = 0;
+    size_t IndexCount = 0;
+};
+
+struct LevelModel
+{
+    Mat4x4f Transform;
+
+    size_t Mesh = 0;
+    size_t Material = 0;
+
+    ModelType Type = ModelType::MODEL;
+    unsigned int Visibility = (unsigned int)Vis::SHADOW_CAST | (unsigned int)Vis::SHADOW_RECV;
+
+    std::vector<std::string> Behaviours;
+};
+
+struct LevelBrush
+{
+    size_t Material = 0;
+
+    std::vector<Vec3f> Vertices;
+    std::vector<std::vector<unsigned int>> Faces;
+};
+
+struct LevelData
+{
+    LevelData() = default;
+    ~LevelData();
+
+    // Might own a mapping, which can't be shared
+    LevelData(const LevelData&) = delete;
+    LevelData& operator=(const LevelData&) = delete;
+
+    std::vector<LevelMaterial> Materials;
+    std::vector<LevelMesh> Meshes;
+    std::vector<LevelModel> Models;
+    std::vector<LevelBrush> Brushes;
+    std::vector<PointLight> PointLights;
+
+    // Generated meshes' geometry, every mesh's is a range of these
+    std::vector<float> Vertices;
+    std::vector<ElementIndex> Indices;
+
+    // Generated meshes in Meshes by their hash
+    std::unordered_multimap<uint64_t, size_t> GeneratedMeshesByHash;
+
+    // Levels read from binary files keep the file mapped and use the geometry in it instead of Vertices/Indices
+    Engine::MappedFile Mapping;
+    const float* MappedVertices = nullptr;
+    size_t MappedVertexCount = 0;
+    const ElementIndex* MappedIndices = nullptr;
+    size_t MappedIndexCount = 0;
+
+    // Empties everything out and lets go of the mapping
+    void Clear();
+
+    const float* GetVertices(const LevelMesh& Mesh) const;
+    const ElementIndex* GetIndices(const LevelMesh& Mesh) const;
+
+    size_t GetVertexFloatCount() const;
+    size_t GetIndexCount() const;
+
+    // The first generated mesh with exactly this geometry, or Meshes.size() if there isn't one
+    size_t FindGeneratedMesh(uint64_t Hash, const float* MeshVertices, size_t VertexFloatCount, const ElementIndex* MeshIndices, size_t IndexCount) const;
+
+    // Both are only for levels being put together, not ones read from binary files, and return the index of the mesh in Meshes.
+    // A mesh with the same geometry as one that's already there isn't added again, the existing one is used instead
+    size_t AddGeneratedMesh(const float* MeshVertices, size_t VertexFloatCount, const ElementIndex* MeshIndices, size_t IndexCount);
+    // For geometry that's already been put on the end of Vertices and Indices (Mesh says where), it's taken back off if it's a duplicate
+    size_t AddGeneratedMesh(LevelMesh Mesh);
+};
+
+class LevelFile
+{
+public:
+    // Both only look at the start of the file
+    static bool IsBinary(const std::string& FileName);
+    // Levels from before they were JSON, Scene::LegacyLoad reads them
+    static bool IsLegacy(const std::string& FileName);
+
+    // Both replace whatever's in OutLevel, and fail on files that can't be opened or don't hold a valid level (nothing in OutLevel should
+    // be used if they do). A JSON load failing might just mean it's a legacy text level
+    static bool LoadJson(const std::string& FileName, LevelData& OutLevel);
+    static bool LoadBinary(const std::string& FileName, LevelData& OutLevel);
+
+    // Picks the right one of the above for the file
+    static bool Load(const std::string& FileName, LevelData& OutLevel);
+
+    static bool Save(const std::string& FileName, const LevelData& Level, LevelFormat Format);
+
+    // What generated meshes are stored under, the same in both formats
+    static uint64_t HashMesh(const float* Vertices, size_t VertexFloatCount, const ElementIndex* Indices, size_t IndexCount);
+
+private:
+    // Checks every index in the level points at something that exists, so nothing loading it has to
+    static bool Validate(const LevelData& Level, std::string& OutError);
+
+    static bool SaveJson(const std::string& FileName, const LevelData& Level);
+    static bool SaveBinary(const std::string& FileName, const LevelData& Level);
+};
@@ -1,6 +1,6 @@
 #include "MeshGenerator.h"
 
-#include "Platform\RendererPlatform.h"
+#include "Platform/RendererPlatform.h"
 
 StaticMesh_ID MeshGenerator::GenCube(Renderer& renderer)
 {
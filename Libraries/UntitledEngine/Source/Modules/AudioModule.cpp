@@ -1,6 +1,8 @@
 #include "AudioModule.h"
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 AudioModule* AudioModule::s_Instance = nullptr;
 
@@ -16,5 +18,7 @@ AudioModule::~AudioModule()
 
 void AudioModule::PlayAsyncSound(std::string filePath)
 {
+#ifdef _WIN32
     PlaySound((LPCTSTR)SND_ALIAS_SYSTEMHAND, NULL, SND_ALIAS_ID | SND_ASYNC);
+#endif
 }
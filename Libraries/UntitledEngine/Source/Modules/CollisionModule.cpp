@@ -1,5 +1,9 @@
 #include "CollisionModule.h"
 
+#include "Profiling/Profiler.h"
+
+#include <cfloat>
+
 CollisionModule* CollisionModule::s_Instance = nullptr;
 
 OctreeNode::~OctreeNode()
@@ -104,6 +108,7 @@ void OctreeNode::AddLevel(int tempDepth)
 
 CollisionModule::CollisionModule(Renderer& renderer)
     : m_Renderer(renderer)
+    , m_MainThreadId(std::this_thread::get_id())
 {
     s_Instance = this;
 }
@@ -126,6 +131,11 @@ CollisionMesh* CollisionModule::GetCollisionMeshFromMesh(StaticMesh mesh)
 
 CollisionMesh* CollisionModule::GenerateCollisionMeshFromMesh(StaticMesh mesh)
 {
+    PROFILE_SCOPE("Collision::GenerateCollisionMesh");
+
+    // Off the main thread this has to already have been done by Scene::UpdateRenderResources
+    assert(std::this_thread::get_id() == m_MainThreadId);
+
     CollisionMesh* collMesh = new CollisionMesh();
 
     std::vector<Vertex*> verts = m_Renderer.MapMeshVertices(mesh.Id);
@@ -208,6 +218,8 @@ RayCastHit CollisionModule::RayCast(Ray ray, const CollisionMesh& mesh, Transfor
 
 RayCastHit CollisionModule::RayCast(Ray ray, const CollisionMesh& mesh, const Mat4x4f& meshTransform)
 {
+    PROFILE_SCOPE("Collision::RayCast");
+
     RayCastHit resultHit;
 
     Mat4x4f invMeshTransform = Math::inv(meshTransform);
@@ -542,6 +554,8 @@ Intersection CollisionModule::SphereIntersection(Sphere sphere, Model& model)
 
 Intersection CollisionModule::SphereIntersection(Sphere sphere, const CollisionMesh& mesh, Transform& transform)
 {
+    PROFILE_SCOPE("Collision::SphereIntersection");
+
     Intersection resultIntersection;
 
     Mat4x4f meshTransform = transform.GetTransformMatrix();
@@ -8,12 +8,13 @@
 #undef min
 #endif
 
-#include "..\Platform\RendererPlatform.h"
-#include "..\Math\Geometry.h"
+#include "../Platform/RendererPlatform.h"
+#include "../Math/Geometry.h"
 
 #include "GraphicsModule.h"
 
 #include <limits> 
+#include <thread>
 #include <unordered_map>
 
 
@@ -121,6 +122,9 @@ private:
 
     std::unordered_map<StaticMesh_ID, CollisionMesh*> m_CollisionMeshMap;
 
+    // Generating a collision mesh maps the mesh buffers, which only works on the thread that owns the GL context
+    std::thread::id m_MainThreadId;
+
     bool OctreeEnabled = true;
     bool OctreeDebugDrawEnabled = false;
 
@@ -1,8 +1,15 @@
 #include "GraphicsModule.h"
 
-#include "..\FileLoader.h"
-
+#include "../FileLoader.h"
+#include "Profiling/Profiler.h"
+#include "Rendering/MeshSimplifier.h"
+#include "Utils/Hash.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <iomanip>
 #include <random>
+#include <sstream>
 #include "Scene.h"
 
 Brush::Brush(AABB InAABB)
@@ -58,17 +65,20 @@ Brush::Brush(std::vector<Vec3f>& InVerts, std::vector<std::vector<unsigned int>>
     Faces = InFaces;
 }
 
-GraphicsModule* GraphicsModule::s_Instance = nullptr;
-
-Material::Material(Texture Albedo, Texture Normal, Texture Roughness, Texture Metallic, Texture AO)
-    : m_Albedo(Albedo)
-    , m_Normal(Normal)
-    , m_Roughness(Roughness)
-    , m_Metallic(Metallic)
-    , m_AO(AO)
+void DebugDrawCapture::Clear()
 {
+    for (std::vector<float>& LayerVertices : LineVertices)
+    {
+        LayerVertices.clear();
+    }
+    PersistentLines.clear();
 }
 
+GraphicsModule* GraphicsModule::s_Instance = nullptr;
+
+// Set per thread by SetDebugDrawCapture
+static thread_local DebugDrawCapture* t_DebugDrawCapture = nullptr;
+
 GraphicsModule::GraphicsModule(Renderer& renderer)
     : m_Renderer(renderer)
     , m_Camera(nullptr)
@@ -77,7 +87,7 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
     , m_IsDebugDrawInitialized(false)
     , m_IsDebugDrawAttachedToFBuffer(false)
     , m_TexturedMeshFormat({ VertAttribute::Vec3f, VertAttribute::Vec3f, VertAttribute::Vec4f, VertAttribute::Vec2f })
-    , m_DebugVertFormat({ VertAttribute::Vec3f })
+    , m_DebugVertFormat({ VertAttribute::Vec3f, VertAttribute::Vec3f })
     , m_RenderMode(RenderMode::DEFAULT)
 {
 
@@ -89,18 +99,26 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 	uniform mat4x4 Transformation;
 	uniform mat4x4 Camera;
 
-    in vec4 VertPosition;
-	in vec4 VertNormal;
-	in vec4 VertColour;
-	in vec2 VertUV;
+    layout (location = 0) in vec4 VertPosition;
+	layout (location = 1) in vec4 VertNormal;
+	layout (location = 2) in vec4 VertColour;
+	layout (location = 3) in vec2 VertUV;
 
     smooth out vec4 FragNormal;
     smooth out vec4 FragColour;
     smooth out vec2 FragUV;
 
+    // Static meshes can have their positions quantised against their bounds (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
     void main()
     {
-        gl_Position = (Camera * Transformation) * VertPosition;
+        gl_Position = (Camera * Transformation) * DecodePosition(VertPosition);
         
         FragNormal = VertNormal;
         FragColour = VertColour;
@@ -144,10 +162,10 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 	uniform mat4x4 Camera;
     uniform mat4x4 LightSpaceMatrix;
 
-	in vec4 VertPosition;
-	in vec4 VertNormal;
-	in vec4 VertColour;
-	in vec2 VertUV;
+	layout (location = 0) in vec4 VertPosition;
+	layout (location = 1) in vec4 VertNormal;
+	layout (location = 2) in vec4 VertColour;
+	layout (location = 3) in vec2 VertUV;
 	
     smooth out vec3 FragPosition;
 	smooth out vec3 FragNormal;
@@ -155,13 +173,37 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 	smooth out vec2 FragUV;
     out vec4 FragPosLightSpace;
 
+    // Static meshes can have their positions quantised against their bounds and their normals packed onto an octahedron (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+    uniform bool MeshOctahedralNormals;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
+    vec3 DecodeNormal(vec4 Normal)
+    {
+        if (!MeshOctahedralNormals)
+        {
+            return Normal.xyz;
+        }
+
+        vec3 N = vec3(Normal.xy, 1.0 - abs(Normal.x) - abs(Normal.y));
+        float Unfold = max(-N.z, 0.0);
+        N.x += N.x >= 0.0 ? -Unfold : Unfold;
+        N.y += N.y >= 0.0 ? -Unfold : Unfold;
+        return normalize(N);
+    }
+
 	void main()
 	{
-		gl_Position = (Camera * Transformation) * VertPosition;
+        vec4 Position = DecodePosition(VertPosition);
+		gl_Position = (Camera * Transformation) * Position;
 		
-		FragPosition = vec3(Transformation * VertPosition);
+		FragPosition = vec3(Transformation * Position);
         //TEMP(fraser): costly inverses
-		FragNormal = mat3(transpose(inverse(Transformation))) * VertNormal.xyz;
+		FragNormal = mat3(transpose(inverse(Transformation))) * DecodeNormal(VertNormal);
 		FragColour = VertColour;
 		FragUV = VertUV;
         FragPosLightSpace = LightSpaceMatrix * vec4(FragPosition, 1.0);
@@ -381,14 +423,22 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     std::string shadowVertShader = R"(
     #version 400
-    layout (location = 0) in vec3 aPos;
+    layout (location = 0) in vec4 aPos;
 
     uniform mat4 LightSpaceMatrix;
     uniform mat4 Transformation;
 
+    // Static meshes can have their positions quantised against their bounds (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
     void main()
     {
-        gl_Position = LightSpaceMatrix * Transformation * vec4(aPos, 1.0);
+        gl_Position = LightSpaceMatrix * Transformation * DecodePosition(aPos);
     }   
     )";
 
@@ -402,6 +452,73 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     m_ShadowShader = m_Renderer.LoadShader(shadowVertShader, shadowFragShader);
 
+    // Same as above, but the transformation comes from the per-instance attribute
+    shadowVertShader = R"(
+    #version 400
+    layout (location = 0) in vec4 aPos;
+    layout (location = 8) in mat4 InstanceTransformation;
+
+    uniform mat4 LightSpaceMatrix;
+
+    // Static meshes can have their positions quantised against their bounds (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
+    void main()
+    {
+        gl_Position = LightSpaceMatrix * InstanceTransformation * DecodePosition(aPos);
+    }   
+    )";
+
+    m_ShadowInstancedShader = m_Renderer.LoadShader(shadowVertShader, shadowFragShader);
+
+    // Point light shadows store the distance to the light (over the light's radius) instead of the projected depth,
+    // so every cube face can be compared against the same way
+    shadowVertShader = R"(
+    #version 400
+    layout (location = 0) in vec4 aPos;
+    layout (location = 8) in mat4 InstanceTransformation;
+
+    uniform mat4 LightSpaceMatrix;
+
+    out vec3 WorldPos;
+
+    // Static meshes can have their positions quantised against their bounds (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
+    void main()
+    {
+        vec4 World = InstanceTransformation * DecodePosition(aPos);
+        WorldPos = World.xyz;
+        gl_Position = LightSpaceMatrix * World;
+    }   
+    )";
+
+    shadowFragShader = R"(
+    #version 400
+
+    in vec3 WorldPos;
+
+    uniform vec3 LightPosition;
+    uniform float LightRadius;
+    
+    void main()
+    {
+        gl_FragDepth = length(WorldPos - LightPosition) / LightRadius;
+    }
+    )";
+
+    m_PointShadowShader = m_Renderer.LoadShader(shadowVertShader, shadowFragShader);
+
     // ~~~~~~~~~~~~~~~~~~~~~Skybox shader code~~~~~~~~~~~~~~~~~~~~~ //
     vertShaderSource = R"(
     #version 400
@@ -443,16 +560,16 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 	#version 400
 
 	uniform mat4x4 Camera;	
-    uniform vec3 Colour;
 
 	in vec3 VertPosition;
+	in vec3 VertColour;
 
 	smooth out vec4 FragColour;
 
 	void main()
 	{
 		gl_Position = Camera * vec4(VertPosition, 1.0);
-		FragColour = vec4(Colour, 1.0);
+		FragColour = vec4(VertColour, 1.0);
 	}
 	)";
 
@@ -526,24 +643,52 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
     #version 400
 
 	uniform mat4x4 Transformation;
-	uniform mat4x4 Camera;
+	layout (std140) uniform FrameData
+	{
+	    mat4 Camera;
+	    vec3 CameraPos;
+	};
 
-	in vec4 VertPosition;
-	in vec4 VertNormal;
-	in vec4 VertColour;
-	in vec2 VertUV;
+	layout (location = 0) in vec4 VertPosition;
+	layout (location = 1) in vec4 VertNormal;
+	layout (location = 2) in vec4 VertColour;
+	layout (location = 3) in vec2 VertUV;
 
     smooth out vec3 FragPosition;
 	smooth out vec3 FragNormal;
     smooth out vec4 FragColour;
 	smooth out vec2 FragUV;
 
+    // Static meshes can have their positions quantised against their bounds and their normals packed onto an octahedron (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+    uniform bool MeshOctahedralNormals;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
+    vec3 DecodeNormal(vec4 Normal)
+    {
+        if (!MeshOctahedralNormals)
+        {
+            return Normal.xyz;
+        }
+
+        vec3 N = vec3(Normal.xy, 1.0 - abs(Normal.x) - abs(Normal.y));
+        float Unfold = max(-N.z, 0.0);
+        N.x += N.x >= 0.0 ? -Unfold : Unfold;
+        N.y += N.y >= 0.0 ? -Unfold : Unfold;
+        return normalize(N);
+    }
+
     void main()
     {
-        gl_Position = (Camera * Transformation) * VertPosition;
+        vec4 Position = DecodePosition(VertPosition);
+        gl_Position = (Camera * Transformation) * Position;
 
-        FragPosition = vec3(Transformation * VertPosition);
-        FragNormal = mat3(transpose(inverse(Transformation))) * VertNormal.xyz;
+        FragPosition = vec3(Transformation * Position);
+        FragNormal = mat3(transpose(inverse(Transformation))) * DecodeNormal(VertNormal);
         FragColour = VertColour;
         FragUV = VertUV;
     }
@@ -554,12 +699,10 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
     #version 400
 
     //out vec4 OutColour;
-    layout (location = 0) out vec4 gPosition;
-    layout (location = 1) out vec4 gNormal;
-    layout (location = 2) out vec4 gAlbedo;
-    layout (location = 3) out vec4 gMetallic;
-    layout (location = 4) out vec4 gRoughness;
-    layout (location = 5) out vec4 gAO;
+    // Position isn't written, the lighting passes rebuild it from the depth buffer
+    layout (location = 0) out vec2 gNormal;
+    layout (location = 1) out vec4 gAlbedo;
+    layout (location = 2) out vec4 gMaterial;
 
     smooth in vec3 FragPosition;
     smooth in vec3 FragNormal;   
@@ -572,7 +715,11 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
     uniform sampler2D RoughnessMap;
     uniform sampler2D AOMap;
 
-    uniform vec3 CameraPos;
+    layout (std140) uniform FrameData
+    {
+        mat4 Camera;
+        vec3 CameraPos;
+    };
 
     mat3 cotangent_frame( vec3 N, vec3 p, vec2 uv )
     {
@@ -593,6 +740,17 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
         return mat3( T * invmax, B * invmax, N );
     }
 
+    // Octahedral mapping, unit vectors fold down into the [-1, 1] square
+    vec2 EncodeNormal(vec3 N)
+    {
+        N /= abs(N.x) + abs(N.y) + abs(N.z);
+        if (N.z < 0.0)
+        {
+            N.xy = (1.0 - abs(N.yx)) * vec2(N.x >= 0.0 ? 1.0 : -1.0, N.y >= 0.0 ? 1.0 : -1.0);
+        }
+        return N.xy;
+    }
+
     vec3 perturb_normal( vec3 N, vec3 V, vec2 texcoord )
     {
         // assume N, the interpolated vertex normal and 
@@ -607,15 +765,12 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
     {
         vec3 ViewVector = CameraPos - FragPosition;       
        
-        gPosition = vec4(FragPosition, 1.0);
         gAlbedo = texture(AlbedoMap, FragUV);
-        gMetallic = texture(MetallicMap, FragUV);
-        gRoughness = texture(RoughnessMap, FragUV);
-        gAO = texture(AOMap, FragUV);
+        gMaterial = vec4(texture(MetallicMap, FragUV).r, texture(RoughnessMap, FragUV).g, texture(AOMap, FragUV).r, 1.0);
 
         
         vec3 Normal = perturb_normal(normalize(FragNormal), ViewVector, FragUV);
-        gNormal = vec4(Normal, 1.0);
+        gNormal = EncodeNormal(Normal);
         //vec3 Normal = normalize(FragNormal);
         //gNormal = vec4(Normal, 1.0 + tiny);
     }   
@@ -624,6 +779,66 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     m_GBufferShader = m_Renderer.LoadShader(vertShaderSource, fragShaderSource);
 
+    // ~~~~~~~~~~~~~~~~~~~~~GBuffer instanced shader code~~~~~~~~~~~~~~~~~~~~~ //
+    // Uses the same fragment shader as the regular GBuffer shader
+    vertShaderSource = R"(
+    #version 400
+
+	layout (std140) uniform FrameData
+	{
+	    mat4 Camera;
+	    vec3 CameraPos;
+	};
+
+	layout (location = 0) in vec4 VertPosition;
+	layout (location = 1) in vec4 VertNormal;
+	layout (location = 2) in vec4 VertColour;
+	layout (location = 3) in vec2 VertUV;
+    layout (location = 8) in mat4 InstanceTransformation;
+
+    smooth out vec3 FragPosition;
+	smooth out vec3 FragNormal;
+    smooth out vec4 FragColour;
+	smooth out vec2 FragUV;
+
+    // Static meshes can have their positions quantised against their bounds and their normals packed onto an octahedron (see VertexDecode)
+    uniform vec4 MeshPositionDecode;
+    uniform bool MeshOctahedralNormals;
+
+    vec4 DecodePosition(vec4 Position)
+    {
+        return vec4(Position.xyz * MeshPositionDecode.w + MeshPositionDecode.xyz, 1.0);
+    }
+
+    vec3 DecodeNormal(vec4 Normal)
+    {
+        if (!MeshOctahedralNormals)
+        {
+            return Normal.xyz;
+        }
+
+        vec3 N = vec3(Normal.xy, 1.0 - abs(Normal.x) - abs(Normal.y));
+        float Unfold = max(-N.z, 0.0);
+        N.x += N.x >= 0.0 ? -Unfold : Unfold;
+        N.y += N.y >= 0.0 ? -Unfold : Unfold;
+        return normalize(N);
+    }
+
+    void main()
+    {
+        vec4 Position = DecodePosition(VertPosition);
+        gl_Position = (Camera * InstanceTransformation) * Position;
+
+        FragPosition = vec3(InstanceTransformation * Position);
+        FragNormal = mat3(transpose(inverse(InstanceTransformation))) * DecodeNormal(VertNormal);
+        FragColour = VertColour;
+        FragUV = VertUV;
+    }
+
+    )";
+
+    m_GBufferInstancedShader = m_Renderer.LoadShader(vertShaderSource, fragShaderSource);
+
     // ~~~~~~~~~~~~~~~~~~~~~GBuffer lighting shader code~~~~~~~~~~~~~~~~~~~~~ //
     vertShaderSource = R"(
     #version 400
@@ -883,22 +1098,53 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     smooth in vec2 FragUV;
 
-    uniform sampler2D gPosition;
+    uniform sampler2D gDepth;
+    // Octahedral encoded normal
     uniform sampler2D gNormal;
     uniform sampler2D gAlbedo;
-    uniform sampler2D gMetallic;
-    uniform sampler2D gRoughness;
-    uniform sampler2D gAO;
+    // r = metallic, g = roughness, b = ambient occlusion
+    uniform sampler2D gMaterial;
 
     uniform samplerCube SkyBox;	
 
+    // Every cascade side by side in one depth texture
     uniform sampler2D ShadowMap;    
-    uniform mat4x4 LightSpaceMatrix;
 
 	uniform vec3 SunDirection;
     uniform vec3 SunColour;
 
-    uniform vec3 CameraPos;
+    layout (std140) uniform FrameData
+    {
+        mat4 Camera;
+        vec3 CameraPos;
+        mat4 InvCamera;
+    };
+
+    vec3 GetWorldPosition(vec2 UV)
+    {
+        vec4 ClipPosition = vec4(UV, texture(gDepth, UV).r, 1.0) * 2.0 - 1.0;
+        vec4 WorldPosition = InvCamera * ClipPosition;
+        return WorldPosition.xyz / WorldPosition.w;
+    }
+
+    vec3 DecodeNormal(vec2 Encoded)
+    {
+        vec3 N = vec3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+        float T = clamp(-N.z, 0.0, 1.0);
+        N.x += N.x >= 0.0 ? -T : T;
+        N.y += N.y >= 0.0 ? -T : T;
+        return normalize(N);
+    }
+
+    layout (std140) uniform ShadowCascadeData
+    {
+        mat4 CascadeMatrices[4];
+        vec4 CascadeSplits;
+        vec4 CascadeDepthRanges;
+        vec4 CascadeTexelSizes;
+        vec3 CascadeCameraForward;
+        int CascadeCount;
+    };
     
     const float PI = 3.14159265359;
     // ----------------------------------------------------------------------------
@@ -943,41 +1189,60 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
         return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
     }
 
-    float ShadowCalculation(vec4 fragPosLightSpace, vec3 FragNormal)
+    float ShadowCalculation(vec3 FragPos, vec3 FragNormal)
     {
+        // pick the first cascade whose slice of the view contains this fragment
+        float ViewDepth = dot(FragPos - CameraPos, CascadeCameraForward);
+        int Cascade = -1;
+        for (int i = 0; i < CascadeCount; ++i)
+        {
+            if (ViewDepth <= CascadeSplits[i])
+            {
+                Cascade = i;
+                break;
+            }
+        }
+        if (Cascade < 0)
+        {
+            return 0.0;
+        }
+
+        vec4 fragPosLightSpace = CascadeMatrices[Cascade] * vec4(FragPos, 1.0);
         // perform perspective divide
         vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
         // transform to [0,1] range
         projCoords = projCoords * 0.5 + 0.5;
-        // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-        float closestDepth = texture(ShadowMap, projCoords.xy).r; 
+        if (projCoords.z > 1.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+        {
+            return 0.0;
+        }
+        // get closest depth value from light's perspective (offset into this cascade's tile of the atlas)
+        vec2 atlasCoords = vec2((projCoords.x + float(Cascade)) / float(CascadeCount), projCoords.y);
+        float closestDepth = texture(ShadowMap, atlasCoords).r; 
         // get depth of current fragment from light's perspective
         float currentDepth = projCoords.z;
         // check whether current frag pos is in shadow  
         vec3 sun = vec3(-SunDirection.x, -SunDirection.y, -SunDirection.z);      
-        //float bias = max(0.05 * (1.0 - dot(FragNormal, sun)), 0.005);  
-        float bias = max(0.0009 * (1.0 - dot(FragNormal.xyz, sun)), 0.0002);         
-
+        // bias is worked out in world units (a few texels, more at grazing angles) then converted to this cascade's depth range
+        float bias = max(6.0 * (1.0 - dot(FragNormal.xyz, sun)), 1.5) * CascadeTexelSizes[Cascade];
+        bias /= CascadeDepthRanges[Cascade];
     
         float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;  
-        if (projCoords.z > 1.0)
-        {
-            shadow = 0.0;
-        }
 
         return shadow;
     }
 
     void main()
     {
-        vec3 Position = texture(gPosition, FragUV).xyz;
-        vec3 Normal = texture(gNormal, FragUV).xyz;
+        vec3 Position = GetWorldPosition(FragUV);
+        vec3 Normal = DecodeNormal(texture(gNormal, FragUV).xy);
         vec3 Albedo = texture(gAlbedo, FragUV).xyz;
-        float Metallic = texture(gMetallic, FragUV).r;
-        float Roughness = texture(gRoughness, FragUV).g;
-        float AO = texture(gAO, FragUV).r;        
+        vec3 MaterialParams = texture(gMaterial, FragUV).rgb;
+        float Metallic = MaterialParams.r;
+        float Roughness = MaterialParams.g;
+        float AO = MaterialParams.b;
 
-        vec3 N = normalize(Normal);
+        vec3 N = Normal;
         vec3 V = normalize(CameraPos - Position);        
 
         // calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
@@ -1018,8 +1283,7 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
         // scale light by NdotL
         float NdotL = max(dot(N, L), 0.0);        
 
-        vec4 FragPosLightSpace = LightSpaceMatrix * vec4(Position, 1.0);
-        float shadow = ShadowCalculation(FragPosLightSpace, Normal);
+        float shadow = ShadowCalculation(Position, Normal);
 
         // add to outgoing radiance Lo
         Lo += (kD / PI + specular) * radiance * NdotL;  // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
@@ -1056,21 +1320,112 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     smooth in vec2 FragUV;
 
-    uniform sampler2D gPosition;
+    uniform sampler2D gDepth;
+    // Octahedral encoded normal
     uniform sampler2D gNormal;
     uniform sampler2D gAlbedo;
-    uniform sampler2D gMetallic;
-    uniform sampler2D gRoughness;
-    uniform sampler2D gAO;
+    // r = metallic, g = roughness, b = ambient occlusion
+    uniform sampler2D gMaterial;
 
     uniform samplerCube SkyBox;	
  
-    uniform vec3 LightPosition;
-    uniform vec3 LightColour;
+    // Three texels per light: xyz = position, w = radius, then rgb = colour * intensity, then r = shadow slot (-1 for none)
+    uniform samplerBuffer LightData;
+    // Per cluster: x = offset into ClusterLightIndices, y = light count
+    uniform usamplerBuffer ClusterRanges;
+    uniform usamplerBuffer ClusterLightIndices;
+
+    uniform vec3 CameraForward;
+    uniform int ClusterTilesX;
+    uniform int ClusterTilesY;
+    uniform int ClusterSlices;
+    uniform float DepthSliceScale;
+    uniform float DepthSliceBias;
+
+    // Row of 6 cube face tiles per shadow slot (+X, -X, +Y, -Y, +Z, -Z)
+    uniform sampler2D PointShadowAtlas;
+    // Five texels per face: light space matrix columns, then xyz = light position, w = radius the face was drawn with
+    uniform samplerBuffer PointShadowData;
+
+    layout (std140) uniform FrameData
+    {
+        mat4 Camera;
+        vec3 CameraPos;
+        mat4 InvCamera;
+    };
 
-    uniform vec3 CameraPos;
+    vec3 GetWorldPosition(vec2 UV)
+    {
+        vec4 ClipPosition = vec4(UV, texture(gDepth, UV).r, 1.0) * 2.0 - 1.0;
+        vec4 WorldPosition = InvCamera * ClipPosition;
+        return WorldPosition.xyz / WorldPosition.w;
+    }
+
+    vec3 DecodeNormal(vec2 Encoded)
+    {
+        vec3 N = vec3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+        float T = clamp(-N.z, 0.0, 1.0);
+        N.x += N.x >= 0.0 ? -T : T;
+        N.y += N.y >= 0.0 ? -T : T;
+        return normalize(N);
+    }
     
     const float PI = 3.14159265359;
+
+    float PointShadowCalculation(int Slot, vec3 LightPosition, vec3 FragPos, vec3 FragNormal)
+    {
+        vec3 ToFrag = FragPos - LightPosition;
+        vec3 AbsToFrag = abs(ToFrag);
+
+        int Face;
+        if (AbsToFrag.x >= AbsToFrag.y && AbsToFrag.x >= AbsToFrag.z)
+        {
+            Face = ToFrag.x > 0.0 ? 0 : 1;
+        }
+        else if (AbsToFrag.y >= AbsToFrag.z)
+        {
+            Face = ToFrag.y > 0.0 ? 2 : 3;
+        }
+        else
+        {
+            Face = ToFrag.z > 0.0 ? 4 : 5;
+        }
+
+        int FaceTexel = (Slot * 6 + Face) * 5;
+
+        // Face hasn't been drawn yet
+        vec4 FaceLight = texelFetch(PointShadowData, FaceTexel + 4);
+        if (FaceLight.w <= 0.0)
+        {
+            return 0.0;
+        }
+
+        mat4 LightSpaceMatrix = mat4(
+            texelFetch(PointShadowData, FaceTexel),
+            texelFetch(PointShadowData, FaceTexel + 1),
+            texelFetch(PointShadowData, FaceTexel + 2),
+            texelFetch(PointShadowData, FaceTexel + 3));
+
+        vec2 AtlasSize = vec2(textureSize(PointShadowAtlas, 0));
+        float FaceSize = AtlasSize.x / 6.0;
+
+        // Push the sample out along the normal by about a texel (at that distance) to avoid acne
+        float TexelWorldSize = 2.0 * length(ToFrag) / FaceSize;
+        vec3 SamplePos = FragPos + FragNormal * TexelWorldSize;
+
+        vec4 LightSpacePos = LightSpaceMatrix * vec4(SamplePos, 1.0);
+        vec2 FaceUV = clamp(LightSpacePos.xy / LightSpacePos.w * 0.5 + 0.5, 0.0, 1.0);
+
+        // Keep the lookup inside this face's tile
+        vec2 TileMin = vec2(Face, Slot) * FaceSize;
+        vec2 AtlasTexel = clamp(TileMin + FaceUV * FaceSize, TileMin + 0.5, TileMin + FaceSize - 0.5);
+
+        float ClosestDepth = texture(PointShadowAtlas, AtlasTexel / AtlasSize).r;
+        float CurrentDepth = length(SamplePos - FaceLight.xyz) / FaceLight.w;
+
+        return CurrentDepth - 0.002 > ClosestDepth ? 1.0 : 0.0;
+    }
+
     // ----------------------------------------------------------------------------
     float DistributionGGX(vec3 N, vec3 H, float roughness)
     {
@@ -1115,14 +1470,15 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     void main()
     {
-        vec3 Position = texture(gPosition, FragUV).xyz;
-        vec3 Normal = texture(gNormal, FragUV).xyz;
+        vec3 Position = GetWorldPosition(FragUV);
+        vec3 Normal = DecodeNormal(texture(gNormal, FragUV).xy);
         vec3 Albedo = texture(gAlbedo, FragUV).xyz;
-        float Metallic = texture(gMetallic, FragUV).r;
-        float Roughness = texture(gRoughness, FragUV).g;
-        float AO = texture(gAO, FragUV).r;        
+        vec3 MaterialParams = texture(gMaterial, FragUV).rgb;
+        float Metallic = MaterialParams.r;
+        float Roughness = MaterialParams.g;
+        float AO = MaterialParams.b;
 
-        vec3 N = normalize(Normal);
+        vec3 N = Normal;
         vec3 V = normalize(CameraPos - Position);        
 
         // calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
@@ -1133,42 +1489,77 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
         // reflectance equation
         vec3 Lo = vec3(0.0);
 
-        // calculate per-light radiance
-        vec3 L = normalize(LightPosition - Position);
-        vec3 H = normalize(V + L);
-        float distance = length(LightPosition - Position);
-        float attenuation = 1.0 / (distance * distance);
-        //float linear = 0.001;
-        //float quadratic = 0.02;
-        //float attenuation = 1.0 / (1.0 + linear * distance + quadratic * distance * distance);
-        attenuation *= 20.0;
-        vec3 radiance = LightColour * attenuation;
+        // find which cluster this pixel is in
+        float ViewDepth = max(dot(Position - CameraPos, CameraForward), 0.0001);
+        int Slice = clamp(int(log(ViewDepth) * DepthSliceScale + DepthSliceBias), 0, ClusterSlices - 1);
+        ivec2 Tile = clamp(ivec2(FragUV * vec2(ClusterTilesX, ClusterTilesY)), ivec2(0), ivec2(ClusterTilesX - 1, ClusterTilesY - 1));
+        int Cluster = (Slice * ClusterTilesY + Tile.y) * ClusterTilesX + Tile.x;
 
-        // Cook-Torrance BRDF
-        float NDF = DistributionGGX(N, H, Roughness);   
-        float G   = GeometrySmith(N, V, L, Roughness);      
-        vec3 F    = fresnelSchlick(clamp(dot(H, V), 0.0, 1.0), F0);
-    
-        vec3 numerator    = NDF * G * F; 
-        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
-        vec3 specular = numerator / denominator;    
+        uvec2 ClusterRange = texelFetch(ClusterRanges, Cluster).xy;
 
-        // kS is equal to Fresnel
-        vec3 kS = F;
-        // for energy conservation, the diffuse and specular light can't
-        // be above 1.0 (unless the surface emits light); to preserve this
-        // relationship the diffuse component (kD) should equal 1.0 - kS.
-        vec3 kD = vec3(1.0) - kS;
-        // multiply kD by the inverse metalness such that only non-metals 
-        // have diffuse lighting, or a linear blend if partly metal (pure metals
-        // have no diffuse light).
-        kD *= 1.0 - Metallic;	  
+        for (uint i = 0u; i < ClusterRange.y; ++i)
+        {
+            int LightIndex = int(texelFetch(ClusterLightIndices, int(ClusterRange.x + i)).r);
 
-        // scale light by NdotL
-        float NdotL = max(dot(N, L), 0.0);        
+            vec4 LightPositionRadius = texelFetch(LightData, LightIndex * 3);
+            vec3 LightPosition = LightPositionRadius.xyz;
+            float LightRadius = LightPositionRadius.w;
+            vec3 LightColour = texelFetch(LightData, LightIndex * 3 + 1).rgb;
+            int ShadowSlot = int(texelFetch(LightData, LightIndex * 3 + 2).r);
 
-        // add to outgoing radiance Lo
-        Lo += (kD / PI + specular) * radiance * NdotL;  // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+            float distance = length(LightPosition - Position);
+            if (distance >= LightRadius)
+            {
+                continue;
+            }
+
+            // calculate per-light radiance
+            vec3 L = normalize(LightPosition - Position);
+            vec3 H = normalize(V + L);
+            float attenuation = 1.0 / (distance * distance);
+            //float linear = 0.001;
+            //float quadratic = 0.02;
+            //float attenuation = 1.0 / (1.0 + linear * distance + quadratic * distance * distance);
+            attenuation *= 20.0;
+
+            // window the falloff so it reaches zero at the light's radius instead of going on forever
+            float DistanceRatio = distance / LightRadius;
+            float Window = clamp(1.0 - DistanceRatio * DistanceRatio * DistanceRatio * DistanceRatio, 0.0, 1.0);
+            attenuation *= Window * Window;
+
+            if (ShadowSlot >= 0)
+            {
+                attenuation *= 1.0 - PointShadowCalculation(ShadowSlot, LightPosition, Position, N);
+            }
+
+            vec3 radiance = LightColour * attenuation;
+
+            // Cook-Torrance BRDF
+            float NDF = DistributionGGX(N, H, Roughness);   
+            float G   = GeometrySmith(N, V, L, Roughness);      
+            vec3 F    = fresnelSchlick(clamp(dot(H, V), 0.0, 1.0), F0);
+    
+            vec3 numerator    = NDF * G * F; 
+            float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
+            vec3 specular = numerator / denominator;    
+
+            // kS is equal to Fresnel
+            vec3 kS = F;
+            // for energy conservation, the diffuse and specular light can't
+            // be above 1.0 (unless the surface emits light); to preserve this
+            // relationship the diffuse component (kD) should equal 1.0 - kS.
+            vec3 kD = vec3(1.0) - kS;
+            // multiply kD by the inverse metalness such that only non-metals 
+            // have diffuse lighting, or a linear blend if partly metal (pure metals
+            // have no diffuse light).
+            kD *= 1.0 - Metallic;	  
+
+            // scale light by NdotL
+            float NdotL = max(dot(N, L), 0.0);        
+
+            // add to outgoing radiance Lo
+            Lo += (kD / PI + specular) * radiance * NdotL;  // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+        }
 
         //float randomTiny = 0.000001 * (Position.x + Normal.x + Albedo.x + Metallic + Roughness + AO + SunDirection.x + SunColour.r + CameraPos.x);
         
@@ -1202,28 +1593,49 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     out vec4 OutColour;
 
-    uniform sampler2D PositionTex;
+    uniform sampler2D DepthTex;
     uniform sampler2D NormalTex;
-    uniform sampler2D MetallicTex;
+    uniform sampler2D MaterialTex;
 
     uniform sampler2D UnlitTex;
     uniform sampler2D LightingTex;
     
     uniform samplerCube SkyBox;	
 
-    uniform vec3 CameraPos;
+    layout (std140) uniform FrameData
+    {
+        mat4 Camera;
+        vec3 CameraPos;
+        mat4 InvCamera;
+    };
+
+    vec3 GetWorldPosition(vec2 UV)
+    {
+        vec4 ClipPosition = vec4(UV, texture(DepthTex, UV).r, 1.0) * 2.0 - 1.0;
+        vec4 WorldPosition = InvCamera * ClipPosition;
+        return WorldPosition.xyz / WorldPosition.w;
+    }
+
+    vec3 DecodeNormal(vec2 Encoded)
+    {
+        vec3 N = vec3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+        float T = clamp(-N.z, 0.0, 1.0);
+        N.x += N.x >= 0.0 ? -T : T;
+        N.y += N.y >= 0.0 ? -T : T;
+        return normalize(N);
+    }
 
     void main()
     {
         vec3 BaseColour = texture(UnlitTex, FragUV).xyz;
         vec3 Light = texture(LightingTex, FragUV).xyz;
     
-        vec3 Position = texture(PositionTex, FragUV).xyz;
-        vec3 Normal = texture(NormalTex, FragUV).xyz;
-        float Metallic = texture(MetallicTex, FragUV).r;
+        vec3 Position = GetWorldPosition(FragUV);
+        vec3 Normal = DecodeNormal(texture(NormalTex, FragUV).xy);
+        float Metallic = texture(MaterialTex, FragUV).r;
 
         vec3 I = normalize(Position - CameraPos);
-        vec3 R = reflect(I, normalize(Normal));
+        vec3 R = reflect(I, Normal);
         vec3 reflectColour = texture(SkyBox, R).rgb * Metallic;
         vec3 ambient = max(reflectColour, vec3(0.15)) * BaseColour;
 
@@ -1293,13 +1705,12 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
     m_SkyboxCubemap = m_Renderer.LoadCubemap("asda");
     m_IsSkyboxSet = true;
 
-    m_ShadowBuffer = CreateFBuffer(Vec2i(8000, 8000), FBufferFormat::DEPTH);
+    m_ShadowAtlas = 0;
+    CreateShadowAtlas();
 
-    m_ShadowCamera = Camera(Projection::Orthographic);
-    m_ShadowCamera.SetScreenSize(Vec2f(100.0f, 100.0f));
-    m_ShadowCamera.SetNearPlane(0.0f);
-    m_ShadowCamera.SetFarPlane(100.0f);
-    m_ShadowCamera.SetPosition(Vec3f(0.0f, -30.0f, 6.0f));
+    m_PointShadowAtlas = 0;
+    m_PointShadowDataBuffer = m_Renderer.CreateBufferTexture(BufferTextureFormat::RGBA32F);
+    CreatePointShadowAtlas();
 
     VertexBufferFormat quadMeshFormat = VertexBufferFormat({ VertAttribute::Vec3f, VertAttribute::Vec3f, VertAttribute::Vec4f, VertAttribute::Vec2f });
     MeshData quadMeshData = GetVertexDataFor3DQuad();
@@ -1308,25 +1719,102 @@ GraphicsModule::GraphicsModule(Renderer& renderer)
 
     m_LightTexture = m_Renderer.LoadTexture("Assets/images/light.png", TextureMode::LINEAR, TextureMode::NEAREST);
 
-    s_Instance = this;
-}
+    m_FrameUniformBuffer = m_Renderer.CreateUniformBuffer(sizeof(FrameUniformData), FRAME_UNIFORM_BINDING);
 
-GraphicsModule::~GraphicsModule()
-{
-}
+    m_Renderer.BindShaderUniformBlock(m_GBufferShader, "FrameData", FRAME_UNIFORM_BINDING);
+    m_Renderer.BindShaderUniformBlock(m_GBufferInstancedShader, "FrameData", FRAME_UNIFORM_BINDING);
+    m_Renderer.BindShaderUniformBlock(m_GBufferDirectionalLightShader, "FrameData", FRAME_UNIFORM_BINDING);
+    m_Renderer.BindShaderUniformBlock(m_GBufferPointLightShader, "FrameData", FRAME_UNIFORM_BINDING);
+    m_Renderer.BindShaderUniformBlock(m_GBufferCombinerShader, "FrameData", FRAME_UNIFORM_BINDING);
 
-void GraphicsModule::Initialize()
-{
-    AssetRegistry* Registry = AssetRegistry::Get();
+    m_ShadowCascadeUniformBuffer = m_Renderer.CreateUniformBuffer(sizeof(ShadowCascadeUniformData), SHADOW_CASCADE_UNIFORM_BINDING);
 
-    m_DefaultNormalMap = *Registry->LoadTexture("Assets/textures/default_norm.png");
-    m_DefaultMetallicMap = *Registry->LoadTexture("Assets/textures/default_metallic.png");
-    m_DefaultRoughnessMap = *Registry->LoadTexture("Assets/textures/default_roughness.png");
-    m_DefaultAOMap = *Registry->LoadTexture("Assets/textures/default_ao.png");
-    m_DefaultHeightMap = *Registry->LoadTexture("Assets/textures/default_height.png");
+    m_Renderer.BindShaderUniformBlock(m_GBufferDirectionalLightShader, "ShadowCascadeData", SHADOW_CASCADE_UNIFORM_BINDING);
 
-    m_DebugMaterial = CreateMaterial(*Registry->LoadTexture("Assets/textures/debugTexture0.png"),
-        *Registry->LoadTexture("Assets/textures/debugTexture0.norm.png"));
+    m_TexturedMeshSamplers = GetMaterialSamplerHandles(m_TexturedMeshShader);
+    m_TexturedMeshTransformation = m_Renderer.GetUniformHandle(m_TexturedMeshShader, "Transformation");
+    m_TexturedMeshCamera = m_Renderer.GetUniformHandle(m_TexturedMeshShader, "Camera");
+    m_TexturedMeshCameraPos = m_Renderer.GetUniformHandle(m_TexturedMeshShader, "CameraPos");
+    m_TexturedMeshSunDirection = m_Renderer.GetUniformHandle(m_TexturedMeshShader, "SunDirection");
+    m_TexturedMeshSunColour = m_Renderer.GetUniformHandle(m_TexturedMeshShader, "SunColour");
+
+    m_GBufferInstancedSamplers = GetMaterialSamplerHandles(m_GBufferInstancedShader);
+
+    m_UnlitTransformation = m_Renderer.GetUniformHandle(m_UnlitShader, "Transformation");
+    m_UnlitAlbedoMap = m_Renderer.GetUniformHandle(m_UnlitShader, "AlbedoMap");
+    m_UnlitCamera = m_Renderer.GetUniformHandle(m_UnlitShader, "Camera");
+
+    m_SkyboxProjection = m_Renderer.GetUniformHandle(m_SkyboxShader, "projection");
+    m_SkyboxView = m_Renderer.GetUniformHandle(m_SkyboxShader, "view");
+    m_SkyboxCubemapSampler = m_Renderer.GetUniformHandle(m_SkyboxShader, "SkyBox");
+
+    m_DebugLineCamera = m_Renderer.GetUniformHandle(m_DebugLineShader, "Camera");
+
+    m_CombinerDepth = m_Renderer.GetUniformHandle(m_GBufferCombinerShader, "DepthTex");
+    m_CombinerNormal = m_Renderer.GetUniformHandle(m_GBufferCombinerShader, "NormalTex");
+    m_CombinerMaterial = m_Renderer.GetUniformHandle(m_GBufferCombinerShader, "MaterialTex");
+    m_CombinerUnlit = m_Renderer.GetUniformHandle(m_GBufferCombinerShader, "UnlitTex");
+    m_CombinerLighting = m_Renderer.GetUniformHandle(m_GBufferCombinerShader, "LightingTex");
+    m_CombinerSkyBox = m_Renderer.GetUniformHandle(m_GBufferCombinerShader, "SkyBox");
+
+    m_GBufferSkySampler = m_Renderer.GetUniformHandle(m_GBufferSkyShader, "gSky");
+    m_GBufferDebugSampler = m_Renderer.GetUniformHandle(m_GBufferDebugShader, "gDebug");
+
+    m_ShadowLightSpaceMatrix = m_Renderer.GetUniformHandle(m_ShadowInstancedShader, "LightSpaceMatrix");
+
+    m_DirectionalLightSamplers = GetGBufferSamplerHandles(m_GBufferDirectionalLightShader);
+    m_DirectionalLightShadowMap = m_Renderer.GetUniformHandle(m_GBufferDirectionalLightShader, "ShadowMap");
+    m_DirectionalLightSunDirection = m_Renderer.GetUniformHandle(m_GBufferDirectionalLightShader, "SunDirection");
+    m_DirectionalLightSunColour = m_Renderer.GetUniformHandle(m_GBufferDirectionalLightShader, "SunColour");
+
+    m_PointLightSamplers = GetGBufferSamplerHandles(m_GBufferPointLightShader);
+    m_PointLightData = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "LightData");
+    m_PointLightClusterRanges = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "ClusterRanges");
+    m_PointLightClusterIndices = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "ClusterLightIndices");
+    m_PointLightCameraForward = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "CameraForward");
+    m_PointLightClusterTilesX = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "ClusterTilesX");
+    m_PointLightClusterTilesY = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "ClusterTilesY");
+    m_PointLightClusterSlices = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "ClusterSlices");
+    m_PointLightDepthSliceScale = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "DepthSliceScale");
+    m_PointLightDepthSliceBias = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "DepthSliceBias");
+    m_PointLightShadowAtlas = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "PointShadowAtlas");
+    m_PointLightShadowData = m_Renderer.GetUniformHandle(m_GBufferPointLightShader, "PointShadowData");
+
+    m_PointShadowLightSpaceMatrix = m_Renderer.GetUniformHandle(m_PointShadowShader, "LightSpaceMatrix");
+    m_PointShadowLightPosition = m_Renderer.GetUniformHandle(m_PointShadowShader, "LightPosition");
+    m_PointShadowLightRadius = m_Renderer.GetUniformHandle(m_PointShadowShader, "LightRadius");
+
+    m_PointLightDataBuffer = m_Renderer.CreateBufferTexture(BufferTextureFormat::RGBA32F);
+    m_ClusterRangeBuffer = m_Renderer.CreateBufferTexture(BufferTextureFormat::RG32UI);
+    m_ClusterLightIndexBuffer = m_Renderer.CreateBufferTexture(BufferTextureFormat::R32UI);
+
+    for (size_t Frame = 0; Frame < GPU_TIMER_FRAMES; ++Frame)
+    {
+        for (int Pass = 0; Pass < (int)RenderPass::COUNT; ++Pass)
+        {
+            m_PassTimers[Frame][Pass] = m_Renderer.CreateTimerQuery();
+        }
+    }
+
+    s_Instance = this;
+}
+
+GraphicsModule::~GraphicsModule()
+{
+}
+
+void GraphicsModule::Initialize()
+{
+    AssetRegistry* Registry = AssetRegistry::Get();
+
+    m_DefaultNormalMap = *Registry->LoadTexture("Assets/textures/default_norm.png");
+    m_DefaultMetallicMap = *Registry->LoadTexture("Assets/textures/default_metallic.png");
+    m_DefaultRoughnessMap = *Registry->LoadTexture("Assets/textures/default_roughness.png");
+    m_DefaultAOMap = *Registry->LoadTexture("Assets/textures/default_ao.png");
+    m_DefaultHeightMap = *Registry->LoadTexture("Assets/textures/default_height.png");
+
+    m_DebugMaterial = CreateMaterial(*Registry->LoadTexture("Assets/textures/debugTexture0.png"),
+        *Registry->LoadTexture("Assets/textures/debugTexture0.norm.png"));
 }
 
 GBuffer GraphicsModule::CreateGBuffer(Vec2i Size)
@@ -1334,21 +1822,20 @@ GBuffer GraphicsModule::CreateGBuffer(Vec2i Size)
     GBuffer newGBuffer;
 
     newGBuffer.Buffer = m_Renderer.CreateFrameBuffer(Size, FBufferFormat::EMPTY);
-    newGBuffer.PositionTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 0);
-    newGBuffer.NormalTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 1);
-    newGBuffer.AlbedoTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 2);
-    newGBuffer.MetallicTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 3);
-    newGBuffer.RoughnessTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 4);
-    newGBuffer.AOTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 5);
+    newGBuffer.DepthTex = m_Renderer.AttachDepthTextureToFrameBuffer(newGBuffer.Buffer);
+    newGBuffer.NormalTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RG, ColourFormat::RG, DataFormat::HALF_FLOAT), 0);
+    newGBuffer.AlbedoTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::UNSIGNED_BYTE), 1);
+    newGBuffer.MaterialTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.Buffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::UNSIGNED_BYTE), 2);
 
+    // Sky and debug draws are plain LDR colour, lighting accumulates so it keeps some range
     newGBuffer.SkyBuffer = m_Renderer.CreateFBufferWithExistingDepthBuffer(newGBuffer.Buffer, Size, FBufferFormat::EMPTY);
-    newGBuffer.SkyTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.SkyBuffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 0);
+    newGBuffer.SkyTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.SkyBuffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::UNSIGNED_BYTE), 0);
 
     newGBuffer.LightBuffer = m_Renderer.CreateFrameBuffer(Size, FBufferFormat::EMPTY);
-    newGBuffer.LightTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.LightBuffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 0);
+    newGBuffer.LightTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.LightBuffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::HALF_FLOAT), 0);
 
     newGBuffer.DebugBuffer = m_Renderer.CreateFBufferWithExistingDepthBuffer(newGBuffer.Buffer, Size, FBufferFormat::EMPTY);
-    newGBuffer.DebugTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.DebugBuffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::FLOAT), 0);
+    newGBuffer.DebugTex = m_Renderer.AttachColourAttachmentToFrameBuffer(newGBuffer.DebugBuffer, TextureCreateInfo(Size, ColourFormat::RGBA, ColourFormat::RGBA, DataFormat::UNSIGNED_BYTE), 0);
 
     newGBuffer.FinalOutput = m_Renderer.CreateFrameBuffer(Size, FBufferFormat::COLOUR);
 
@@ -1364,12 +1851,10 @@ void GraphicsModule::DeleteGBuffer(GBuffer& GBuf)
 {
     DeleteFBuffer(GBuf.Buffer);
 
-    DeleteTexture(GBuf.PositionTex);
+    DeleteTexture(GBuf.DepthTex);
     DeleteTexture(GBuf.NormalTex);
     DeleteTexture(GBuf.AlbedoTex);
-    DeleteTexture(GBuf.MetallicTex);
-    DeleteTexture(GBuf.RoughnessTex);
-    DeleteTexture(GBuf.AOTex);
+    DeleteTexture(GBuf.MaterialTex);
 
     DeleteFBuffer(GBuf.SkyBuffer);
     DeleteTexture(GBuf.SkyTex);
@@ -1389,6 +1874,11 @@ void GraphicsModule::AddRenderCommand(StaticMeshRenderCommand Command)
     m_StaticMeshRenderCommands.push_back(Command);
 }
 
+void GraphicsModule::AddRenderCommands(const std::vector<StaticMeshRenderCommand>& Commands)
+{
+    m_StaticMeshRenderCommands.insert(m_StaticMeshRenderCommands.end(), Commands.begin(), Commands.end());
+}
+
 void GraphicsModule::AddRenderCommand(BillboardRenderCommand Command)
 {
     m_BillboardRenderCommands.push_back(Command);
@@ -1401,107 +1891,145 @@ void GraphicsModule::AddRenderCommand(PointLightRenderCommand Command)
 
 void GraphicsModule::Render(GBuffer Buffer, Camera Cam, DirectionalLight DirLight)
 {
+    PROFILE_SCOPE("GraphicsModule::Render");
+
+    PROFILE_COUNTER("Static mesh commands", m_StaticMeshRenderCommands.size());
+    PROFILE_COUNTER("Point lights", m_PointLightRenderCommands.size());
+
+    ResolvePassTimers();
+
+    // G-Buffer
     m_Renderer.SetActiveFBuffer(Buffer.Buffer);
+    {
+        PROFILE_SCOPE("Render::GBuffer");
+        ScopedPassTimer PassTimer(*this, RenderPass::GBUFFER);
 
-    m_Renderer.DisableStencilTesting();
+        m_Renderer.DisableStencilTesting();
 
-    m_Renderer.SetActiveShader(m_GBufferShader);
-    m_Renderer.ClearScreenAndDepthBuffer();
+        m_Renderer.SetActiveShader(m_GBufferInstancedShader);
+        m_Renderer.ClearScreenAndDepthBuffer();
 
-    m_Renderer.SetShaderUniformMat4x4f(m_GBufferShader, "Camera", Cam.GetCamMatrix());
-    m_Renderer.SetShaderUniformVec3f(m_GBufferShader, "CameraPos", Cam.GetPosition());
+        FrameUniformData FrameData;
+        FrameData.Camera = Cam.GetCamMatrix();
+        FrameData.CameraPos = Cam.GetPosition();
+        FrameData.InvCamera = Cam.GetInvCamMatrix();
 
-    for (StaticMeshRenderCommand& Command : m_StaticMeshRenderCommands)
-    {
-        m_Renderer.SetShaderUniformMat4x4f(m_GBufferShader, "Transformation", Command.m_TransMat);
+        m_Renderer.UpdateUniformBuffer(m_FrameUniformBuffer, &FrameData, sizeof(FrameUniformData));
 
-        m_Renderer.SetActiveTexture(Command.m_Material.m_Albedo.Id, "AlbedoMap");
-        m_Renderer.SetActiveTexture(Command.m_Material.m_Normal.Id, "NormalMap");
-        m_Renderer.SetActiveTexture(Command.m_Material.m_Metallic.Id, "MetallicMap");
-        m_Renderer.SetActiveTexture(Command.m_Material.m_Roughness.Id, "RoughnessMap");
-        m_Renderer.SetActiveTexture(Command.m_Material.m_AO.Id, "AOMap");
+        SortStaticMeshRenderCommands();
 
-        m_Renderer.DrawMesh(Command.m_Mesh);
+        // Every run of commands with the same mesh and material gets drawn with one instanced draw
+        for (size_t RunStart = 0; RunStart < m_SortedStaticMeshRenderCommands.size();)
+        {
+            StaticMeshRenderCommand* First = m_SortedStaticMeshRenderCommands[RunStart];
+
+            m_InstanceTransforms.clear();
+
+            size_t RunEnd = RunStart;
+            while (RunEnd < m_SortedStaticMeshRenderCommands.size()
+                && m_SortedStaticMeshRenderCommands[RunEnd]->m_Mesh == First->m_Mesh
+                && m_SortedStaticMeshRenderCommands[RunEnd]->m_Material == First->m_Material)
+            {
+                m_InstanceTransforms.push_back(m_SortedStaticMeshRenderCommands[RunEnd]->m_TransMat);
+                RunEnd++;
+            }
+
+            SetActiveMaterial(First->m_Material, m_GBufferInstancedSamplers);
+
+            m_Renderer.DrawMeshInstanced(First->m_Mesh, m_InstanceTransforms);
+
+            RunStart = RunEnd;
+        }
     }
 
     // TEMP: skybox code blech
 
     m_Renderer.SetActiveFBuffer(Buffer.SkyBuffer);
-    m_Renderer.SetActiveShader(m_SkyboxShader);
-    m_Renderer.ClearColourBuffer();
+    {
+        PROFILE_SCOPE("Render::Sky");
+        ScopedPassTimer PassTimer(*this, RenderPass::SKY);
 
-    m_Renderer.SetShaderUniformMat4x4f(m_SkyboxShader, "projection", Cam.GetProjectionMatrix());
+        m_Renderer.SetActiveShader(m_SkyboxShader);
+        m_Renderer.ClearColourBuffer();
 
-    Mat4x4f newView = Cam.GetViewMatrix();
+        m_Renderer.SetShaderUniformMat4x4f(m_SkyboxProjection, Cam.GetProjectionMatrix());
 
-    newView[3][0] = 0.0f;
-    newView[3][1] = 0.0f;
-    newView[3][2] = 0.0f;
-    newView[3][3] = 1.0f;
+        Mat4x4f newView = Cam.GetViewMatrix();
 
-    newView[0][3] = 0.0f;
-    newView[1][3] = 0.0f;
-    newView[2][3] = 0.0f;
+        newView[3][0] = 0.0f;
+        newView[3][1] = 0.0f;
+        newView[3][2] = 0.0f;
+        newView[3][3] = 1.0f;
 
-    m_Renderer.SetShaderUniformMat4x4f(m_SkyboxShader, "view", newView);
+        newView[0][3] = 0.0f;
+        newView[1][3] = 0.0f;
+        newView[2][3] = 0.0f;
 
-    m_Renderer.SetActiveCubemap(m_SkyboxCubemap, "SkyBox");
+        m_Renderer.SetShaderUniformMat4x4f(m_SkyboxView, newView);
+
+        m_Renderer.SetActiveCubemap(m_SkyboxCubemap, m_SkyboxCubemapSampler);
     
-    m_Renderer.DrawMesh(m_SkyboxMesh);
+        m_Renderer.DrawMesh(m_SkyboxMesh);
+    }
 
     // Temp skybox code end
 
     // Debug draw
     m_Renderer.SetActiveFBuffer(Buffer.DebugBuffer);
-    m_Renderer.ClearColourBuffer();
-    DrawDebugDrawMesh(Cam);
+    {
+        PROFILE_SCOPE("Render::Debug");
+        ScopedPassTimer PassTimer(*this, RenderPass::DEBUG);
 
-    // Billboards draw (also to debug buffer)
+        m_Renderer.ClearColourBuffer();
+        DrawDebugDrawMesh(Cam);
 
-    m_Renderer.SetActiveShader(m_UnlitShader);
-    m_Renderer.SetShaderUniformMat4x4f(m_UnlitShader, "Camera", Cam.GetCamMatrix());
+        // Billboards draw (also to debug buffer)
 
-    for (BillboardRenderCommand& Command : m_BillboardRenderCommands)
-    {
-        Mat4x4f BillboardMatrix;
+        m_Renderer.SetActiveShader(m_UnlitShader);
+        m_Renderer.SetShaderUniformMat4x4f(m_UnlitCamera, Cam.GetCamMatrix());
+
+        for (BillboardRenderCommand& Command : m_BillboardRenderCommands)
+        {
+            Mat4x4f BillboardMatrix;
 
-        Vec3f CamToBill = Math::normalize(Cam.GetPosition() - Command.m_Position);
+            Vec3f CamToBill = Math::normalize(Cam.GetPosition() - Command.m_Position);
 
-        Vec3f CrossBill = Cam.GetUp();
+            Vec3f CrossBill = Cam.GetUp();
 
-        Vec3f BillDir = CamToBill;
-        Vec3f BillUp = Cam.GetUp();
+            Vec3f BillDir = CamToBill;
+            Vec3f BillUp = Cam.GetUp();
 
-        //Vec3f BillUp = Math::cross(BillDir, Cam.GetPerpVector());
+            //Vec3f BillUp = Math::cross(BillDir, Cam.GetPerpVector());
 
-        Vec3f xAxis = Math::cross(BillUp, BillDir);
-        xAxis = Math::normalize(xAxis);
+            Vec3f xAxis = Math::cross(BillUp, BillDir);
+            xAxis = Math::normalize(xAxis);
 
-        Vec3f yAxis = Math::cross(BillDir, xAxis);
-        yAxis = Math::normalize(yAxis);
+            Vec3f yAxis = Math::cross(BillDir, xAxis);
+            yAxis = Math::normalize(yAxis);
 
-        BillboardMatrix[0][0] = xAxis.x;
-        BillboardMatrix[1][0] = yAxis.x;
-        BillboardMatrix[2][0] = BillDir.x;
+            BillboardMatrix[0][0] = xAxis.x;
+            BillboardMatrix[1][0] = yAxis.x;
+            BillboardMatrix[2][0] = BillDir.x;
 
-        BillboardMatrix[0][1] = xAxis.y;
-        BillboardMatrix[1][1] = yAxis.y;
-        BillboardMatrix[2][1] = BillDir.y;
+            BillboardMatrix[0][1] = xAxis.y;
+            BillboardMatrix[1][1] = yAxis.y;
+            BillboardMatrix[2][1] = BillDir.y;
 
-        BillboardMatrix[0][2] = xAxis.z;
-        BillboardMatrix[1][2] = yAxis.z;
-        BillboardMatrix[2][2] = BillDir.z;
+            BillboardMatrix[0][2] = xAxis.z;
+            BillboardMatrix[1][2] = yAxis.z;
+            BillboardMatrix[2][2] = BillDir.z;
 
-        Transform BillboardTransform;
-        BillboardTransform.SetTransformMatrix(BillboardMatrix);
-        BillboardTransform.SetPosition(Command.m_Position);
-        BillboardTransform.SetScale(Vec3f(Command.m_Size, Command.m_Size, Command.m_Size));
+            Transform BillboardTransform;
+            BillboardTransform.SetTransformMatrix(BillboardMatrix);
+            BillboardTransform.SetPosition(Command.m_Position);
+            BillboardTransform.SetScale(Vec3f(Command.m_Size, Command.m_Size, Command.m_Size));
 
-        m_Renderer.SetShaderUniformMat4x4f(m_UnlitShader, "Transformation", BillboardTransform.GetTransformMatrix());
-        m_Renderer.SetActiveTexture(Command.m_Texture, "AlbedoMap");
+            m_Renderer.SetShaderUniformMat4x4f(m_UnlitTransformation, BillboardTransform.GetTransformMatrix());
+            m_Renderer.SetActiveTexture(Command.m_Texture, m_UnlitAlbedoMap);
 
-        m_Renderer.SetMeshColour(m_BillboardQuadMesh, Vec4f(Command.m_Colour.x, Command.m_Colour.y, Command.m_Colour.z, 1.0f));
-        m_Renderer.DrawMesh(m_BillboardQuadMesh);
+            m_Renderer.SetMeshColour(m_BillboardQuadMesh, Vec4f(Command.m_Colour.x, Command.m_Colour.y, Command.m_Colour.z, 1.0f));
+            m_Renderer.DrawMesh(m_BillboardQuadMesh);
+        }
     }
 
     // ~~~~~~~ Render lights ~~~~~~~
@@ -1512,66 +2040,109 @@ void GraphicsModule::Render(GBuffer Buffer, Camera Cam, DirectionalLight DirLigh
 
         // Loop through directional lights here
         
-        // Create directional light shadow map
-        m_ShadowCamera.SetPosition(Cam.GetPosition() + (-m_ShadowCamera.GetDirection() * 40.0f));
-        m_ShadowCamera.SetDirection(DirLight.direction);
-        
-        m_Renderer.SetActiveShader(m_ShadowShader);
-        SetActiveFrameBuffer(m_ShadowBuffer);
-        //m_Renderer.ClearScreenAndDepthBuffer();
+        // Create directional light shadow cascades
+        UpdateShadowCascades(Cam, DirLight.direction);
+
+        m_Renderer.SetActiveShader(m_ShadowInstancedShader);
+        SetActiveFrameBuffer(m_ShadowAtlas);
         {
-            m_Renderer.SetShaderUniformMat4x4f(m_ShadowShader, "LightSpaceMatrix", m_ShadowCamera.GetCamMatrix());
+            PROFILE_SCOPE("Render::DirectionalShadows");
+            ScopedPassTimer PassTimer(*this, RenderPass::DIRECTIONAL_SHADOWS);
 
-            for (StaticMeshRenderCommand& Command : m_StaticMeshRenderCommands)
+            GatherShadowCasters();
+
+            int Resolution = m_ShadowCascadeSettings.Resolution;
+
+            for (int CascadeIndex = 0; CascadeIndex < m_ShadowCascadeSettings.CascadeCount; ++CascadeIndex)
             {
-                // Set mesh-specific transform uniform
-                m_Renderer.SetShaderUniformMat4x4f(m_ShadowShader, "Transformation", Command.m_TransMat);
+                ShadowCascade& Cascade = m_ShadowCascades[CascadeIndex];
 
-                // Draw mesh to shadow map
-                m_Renderer.DrawMesh(Command.m_Mesh);
+                m_Renderer.SetViewport(Recti(Vec2i(CascadeIndex * Resolution, 0), Vec2i((CascadeIndex + 1) * Resolution, Resolution)));
+                m_Renderer.SetShaderUniformMat4x4f(m_ShadowLightSpaceMatrix, Cascade.LightSpaceMatrix);
+
+                // Material doesn't matter for the shadow map, so batch every caster sharing a mesh
+                // (casters are still sorted by mesh from the GBuffer pass)
+                for (size_t RunStart = 0; RunStart < m_ShadowCasters.size();)
+                {
+                    StaticMesh_ID Mesh = m_ShadowCasters[RunStart]->m_Mesh;
+
+                    m_InstanceTransforms.clear();
+
+                    size_t RunEnd = RunStart;
+                    while (RunEnd < m_ShadowCasters.size()
+                        && m_ShadowCasters[RunEnd]->m_Mesh == Mesh)
+                    {
+                        const Sphere& Bounds = m_ShadowCasterBounds[RunEnd];
+                        if (Bounds.radius < 0.0f || IsShadowCasterInCascade(Cascade, Bounds))
+                        {
+                            m_InstanceTransforms.push_back(m_ShadowCasters[RunEnd]->m_TransMat);
+                        }
+                        RunEnd++;
+                    }
+
+                    // Draw meshes to this cascade's tile of the shadow atlas
+                    if (!m_InstanceTransforms.empty())
+                    {
+                        m_Renderer.DrawMeshInstanced(Mesh, m_InstanceTransforms);
+                    }
+
+                    RunStart = RunEnd;
+                }
             }
         }
 
-        m_Renderer.SetActiveShader(m_GBufferDirectionalLightShader);
+        // Point light shadows, only the faces that are out of date get redrawn
+        if (!m_PointLightRenderCommands.empty())
+        {
+            PROFILE_SCOPE("Render::PointShadows");
+            ScopedPassTimer PassTimer(*this, RenderPass::POINT_SHADOWS);
+
+            UpdatePointShadows(Cam);
+        }
+
         m_Renderer.SetActiveFBuffer(Buffer.LightBuffer);
-        m_Renderer.ClearScreenAndDepthBuffer();
+        {
+            PROFILE_SCOPE("Render::DirectionalLight");
+            ScopedPassTimer PassTimer(*this, RenderPass::DIRECTIONAL_LIGHT);
 
-        m_Renderer.SetShaderUniformVec3f(m_GBufferDirectionalLightShader, "CameraPos", Cam.GetPosition());
+            m_Renderer.SetActiveShader(m_GBufferDirectionalLightShader);
+            m_Renderer.ClearScreenAndDepthBuffer();
 
-        m_Renderer.SetActiveTexture(Buffer.PositionTex, "gPosition");
-        m_Renderer.SetActiveTexture(Buffer.NormalTex, "gNormal");
-        m_Renderer.SetActiveTexture(Buffer.AlbedoTex, "gAlbedo");
-        m_Renderer.SetActiveTexture(Buffer.MetallicTex, "gMetallic");
-        m_Renderer.SetActiveTexture(Buffer.RoughnessTex, "gRoughness");
-        m_Renderer.SetActiveTexture(Buffer.AOTex, "gAO");
+            SetActiveGBufferTextures(Buffer, m_DirectionalLightSamplers);
 
-        m_Renderer.SetActiveFBufferTexture(m_ShadowBuffer, "ShadowMap");
-        m_Renderer.SetShaderUniformMat4x4f(m_GBufferDirectionalLightShader, "LightSpaceMatrix", m_ShadowCamera.GetCamMatrix());
+            m_Renderer.SetActiveFBufferTexture(m_ShadowAtlas, m_DirectionalLightShadowMap);
 
-        m_Renderer.SetShaderUniformVec3f(m_GBufferDirectionalLightShader, "SunDirection", DirLight.direction);
-        m_Renderer.SetShaderUniformVec3f(m_GBufferDirectionalLightShader, "SunColour", DirLight.colour);
+            m_Renderer.SetShaderUniformVec3f(m_DirectionalLightSunDirection, DirLight.direction);
+            m_Renderer.SetShaderUniformVec3f(m_DirectionalLightSunColour, DirLight.colour);
 
-        m_Renderer.DrawMesh(Buffer.QuadMesh);
+            m_Renderer.DrawMesh(Buffer.QuadMesh);
+        }
 
-        // Point lights
-        m_Renderer.SetActiveShader(m_GBufferPointLightShader);
+        // Point lights, all of them in one pass with each pixel only looking at the lights in its cluster
+        if (!m_PointLightRenderCommands.empty())
+        {
+            PROFILE_SCOPE("Render::PointLights");
+            ScopedPassTimer PassTimer(*this, RenderPass::POINT_LIGHTS);
 
-        m_Renderer.SetShaderUniformVec3f(m_GBufferPointLightShader, "CameraPos", Cam.GetPosition());
+            BuildLightClusters(Cam);
 
-        // Needed?
-        m_Renderer.SetActiveTexture(Buffer.PositionTex, "gPosition");
-        m_Renderer.SetActiveTexture(Buffer.NormalTex, "gNormal");
-        m_Renderer.SetActiveTexture(Buffer.AlbedoTex, "gAlbedo");
-        m_Renderer.SetActiveTexture(Buffer.MetallicTex, "gMetallic");
-        m_Renderer.SetActiveTexture(Buffer.RoughnessTex, "gRoughness");
-        m_Renderer.SetActiveTexture(Buffer.AOTex, "gAO");
+            m_Renderer.SetActiveShader(m_GBufferPointLightShader);
 
-        // Loop through point lights here
+            SetActiveGBufferTextures(Buffer, m_PointLightSamplers);
 
-        for (PointLightRenderCommand& Command : m_PointLightRenderCommands)
-        {
-            m_Renderer.SetShaderUniformVec3f(m_GBufferPointLightShader, "LightPosition", Command.m_Position);
-            m_Renderer.SetShaderUniformVec3f(m_GBufferPointLightShader, "LightColour", Command.m_Colour * Command.m_Intensity);
+            m_Renderer.SetActiveBufferTexture(m_PointLightDataBuffer, m_PointLightData);
+            m_Renderer.SetActiveBufferTexture(m_ClusterRangeBuffer, m_PointLightClusterRanges);
+            m_Renderer.SetActiveBufferTexture(m_ClusterLightIndexBuffer, m_PointLightClusterIndices);
+
+            m_Renderer.SetActiveFBufferTexture(m_PointShadowAtlas, m_PointLightShadowAtlas);
+            m_Renderer.SetActiveBufferTexture(m_PointShadowDataBuffer, m_PointLightShadowData);
+
+            m_Renderer.SetShaderUniformVec3f(m_PointLightCameraForward, Math::normalize(Cam.GetDirection()));
+            m_Renderer.SetShaderUniformInt(m_PointLightClusterTilesX, m_LightClusters.TilesX);
+            m_Renderer.SetShaderUniformInt(m_PointLightClusterTilesY, m_LightClusters.TilesY);
+            m_Renderer.SetShaderUniformInt(m_PointLightClusterSlices, m_LightClusters.Slices);
+            m_Renderer.SetShaderUniformFloat(m_PointLightDepthSliceScale, m_LightClusters.DepthSliceScale);
+            m_Renderer.SetShaderUniformFloat(m_PointLightDepthSliceBias, m_LightClusters.DepthSliceBias);
 
             m_Renderer.DrawMesh(Buffer.QuadMesh);
         }
@@ -1582,19 +2153,20 @@ void GraphicsModule::Render(GBuffer Buffer, Camera Cam, DirectionalLight DirLigh
     // Combine everything
     m_Renderer.SetActiveFBuffer(Buffer.FinalOutput);
     {
+        PROFILE_SCOPE("Render::Combine");
+        ScopedPassTimer PassTimer(*this, RenderPass::COMBINE);
+
         m_Renderer.SetActiveShader(m_GBufferCombinerShader);
         m_Renderer.ClearScreenAndDepthBuffer();
 
-        m_Renderer.SetShaderUniformVec3f(m_GBufferCombinerShader, "CameraPos", Cam.GetPosition());
-        
-        m_Renderer.SetActiveTexture(Buffer.PositionTex, "PositionTex");
-        m_Renderer.SetActiveTexture(Buffer.NormalTex, "NormalTex");
-        m_Renderer.SetActiveTexture(Buffer.MetallicTex, "MetallicTex");
+        m_Renderer.SetActiveTexture(Buffer.DepthTex, m_CombinerDepth);
+        m_Renderer.SetActiveTexture(Buffer.NormalTex, m_CombinerNormal);
+        m_Renderer.SetActiveTexture(Buffer.MaterialTex, m_CombinerMaterial);
         
-        m_Renderer.SetActiveTexture(Buffer.AlbedoTex, "UnlitTex");
-        m_Renderer.SetActiveTexture(Buffer.LightTex, "LightingTex");
+        m_Renderer.SetActiveTexture(Buffer.AlbedoTex, m_CombinerUnlit);
+        m_Renderer.SetActiveTexture(Buffer.LightTex, m_CombinerLighting);
 
-        m_Renderer.SetActiveCubemap(m_SkyboxCubemap, "SkyBox");
+        m_Renderer.SetActiveCubemap(m_SkyboxCubemap, m_CombinerSkyBox);
 
         m_Renderer.DrawMesh(Buffer.QuadMesh);
 
@@ -1602,13 +2174,13 @@ void GraphicsModule::Render(GBuffer Buffer, Camera Cam, DirectionalLight DirLigh
         m_Renderer.DisableDepthTesting();
         m_Renderer.SetActiveShader(m_GBufferSkyShader);
 
-        m_Renderer.SetActiveTexture(Buffer.SkyTex, "gSky");
+        m_Renderer.SetActiveTexture(Buffer.SkyTex, m_GBufferSkySampler);
         m_Renderer.DrawMesh(Buffer.QuadMesh);
         
         // Debug stuff
         m_Renderer.SetActiveShader(m_GBufferDebugShader);
 
-        m_Renderer.SetActiveTexture(Buffer.DebugTex, "gDebug");
+        m_Renderer.SetActiveTexture(Buffer.DebugTex, m_GBufferDebugSampler);
         m_Renderer.DrawMesh(Buffer.QuadMesh);
         
         m_Renderer.EnableDepthTesting();
@@ -1616,12 +2188,185 @@ void GraphicsModule::Render(GBuffer Buffer, Camera Cam, DirectionalLight DirLigh
     }
 
     m_StaticMeshRenderCommands.clear();
+    m_SortedStaticMeshRenderCommands.clear();
     m_BillboardRenderCommands.clear();
     m_PointLightRenderCommands.clear();
 
     m_Renderer.EnableStencilTesting();
 }
 
+const RenderStats& GraphicsModule::GetRenderStats() const
+{
+    return m_RenderStats;
+}
+
+const char* GraphicsModule::GetRenderPassName(RenderPass Pass)
+{
+    switch (Pass)
+    {
+    case RenderPass::GBUFFER: return "GBuffer";
+    case RenderPass::SKY: return "Sky";
+    case RenderPass::DEBUG: return "Debug";
+    case RenderPass::DIRECTIONAL_SHADOWS: return "Directional Shadows";
+    case RenderPass::POINT_SHADOWS: return "Point Shadows";
+    case RenderPass::DIRECTIONAL_LIGHT: return "Directional Light";
+    case RenderPass::POINT_LIGHTS: return "Point Lights";
+    case RenderPass::COMBINE: return "Combine";
+    default: return "Unknown";
+    }
+}
+
+GraphicsModule::ScopedPassTimer::ScopedPassTimer(GraphicsModule& Graphics, RenderPass Pass)
+    : m_Graphics(Graphics)
+    , m_Pass(Pass)
+{
+    m_Graphics.m_Renderer.BeginTimerQuery(m_Graphics.m_PassTimers[m_Graphics.m_PassTimerFrame][(int)m_Pass]);
+}
+
+GraphicsModule::ScopedPassTimer::~ScopedPassTimer()
+{
+    m_Graphics.m_Renderer.EndTimerQuery(m_Graphics.m_PassTimers[m_Graphics.m_PassTimerFrame][(int)m_Pass]);
+    m_Graphics.m_PassTimerIssued[m_Graphics.m_PassTimerFrame][(int)m_Pass] = true;
+}
+
+void GraphicsModule::ResolvePassTimers()
+{
+    m_PassTimerFrame = (m_PassTimerFrame + 1) % GPU_TIMER_FRAMES;
+
+    bool* Issued = m_PassTimerIssued[m_PassTimerFrame];
+
+    // Anything issued into this frame's queries was issued GPU_TIMER_FRAMES renders ago,
+    // if the GPU still isn't done with it keep the last stats rather than wait.
+    // Nothing is marked as read until every pass has its result, so the passes can't get out of step
+    uint64_t Nanoseconds[(int)RenderPass::COUNT] = {};
+    for (int Pass = 0; Pass < (int)RenderPass::COUNT; ++Pass)
+    {
+        if (Issued[Pass] && !m_Renderer.GetTimerQueryResult(m_PassTimers[m_PassTimerFrame][Pass], Nanoseconds[Pass]))
+        {
+            return;
+        }
+    }
+
+    m_RenderStats.TotalMilliseconds = 0.0f;
+    for (int Pass = 0; Pass < (int)RenderPass::COUNT; ++Pass)
+    {
+        m_RenderStats.PassMilliseconds[Pass] = (float)((double)Nanoseconds[Pass] / 1000000.0);
+        m_RenderStats.TotalMilliseconds += m_RenderStats.PassMilliseconds[Pass];
+
+        Issued[Pass] = false;
+    }
+
+    PROFILE_COUNTER("GPU frame (us)", m_RenderStats.TotalMilliseconds * 1000.0f);
+}
+
+void GraphicsModule::BuildLightClusters(Camera& Cam)
+{
+    m_ClusterLights.clear();
+    m_PointLightTexels.clear();
+
+    for (size_t i = 0; i < m_PointLightRenderCommands.size(); ++i)
+    {
+        PointLightRenderCommand& Command = m_PointLightRenderCommands[i];
+
+        ClusterLight Light;
+        Light.Position = Command.m_Position;
+        Light.Radius = Command.m_Radius;
+        m_ClusterLights.push_back(Light);
+
+        Vec3f Colour = Command.m_Colour * Command.m_Intensity;
+
+        m_PointLightTexels.push_back(Vec4f(Command.m_Position.x, Command.m_Position.y, Command.m_Position.z, Command.m_Radius));
+        m_PointLightTexels.push_back(Vec4f(Colour.x, Colour.y, Colour.z, 0.0f));
+
+        float ShadowSlot = i < m_PointLightShadowSlots.size() ? (float)m_PointLightShadowSlots[i] : -1.0f;
+        m_PointLightTexels.push_back(Vec4f(ShadowSlot, 0.0f, 0.0f, 0.0f));
+    }
+
+    Vec3f Forward = Math::normalize(Cam.GetDirection());
+    Vec3f Right = Math::normalize(Math::cross(Forward, Cam.GetUp()));
+
+    ClusterFrustum Frustum;
+    Frustum.Position = Cam.GetPosition();
+    Frustum.Forward = Forward;
+    Frustum.Right = Right;
+    Frustum.Up = Math::cross(Right, Forward);
+    Frustum.VerticalFOV = Cam.GetFieldOfView();
+    Frustum.AspectRatio = Cam.GetScreenSize().x / Cam.GetScreenSize().y;
+    Frustum.NearPlane = Cam.GetNearPlane();
+    Frustum.FarPlane = Cam.GetFarPlane();
+
+    if (Cam.GetProjectionType() == Projection::Orthographic)
+    {
+        // Orthographic cameras' screen size is how much of the world they see
+        Frustum.Orthographic = true;
+        Frustum.OrthoHalfWidth = Cam.GetScreenSize().x * 0.5f;
+        Frustum.OrthoHalfHeight = Cam.GetScreenSize().y * 0.5f;
+    }
+
+    LightClustering::BuildClusters(Frustum, m_ClusterLights, m_LightClusters);
+
+    m_Renderer.UpdateBufferTexture(m_PointLightDataBuffer, m_PointLightTexels.data(), (unsigned int)(m_PointLightTexels.size() * sizeof(Vec4f)));
+    m_Renderer.UpdateBufferTexture(m_ClusterRangeBuffer, m_LightClusters.ClusterRanges.data(), (unsigned int)(m_LightClusters.ClusterRanges.size() * sizeof(unsigned int)));
+    m_Renderer.UpdateBufferTexture(m_ClusterLightIndexBuffer, m_LightClusters.LightIndices.data(), (unsigned int)(m_LightClusters.LightIndices.size() * sizeof(unsigned int)));
+}
+
+GraphicsModule::MaterialSamplerHandles GraphicsModule::GetMaterialSamplerHandles(Shader_ID Shader)
+{
+    MaterialSamplerHandles Handles;
+    Handles.Albedo = m_Renderer.GetUniformHandle(Shader, "AlbedoMap");
+    Handles.Normal = m_Renderer.GetUniformHandle(Shader, "NormalMap");
+    Handles.Metallic = m_Renderer.GetUniformHandle(Shader, "MetallicMap");
+    Handles.Roughness = m_Renderer.GetUniformHandle(Shader, "RoughnessMap");
+    Handles.AO = m_Renderer.GetUniformHandle(Shader, "AOMap");
+    return Handles;
+}
+
+GraphicsModule::GBufferSamplerHandles GraphicsModule::GetGBufferSamplerHandles(Shader_ID Shader)
+{
+    GBufferSamplerHandles Handles;
+    Handles.Depth = m_Renderer.GetUniformHandle(Shader, "gDepth");
+    Handles.Normal = m_Renderer.GetUniformHandle(Shader, "gNormal");
+    Handles.Albedo = m_Renderer.GetUniformHandle(Shader, "gAlbedo");
+    Handles.Material = m_Renderer.GetUniformHandle(Shader, "gMaterial");
+    return Handles;
+}
+
+void GraphicsModule::SetActiveMaterial(MaterialHandle Mat, const MaterialSamplerHandles& Samplers)
+{
+    const MaterialTextures& Textures = m_MaterialRegistry.GetTextures(Mat);
+
+    m_Renderer.SetActiveTexture(Textures.Albedo, Samplers.Albedo);
+    m_Renderer.SetActiveTexture(Textures.Normal, Samplers.Normal);
+    m_Renderer.SetActiveTexture(Textures.Metallic, Samplers.Metallic);
+    m_Renderer.SetActiveTexture(Textures.Roughness, Samplers.Roughness);
+    m_Renderer.SetActiveTexture(Textures.AO, Samplers.AO);
+}
+
+void GraphicsModule::SetActiveGBufferTextures(const GBuffer& Buffer, const GBufferSamplerHandles& Samplers)
+{
+    m_Renderer.SetActiveTexture(Buffer.DepthTex, Samplers.Depth);
+    m_Renderer.SetActiveTexture(Buffer.NormalTex, Samplers.Normal);
+    m_Renderer.SetActiveTexture(Buffer.AlbedoTex, Samplers.Albedo);
+    m_Renderer.SetActiveTexture(Buffer.MaterialTex, Samplers.Material);
+}
+
+void GraphicsModule::SortStaticMeshRenderCommands()
+{
+    m_SortedStaticMeshRenderCommands.clear();
+    for (StaticMeshRenderCommand& Command : m_StaticMeshRenderCommands)
+    {
+        m_SortedStaticMeshRenderCommands.push_back(&Command);
+    }
+
+    // Sort by mesh first so the shadow pass can batch across materials too
+    std::sort(m_SortedStaticMeshRenderCommands.begin(), m_SortedStaticMeshRenderCommands.end(),
+        [](const StaticMeshRenderCommand* Lhs, const StaticMeshRenderCommand* Rhs)
+        {
+            if (Lhs->m_Mesh != Rhs->m_Mesh) return Lhs->m_Mesh < Rhs->m_Mesh;
+            return Lhs->m_Material < Rhs->m_Material;
+        });
+}
+
 Shader_ID GraphicsModule::CreateShader(std::string vertShaderSource, std::string fragShaderSource)
 {
     return m_Renderer.LoadShader(vertShaderSource, fragShaderSource);
@@ -1670,23 +2415,146 @@ void GraphicsModule::DeleteTexture(Texture_ID texID)
 StaticMesh GraphicsModule::LoadMesh(std::string filePath)
 {
     // todo(Fraser): Switch here on different file types? (If I ever want something that's not .obj)
-    StaticMesh_ID Id = FileLoader::LoadOBJFile(filePath, m_Renderer);
-
-    //auto elements = m_Renderer.MapMeshElements(Id);
-    //auto vertices = m_Renderer.MapMeshVertices(Id);
+    VertexBufferFormat Format = FileLoader::GetOBJVertexFormat();
 
+    std::vector<float> Vertices;
+    std::vector<ElementIndex> Indices;
+    OBJLoadStats LoadStats;
+    if (!FileLoader::LoadOBJData(filePath, Vertices, Indices, &LoadStats))
+    {
+        Engine::DEBUGPrint("Couldn't open mesh file " + filePath);
+    }
+    else if (!Indices.empty())
+    {
+        // The vertex counts are before and after face corners were shared, the ACMRs before and after the triangles were reordered
+        size_t Stride = Format.GetVertexStride();
 
-    //m_Renderer.UnmapMeshElements(Id);
-    //m_Renderer.UnmapMeshVertices(Id);
+        std::ostringstream Stats;
+        Stats << std::fixed << std::setprecision(2);
+        Stats << filePath << ": " << LoadStats.CornerCount << " -> " << LoadStats.VertexCount << " vertices ("
+            << (LoadStats.CornerCount * Stride) / 1024.0f << " KB -> " << (LoadStats.VertexCount * Stride) / 1024.0f << " KB), ACMR "
+            << LoadStats.LoadedACMR << " -> " << LoadStats.OptimizedACMR << ", loaded in " << LoadStats.ParseMilliseconds + LoadStats.OptimizeMilliseconds << "ms";
+        Engine::DEBUGPrint(Stats.str());
+    }
 
     StaticMesh Result;
-    Result.Id = Id;
+    Result.Id = m_Renderer.LoadCompressedMesh(m_StaticMeshLayout, Vertices, Indices);
     Result.LoadedFromFile = true;
     Result.Path = filePath;
 
+    if (Vertices.empty())
+    {
+        return Result;
+    }
+
+    size_t Stride = Format.GetVertexStride() / sizeof(float);
+
+    Vec3f Min = Vec3f(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vec3f Max = Vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (size_t i = 0; i < Vertices.size(); i += Stride)
+    {
+        Min = Vec3f(Math::Min(Min.x, Vertices[i]), Math::Min(Min.y, Vertices[i + 1]), Math::Min(Min.z, Vertices[i + 2]));
+        Max = Vec3f(Math::Max(Max.x, Vertices[i]), Math::Max(Max.y, Vertices[i + 1]), Math::Max(Max.z, Vertices[i + 2]));
+    }
+    Result.BoundsCenter = (Min + Max) / 2.0f;
+    Result.BoundsRadius = Math::magnitude(Max - Min) / 2.0f;
+
+#ifndef DEDICATED_SERVER
+    // Nothing's drawn on a dedicated server so there's no point building LODs
+    PROFILE_SCOPE("GraphicsModule::BuildMeshLODs");
+
+    float MaxError = Result.BoundsRadius * MESH_LOD_MAX_ERROR;
+    float Error = 0.0f;
+
+    while (Result.LODCount < MAX_MESH_LODS - 1)
+    {
+        size_t TriangleCount = Indices.size() / 3;
+        size_t TargetTriangles = TriangleCount / 2;
+        if (TargetTriangles < MESH_LOD_MIN_TRIANGLES)
+        {
+            break;
+        }
+
+        // Each LOD's simplified from the last, so the errors add up
+        SimplifiedMesh LOD = MeshSimplifier::Simplify(Vertices, Stride, Indices, TargetTriangles, MaxError - Error);
+
+        // Not worth another LOD if it's barely any smaller (the error limit stopped it early)
+        if (LOD.Indices.size() / 3 > TriangleCount * 3 / 4)
+        {
+            break;
+        }
+
+        Error += LOD.Error;
+
+        StaticMeshLOD& NewLOD = Result.LODs[Result.LODCount++];
+        NewLOD.Id = m_Renderer.LoadCompressedMesh(m_StaticMeshLayout, LOD.Vertices, LOD.Indices);
+        NewLOD.Error = Error;
+
+        Vertices = std::move(LOD.Vertices);
+        Indices = std::move(LOD.Indices);
+    }
+#endif
+
     return Result;
 }
 
+void GraphicsModule::SetStaticMeshVertexLayout(const CompressedVertexLayout& Layout)
+{
+    m_StaticMeshLayout = Layout;
+}
+
+CompressedVertexLayout GraphicsModule::GetStaticMeshVertexLayout() const
+{
+    return m_StaticMeshLayout;
+}
+
+int GraphicsModule::SelectMeshLOD(const StaticMesh& Mesh, Mat4x4f TransMat, const Camera& Cam, int CurrentLOD)
+{
+    if (Mesh.LODCount == 0)
+    {
+        return 0;
+    }
+
+    // Largest scale along any axis, so the errors are never underestimated
+    float Scale = Math::Max(Math::Max(
+        Math::magnitude(Vec3f(TransMat[0].x, TransMat[0].y, TransMat[0].z)),
+        Math::magnitude(Vec3f(TransMat[1].x, TransMat[1].y, TransMat[1].z))),
+        Math::magnitude(Vec3f(TransMat[2].x, TransMat[2].y, TransMat[2].z)));
+
+    // Orthographic cameras are a pixel per unit, perspective ones are worked out at the nearest point of the bounds
+    float PixelsPerUnit = 1.0f;
+    if (Cam.GetProjectionType() == Projection::Perspective)
+    {
+        Vec3f Center = Math::mult(Mesh.BoundsCenter, TransMat);
+        float Distance = Math::magnitude(Center - Cam.GetPosition()) - Mesh.BoundsRadius * Scale;
+        Distance = Math::Max(Distance, Cam.GetNearPlane());
+
+        PixelsPerUnit = Cam.GetScreenSize().y / (2.0f * Distance * tanf(Cam.GetFieldOfView() / 2.0f));
+    }
+
+    auto GetPixelError = [&](int LOD)
+        {
+            return LOD == 0 ? 0.0f : Mesh.LODs[LOD - 1].Error * Scale * PixelsPerUnit;
+        };
+
+    int LOD = Math::Min(CurrentLOD, Mesh.LODCount);
+    while (LOD > 0 && GetPixelError(LOD) > MESH_LOD_PIXEL_ERROR * (1.0f + MESH_LOD_HYSTERESIS))
+    {
+        LOD--;
+    }
+    while (LOD < Mesh.LODCount && GetPixelError(LOD + 1) < MESH_LOD_PIXEL_ERROR * (1.0f - MESH_LOD_HYSTERESIS))
+    {
+        LOD++;
+    }
+
+    return LOD;
+}
+
+StaticMesh_ID GraphicsModule::GetMeshLODId(const StaticMesh& Mesh, int LOD)
+{
+    return LOD == 0 ? Mesh.Id : Mesh.LODs[LOD - 1].Id;
+}
+
 void GraphicsModule::AttachTextureToFBuffer(Texture texture, Framebuffer_ID fBufferID)
 {
     m_Renderer.AttachTextureToFramebuffer(texture.Id, fBufferID);
@@ -1746,12 +2614,10 @@ void GraphicsModule::ResizeGBuffer(GBuffer& Buffer, Vec2i Size)
     //m_Renderer.ResizeFBuffer(Buffer.LightBuffer, Size);
     //m_Renderer.ResizeFBuffer(Buffer.DebugBuffer, Size);
 
-    //m_Renderer.ResizeTexture(Buffer.PositionTex, Size);
+    //m_Renderer.ResizeTexture(Buffer.DepthTex, Size);
     //m_Renderer.ResizeTexture(Buffer.NormalTex, Size);
     //m_Renderer.ResizeTexture(Buffer.AlbedoTex, Size);
-    //m_Renderer.ResizeTexture(Buffer.MetallicTex, Size);
-    //m_Renderer.ResizeTexture(Buffer.RoughnessTex, Size);
-    //m_Renderer.ResizeTexture(Buffer.AOTex, Size);
+    //m_Renderer.ResizeTexture(Buffer.MaterialTex, Size);
     //m_Renderer.ResizeTexture(Buffer.DebugTex, Size);
 
     //m_Renderer.ResizeTexture(Buffer.SkyTex, Size);
@@ -1774,34 +2640,39 @@ void GraphicsModule::ResetFrameBuffer()
 //    return Result;
 //}
 
-Material GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap, Texture AOMap)
+MaterialHandle GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap, Texture AOMap)
 {
-    Material Result = Material(AlbedoMap, NormalMap, RoughnessMap, MetallicMap, AOMap);
-    return Result;
+    return RegisterMaterial(Material(AlbedoMap, NormalMap, RoughnessMap, MetallicMap, AOMap));
 }
 
-Material GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap)
+MaterialHandle GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap)
 {
-    Material Result = Material(AlbedoMap, NormalMap, RoughnessMap, MetallicMap, m_DefaultAOMap);
-    return Result;
+    return RegisterMaterial(Material(AlbedoMap, NormalMap, RoughnessMap, MetallicMap, m_DefaultAOMap));
 }
 
-Material GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap)
+MaterialHandle GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap)
 {
-    Material Result = Material(AlbedoMap, NormalMap, RoughnessMap, m_DefaultMetallicMap, m_DefaultAOMap);
-    return Result;
+    return RegisterMaterial(Material(AlbedoMap, NormalMap, RoughnessMap, m_DefaultMetallicMap, m_DefaultAOMap));
 }
 
-Material GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap)
+MaterialHandle GraphicsModule::CreateMaterial(Texture AlbedoMap, Texture NormalMap)
 {
-    Material Result = Material(AlbedoMap, NormalMap, m_DefaultRoughnessMap, m_DefaultMetallicMap, m_DefaultAOMap);
-    return Result;
+    return RegisterMaterial(Material(AlbedoMap, NormalMap, m_DefaultRoughnessMap, m_DefaultMetallicMap, m_DefaultAOMap));
 }
 
-Material GraphicsModule::CreateMaterial(Texture AlbedoMap)
+MaterialHandle GraphicsModule::CreateMaterial(Texture AlbedoMap)
 {
-    Material Result = Material(AlbedoMap, m_DefaultNormalMap, m_DefaultRoughnessMap, m_DefaultMetallicMap, m_DefaultAOMap);
-    return Result;
+    return RegisterMaterial(Material(AlbedoMap, m_DefaultNormalMap, m_DefaultRoughnessMap, m_DefaultMetallicMap, m_DefaultAOMap));
+}
+
+MaterialHandle GraphicsModule::RegisterMaterial(const Material& Mat)
+{
+    return m_MaterialRegistry.Register(Mat);
+}
+
+const Material& GraphicsModule::GetMaterial(MaterialHandle Handle) const
+{
+    return m_MaterialRegistry.Get(Handle);
 }
 
 Model GraphicsModule::CreateModel(TexturedMesh texturedMesh)
@@ -1814,25 +2685,30 @@ Model GraphicsModule::CloneModel(const Model& original)
     return Model(original.m_TexturedMeshes[0]);
 }
 
-Model GraphicsModule::LoadModel(std::vector<float>& BufferData, std::vector<unsigned int>& IndexData, Material Mat)
+Model GraphicsModule::LoadModel(std::vector<float>& BufferData, std::vector<unsigned int>& IndexData, MaterialHandle Mat)
 {
-    StaticMesh_ID MeshID = m_Renderer.LoadMesh(m_TexturedMeshFormat, BufferData, IndexData);
-
-    StaticMesh Mesh;
-    Mesh.Id = MeshID;
-    Mesh.LoadedFromFile = false;
+    StaticMesh Mesh = LoadGeneratedMesh(BufferData.data(), BufferData.size(), IndexData.data(), IndexData.size());
 
     Model Result = Model(TexturedMesh(Mesh, Mat));
 
     return Result;
 }
 
+StaticMesh GraphicsModule::LoadGeneratedMesh(const float* BufferData, size_t BufferSize, const ElementIndex* IndexData, size_t IndexCount)
+{
+    StaticMesh Mesh;
+    Mesh.Id = m_Renderer.LoadMesh(m_TexturedMeshFormat, BufferData, BufferSize, IndexData, IndexCount);
+    Mesh.LoadedFromFile = false;
+
+    return Mesh;
+}
+
 Model GraphicsModule::CreateBoxModel(AABB box)
 {
     return CreateBoxModel(box, m_DebugMaterial);
 }
 
-Model GraphicsModule::CreateBoxModel(AABB box, Material material)
+Model GraphicsModule::CreateBoxModel(AABB box, MaterialHandle material)
 {
     Vec3f min = box.min;
     Vec3f max = box.max;
@@ -2108,7 +2984,7 @@ Model GraphicsModule::CreatePlaneModel(Vec2f min, Vec2f max, float elevation, in
     return CreatePlaneModel(min, max, m_DebugMaterial, elevation, subsections);
 }
 
-Model GraphicsModule::CreatePlaneModel(Vec2f min, Vec2f max, Material material, float elevation, int subsections)
+Model GraphicsModule::CreatePlaneModel(Vec2f min, Vec2f max, MaterialHandle material, float elevation, int subsections)
 {
     int Rows = subsections;
     int Columns = subsections;
@@ -2238,21 +3114,17 @@ void GraphicsModule::Draw(Model& model)
     {
         if (!m_CameraMatrixSetThisFrame && m_Camera != nullptr)
         {
-            m_Renderer.SetShaderUniformMat4x4f(m_TexturedMeshShader, "Camera", m_Camera->GetCamMatrix());
-            m_Renderer.SetShaderUniformVec3f(m_TexturedMeshShader, "CameraPos", m_Camera->GetPosition());
+            m_Renderer.SetShaderUniformMat4x4f(m_TexturedMeshCamera, m_Camera->GetCamMatrix());
+            m_Renderer.SetShaderUniformVec3f(m_TexturedMeshCameraPos, m_Camera->GetPosition());
             m_CameraMatrixSetThisFrame = true;
         }
 
         m_Renderer.SetActiveShader(m_TexturedMeshShader);
-        m_Renderer.SetShaderUniformMat4x4f(m_TexturedMeshShader, "Transformation", model.GetTransform().GetTransformMatrix());
+        m_Renderer.SetShaderUniformMat4x4f(m_TexturedMeshTransformation, model.GetTransform().GetTransformMatrix());
 
         for (int i = 0; i < model.m_TexturedMeshes.size(); ++i)
         {
-            m_Renderer.SetActiveTexture(model.m_TexturedMeshes[i].m_Material.m_Normal.Id, "NormalMap");
-            m_Renderer.SetActiveTexture(model.m_TexturedMeshes[i].m_Material.m_Albedo.Id, "AlbedoMap");
-            m_Renderer.SetActiveTexture(model.m_TexturedMeshes[i].m_Material.m_Metallic.Id, "MetallicMap");
-            m_Renderer.SetActiveTexture(model.m_TexturedMeshes[i].m_Material.m_Roughness.Id, "RoughnessMap");
-            m_Renderer.SetActiveTexture(model.m_TexturedMeshes[i].m_Material.m_AO.Id, "AOMap");
+            SetActiveMaterial(model.m_TexturedMeshes[i].m_Material, m_TexturedMeshSamplers);
             m_Renderer.DrawMesh(model.m_TexturedMeshes[i].m_Mesh.Id);
         }
 
@@ -2262,16 +3134,16 @@ void GraphicsModule::Draw(Model& model)
         // Temp(fraser): Matrix set this frame PER render mode
         //if (!m_CameraMatrixSetThisFrame && m_Camera != nullptr)
         //{
-        m_Renderer.SetShaderUniformMat4x4f(m_UnlitShader, "Camera", m_Camera->GetCamMatrix());
+        m_Renderer.SetShaderUniformMat4x4f(m_UnlitCamera, m_Camera->GetCamMatrix());
         m_CameraMatrixSetThisFrame = true;
         //}
 
         m_Renderer.SetActiveShader(m_UnlitShader);
-        m_Renderer.SetShaderUniformMat4x4f(m_UnlitShader, "Transformation", model.GetTransform().GetTransformMatrix());
+        m_Renderer.SetShaderUniformMat4x4f(m_UnlitTransformation, model.GetTransform().GetTransformMatrix());
 
         for (int i = 0; i < model.m_TexturedMeshes.size(); ++i)
         {
-            m_Renderer.SetActiveTexture(model.m_TexturedMeshes[i].m_Material.m_Albedo.Id, "AlbedoMap");
+            m_Renderer.SetActiveTexture(m_MaterialRegistry.GetTextures(model.m_TexturedMeshes[i].m_Material).Albedo, m_UnlitAlbedoMap);
             m_Renderer.DrawMesh(model.m_TexturedMeshes[i].m_Mesh.Id);
         }
     }
@@ -2286,50 +3158,643 @@ void GraphicsModule::SetCamera(Camera* camera)
 
 void GraphicsModule::SetDirectionalLight(DirectionalLight dirLight)
 {
-    m_Renderer.SetShaderUniformVec3f(m_TexturedMeshShader, "SunDirection", dirLight.direction);
-    m_Renderer.SetShaderUniformVec3f(m_TexturedMeshShader, "SunColour", dirLight.colour);
+    m_Renderer.SetShaderUniformVec3f(m_TexturedMeshSunDirection, dirLight.direction);
+    m_Renderer.SetShaderUniformVec3f(m_TexturedMeshSunColour, dirLight.colour);
 }
 
-std::vector<float> GraphicsModule::GetModelVertexBuffer(Model& model)
+void GraphicsModule::SetShadowCascadeSettings(ShadowCascadeSettings Settings)
 {
-    return m_Renderer.GetMeshVertexData(model.m_TexturedMeshes[0].m_Mesh.Id);
+    Settings.CascadeCount = (int)Math::clamp((float)Settings.CascadeCount, 1.0f, (float)MAX_SHADOW_CASCADES);
+
+    bool AtlasSizeChanged = Settings.CascadeCount != m_ShadowCascadeSettings.CascadeCount
+        || Settings.Resolution != m_ShadowCascadeSettings.Resolution;
+
+    m_ShadowCascadeSettings = Settings;
+
+    if (AtlasSizeChanged)
+    {
+        CreateShadowAtlas();
+    }
 }
 
-std::vector<unsigned int> GraphicsModule::GetModelIndexBuffer(Model& model)
+ShadowCascadeSettings GraphicsModule::GetShadowCascadeSettings() const
 {
-    return m_Renderer.GetMeshIndexData(model.m_TexturedMeshes[0].m_Mesh.Id);
+    return m_ShadowCascadeSettings;
 }
 
-void GraphicsModule::OnFrameStart()
+void GraphicsModule::CreateShadowAtlas()
 {
-    ResetFrameBuffer();
-
-    m_CameraMatrixSetThisFrame = false;
-    m_Renderer.ClearScreenAndDepthBuffer();
-
-    if (m_IsDebugDrawInitialized)
+    if (m_ShadowAtlas)
     {
-        m_DebugLineMap.clear();
+        m_Renderer.DeleteFrameBuffer(m_ShadowAtlas);
     }
-   
+
+    Vec2i AtlasSize = Vec2i(m_ShadowCascadeSettings.Resolution * m_ShadowCascadeSettings.CascadeCount, m_ShadowCascadeSettings.Resolution);
+    m_ShadowAtlas = CreateFBuffer(AtlasSize, FBufferFormat::DEPTH);
 }
 
-void GraphicsModule::OnFrameEnd()
+void GraphicsModule::SetPointShadowSettings(PointShadowSettings Settings)
 {
-    if (m_IsDebugDrawInitialized && !m_IsDebugDrawAttachedToFBuffer)
+    Settings.FaceResolution = Math::Max(Settings.FaceResolution, 1);
+    Settings.MaxShadowedLights = Math::Max(Settings.MaxShadowedLights, 0);
+    Settings.FaceUpdateBudget = Math::Max(Settings.FaceUpdateBudget, 0);
+
+    bool AtlasSizeChanged = Settings.FaceResolution != m_PointShadowSettings.FaceResolution
+        || Settings.MaxShadowedLights != m_PointShadowSettings.MaxShadowedLights;
+
+    m_PointShadowSettings = Settings;
+
+    if (AtlasSizeChanged)
     {
-        DrawDebugDrawMesh(*m_Camera);
+        CreatePointShadowAtlas();
     }
-
-    //ResetFrameBuffer();
-    m_Renderer.SwapBuffer();
 }
 
-void GraphicsModule::InitializeDebugDraw()
+PointShadowSettings GraphicsModule::GetPointShadowSettings() const
 {
-    m_DebugDrawMesh = m_Renderer.CreateEmptyMesh(m_DebugVertFormat, false);
-    m_Renderer.SetMeshDrawType(m_DebugDrawMesh, DrawType::Line);
-    m_IsDebugDrawInitialized = true;
+    return m_PointShadowSettings;
+}
+
+void GraphicsModule::CreatePointShadowAtlas()
+{
+    if (m_PointShadowAtlas)
+    {
+        m_Renderer.DeleteFrameBuffer(m_PointShadowAtlas);
+    }
+
+    // Always at least one row so there's something to bind
+    int Rows = Math::Max(m_PointShadowSettings.MaxShadowedLights, 1);
+
+    Vec2i AtlasSize = Vec2i(m_PointShadowSettings.FaceResolution * 6, m_PointShadowSettings.FaceResolution * Rows);
+    m_PointShadowAtlas = CreateFBuffer(AtlasSize, FBufferFormat::DEPTH);
+
+    // Everything that was cached lived in the old atlas
+    m_PointShadowCache.assign(m_PointShadowSettings.MaxShadowedLights, PointShadowCacheEntry());
+
+    m_PointShadowTexels.assign(Rows * 6 * 5, Vec4f(0.0f, 0.0f, 0.0f, 0.0f));
+    m_Renderer.UpdateBufferTexture(m_PointShadowDataBuffer, m_PointShadowTexels.data(), (unsigned int)(m_PointShadowTexels.size() * sizeof(Vec4f)));
+}
+
+void GraphicsModule::UpdatePointShadows(Camera& Cam)
+{
+    m_PointLightShadowSlots.assign(m_PointLightRenderCommands.size(), -1);
+
+    m_PointShadowCasters.clear();
+    m_PointShadowCasterBounds.clear();
+    m_PointShadowCasterHashes.clear();
+
+    uint64_t AllCastersSignature = 0;
+
+    for (StaticMeshRenderCommand* Command : m_SortedStaticMeshRenderCommands)
+    {
+        if ((Command->m_Vis & (unsigned int)Vis::SHADOW_CAST) == 0)
+        {
+            continue;
+        }
+
+        Sphere Bounds;
+        if (!GetRenderCommandBounds(*Command, Bounds))
+        {
+            Bounds.radius = -1.0f;
+        }
+
+        uint64_t CasterHash = Hash::Hash_Bytes(&Command->m_TransMat, sizeof(Mat4x4f), Hash::Hash_Value(Command->m_Mesh));
+
+        m_PointShadowCasters.push_back(Command);
+        m_PointShadowCasterBounds.push_back(Bounds);
+        m_PointShadowCasterHashes.push_back(CasterHash);
+
+        AllCastersSignature = Hash::Combine64(AllCastersSignature, CasterHash);
+    }
+
+    // Per light signatures only need redoing when some caster somewhere has changed
+    bool AnyCastersChanged = AllCastersSignature != m_PointShadowAllCastersSignature;
+    m_PointShadowAllCastersSignature = AllCastersSignature;
+
+    for (PointShadowCacheEntry& Entry : m_PointShadowCache)
+    {
+        Entry.SeenThisFrame = false;
+    }
+
+    // Lights that haven't moved keep their slot...
+    for (size_t i = 0; i < m_PointLightRenderCommands.size(); ++i)
+    {
+        PointLightRenderCommand& Command = m_PointLightRenderCommands[i];
+        if (!Command.m_CastsShadows)
+        {
+            continue;
+        }
+
+        int Slot = FindPointShadowEntry(Command.m_Position, Command.m_Radius);
+        if (Slot >= 0)
+        {
+            m_PointShadowCache[Slot].SeenThisFrame = true;
+            m_PointLightShadowSlots[i] = Slot;
+        }
+    }
+
+    // ...the rest take over the closest left over entry within their radius (most likely the same light after moving), or a free one
+    for (size_t i = 0; i < m_PointLightRenderCommands.size(); ++i)
+    {
+        PointLightRenderCommand& Command = m_PointLightRenderCommands[i];
+        if (!Command.m_CastsShadows || m_PointLightShadowSlots[i] >= 0)
+        {
+            continue;
+        }
+
+        int Slot = -1;
+        float ClosestDistance = FLT_MAX;
+
+        for (int j = 0; j < (int)m_PointShadowCache.size(); ++j)
+        {
+            PointShadowCacheEntry& Entry = m_PointShadowCache[j];
+            if (Entry.SeenThisFrame)
+            {
+                continue;
+            }
+
+            float Distance = FLT_MAX * 0.5f;
+            if (Entry.InUse)
+            {
+                float EntryDistance = Math::magnitude(Entry.LightPosition - Command.m_Position);
+                if (EntryDistance <= Command.m_Radius)
+                {
+                    Distance = EntryDistance;
+                }
+            }
+
+            if (Distance < ClosestDistance)
+            {
+                ClosestDistance = Distance;
+                Slot = j;
+            }
+        }
+
+        if (Slot < 0)
+        {
+            // Out of slots, this light goes without shadows
+            continue;
+        }
+
+        PointShadowCacheEntry& Entry = m_PointShadowCache[Slot];
+
+        // Depth cached for some other light is no use to this one
+        if (ClosestDistance > Command.m_Radius)
+        {
+            Entry = PointShadowCacheEntry();
+        }
+
+        Entry.InUse = true;
+        Entry.SeenThisFrame = true;
+        Entry.LightPosition = Command.m_Position;
+        Entry.LightRadius = Command.m_Radius;
+        Entry.CasterSignatureValid = false;
+
+        // Faces keep their old depth (and the matrix/position it was drawn with) until they get redrawn
+        for (PointShadowFace& Face : Entry.Faces)
+        {
+            Face.Dirty = true;
+        }
+
+        m_PointLightShadowSlots[i] = Slot;
+    }
+
+    // Anything left over belonged to a light that's gone
+    for (PointShadowCacheEntry& Entry : m_PointShadowCache)
+    {
+        if (!Entry.SeenThisFrame)
+        {
+            Entry = PointShadowCacheEntry();
+        }
+    }
+
+    // Redraw every face of a light when something within its radius has changed
+    std::vector<PointShadowDirtyFace>& DirtyFaces = m_PointShadowDirtyFaces;
+    DirtyFaces.clear();
+
+    for (int Slot = 0; Slot < (int)m_PointShadowCache.size(); ++Slot)
+    {
+        PointShadowCacheEntry& Entry = m_PointShadowCache[Slot];
+        if (!Entry.InUse)
+        {
+            continue;
+        }
+
+        bool CastersChanged = false;
+        if (AnyCastersChanged || !Entry.CasterSignatureValid)
+        {
+            uint64_t Signature = GetPointShadowCasterSignature(Entry.LightPosition, Entry.LightRadius);
+            CastersChanged = Entry.CasterSignatureValid && Signature != Entry.CasterSignature;
+            Entry.CasterSignature = Signature;
+            Entry.CasterSignatureValid = true;
+        }
+
+        float DistanceToCamera = Math::magnitude(Entry.LightPosition - Cam.GetPosition());
+
+        for (int Face = 0; Face < 6; ++Face)
+        {
+            PointShadowFace& ShadowFace = Entry.Faces[Face];
+            if (CastersChanged)
+            {
+                ShadowFace.Dirty = true;
+            }
+
+            if (ShadowFace.Dirty)
+            {
+                DirtyFaces.push_back({ Slot, Face, ShadowFace.LightRadius <= 0.0f, DistanceToCamera });
+            }
+        }
+    }
+
+    if (DirtyFaces.empty())
+    {
+        return;
+    }
+
+    // Faces that have never been drawn go first, then the ones closest to the camera
+    std::sort(DirtyFaces.begin(), DirtyFaces.end(), [](const PointShadowDirtyFace& A, const PointShadowDirtyFace& B)
+        {
+            if (A.NeverDrawn != B.NeverDrawn)
+            {
+                return A.NeverDrawn;
+            }
+            return A.DistanceToCamera < B.DistanceToCamera;
+        });
+
+    size_t FaceCount = Math::Min(DirtyFaces.size(), (size_t)m_PointShadowSettings.FaceUpdateBudget);
+    if (FaceCount == 0)
+    {
+        return;
+    }
+
+    m_Renderer.SetActiveShader(m_PointShadowShader);
+    m_Renderer.SetActiveFBuffer(m_PointShadowAtlas);
+
+    for (size_t i = 0; i < FaceCount; ++i)
+    {
+        DrawPointShadowFace(DirtyFaces[i].Slot, DirtyFaces[i].Face);
+    }
+
+    for (int Slot = 0; Slot < (int)m_PointShadowCache.size(); ++Slot)
+    {
+        for (int Face = 0; Face < 6; ++Face)
+        {
+            PointShadowFace& ShadowFace = m_PointShadowCache[Slot].Faces[Face];
+            Vec4f* FaceTexels = &m_PointShadowTexels[(Slot * 6 + Face) * 5];
+
+            for (int Column = 0; Column < 4; ++Column)
+            {
+                FaceTexels[Column] = ShadowFace.LightSpaceMatrix[Column];
+            }
+            FaceTexels[4] = Vec4f(ShadowFace.LightPosition.x, ShadowFace.LightPosition.y, ShadowFace.LightPosition.z, ShadowFace.LightRadius);
+        }
+    }
+
+    m_Renderer.UpdateBufferTexture(m_PointShadowDataBuffer, m_PointShadowTexels.data(), (unsigned int)(m_PointShadowTexels.size() * sizeof(Vec4f)));
+}
+
+int GraphicsModule::FindPointShadowEntry(Vec3f Position, float Radius)
+{
+    for (int i = 0; i < (int)m_PointShadowCache.size(); ++i)
+    {
+        PointShadowCacheEntry& Entry = m_PointShadowCache[i];
+        if (Entry.InUse && !Entry.SeenThisFrame && Entry.LightPosition == Position && Entry.LightRadius == Radius)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint64_t GraphicsModule::GetPointShadowCasterSignature(Vec3f Position, float Radius)
+{
+    uint64_t Signature = 0;
+
+    for (size_t i = 0; i < m_PointShadowCasters.size(); ++i)
+    {
+        const Sphere& Bounds = m_PointShadowCasterBounds[i];
+        if (Bounds.radius >= 0.0f)
+        {
+            Vec3f CasterPosition = Bounds.position;
+            if (Math::magnitude(CasterPosition - Position) > Bounds.radius + Radius)
+            {
+                continue;
+            }
+        }
+
+        Signature = Hash::Combine64(Signature, m_PointShadowCasterHashes[i]);
+    }
+
+    return Signature;
+}
+
+void GraphicsModule::DrawPointShadowFace(int Slot, int Face)
+{
+    static const Vec3f FaceDirections[6] =
+    {
+        Vec3f(1.0f, 0.0f, 0.0f), Vec3f(-1.0f, 0.0f, 0.0f),
+        Vec3f(0.0f, 1.0f, 0.0f), Vec3f(0.0f, -1.0f, 0.0f),
+        Vec3f(0.0f, 0.0f, 1.0f), Vec3f(0.0f, 0.0f, -1.0f),
+    };
+    static const Vec3f FaceUps[6] =
+    {
+        Vec3f(0.0f, 0.0f, 1.0f), Vec3f(0.0f, 0.0f, 1.0f),
+        Vec3f(0.0f, 0.0f, 1.0f), Vec3f(0.0f, 0.0f, 1.0f),
+        Vec3f(0.0f, 1.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f),
+    };
+
+    PointShadowCacheEntry& Entry = m_PointShadowCache[Slot];
+    PointShadowFace& ShadowFace = Entry.Faces[Face];
+
+    Vec3f LightPosition = Entry.LightPosition;
+    float LightRadius = Entry.LightRadius;
+
+    Mat4x4f FaceView = Math::GenerateViewMatrix(LightPosition, FaceDirections[Face], FaceUps[Face]);
+    Mat4x4f FaceProjection = Math::GenerateProjectionMatrix(Math::Pi() * 0.5f, 1.0f, 0.05f, LightRadius);
+
+    ShadowFace.LightSpaceMatrix = FaceProjection * FaceView;
+    ShadowFace.LightPosition = LightPosition;
+    ShadowFace.LightRadius = LightRadius;
+    ShadowFace.Dirty = false;
+
+    int Resolution = m_PointShadowSettings.FaceResolution;
+    Recti Tile = Recti(Vec2i(Face * Resolution, Slot * Resolution), Vec2i((Face + 1) * Resolution, (Slot + 1) * Resolution));
+
+    m_Renderer.SetViewport(Tile);
+    m_Renderer.ClearDepthBufferRegion(Tile);
+
+    m_Renderer.SetShaderUniformMat4x4f(m_PointShadowLightSpaceMatrix, ShadowFace.LightSpaceMatrix);
+    m_Renderer.SetShaderUniformVec3f(m_PointShadowLightPosition, LightPosition);
+    m_Renderer.SetShaderUniformFloat(m_PointShadowLightRadius, LightRadius);
+
+    // Same batching as the cascades, casters are still sorted by mesh
+    for (size_t RunStart = 0; RunStart < m_PointShadowCasters.size();)
+    {
+        StaticMesh_ID Mesh = m_PointShadowCasters[RunStart]->m_Mesh;
+
+        m_InstanceTransforms.clear();
+
+        size_t RunEnd = RunStart;
+        while (RunEnd < m_PointShadowCasters.size()
+            && m_PointShadowCasters[RunEnd]->m_Mesh == Mesh)
+        {
+            const Sphere& Bounds = m_PointShadowCasterBounds[RunEnd];
+            Vec3f CasterPosition = Bounds.position;
+
+            if (Bounds.radius < 0.0f || Math::magnitude(CasterPosition - LightPosition) <= Bounds.radius + LightRadius)
+            {
+                m_InstanceTransforms.push_back(m_PointShadowCasters[RunEnd]->m_TransMat);
+            }
+            RunEnd++;
+        }
+
+        if (!m_InstanceTransforms.empty())
+        {
+            m_Renderer.DrawMeshInstanced(Mesh, m_InstanceTransforms);
+        }
+
+        RunStart = RunEnd;
+    }
+}
+
+void GraphicsModule::UpdateShadowCascades(Camera& Cam, Vec3f LightDirection)
+{
+    const ShadowCascadeSettings& Settings = m_ShadowCascadeSettings;
+
+    Vec3f Forward = Math::normalize(Cam.GetDirection());
+
+    float TanHalfFOVY = tanf(Cam.GetFieldOfView() * 0.5f);
+    float TanHalfFOVX = TanHalfFOVY * (Cam.GetScreenSize().x / Cam.GetScreenSize().y);
+
+    // Squared slope of the frustum's corner edges
+    float CornerSlopeSq = TanHalfFOVX * TanHalfFOVX + TanHalfFOVY * TanHalfFOVY;
+
+    float NearPlane = Cam.GetNearPlane();
+    float FarPlane = Math::Min(Settings.ShadowDistance, Cam.GetFarPlane());
+
+    // Any up vector will do for the light as long as it isn't parallel to the light direction
+    Vec3f LightDir = Math::normalize(LightDirection);
+    Vec3f LightUpHint = fabsf(LightDir.z) > 0.99f ? Vec3f(0.0f, 1.0f, 0.0f) : Vec3f(0.0f, 0.0f, 1.0f);
+    Vec3f LightRight = Math::normalize(Math::cross(LightDir, LightUpHint));
+    Vec3f LightUp = Math::cross(LightRight, LightDir);
+
+    float SliceNear = NearPlane;
+
+    m_ShadowVolumeMin = Vec3f(FLT_MAX, FLT_MAX, FLT_MAX);
+    m_ShadowVolumeMax = Vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    for (int i = 0; i < Settings.CascadeCount; ++i)
+    {
+        ShadowCascade& Cascade = m_ShadowCascades[i];
+
+        float SplitFraction = (float)(i + 1) / (float)Settings.CascadeCount;
+        float UniformSplit = NearPlane + (FarPlane - NearPlane) * SplitFraction;
+        float LogSplit = NearPlane * powf(FarPlane / NearPlane, SplitFraction);
+        float SliceFar = Math::Lerp(UniformSplit, LogSplit, Settings.SplitLambda);
+
+        // Smallest sphere around the slice, centred on the view axis. Using a sphere keeps the cascade the same size
+        // however the camera is rotated, so shadow edges don't swim when looking around
+        float CenterDistance = 0.5f * (SliceNear + SliceFar) * (1.0f + CornerSlopeSq);
+        float Radius;
+        if (CenterDistance >= SliceFar)
+        {
+            CenterDistance = SliceFar;
+            Radius = SliceFar * sqrtf(CornerSlopeSq);
+        }
+        else
+        {
+            Radius = sqrtf((CenterDistance - SliceNear) * (CenterDistance - SliceNear) + SliceNear * SliceNear * CornerSlopeSq);
+        }
+
+        // Round up so float error doesn't make the texel size flicker frame to frame
+        Radius = ceilf(Radius * 16.0f) / 16.0f;
+
+        float TexelSize = (2.0f * Radius) / (float)Settings.Resolution;
+
+        // Snap the centre to whole texels in light space so shadow edges don't crawl as the camera moves
+        Vec3f Center = Cam.GetPosition() + Forward * CenterDistance;
+        float CenterX = Math::dot(Center, LightRight);
+        float CenterY = Math::dot(Center, LightUp);
+        Center += LightRight * (floorf(CenterX / TexelSize) * TexelSize - CenterX);
+        Center += LightUp * (floorf(CenterY / TexelSize) * TexelSize - CenterY);
+
+        // Pull the light back past the cascade so casters between it and the light still land in the shadow map
+        float DepthRange = 2.0f * Radius + Settings.CasterDistance;
+        Vec3f LightPosition = Center - LightDir * (Radius + Settings.CasterDistance);
+
+        Mat4x4f LightView = Math::GenerateViewMatrix(LightPosition, LightDir, LightUp);
+        Mat4x4f LightProjection = Math::GenerateOrthoMatrix(-Radius, Radius, -Radius, Radius, 0.0f, DepthRange);
+
+        Cascade.LightSpaceMatrix = LightProjection * LightView;
+        Cascade.Center = Center;
+        Cascade.Radius = Radius;
+        Cascade.LightRight = LightRight;
+        Cascade.LightUp = LightUp;
+        Cascade.LightDirection = LightDir;
+
+        m_ShadowCascadeData.LightSpaceMatrices[i] = Cascade.LightSpaceMatrix;
+        m_ShadowCascadeData.SplitDepths[i] = SliceFar;
+        m_ShadowCascadeData.DepthRanges[i] = DepthRange;
+        m_ShadowCascadeData.TexelSizes[i] = TexelSize;
+
+        // Grow the overall shadow volume to fit this cascade's ortho box
+        Vec3f LightSpaceCenter = Vec3f(Math::dot(Center, LightRight), Math::dot(Center, LightUp), Math::dot(Center, LightDir));
+        Vec3f CascadeMin = LightSpaceCenter - Vec3f(Radius, Radius, Radius + Settings.CasterDistance);
+        Vec3f CascadeMax = LightSpaceCenter + Vec3f(Radius, Radius, Radius);
+
+        m_ShadowVolumeMin = Vec3f(Math::Min(m_ShadowVolumeMin.x, CascadeMin.x), Math::Min(m_ShadowVolumeMin.y, CascadeMin.y), Math::Min(m_ShadowVolumeMin.z, CascadeMin.z));
+        m_ShadowVolumeMax = Vec3f(Math::Max(m_ShadowVolumeMax.x, CascadeMax.x), Math::Max(m_ShadowVolumeMax.y, CascadeMax.y), Math::Max(m_ShadowVolumeMax.z, CascadeMax.z));
+
+        SliceNear = SliceFar;
+    }
+
+    m_ShadowCascadeData.CameraForward = Forward;
+    m_ShadowCascadeData.CascadeCount = Settings.CascadeCount;
+
+    m_Renderer.UpdateUniformBuffer(m_ShadowCascadeUniformBuffer, &m_ShadowCascadeData, sizeof(ShadowCascadeUniformData));
+}
+
+bool GraphicsModule::IsShadowCasterInCascade(const ShadowCascade& Cascade, const Sphere& Bounds)
+{
+    Vec3f CasterPosition = Bounds.position;
+    Vec3f ToCaster = CasterPosition - Cascade.Center;
+
+    float X = Math::dot(ToCaster, Cascade.LightRight);
+    float Y = Math::dot(ToCaster, Cascade.LightUp);
+    float Z = Math::dot(ToCaster, Cascade.LightDirection);
+
+    float Extent = Cascade.Radius + Bounds.radius;
+
+    return fabsf(X) <= Extent
+        && fabsf(Y) <= Extent
+        && Z <= Extent
+        && Z >= -(Extent + m_ShadowCascadeSettings.CasterDistance);
+}
+
+void GraphicsModule::GatherShadowCasters()
+{
+    m_ShadowCasters.clear();
+    m_ShadowCasterBounds.clear();
+
+    for (StaticMeshRenderCommand* Command : m_SortedStaticMeshRenderCommands)
+    {
+        if ((Command->m_Vis & (unsigned int)Vis::SHADOW_CAST) == 0)
+        {
+            continue;
+        }
+
+        Sphere Bounds;
+        if (!GetRenderCommandBounds(*Command, Bounds))
+        {
+            Bounds.radius = -1.0f;
+        }
+        else if (!IsShadowCasterInLightVolume(Bounds))
+        {
+            continue;
+        }
+
+        m_ShadowCasters.push_back(Command);
+        m_ShadowCasterBounds.push_back(Bounds);
+    }
+}
+
+bool GraphicsModule::IsShadowCasterInLightVolume(const Sphere& Bounds)
+{
+    // Every cascade shares the same light basis
+    const ShadowCascade& Basis = m_ShadowCascades[0];
+
+    Vec3f CasterPosition = Bounds.position;
+
+    float X = Math::dot(CasterPosition, Basis.LightRight);
+    float Y = Math::dot(CasterPosition, Basis.LightUp);
+    float Z = Math::dot(CasterPosition, Basis.LightDirection);
+
+    return X + Bounds.radius >= m_ShadowVolumeMin.x && X - Bounds.radius <= m_ShadowVolumeMax.x
+        && Y + Bounds.radius >= m_ShadowVolumeMin.y && Y - Bounds.radius <= m_ShadowVolumeMax.y
+        && Z + Bounds.radius >= m_ShadowVolumeMin.z && Z - Bounds.radius <= m_ShadowVolumeMax.z;
+}
+
+bool GraphicsModule::GetRenderCommandBounds(StaticMeshRenderCommand& Command, Sphere& OutBounds)
+{
+    AABB LocalBounds;
+    if (!m_Renderer.GetMeshBounds(Command.m_Mesh, LocalBounds))
+    {
+        return false;
+    }
+
+    Mat4x4f& Trans = Command.m_TransMat;
+
+    float ScaleX = Math::magnitude(Vec3f(Trans[0].x, Trans[0].y, Trans[0].z));
+    float ScaleY = Math::magnitude(Vec3f(Trans[1].x, Trans[1].y, Trans[1].z));
+    float ScaleZ = Math::magnitude(Vec3f(Trans[2].x, Trans[2].y, Trans[2].z));
+
+    OutBounds.position = Math::mult(LocalBounds.Center(), Trans);
+    OutBounds.radius = 0.5f * Math::magnitude(LocalBounds.max - LocalBounds.min) * Math::Max(ScaleX, Math::Max(ScaleY, ScaleZ));
+
+    return true;
+}
+
+std::vector<float> GraphicsModule::GetModelVertexBuffer(Model& model)
+{
+    return m_Renderer.GetMeshVertexData(model.m_TexturedMeshes[0].m_Mesh.Id);
+}
+
+std::vector<unsigned int> GraphicsModule::GetModelIndexBuffer(Model& model)
+{
+    return m_Renderer.GetMeshIndexData(model.m_TexturedMeshes[0].m_Mesh.Id);
+}
+
+void GraphicsModule::OnFrameStart()
+{
+    ResetFrameBuffer();
+
+    m_CameraMatrixSetThisFrame = false;
+    m_Renderer.ClearScreenAndDepthBuffer();
+
+    if (m_IsDebugDrawInitialized)
+    {
+        for (std::vector<float>& LayerVertices : m_DebugLineVertices)
+        {
+            LayerVertices.clear();
+        }
+
+        // Lines with a duration get re-added every frame until they run out
+        float CurrentTime = Engine::GetElapsedTime();
+        for (size_t i = 0; i < m_PersistentDebugLines.size();)
+        {
+            PersistentDebugLine& Line = m_PersistentDebugLines[i];
+            if (CurrentTime >= Line.ExpiryTime)
+            {
+                Line = m_PersistentDebugLines.back();
+                m_PersistentDebugLines.pop_back();
+                continue;
+            }
+
+            AddDebugLineVertices(Line.A, Line.B, Line.Colour, Line.Layer);
+            ++i;
+        }
+    }
+   
+}
+
+void GraphicsModule::OnFrameEnd()
+{
+    if (m_IsDebugDrawInitialized && !m_IsDebugDrawAttachedToFBuffer)
+    {
+        DrawDebugDrawMesh(*m_Camera);
+    }
+
+    //ResetFrameBuffer();
+    m_Renderer.SwapBuffer();
+}
+
+void GraphicsModule::InitializeDebugDraw()
+{
+    for (std::vector<float>& LayerVertices : m_DebugLineVertices)
+    {
+        LayerVertices.reserve(DEBUG_DRAW_RESERVED_LINES * 12);
+    }
+    m_IsDebugDrawInitialized = true;
 }
 
 void GraphicsModule::InitializeDebugDraw(Framebuffer_ID fBuffer)
@@ -2339,24 +3804,54 @@ void GraphicsModule::InitializeDebugDraw(Framebuffer_ID fBuffer)
     m_DebugFBuffer = fBuffer;
 }
 
-void GraphicsModule::DebugDrawLine(Vec3f a, Vec3f b, Vec3f colour)
+void GraphicsModule::DebugDrawLine(Vec3f a, Vec3f b, Vec3f colour, float duration, DebugDrawLayer layer)
 {
     assert(m_IsDebugDrawInitialized);
 
-    if (m_DebugLineMap.find(colour) == m_DebugLineMap.end())
+    AddDebugLineVertices(a, b, colour, layer);
+
+    if (duration > 0.0f)
     {
-        m_DebugLineMap[colour] = std::vector<float>();
+        std::vector<PersistentDebugLine>& PersistentLines = t_DebugDrawCapture ? t_DebugDrawCapture->PersistentLines : m_PersistentDebugLines;
+        PersistentLines.push_back({ a, b, colour, Engine::GetElapsedTime() + duration, layer });
     }
+}
+
+void GraphicsModule::DebugDrawLine(LineSegment line, Vec3f colour, float duration, DebugDrawLayer layer)
+{
+    DebugDrawLine(line.a, line.b, colour, duration, layer);
+}
 
-    m_DebugLineMap[colour].insert(m_DebugLineMap[colour].end(), { a.x, a.y, a.z, b.x, b.y, b.z });
+void GraphicsModule::SetDebugDrawCapture(DebugDrawCapture* Capture)
+{
+    t_DebugDrawCapture = Capture;
 }
 
-void GraphicsModule::DebugDrawLine(LineSegment line, Vec3f colour)
+void GraphicsModule::SubmitDebugDrawCapture(const DebugDrawCapture& Capture)
 {
-    DebugDrawLine(line.a, line.b, colour);
+    if (!m_IsDebugDrawInitialized)
+    {
+        return;
+    }
+
+    for (int Layer = 0; Layer < (int)DebugDrawLayer::COUNT; ++Layer)
+    {
+        m_DebugLineVertices[Layer].insert(m_DebugLineVertices[Layer].end(), Capture.LineVertices[Layer].begin(), Capture.LineVertices[Layer].end());
+    }
+    m_PersistentDebugLines.insert(m_PersistentDebugLines.end(), Capture.PersistentLines.begin(), Capture.PersistentLines.end());
 }
 
-void GraphicsModule::DebugDrawModelMesh(Model model, Vec3f colour)
+void GraphicsModule::AddDebugLineVertices(Vec3f a, Vec3f b, Vec3f colour, DebugDrawLayer layer)
+{
+    std::vector<float>& LayerVertices = t_DebugDrawCapture ? t_DebugDrawCapture->LineVertices[(int)layer] : m_DebugLineVertices[(int)layer];
+
+    LayerVertices.insert(LayerVertices.end(), {
+        a.x, a.y, a.z, colour.x, colour.y, colour.z,
+        b.x, b.y, b.z, colour.x, colour.y, colour.z
+        });
+}
+
+void GraphicsModule::DebugDrawModelMesh(Model model, Vec3f colour, float duration, DebugDrawLayer layer)
 {
     assert(m_IsDebugDrawInitialized);
 
@@ -2368,18 +3863,18 @@ void GraphicsModule::DebugDrawModelMesh(Model model, Vec3f colour)
         std::vector<unsigned int*> indices = m_Renderer.MapMeshElements(model.m_TexturedMeshes[i].m_Mesh.Id);
         for (int j = 0; j < indices.size(); j += 3)
         {
-            DebugDrawLine(vertices[*indices[j]]->position * modelTransform, vertices[*indices[(size_t)j + 1]]->position * modelTransform, colour);
+            DebugDrawLine(vertices[*indices[j]]->position * modelTransform, vertices[*indices[(size_t)j + 1]]->position * modelTransform, colour, duration, layer);
 
-            DebugDrawLine(vertices[*indices[(size_t)j + 1]]->position * modelTransform, vertices[*indices[(size_t)j + 2]]->position * modelTransform, colour);
+            DebugDrawLine(vertices[*indices[(size_t)j + 1]]->position * modelTransform, vertices[*indices[(size_t)j + 2]]->position * modelTransform, colour, duration, layer);
 
-            DebugDrawLine(vertices[*indices[(size_t)j + 2]]->position * modelTransform, vertices[*indices[j]]->position * modelTransform, colour);
+            DebugDrawLine(vertices[*indices[(size_t)j + 2]]->position * modelTransform, vertices[*indices[j]]->position * modelTransform, colour, duration, layer);
         }
         m_Renderer.UnmapMeshVertices(model.m_TexturedMeshes[i].m_Mesh.Id);
         m_Renderer.UnmapMeshElements(model.m_TexturedMeshes[i].m_Mesh.Id);
     }
 }
 
-void GraphicsModule::DebugDrawAABB(AABB box, Vec3f colour, Mat4x4f transform)
+void GraphicsModule::DebugDrawAABB(AABB box, Vec3f colour, Mat4x4f transform, float duration, DebugDrawLayer layer)
 {
     assert(m_IsDebugDrawInitialized);
     Vec3f points[] =
@@ -2400,40 +3895,32 @@ void GraphicsModule::DebugDrawAABB(AABB box, Vec3f colour, Mat4x4f transform)
         points[i] = points[i] * transform;
     }
 
-    DebugDrawLine(points[0], points[1], colour);
-    DebugDrawLine(points[1], points[2], colour);
-    DebugDrawLine(points[2], points[3], colour);
-    DebugDrawLine(points[3], points[0], colour);
+    DebugDrawLine(points[0], points[1], colour, duration, layer);
+    DebugDrawLine(points[1], points[2], colour, duration, layer);
+    DebugDrawLine(points[2], points[3], colour, duration, layer);
+    DebugDrawLine(points[3], points[0], colour, duration, layer);
 
-    DebugDrawLine(points[4], points[5], colour);
-    DebugDrawLine(points[5], points[6], colour);
-    DebugDrawLine(points[6], points[7], colour);
-    DebugDrawLine(points[7], points[4], colour);
+    DebugDrawLine(points[4], points[5], colour, duration, layer);
+    DebugDrawLine(points[5], points[6], colour, duration, layer);
+    DebugDrawLine(points[6], points[7], colour, duration, layer);
+    DebugDrawLine(points[7], points[4], colour, duration, layer);
 
-    DebugDrawLine(points[0], points[4], colour);
-    DebugDrawLine(points[1], points[5], colour);
-    DebugDrawLine(points[2], points[6], colour);
-    DebugDrawLine(points[3], points[7], colour);
+    DebugDrawLine(points[0], points[4], colour, duration, layer);
+    DebugDrawLine(points[1], points[5], colour, duration, layer);
+    DebugDrawLine(points[2], points[6], colour, duration, layer);
+    DebugDrawLine(points[3], points[7], colour, duration, layer);
 }
 
-void GraphicsModule::DebugDrawPoint(Vec3f p, Vec3f colour)
+void GraphicsModule::DebugDrawPoint(Vec3f p, Vec3f colour, float duration, DebugDrawLayer layer)
 {
     assert(m_IsDebugDrawInitialized);
 
-    if (m_DebugLineMap.find(colour) == m_DebugLineMap.end())
-    {
-        m_DebugLineMap[colour] = std::vector<float>();
-    }
-
-    m_DebugLineMap[colour].insert(m_DebugLineMap[colour].end(), {
-        p.x, p.y - 0.5f, p.z, p.x, p.y + 0.5f, p.z,
-        p.x - 0.5f, p.y, p.z, p.x + 0.5f, p.y, p.z,
-        p.x, p.y, p.z - 0.5f, p.x, p.y, p.z + 0.5f,
-
-        });
+    DebugDrawLine(Vec3f(p.x, p.y - 0.5f, p.z), Vec3f(p.x, p.y + 0.5f, p.z), colour, duration, layer);
+    DebugDrawLine(Vec3f(p.x - 0.5f, p.y, p.z), Vec3f(p.x + 0.5f, p.y, p.z), colour, duration, layer);
+    DebugDrawLine(Vec3f(p.x, p.y, p.z - 0.5f), Vec3f(p.x, p.y, p.z + 0.5f), colour, duration, layer);
 }
 
-void GraphicsModule::DebugDrawSphere(Vec3f p, float radius /*= 1.0f*/, Vec3f colour /*= Vec3f(1.0f, 1.0f, 1.0f)*/)
+void GraphicsModule::DebugDrawSphere(Vec3f p, float radius /*= 1.0f*/, Vec3f colour /*= Vec3f(1.0f, 1.0f, 1.0f)*/, float duration, DebugDrawLayer layer)
 {
     Vec3f Top = p + Vec3f(0.0f, 0.0f, 1.0f) * radius;
     Vec3f Bot = p + Vec3f(0.0f, 0.0f, -1.0f) * radius;
@@ -2453,11 +3940,11 @@ void GraphicsModule::DebugDrawSphere(Vec3f p, float radius /*= 1.0f*/, Vec3f col
     {
         if (i == 9)
         {
-            DebugDrawLine(CenterPoints[i], CenterPoints[0], colour);
+            DebugDrawLine(CenterPoints[i], CenterPoints[0], colour, duration, layer);
         }
         else
         {
-            DebugDrawLine(CenterPoints[i], CenterPoints[i + 1], colour);
+            DebugDrawLine(CenterPoints[i], CenterPoints[i + 1], colour, duration, layer);
         }
     }
 
@@ -2497,17 +3984,25 @@ void GraphicsModule::SetRenderMode(RenderMode mode)
 
 void GraphicsModule::DrawDebugDrawMesh(Camera cam)
 {
-    m_Renderer.ClearMesh(m_DebugDrawMesh);
+    if (m_DebugLineVertices[(int)DebugDrawLayer::WORLD].empty() && m_DebugLineVertices[(int)DebugDrawLayer::OVERLAY].empty())
+    {
+        return;
+    }
+
     m_Renderer.SetActiveShader(m_DebugLineShader);
-    if (m_DebugLineMap.size() > 0)
+    m_Renderer.SetShaderUniformMat4x4f(m_DebugLineCamera, cam.GetCamMatrix());
+
+    // Every line in a layer goes out in a single draw
+    DynamicGeometry WorldLines = m_Renderer.WriteDynamicGeometry(m_DebugVertFormat, m_DebugLineVertices[(int)DebugDrawLayer::WORLD]);
+    m_Renderer.DrawDynamicGeometry(WorldLines, DrawType::Line);
+
+    if (!m_DebugLineVertices[(int)DebugDrawLayer::OVERLAY].empty())
     {
-        m_Renderer.SetShaderUniformMat4x4f(m_DebugLineShader, "Camera", cam.GetCamMatrix());
-        for (auto& it : m_DebugLineMap)
-        {
-            m_Renderer.UpdateMeshData(m_DebugDrawMesh, m_DebugVertFormat, it.second);
-            m_Renderer.SetShaderUniformVec3f(m_DebugLineShader, "Colour", it.first);
-            m_Renderer.DrawMesh(m_DebugDrawMesh);
-        }
+        DynamicGeometry OverlayLines = m_Renderer.WriteDynamicGeometry(m_DebugVertFormat, m_DebugLineVertices[(int)DebugDrawLayer::OVERLAY]);
+
+        m_Renderer.DisableDepthTesting();
+        m_Renderer.DrawDynamicGeometry(OverlayLines, DrawType::Line);
+        m_Renderer.EnableDepthTesting();
     }
 }
 
@@ -6,6 +6,8 @@
 #include "Math/Geometry.h"
 #include "Math/Transform.h"
 #include "Platform/RendererPlatform.h"
+#include "Rendering/LightClustering.h"
+#include "Rendering/MaterialRegistry.h"
 
 #include <unordered_map>
 #include <vector>
@@ -36,12 +38,13 @@ struct GBuffer
 {
     Framebuffer_ID Buffer;
 
-    Texture_ID PositionTex;
+    // World position isn't stored, it's rebuilt from depth with the inverse camera matrix
+    Texture_ID DepthTex;
+    // Octahedral encoded normals
     Texture_ID NormalTex;
     Texture_ID AlbedoTex;
-    Texture_ID MetallicTex;
-    Texture_ID RoughnessTex;
-    Texture_ID AOTex;
+    // r = metallic, g = roughness, b = ambient occlusion
+    Texture_ID MaterialTex;
 
     Framebuffer_ID SkyBuffer;
     Texture_ID SkyTex;
@@ -57,34 +60,6 @@ struct GBuffer
     Framebuffer_ID FinalOutput;
 };
 
-struct Material
-{
-    Material() {}
-    Material(Texture Albedo, Texture Normal, Texture Roughness, Texture Metallic, Texture AO);
-
-    Texture m_Albedo;
-    Texture m_Normal;
-    Texture m_Metallic;
-    Texture m_Roughness;
-    Texture m_AO;
-    Texture m_Height;
-
-    friend bool operator<(const Material& lhs, const Material& rhs)
-    {
-        return lhs.m_Albedo < rhs.m_Albedo
-            || lhs.m_Normal < rhs.m_Normal;
-    }
-
-    friend bool operator==(const Material& lhs, const Material& rhs)
-    {
-        return lhs.m_Albedo == rhs.m_Albedo
-            && lhs.m_Normal == rhs.m_Normal
-            && lhs.m_Metallic == rhs.m_Metallic
-            && lhs.m_Roughness == rhs.m_Roughness
-            && lhs.m_AO == rhs.m_AO;
-    }
-};
-
 enum class ModelType
 {
     BLOCK,
@@ -105,18 +80,48 @@ enum class RenderMode
     DEFAULT
 };
 
+// Debug line storage reserved up front per layer, so a typical frame never has to grow it
+#define DEBUG_DRAW_RESERVED_LINES 16384
+
+// World debug lines are depth tested against the scene, overlay lines are drawn on top of everything
+enum class DebugDrawLayer
+{
+    WORLD,
+    OVERLAY,
+    COUNT
+};
+
+struct PersistentDebugLine
+{
+    Vec3f A;
+    Vec3f B;
+    Vec3f Colour;
+    float ExpiryTime;
+    DebugDrawLayer Layer;
+};
+
+// Debug lines drawn on a thread that has a capture set end up in here instead of in the current frame,
+// so they can be handed to the graphics module later with SubmitDebugDrawCapture (see ScenePipeline)
+struct DebugDrawCapture
+{
+    std::vector<float> LineVertices[(int)DebugDrawLayer::COUNT];
+    std::vector<PersistentDebugLine> PersistentLines;
+
+    void Clear();
+};
+
 struct TexturedMesh
 {
     TexturedMesh() {}
 
-    TexturedMesh(StaticMesh mesh, Material material)
+    TexturedMesh(StaticMesh mesh, MaterialHandle material)
         : m_Mesh(mesh)
         , m_Material(material)
     {}
 
     StaticMesh m_Mesh;
 
-    Material m_Material;
+    MaterialHandle m_Material;
 };
 
 class Model
@@ -136,7 +141,7 @@ public:
         return m_Transform;
     }
 
-    void SetMaterial(Material material)
+    void SetMaterial(MaterialHandle material)
     {
         m_TexturedMeshes[0].m_Material = material;
     }
@@ -146,6 +151,12 @@ public:
     std::string m_Name = "";
 
     ModelType Type = ModelType::MODEL;
+
+    // Vis flags, copied into the model's render commands
+    unsigned int m_Vis = (unsigned int)Vis::SHADOW_CAST | (unsigned int)Vis::SHADOW_RECV;
+
+    // LOD the model was last drawn at, see GraphicsModule::SelectMeshLOD
+    int m_LOD = 0;
 private:
     Transform m_Transform;
 };
@@ -161,13 +172,81 @@ struct PointLight
     Vec3f position = Vec3f(0.0f, 0.0f, 0.0f);
     Colour colour = Colour(1.0f, 1.0f, 1.0f);
     float intensity = 1.0f;
+
+    // Distance at which the light's contribution is faded out to nothing
+    float radius = 20.0f;
+
+    bool castsShadows = false;
 };
 
+// Layout of the std140 FrameData uniform block shared by the deferred shaders
+struct FrameUniformData
+{
+    Mat4x4f Camera;
+    Vec3f CameraPos;
+    float Padding = 0.0f;
+    Mat4x4f InvCamera;
+};
+
+#define MAX_SHADOW_CASCADES 4
+
+// The directional light's shadows are split into cascades along the view direction,
+// each cascade gets its own tile (side by side) in a single shadow atlas
+struct ShadowCascadeSettings
+{
+    int CascadeCount = 4;
+
+    // Width/height of one cascade's tile in the atlas
+    int Resolution = 1024;
+
+    // Shadows aren't drawn past this distance from the camera
+    float ShadowDistance = 100.0f;
+
+    // Blend between evenly spaced splits (0) and logarithmically spaced splits (1)
+    float SplitLambda = 0.9f;
+
+    // How far beyond a cascade towards the light shadow casters are still drawn into it
+    float CasterDistance = 50.0f;
+};
+
+// Layout of the std140 ShadowCascadeData uniform block
+struct ShadowCascadeUniformData
+{
+    Mat4x4f LightSpaceMatrices[MAX_SHADOW_CASCADES];
+    Vec4f SplitDepths;
+    Vec4f DepthRanges;
+    Vec4f TexelSizes;
+    Vec3f CameraForward;
+    int CascadeCount = 0;
+};
+
+// Shadowed point lights each get a row of 6 cube face tiles in a shared atlas.
+// A face is only redrawn when its light or a shadow caster within the light's radius changes,
+// and no more than FaceUpdateBudget faces are redrawn per frame (the rest keep their cached depth)
+struct PointShadowSettings
+{
+    // Width/height of one cube face's tile in the atlas
+    int FaceResolution = 256;
+
+    // Lights past this many don't get shadows
+    int MaxShadowedLights = 16;
+
+    int FaceUpdateBudget = 12;
+};
+
+// Binding points for uniform blocks shared between shaders
+#define FRAME_UNIFORM_BINDING 0
+#define SHADOW_CASCADE_UNIFORM_BINDING 1
+
+// Plain handles only so commands are cheap to build from many threads at once
 struct StaticMeshRenderCommand
 {
-    StaticMesh_ID m_Mesh;
-    Material m_Material;
+    StaticMesh_ID m_Mesh = 0;
+    MaterialHandle m_Material;
     Mat4x4f m_TransMat;
+
+    // Vis flags
+    unsigned int m_Vis = (unsigned int)Vis::SHADOW_CAST | (unsigned int)Vis::SHADOW_RECV;
 };
 
 struct BillboardRenderCommand
@@ -189,6 +268,45 @@ struct PointLightRenderCommand
     Vec3f m_Colour;
     Vec3f m_Position;
     float m_Intensity;
+    float m_Radius = 20.0f;
+    bool m_CastsShadows = false;
+};
+
+// Static meshes loaded from file get a chain of LODs, each made by simplifying the last down to half its triangles.
+// The chain stops once a LOD would be under MESH_LOD_MIN_TRIANGLES, or would have to move its surface further than
+// MESH_LOD_MAX_ERROR (a fraction of the mesh's bounding radius) from the full detail mesh
+#define MESH_LOD_MIN_TRIANGLES 128
+#define MESH_LOD_MAX_ERROR 0.1f
+
+// The coarsest LOD whose error covers no more than this many pixels on screen is drawn. Switching to a coarser LOD
+// needs the error MESH_LOD_HYSTERESIS (a fraction) under that, switching back needs it that much over, so models
+// sitting right at a threshold don't flicker between LODs
+#define MESH_LOD_PIXEL_ERROR 1.0f
+#define MESH_LOD_HYSTERESIS 0.25f
+
+// Timer queries for this many frames are in flight at once, so each one gets read back this many frames
+// after it was issued and reading it never has to wait on the GPU
+#define GPU_TIMER_FRAMES 4
+
+enum class RenderPass
+{
+    GBUFFER,
+    SKY,
+    DEBUG,
+    DIRECTIONAL_SHADOWS,
+    POINT_SHADOWS,
+    DIRECTIONAL_LIGHT,
+    POINT_LIGHTS,
+    COMBINE,
+    COUNT
+};
+
+// GPU time spent on each pass of Render, from GPU_TIMER_FRAMES frames ago.
+// Passes that didn't run that frame are zero, as is everything when timer queries aren't supported
+struct RenderStats
+{
+    float PassMilliseconds[(int)RenderPass::COUNT] = {};
+    float TotalMilliseconds = 0.0f;
 };
 
 class GraphicsModule
@@ -204,6 +322,7 @@ public:
     void DeleteGBuffer(GBuffer& GBuf);
 
     void AddRenderCommand(StaticMeshRenderCommand Command);
+    void AddRenderCommands(const std::vector<StaticMeshRenderCommand>& Commands);
     void AddRenderCommand(BillboardRenderCommand Command);
     void AddRenderCommand(PointLightRenderCommand Command);
 
@@ -225,32 +344,47 @@ public:
 
     StaticMesh LoadMesh(std::string filePath);
 
+    // How the vertices of static meshes (and their LODs) are packed, only affects meshes loaded after it's set
+    void SetStaticMeshVertexLayout(const CompressedVertexLayout& Layout);
+    CompressedVertexLayout GetStaticMeshVertexLayout() const;
+
+    // LOD a model using Mesh should be drawn at, from how big the mesh's LOD errors come out on Cam's screen.
+    // CurrentLOD is what it was drawn at last time
+    static int SelectMeshLOD(const StaticMesh& Mesh, Mat4x4f TransMat, const Camera& Cam, int CurrentLOD);
+    static StaticMesh_ID GetMeshLODId(const StaticMesh& Mesh, int LOD);
+
     void SetActiveFrameBuffer(Framebuffer_ID fBufferID);
     void ResizeFrameBuffer(Framebuffer_ID fBufferID, Vec2i size);
     void ResizeGBuffer(GBuffer& Buffer, Vec2i Size);
     void ResetFrameBuffer();
 
     //Material CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap, Texture AOMap, Texture HeightMap);
-    Material CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap, Texture AOMap);
-    Material CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap);
-    Material CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap);
-    Material CreateMaterial(Texture AlbedoMap, Texture NormalMap);
-    Material CreateMaterial(Texture AlbedoMap);
+    MaterialHandle CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap, Texture AOMap);
+    MaterialHandle CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap, Texture MetallicMap);
+    MaterialHandle CreateMaterial(Texture AlbedoMap, Texture NormalMap, Texture RoughnessMap);
+    MaterialHandle CreateMaterial(Texture AlbedoMap, Texture NormalMap);
+    MaterialHandle CreateMaterial(Texture AlbedoMap);
+
+    MaterialHandle RegisterMaterial(const Material& Mat);
+    const Material& GetMaterial(MaterialHandle Handle) const;
 
     Model CreateModel(TexturedMesh texturedMesh);
 
     Model CloneModel(const Model& original);
 
-    Model LoadModel(std::vector<float>& BufferData, std::vector<unsigned int>& IndexData, Material Mat);
+    Model LoadModel(std::vector<float>& BufferData, std::vector<unsigned int>& IndexData, MaterialHandle Mat);
+
+    // A mesh that wasn't loaded from a file, in the textured mesh format. Uploaded straight from the given memory
+    StaticMesh LoadGeneratedMesh(const float* BufferData, size_t BufferSize, const ElementIndex* IndexData, size_t IndexCount);
 
     //TODO(fraser) Going to want something that's not a model for level geometry like this, something that can be edited easily (and which doesn't need use a transform matrix)
     Model CreateBoxModel(AABB box);
-    Model CreateBoxModel(AABB box, Material texture);
+    Model CreateBoxModel(AABB box, MaterialHandle texture);
 
     void UpdateBrushModel(Brush* brush);
 
     Model CreatePlaneModel(Vec2f min, Vec2f max, float elevation = 0.0f, int subsections = 1);
-    Model CreatePlaneModel(Vec2f min, Vec2f max, Material material, float elevation = 0.0f, int subsections = 1);
+    Model CreatePlaneModel(Vec2f min, Vec2f max, MaterialHandle material, float elevation = 0.0f, int subsections = 1);
 
     void RecalculateTerrainModelNormals(Model& model);
 
@@ -260,6 +394,12 @@ public:
 
     void SetDirectionalLight(DirectionalLight dirLight);
 
+    void SetShadowCascadeSettings(ShadowCascadeSettings Settings);
+    ShadowCascadeSettings GetShadowCascadeSettings() const;
+
+    void SetPointShadowSettings(PointShadowSettings Settings);
+    PointShadowSettings GetPointShadowSettings() const;
+
     std::vector<float> GetModelVertexBuffer(Model& model);
     std::vector<unsigned int> GetModelIndexBuffer(Model& model);
 
@@ -270,14 +410,20 @@ public:
 
     void InitializeDebugDraw();
     void InitializeDebugDraw(Framebuffer_ID fBuffer);
-    void DebugDrawLine(Vec3f a, Vec3f b, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f));
-    void DebugDrawLine(LineSegment line, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f));
+
+    // Debug lines only last for the frame they're drawn in, unless given a duration (in seconds) to stick around for
+    void DebugDrawLine(Vec3f a, Vec3f b, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), float duration = 0.0f, DebugDrawLayer layer = DebugDrawLayer::WORLD);
+    void DebugDrawLine(LineSegment line, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), float duration = 0.0f, DebugDrawLayer layer = DebugDrawLayer::WORLD);
     
     // Extremely slow, basically never use this
-    void DebugDrawModelMesh(Model model, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f));
-    void DebugDrawAABB(AABB box, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), Mat4x4f transform = Mat4x4f());
-    void DebugDrawPoint(Vec3f p, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f));
-    void DebugDrawSphere(Vec3f p, float radius = 1.0f, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f));
+    void DebugDrawModelMesh(Model model, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), float duration = 0.0f, DebugDrawLayer layer = DebugDrawLayer::WORLD);
+    void DebugDrawAABB(AABB box, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), Mat4x4f transform = Mat4x4f(), float duration = 0.0f, DebugDrawLayer layer = DebugDrawLayer::WORLD);
+    void DebugDrawPoint(Vec3f p, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), float duration = 0.0f, DebugDrawLayer layer = DebugDrawLayer::WORLD);
+    void DebugDrawSphere(Vec3f p, float radius = 1.0f, Vec3f colour = Vec3f(1.0f, 1.0f, 1.0f), float duration = 0.0f, DebugDrawLayer layer = DebugDrawLayer::WORLD);
+
+    // Only affects the calling thread, pass nullptr to go back to drawing straight into the current frame
+    static void SetDebugDrawCapture(DebugDrawCapture* Capture);
+    void SubmitDebugDrawCapture(const DebugDrawCapture& Capture);
 
     Vec2i GetViewportSize();
 
@@ -288,6 +434,9 @@ public:
 
     Texture_ID GetLightTexture();
 
+    const RenderStats& GetRenderStats() const;
+    static const char* GetRenderPassName(RenderPass Pass);
+
     static GraphicsModule* Get() { return s_Instance; }
 
     //TEMP: public
@@ -312,10 +461,13 @@ private:
     Texture m_DefaultAOMap;
     Texture m_DefaultHeightMap;
 
-    Material m_DebugMaterial;
+    MaterialRegistry m_MaterialRegistry;
+    MaterialHandle m_DebugMaterial;
     
     VertexBufferFormat m_TexturedMeshFormat;
 
+    CompressedVertexLayout m_StaticMeshLayout;
+
     //TODO(Fraser): this should likely be moved to some sort of "Scene" and cubemaps should have a more generic interface in the graphics module
     Cubemap_ID m_SkyboxCubemap;
     StaticMesh_ID m_SkyboxMesh;
@@ -335,15 +487,56 @@ private:
     MeshData GetVertexDataForQuad();
     MeshData GetVertexDataFor3DQuad();
 
-    std::unordered_map<Vec3f, std::vector<float>, Vec3fHash> m_DebugLineMap;
+    void AddDebugLineVertices(Vec3f a, Vec3f b, Vec3f colour, DebugDrawLayer layer);
+
+    // Position + colour for every debug line vertex this frame, one array per layer
+    std::vector<float> m_DebugLineVertices[(int)DebugDrawLayer::COUNT];
+    std::vector<PersistentDebugLine> m_PersistentDebugLines;
     VertexBufferFormat m_DebugVertFormat;
-    StaticMesh_ID m_DebugDrawMesh;
 
     StaticMesh_ID m_BillboardQuadMesh;
     Texture_ID m_LightTexture;
 
-    Framebuffer_ID m_ShadowBuffer;
-    Camera m_ShadowCamera;
+    struct ShadowCascade
+    {
+        Mat4x4f LightSpaceMatrix;
+
+        // Centre and half-size of the cascade's (square) ortho volume, the light basis is shared by every cascade
+        Vec3f Center;
+        float Radius;
+
+        Vec3f LightRight;
+        Vec3f LightUp;
+        Vec3f LightDirection;
+    };
+
+    // Fits each cascade around its slice of the camera's view and uploads the cascade uniform data
+    void UpdateShadowCascades(Camera& Cam, Vec3f LightDirection);
+    void CreateShadowAtlas();
+
+    bool IsShadowCasterInCascade(const ShadowCascade& Cascade, const Sphere& Bounds);
+
+    // World space bounding sphere of a render command's mesh, false if the mesh's bounds aren't known
+    bool GetRenderCommandBounds(StaticMeshRenderCommand& Command, Sphere& OutBounds);
+
+    ShadowCascadeSettings m_ShadowCascadeSettings;
+    ShadowCascade m_ShadowCascades[MAX_SHADOW_CASCADES];
+    ShadowCascadeUniformData m_ShadowCascadeData;
+    UniformBuffer_ID m_ShadowCascadeUniformBuffer;
+    Framebuffer_ID m_ShadowAtlas;
+
+    // Collects the commands that cast shadows and can reach the shadow volume into m_ShadowCasters
+    void GatherShadowCasters();
+    bool IsShadowCasterInLightVolume(const Sphere& Bounds);
+
+    // Light space box (along the cascades' LightRight/LightUp/LightDirection) around every cascade, 
+    // stretched towards the light by the caster distance
+    Vec3f m_ShadowVolumeMin;
+    Vec3f m_ShadowVolumeMax;
+
+    // Shadow casters (still sorted by mesh) and their bounds, a negative radius means the bounds aren't known so it's always drawn
+    std::vector<StaticMeshRenderCommand*> m_ShadowCasters;
+    std::vector<Sphere> m_ShadowCasterBounds;
     Shader_ID m_PosShader;
     Shader_ID m_NormalsShader;
     Shader_ID m_AlbedoShader;
@@ -352,8 +545,199 @@ private:
     std::vector<BillboardRenderCommand> m_BillboardRenderCommands;
     std::vector<PointLightRenderCommand> m_PointLightRenderCommands;
 
+    // Sorts the static mesh commands so that commands sharing a mesh and material end up next to each other
+    void SortStaticMeshRenderCommands();
+
+    // Instanced draws are batched from these, kept around between frames to avoid reallocating every frame
+    std::vector<StaticMeshRenderCommand*> m_SortedStaticMeshRenderCommands;
+    std::vector<Mat4x4f> m_InstanceTransforms;
+
+    Shader_ID m_ShadowInstancedShader;
+
+    // Uniform handles for the per-draw uniforms, resolved once after the shaders are loaded
+    struct MaterialSamplerHandles
+    {
+        UniformHandle Albedo;
+        UniformHandle Normal;
+        UniformHandle Metallic;
+        UniformHandle Roughness;
+        UniformHandle AO;
+    };
+
+    struct GBufferSamplerHandles
+    {
+        UniformHandle Depth;
+        UniformHandle Normal;
+        UniformHandle Albedo;
+        UniformHandle Material;
+    };
+
+    MaterialSamplerHandles GetMaterialSamplerHandles(Shader_ID Shader);
+    GBufferSamplerHandles GetGBufferSamplerHandles(Shader_ID Shader);
+
+    void SetActiveMaterial(MaterialHandle Mat, const MaterialSamplerHandles& Samplers);
+    void SetActiveGBufferTextures(const GBuffer& Buffer, const GBufferSamplerHandles& Samplers);
+
+    MaterialSamplerHandles m_TexturedMeshSamplers;
+    UniformHandle m_TexturedMeshTransformation;
+    UniformHandle m_TexturedMeshCamera;
+    UniformHandle m_TexturedMeshCameraPos;
+    UniformHandle m_TexturedMeshSunDirection;
+    UniformHandle m_TexturedMeshSunColour;
+
+    MaterialSamplerHandles m_GBufferInstancedSamplers;
+
+    UniformHandle m_UnlitTransformation;
+    UniformHandle m_UnlitAlbedoMap;
+    UniformHandle m_UnlitCamera;
+
+    UniformHandle m_SkyboxProjection;
+    UniformHandle m_SkyboxView;
+    UniformHandle m_SkyboxCubemapSampler;
+
+    UniformHandle m_DebugLineCamera;
+
+    UniformHandle m_CombinerDepth;
+    UniformHandle m_CombinerNormal;
+    UniformHandle m_CombinerMaterial;
+    UniformHandle m_CombinerUnlit;
+    UniformHandle m_CombinerLighting;
+    UniformHandle m_CombinerSkyBox;
+
+    UniformHandle m_GBufferSkySampler;
+    UniformHandle m_GBufferDebugSampler;
+
+    UniformHandle m_ShadowLightSpaceMatrix;
+
+    GBufferSamplerHandles m_DirectionalLightSamplers;
+    UniformHandle m_DirectionalLightShadowMap;
+    UniformHandle m_DirectionalLightSunDirection;
+    UniformHandle m_DirectionalLightSunColour;
+
+    GBufferSamplerHandles m_PointLightSamplers;
+    UniformHandle m_PointLightData;
+    UniformHandle m_PointLightClusterRanges;
+    UniformHandle m_PointLightClusterIndices;
+    UniformHandle m_PointLightCameraForward;
+    UniformHandle m_PointLightClusterTilesX;
+    UniformHandle m_PointLightClusterTilesY;
+    UniformHandle m_PointLightClusterSlices;
+    UniformHandle m_PointLightDepthSliceScale;
+    UniformHandle m_PointLightDepthSliceBias;
+
+    // Bins this frame's point lights into m_LightClusters and uploads the light data and cluster lists
+    void BuildLightClusters(Camera& Cam);
+
+    struct PointShadowFace
+    {
+        Mat4x4f LightSpaceMatrix;
+
+        // Light position/radius the face was last drawn with, a radius of 0 means it's never been drawn
+        Vec3f LightPosition;
+        float LightRadius = 0.0f;
+
+        bool Dirty = true;
+    };
+
+    struct PointShadowCacheEntry
+    {
+        bool InUse = false;
+        bool SeenThisFrame = false;
+
+        Vec3f LightPosition;
+        float LightRadius = 0.0f;
+
+        // Hash of the meshes/transforms of every caster within the light's radius, in the order they're drawn
+        // Invalid until it's been worked out for the light's current position
+        uint64_t CasterSignature = 0;
+        bool CasterSignatureValid = false;
+
+        PointShadowFace Faces[6];
+    };
+
+    struct PointShadowDirtyFace
+    {
+        int Slot;
+        int Face;
+        bool NeverDrawn;
+        float DistanceToCamera;
+    };
+
+    // Matches this frame's shadowed point lights to cache entries, then redraws as many dirty faces as the budget allows
+    void UpdatePointShadows(Camera& Cam);
+    void CreatePointShadowAtlas();
+
+    int FindPointShadowEntry(Vec3f Position, float Radius);
+    uint64_t GetPointShadowCasterSignature(Vec3f Position, float Radius);
+    void DrawPointShadowFace(int Slot, int Face);
+
+    PointShadowSettings m_PointShadowSettings;
+    std::vector<PointShadowCacheEntry> m_PointShadowCache;
+
+    // Every shadow casting command this frame and its bounds (negative radius if unknown), shared by all the point lights
+    std::vector<StaticMeshRenderCommand*> m_PointShadowCasters;
+    std::vector<Sphere> m_PointShadowCasterBounds;
+    std::vector<uint64_t> m_PointShadowCasterHashes;
+
+    // Signature of every caster last frame, lights only rescan the casters when this changes
+    uint64_t m_PointShadowAllCastersSignature = 0;
+
+    // Faces waiting to be redrawn, kept around so it isn't reallocated every frame
+    std::vector<PointShadowDirtyFace> m_PointShadowDirtyFaces;
+
+    // Cache slot of each point light render command this frame, -1 if it doesn't have shadows
+    std::vector<int> m_PointLightShadowSlots;
+
+    // Five texels per cube face: light space matrix columns, light position + radius the face was drawn with
+    std::vector<Vec4f> m_PointShadowTexels;
+
+    Framebuffer_ID m_PointShadowAtlas;
+    BufferTexture_ID m_PointShadowDataBuffer;
+
+    Shader_ID m_PointShadowShader;
+    UniformHandle m_PointShadowLightSpaceMatrix;
+    UniformHandle m_PointShadowLightPosition;
+    UniformHandle m_PointShadowLightRadius;
+
+    UniformHandle m_PointLightShadowAtlas;
+    UniformHandle m_PointLightShadowData;
+
+    std::vector<ClusterLight> m_ClusterLights;
+    LightClusterGrid m_LightClusters;
+
+    // Three texels per light: position + radius, colour * intensity, shadow cache slot (-1 for none)
+    std::vector<Vec4f> m_PointLightTexels;
+
+    BufferTexture_ID m_PointLightDataBuffer;
+    BufferTexture_ID m_ClusterRangeBuffer;
+    BufferTexture_ID m_ClusterLightIndexBuffer;
+
+    UniformBuffer_ID m_FrameUniformBuffer;
+
+    // Times the GPU work of one pass for as long as it's in scope
+    class ScopedPassTimer
+    {
+    public:
+        ScopedPassTimer(GraphicsModule& Graphics, RenderPass Pass);
+        ~ScopedPassTimer();
+
+    private:
+        GraphicsModule& m_Graphics;
+        RenderPass m_Pass;
+    };
+
+    // Reads back the oldest frame of pass timers (if the GPU's done with them) and moves on to the next frame
+    void ResolvePassTimers();
+
+    TimerQuery_ID m_PassTimers[GPU_TIMER_FRAMES][(int)RenderPass::COUNT];
+    bool m_PassTimerIssued[GPU_TIMER_FRAMES][(int)RenderPass::COUNT] = {};
+    size_t m_PassTimerFrame = 0;
+
+    RenderStats m_RenderStats;
+
     // GBuffer stuff
     Shader_ID m_GBufferShader;
+    Shader_ID m_GBufferInstancedShader;
     Shader_ID m_GBufferOldLightingShader;
     Shader_ID m_GBufferSkyShader;
     Shader_ID m_GBufferDebugShader;
@@ -1,6 +1,6 @@
 #include "InputModule.h"
 
-#include "..\GameEngine.h"
+#include "../GameEngine.h"
 
 InputModule* InputModule::s_Instance = nullptr;
 
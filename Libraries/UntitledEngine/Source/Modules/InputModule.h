@@ -1,7 +1,7 @@
 #pragma once
 
-#include "..\Math\Vector.h"
-#include "..\Interfaces\Resizeable_i.h"
+#include "../Math/Vector.h"
+#include "../Interfaces/Resizeable_i.h"
 
 #include <queue>
 
@@ -69,6 +69,19 @@ enum class Key
 	Plus,
 	Minus,
 
+	F1,
+	F2,
+	F3,
+	F4,
+	F5,
+	F6,
+	F7,
+	F8,
+	F9,
+	F10,
+	F11,
+	F12,
+
 	Count
 };
 
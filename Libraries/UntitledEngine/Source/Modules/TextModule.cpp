@@ -9,6 +9,7 @@ TextModule* TextModule::s_Instance = nullptr;
 
 TextModule::TextModule(Renderer& renderer)
     : m_Renderer(renderer)
+    , m_TextVertexFormat({ VertAttribute::Vec2f, VertAttribute::Vec2f })
 {
     FT_Error error = FT_Init_FreeType(&m_Library);
 
@@ -56,6 +57,10 @@ TextModule::TextModule(Renderer& renderer)
 
     m_TextShader = m_Renderer.LoadShader(vertShaderSource, fragShaderSource);
 
+    m_TextColourUniform = m_Renderer.GetUniformHandle(m_TextShader, "TextColour");
+    m_TextPositionUniform = m_Renderer.GetUniformHandle(m_TextShader, "TextPosition");
+    m_TextTextureSampler = m_Renderer.GetUniformHandle(m_TextShader, "Texture");
+
     Vec2i viewportSize = m_Renderer.GetViewportSize();
 
     Mat4x4f orthoMatrix = Math::GenerateOrthoMatrix(0.0f, (float)viewportSize.x, 0.0f, (float)viewportSize.y, 0.0f, 100.0f);
@@ -151,9 +156,9 @@ void TextModule::DrawText(std::string text, Font* font, Vec2f position, Vec3f co
 
     m_Renderer.SetActiveShader(m_TextShader);
 
-    TextMeshInfo meshInfo = GetTextMeshInfo(text, *font);
+    const TextMeshInfo& meshInfo = GetTextMeshInfo(text, *font);
     
-    m_Renderer.SetShaderUniformVec3f(m_TextShader, "TextColour", colour);
+    m_Renderer.SetShaderUniformVec3f(m_TextColourUniform, colour);
     
     // Temp(fraser): set up "anchor points" for text
 
@@ -174,11 +179,12 @@ void TextModule::DrawText(std::string text, Font* font, Vec2f position, Vec3f co
         break;
     }
    
-    m_Renderer.SetShaderUniformVec2f(m_TextShader, "TextPosition", position);
+    m_Renderer.SetShaderUniformVec2f(m_TextPositionUniform, position);
 
-    m_Renderer.SetActiveTexture(font->m_TextureAtlas, "Texture");
+    m_Renderer.SetActiveTexture(font->m_TextureAtlas, m_TextTextureSampler);
     
-    m_Renderer.DrawMesh(meshInfo.m_Mesh);
+    DynamicGeometry TextGeometry = m_Renderer.WriteDynamicGeometry(m_TextVertexFormat, meshInfo.m_Vertices, meshInfo.m_Indices);
+    m_Renderer.DrawDynamicGeometry(TextGeometry);
 }
 
 void TextModule::Resize(Vec2i newSize)
@@ -188,7 +194,7 @@ void TextModule::Resize(Vec2i newSize)
 
 }
 
-TextMeshInfo TextModule::GetTextMeshInfo(std::string text, Font& font)
+const TextMeshInfo& TextModule::GetTextMeshInfo(std::string text, Font& font)
 {
     TextInfo ti = TextInfo{ text, &font };
 
@@ -196,11 +202,10 @@ TextMeshInfo TextModule::GetTextMeshInfo(std::string text, Font& font)
 
     if (got == m_CachedStrings.end())
     {
-        TextMeshInfo meshInfo = GenerateTextMeshInfo(text, font);
-        m_CachedStrings[ti] = meshInfo;
+        got = m_CachedStrings.emplace(ti, GenerateTextMeshInfo(text, font)).first;
     }
 
-    return m_CachedStrings[ti];
+    return got->second;
 }
 
 TextMeshInfo TextModule::GenerateTextMeshInfo(std::string text, Font& font)
@@ -208,11 +213,9 @@ TextMeshInfo TextModule::GenerateTextMeshInfo(std::string text, Font& font)
     TextMeshInfo textInfo;
     textInfo.m_Font = &font;
     textInfo.m_String = text;
-    
-    VertexBufferFormat vertFormat = { VertAttribute::Vec2f, VertAttribute::Vec2f };
 
-    std::vector<float> textQuadsVertices;
-    std::vector<ElementIndex> indexBuffer;
+    std::vector<float>& textQuadsVertices = textInfo.m_Vertices;
+    std::vector<ElementIndex>& indexBuffer = textInfo.m_Indices;
 
     Vec2i fontAtlasSize = textInfo.m_Font->m_AtlasSize;
 
@@ -253,7 +256,5 @@ TextMeshInfo TextModule::GenerateTextMeshInfo(std::string text, Font& font)
         cursor.y += c.Advance.y >> 6;
     }
 
-    textInfo.m_Mesh = m_Renderer.LoadMesh(vertFormat, textQuadsVertices, indexBuffer);
-
     return textInfo;
 }
@@ -1,9 +1,9 @@
 #pragma once
 
-#include "Platform\RendererPlatform.h"
-#include "Interfaces\Resizeable_i.h"
+#include "Platform/RendererPlatform.h"
+#include "Interfaces/Resizeable_i.h"
 
-#include "Utils\Hash.h"
+#include "Utils/Hash.h"
 
 #include <unordered_map>
 
@@ -59,8 +59,11 @@ struct TextMeshInfo
 {
     std::string m_String;
     Rect m_Bounds;
-    StaticMesh_ID m_Mesh;
     Font* m_Font;
+
+    // Kept on the CPU and written into the renderer's dynamic geometry buffer whenever the string is drawn
+    std::vector<float> m_Vertices;
+    std::vector<ElementIndex> m_Indices;
 };
 
 class TextModule : public IResizeable
@@ -82,14 +85,20 @@ private:
 
     std::unordered_map<TextInfo, TextMeshInfo, Hash::Hasher<TextInfo>> m_CachedStrings;
 
-    TextMeshInfo GetTextMeshInfo(std::string text, Font& font);
+    const TextMeshInfo& GetTextMeshInfo(std::string text, Font& font);
     TextMeshInfo GenerateTextMeshInfo(std::string text, Font& font);
 
     FT_Library m_Library;
     Renderer& m_Renderer;
 
+    VertexBufferFormat m_TextVertexFormat;
+
     Shader_ID m_TextShader;
 
+    UniformHandle m_TextColourUniform;
+    UniformHandle m_TextPositionUniform;
+    UniformHandle m_TextTextureSampler;
+
     static TextModule* s_Instance;
 };
 
@@ -112,10 +112,12 @@ UIModule::UIModule(GraphicsModule& graphics, TextModule& text, InputModule& inpu
 
     m_UIShader = m_Graphics.CreateShader(vertShaderSource, fragShaderSource);
 
-    Resize(m_Renderer.GetViewportSize());
+    m_UIHoveringUniform = m_Renderer.GetUniformHandle(m_UIShader, "Hovering");
+    m_UIClickingUniform = m_Renderer.GetUniformHandle(m_UIShader, "Clicking");
+    m_UIColourUniform = m_Renderer.GetUniformHandle(m_UIShader, "Colour");
+    m_UITextureSampler = m_Renderer.GetUniformHandle(m_UIShader, "Texture");
 
-    m_BorderMesh = m_Renderer.CreateEmptyMesh(UIElementFormat, true);
-    m_RectMesh = m_Renderer.CreateEmptyMesh(UIElementFormat, true);
+    Resize(m_Renderer.GetViewportSize());
 
     m_FrameFont = m_Text.LoadFont("Assets/fonts/ARLRDBD.TTF", 12);
 
@@ -162,16 +164,16 @@ void UIModule::ImgPanel(Texture texture, Rect rect)
 
     MeshData vertexData = GetVertexDataForRect(rect);
 
-    m_Renderer.UpdateMeshData(m_RectMesh, UIElementFormat, vertexData.first, vertexData.second);
+    DynamicGeometry RectGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, vertexData.first, vertexData.second);
 
-    m_Renderer.SetActiveTexture(texture.Id, "Texture");
+    m_Renderer.SetActiveTexture(texture.Id, m_UITextureSampler);
     m_Renderer.SetActiveShader(m_UIShader);
 
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Hovering", false);
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Clicking", false);
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", c_White);
+    m_Renderer.SetShaderUniformBool(m_UIHoveringUniform, false);
+    m_Renderer.SetShaderUniformBool(m_UIClickingUniform, false);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, c_White);
 
-    m_Renderer.DrawMesh(m_RectMesh);
+    m_Renderer.DrawDynamicGeometry(RectGeometry);
 
     m_Renderer.EnableDepthTesting();
 }
@@ -192,16 +194,16 @@ void UIModule::ImgPanel(Texture_ID texture, Rect rect)
 
     MeshData vertexData = GetVertexDataForRect(rect);
 
-    m_Renderer.UpdateMeshData(m_RectMesh, UIElementFormat, vertexData.first, vertexData.second);
+    DynamicGeometry RectGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, vertexData.first, vertexData.second);
 
-    m_Renderer.SetActiveTexture(texture, "Texture");
+    m_Renderer.SetActiveTexture(texture, m_UITextureSampler);
     m_Renderer.SetActiveShader(m_UIShader);
 
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Hovering", false);
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Clicking", false);
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", c_White);
+    m_Renderer.SetShaderUniformBool(m_UIHoveringUniform, false);
+    m_Renderer.SetShaderUniformBool(m_UIClickingUniform, false);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, c_White);
 
-    m_Renderer.DrawMesh(m_RectMesh);
+    m_Renderer.DrawDynamicGeometry(RectGeometry);
 
     m_Renderer.EnableDepthTesting();
 }
@@ -222,20 +224,17 @@ void UIModule::BufferPanel(Framebuffer_ID fBuffer, Rect rect)
 
     MeshData vertexData = GetVertexDataForRect(rect);
 
-    m_Renderer.UpdateMeshData(m_RectMesh, UIElementFormat, vertexData.first, vertexData.second);
+    DynamicGeometry RectGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, vertexData.first, vertexData.second);
 
-    //auto testIndices = m_Renderer.MapMeshElements(m_RectMesh);
-    //
-    //m_Renderer.UnmapMeshElements(m_RectMesh);
-    m_Renderer.SetActiveFBufferTexture(fBuffer, "Texture");
+    m_Renderer.SetActiveFBufferTexture(fBuffer, m_UITextureSampler);
 
     m_Renderer.SetActiveShader(m_UIShader);
 
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Hovering", false);
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Clicking", false);
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", c_White);
+    m_Renderer.SetShaderUniformBool(m_UIHoveringUniform, false);
+    m_Renderer.SetShaderUniformBool(m_UIClickingUniform, false);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, c_White);
 
-    m_Renderer.DrawMesh(m_RectMesh);
+    m_Renderer.DrawDynamicGeometry(RectGeometry);
 
     m_Renderer.EnableDepthTesting();
 }
@@ -302,14 +301,14 @@ Click UIModule::ImgButton(std::string name, Texture texture, Vec2f size, float b
 
     MeshData VertexData = GetVertexDataForRect(innerRect);
 
-    m_Renderer.UpdateMeshData(m_RectMesh, UIElementFormat, VertexData.first, VertexData.second);
+    DynamicGeometry RectGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, VertexData.first, VertexData.second);
 
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", c_White);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, c_White);
 
-    m_Renderer.SetActiveTexture(texture.Id, "Texture");
+    m_Renderer.SetActiveTexture(texture.Id, m_UITextureSampler);
 
     //TODO: come up with better depth testing solution for rendering UI
-    m_Renderer.DrawMesh(m_RectMesh);
+    m_Renderer.DrawDynamicGeometry(RectGeometry);
 
     return Result;
 }
@@ -338,14 +337,14 @@ Click UIModule::BufferButton(std::string name, Framebuffer_ID fBuffer, Vec2f siz
 
     MeshData VertexData = GetVertexDataForRect(innerRect);
 
-    m_Renderer.UpdateMeshData(m_RectMesh, UIElementFormat, VertexData.first, VertexData.second);
+    DynamicGeometry RectGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, VertexData.first, VertexData.second);
 
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", c_White);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, c_White);
 
-    m_Renderer.SetActiveFBufferTexture(fBuffer, "Texture");
+    m_Renderer.SetActiveFBufferTexture(fBuffer, m_UITextureSampler);
 
     //TODO: come up with better depth testing solution for rendering UI
-    m_Renderer.DrawMesh(m_RectMesh);
+    m_Renderer.DrawDynamicGeometry(RectGeometry);
 
     return Result;
 }
@@ -454,24 +453,24 @@ void UIModule::StartFrame(std::string name, Rect rect, float borderWidth, Vec3f
     
     m_Renderer.SetActiveShader(m_UIShader);
     
-    m_Renderer.UpdateMeshData(m_BorderMesh, UIElementFormat, verts.first, verts.second);
-    m_Renderer.SetActiveTexture(m_DefaultFrameTexture, "Texture");
+    DynamicGeometry BorderGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, verts.first, verts.second);
+    m_Renderer.SetActiveTexture(m_DefaultFrameTexture, m_UITextureSampler);
 
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Hovering", false);
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Clicking", false);
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", colour);
+    m_Renderer.SetShaderUniformBool(m_UIHoveringUniform, false);
+    m_Renderer.SetShaderUniformBool(m_UIClickingUniform, false);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, colour);
 
-    m_Renderer.DrawMesh(m_BorderMesh);
+    m_Renderer.DrawDynamicGeometry(BorderGeometry);
 
     verts = GetVertexDataForRect(Rect(rect.location + Vec2f(borderWidth, borderWidth), rect.size - Vec2f(borderWidth * 2, borderWidth * 2)));
     
-    m_Renderer.UpdateMeshData(m_RectMesh, UIElementFormat, verts.first, verts.second);
+    DynamicGeometry RectGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, verts.first, verts.second);
 
-    m_Renderer.SetActiveTexture(m_White, "Texture");
+    m_Renderer.SetActiveTexture(m_White, m_UITextureSampler);
 
     //m_Renderer.ClearStencilBuffer();
     m_Renderer.StartStencilDrawing(StencilCompareFunc::EQUAL, StencilOperationFunc::INCREMENT, (int)m_FrameStateStack.size() - 1);
-    m_Renderer.DrawMesh(m_RectMesh);
+    m_Renderer.DrawDynamicGeometry(RectGeometry);
     m_Renderer.EndStencilDrawing();
 
     if (name != "")
@@ -697,17 +696,17 @@ Click UIModule::ButtonInternal(std::string name, Rect rect, float borderWidth, V
     m_Renderer.DisableDepthTesting();
     MeshData vertexData = GetVertexDataForBorderMesh(rect, borderWidth);
 
-    m_Renderer.UpdateMeshData(m_BorderMesh, UIElementFormat, vertexData.first, vertexData.second);
+    DynamicGeometry BorderGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, vertexData.first, vertexData.second);
 
     m_Renderer.SetActiveShader(m_UIShader);
 
-    m_Renderer.SetActiveTexture(m_DefaultButtonTexture, "Texture");
+    m_Renderer.SetActiveTexture(m_DefaultButtonTexture, m_UITextureSampler);
 
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Hovering", BState->m_Click.hovering);
-    m_Renderer.SetShaderUniformBool(m_UIShader, "Clicking", BState->m_Click.clicking);
-    m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", colour);
+    m_Renderer.SetShaderUniformBool(m_UIHoveringUniform, BState->m_Click.hovering);
+    m_Renderer.SetShaderUniformBool(m_UIClickingUniform, BState->m_Click.clicking);
+    m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, colour);
 
-    m_Renderer.DrawMesh(m_BorderMesh);
+    m_Renderer.DrawDynamicGeometry(BorderGeometry);
 
     m_Renderer.EnableDepthTesting();
     // End render
@@ -743,14 +742,14 @@ void UIModule::FloatSliderInternal(std::string name, Rect rect, float& outNum, f
 
         m_Renderer.SetActiveShader(m_UIShader);
 
-        m_Renderer.UpdateMeshData(m_BorderMesh, UIElementFormat, verts.first, verts.second);
-        m_Renderer.SetActiveTexture(m_DefaultFrameTexture, "Texture");
+        DynamicGeometry BorderGeometry = m_Renderer.WriteDynamicGeometry(UIElementFormat, verts.first, verts.second);
+        m_Renderer.SetActiveTexture(m_DefaultFrameTexture, m_UITextureSampler);
 
-        m_Renderer.SetShaderUniformBool(m_UIShader, "Hovering", false);
-        m_Renderer.SetShaderUniformBool(m_UIShader, "Clicking", false);
-        m_Renderer.SetShaderUniformVec3f(m_UIShader, "Colour", colour);
+        m_Renderer.SetShaderUniformBool(m_UIHoveringUniform, false);
+        m_Renderer.SetShaderUniformBool(m_UIClickingUniform, false);
+        m_Renderer.SetShaderUniformVec3f(m_UIColourUniform, colour);
 
-        m_Renderer.DrawMesh(m_BorderMesh);
+        m_Renderer.DrawDynamicGeometry(BorderGeometry);
 
         if (name != "" && drawText)
         {
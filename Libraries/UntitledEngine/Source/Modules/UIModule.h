@@ -1,10 +1,10 @@
 #pragma once
-#include "Platform\RendererPlatform.h"
-#include "Interfaces\Resizeable_i.h"
-#include "Modules\GraphicsModule.h"
-#include "Modules\TextModule.h"
-#include "Modules\InputModule.h"
-#include "Utils\Hash.h"
+#include "Platform/RendererPlatform.h"
+#include "Interfaces/Resizeable_i.h"
+#include "Modules/GraphicsModule.h"
+#include "Modules/TextModule.h"
+#include "Modules/InputModule.h"
+#include "Utils/Hash.h"
 
 #include <unordered_map>
 #include <functional>
@@ -171,9 +171,6 @@ private:
 
     size_t m_HashCount = 0;
 
-    StaticMesh_ID m_RectMesh;
-    StaticMesh_ID m_BorderMesh;
-
     Texture_ID m_DefaultButtonTexture;
     Texture_ID m_DefaultFrameTexture;
     Texture_ID m_DefaultTabTexture;
@@ -181,6 +178,11 @@ private:
 
     Shader_ID m_UIShader;
 
+    UniformHandle m_UIHoveringUniform;
+    UniformHandle m_UIClickingUniform;
+    UniformHandle m_UIColourUniform;
+    UniformHandle m_UITextureSampler;
+
     GraphicsModule& m_Graphics;
     TextModule& m_Text;
     InputModule& m_Input;
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "..\Math\Math.h"
+#include "../Math/Math.h"
 
 #include <string>
 
@@ -43,4 +43,22 @@ namespace Engine
 
     extern void RunCommand(std::string Command);
 
+    // Hands back lines typed into the console the engine was started from, one per call, false once there are none left.
+    // Only the POSIX platform has a console to read from
+    extern bool PollConsoleLine(std::string& OutLine);
+
+    // A whole file mapped read-only into memory, the OS pages it in as it's read instead of it being copied into a buffer up front
+    struct MappedFile
+    {
+        const char* Data = nullptr;
+        size_t Size = 0;
+
+        // Whatever the platform needs to unmap it again
+        void* Handle = nullptr;
+    };
+
+    // Empty files map fine, they just have no Data
+    extern bool MapFile(const std::string& FilePath, MappedFile& OutFile);
+    extern void UnmapFile(MappedFile& File);
+
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "RendererPlatform.h"
+
+// Renderer-independent parts of the renderer interface, shared by every renderer backend
+
+VertexBufferFormat::VertexBufferFormat(std::initializer_list<VertAttribute> vertAttributes, unsigned int instanceDivisor)
+    : _attributes(vertAttributes)
+    , _vertexStride(0)
+    , _instanceDivisor(instanceDivisor)
+{
+    for (auto it = vertAttributes.begin(); it != vertAttributes.end(); ++it)
+    {
+        _vertexStride += GetSize(*it);
+    }
+}
+
+const std::vector<VertAttribute>& VertexBufferFormat::GetAttributes() const
+{
+    return _attributes;
+}
+
+unsigned int VertexBufferFormat::GetVertexStride() const
+{
+    return _vertexStride;
+}
+
+unsigned int VertexBufferFormat::GetCount(VertAttribute vertAttribute) const
+{
+    switch (vertAttribute)
+    {
+    case VertAttribute::Int:
+    case VertAttribute::UInt:
+    case VertAttribute::Float:
+        return 1;
+    case VertAttribute::Vec2f:
+    case VertAttribute::Vec2ShortNorm:
+    case VertAttribute::Vec2Half:
+        return 2;
+    case VertAttribute::Vec3f:
+        return 3;
+    case VertAttribute::Vec4f:
+    case VertAttribute::Vec4UShortNorm:
+    case VertAttribute::Vec4UByteNorm:
+    case VertAttribute::Vec4Half:
+        return 4;
+    case VertAttribute::Mat4x4f:
+        return 16;
+    case VertAttribute::Empty:
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+unsigned int VertexBufferFormat::GetSize(VertAttribute vertAttribute) const
+{
+    switch (vertAttribute)
+    {
+    case VertAttribute::Int:
+        return sizeof(int);
+    case VertAttribute::UInt:
+        return sizeof(unsigned int);
+    case VertAttribute::Float:
+    case VertAttribute::Vec2f:
+    case VertAttribute::Vec3f:
+    case VertAttribute::Vec4f:
+    case VertAttribute::Mat4x4f:
+        return sizeof(float) * GetCount(vertAttribute);
+    case VertAttribute::Vec2ShortNorm:
+    case VertAttribute::Vec4UShortNorm:
+    case VertAttribute::Vec2Half:
+    case VertAttribute::Vec4Half:
+        return sizeof(uint16_t) * GetCount(vertAttribute);
+    case VertAttribute::Vec4UByteNorm:
+        return sizeof(uint8_t) * GetCount(vertAttribute);
+    case VertAttribute::Empty:
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+unsigned int VertexBufferFormat::GetLocationCount(VertAttribute vertAttribute) const
+{
+    switch (vertAttribute)
+    {
+    case VertAttribute::Mat4x4f:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+unsigned int VertexBufferFormat::GetInstanceDivisor() const
+{
+    return _instanceDivisor;
+}
+
+bool VertexBufferFormat::IsInstanced() const
+{
+    return _instanceDivisor != 0;
+}
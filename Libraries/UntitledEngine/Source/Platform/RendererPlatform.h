@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <initializer_list>
@@ -15,20 +16,30 @@ typedef GUID Cubemap_ID;
 typedef GUID Shader_ID;
 typedef GUID StaticMesh_ID;
 typedef GUID GBuffer_ID;
+typedef GUID UniformBuffer_ID;
+typedef GUID BufferTexture_ID;
+typedef GUID TimerQuery_ID;
 
 typedef unsigned int ElementIndex;
 
+// First attribute location used by per-instance vertex attributes, meshes should keep their own attributes below this
+#define INSTANCE_ATTRIBUTE_LOCATION 8
+
 enum class ColourFormat
 {
     RGB,
     RGBA,
+    RG,
     Red,
-    DEPTH
+    DEPTH,
+    DEPTH_STENCIL
 };
 
+// For render targets this also picks the size of each channel (FLOAT -> 32 bit, HALF_FLOAT -> 16 bit, UNSIGNED_BYTE -> 8 bit)
 enum class DataFormat
 {
     FLOAT,
+    HALF_FLOAT,
     UNSIGNED_BYTE
 };
 
@@ -39,6 +50,14 @@ enum class FBufferFormat
     EMPTY
 };
 
+// Texel formats for buffer textures (R32UI -> usamplerBuffer, RGBA32F -> samplerBuffer)
+enum class BufferTextureFormat
+{
+    R32UI,
+    RG32UI,
+    RGBA32F
+};
+
 enum class TextureMode
 {
     NEAREST,
@@ -47,18 +66,85 @@ enum class TextureMode
 
 enum class VertAttribute
 {
-    //TODO(Fraser) Add normalized fixed-point types
     Int,
     UInt,
     Float,
     Vec2f,
     Vec3f,
     Vec4f,
+    Mat4x4f,
+
+    // Normalized fixed-point types, shaders read them as floats in [-1, 1] (signed) or [0, 1] (unsigned)
+    Vec2ShortNorm,
+    Vec4UShortNorm,
+    Vec4UByteNorm,
+
+    // 16 bit floats
+    Vec2Half,
+    Vec4Half,
+
+    // Takes up an attribute location without any data in the buffer, 
+    // shaders see a constant opaque white instead (so vertex colours can be left out)
+    Empty,
+};
+
+// How each part of a Vertex is stored in a compressed static mesh (see Rendering/VertexCompression.h)
+enum class PositionEncoding
+{
+    Float,      // 12 bytes
+    Half,       // 8 bytes, relative to the mesh's bounds
+    UNorm16     // 8 bytes, relative to the mesh's bounds
+};
+
+enum class NormalEncoding
+{
+    Float,      // 12 bytes
+    Octahedral  // 4 bytes
+};
+
+enum class ColourEncoding
+{
+    Float,      // 16 bytes
+    UNorm8,     // 4 bytes
+    None        // Every vertex is white
+};
+
+enum class UVEncoding
+{
+    Float,      // 8 bytes
+    Half        // 4 bytes
+};
+
+struct CompressedVertexLayout
+{
+    PositionEncoding Position = PositionEncoding::UNorm16;
+    NormalEncoding Normal = NormalEncoding::Octahedral;
+    ColourEncoding Colour = ColourEncoding::UNorm8;
+    UVEncoding UV = UVEncoding::Half;
+
+    // Leave the colour out altogether for meshes where every vertex is white (almost all of them)
+    bool DropWhiteColour = true;
+};
+
+// What a vertex shader needs to turn a compressed vertex back into a full one, the renderer sets it for each mesh it draws
+// through the MeshPositionDecode (xyz offset, w scale) and MeshOctahedralNormals uniforms
+struct VertexDecode
+{
+    // position = stored position * PositionScale + PositionOffset
+    Vec3f PositionOffset;
+    float PositionScale = 1.0f;
+
+    bool OctahedralNormals = false;
+
+    friend bool operator==(const VertexDecode& lhs, const VertexDecode& rhs)
+    {
+        return lhs.PositionOffset == rhs.PositionOffset && lhs.PositionScale == rhs.PositionScale && lhs.OctahedralNormals == rhs.OctahedralNormals;
+    }
 };
 
 struct TextureCreateInfo
 {
-    TextureCreateInfo(Vec2i Size, ColourFormat InternalFormat, ColourFormat ExternalFormat, DataFormat DataFormat) 
+    TextureCreateInfo(Vec2i Size, ColourFormat InternalFormat, ColourFormat ExternalFormat, ::DataFormat DataFormat) 
         : Size(Size), InternalFormat(InternalFormat), ExternalFormat(ExternalFormat), DataFormat(DataFormat)
     {}
 
@@ -67,26 +153,96 @@ struct TextureCreateInfo
     Vec2i Size;
     ColourFormat InternalFormat = ColourFormat::RGBA;
     ColourFormat ExternalFormat = ColourFormat::RGBA;
-    DataFormat DataFormat = DataFormat::FLOAT;
+    ::DataFormat DataFormat = ::DataFormat::FLOAT;
 };
 
 
 class VertexBufferFormat
 {
 public:
-    VertexBufferFormat(std::initializer_list<VertAttribute> vertAttributes);
+    // An instance divisor of 0 means the attributes advance per vertex, otherwise they advance once every <instanceDivisor> instances
+    VertexBufferFormat(std::initializer_list<VertAttribute> vertAttributes, unsigned int instanceDivisor = 0);
 
-    void EnableVertexAttributes() const;
+    void EnableVertexAttributes(unsigned int firstLocation = 0) const;
 
     const std::vector<VertAttribute>& GetAttributes() const;
     unsigned int GetVertexStride() const;
 
     unsigned int GetCount(VertAttribute vertAttribute) const;
     unsigned int GetSize(VertAttribute vertAttribute) const;
+    
+    // Number of attribute locations the attribute takes up (matrices take one per column)
+    unsigned int GetLocationCount(VertAttribute vertAttribute) const;
+
+    unsigned int GetInstanceDivisor() const;
+    bool IsInstanced() const;
 
 private:
     std::vector<VertAttribute> _attributes;
     unsigned int _vertexStride;
+    unsigned int _instanceDivisor;
+};
+
+// A uniform location resolved ahead of time so setting it doesn't need a name lookup
+struct UniformHandle
+{
+    Shader_ID Shader = 0;
+    int Location = -1;
+
+    // Texture slot assigned to the uniform if it's a sampler, otherwise -1
+    int TextureSlot = -1;
+
+    bool IsValid() const { return Location >= 0; }
+};
+
+// A range of the renderer's per-frame dynamic geometry buffer, written with WriteDynamicGeometry
+// Only good for the frame it was written in, the space gets reused a couple of frames later
+struct DynamicGeometry
+{
+    // Which vertex format's VAO to draw with
+    unsigned int Format = 0;
+
+    int BaseVertex = 0;
+    unsigned int VertexCount = 0;
+
+    // Byte offset of the first index, IndexCount is 0 for non-indexed geometry
+    unsigned int IndexOffset = 0;
+    unsigned int IndexCount = 0;
+
+    bool IsValid() const { return VertexCount > 0; }
+};
+
+// Work a renderer has been asked to do since the stats were last reset.
+// Only the headless renderer counts anything, the others leave it all at 0
+struct RendererStats
+{
+    uint64_t Calls = 0;
+
+    // Shader, texture, cubemap, framebuffer and buffer texture binds
+    uint64_t Binds = 0;
+
+    // Anything that sends data over to the GPU (mesh and texture data, uniforms, uniform buffers, dynamic geometry...)
+    uint64_t Uploads = 0;
+    uint64_t BytesUploaded = 0;
+
+    uint64_t DrawCalls = 0;
+    uint64_t Instances = 0;
+
+    // Vertices (or elements, for indexed meshes) submitted across every draw
+    uint64_t Vertices = 0;
+};
+
+// One call made to the renderer, as kept in the headless renderer's call log
+struct RecordedRenderCall
+{
+    // Name of the Renderer function that was called
+    const char* Function = nullptr;
+
+    // Mesh, texture, shader etc. the call was about, 0 if it wasn't about one
+    GUID Resource = 0;
+
+    // Data uploaded by the call
+    uint64_t Bytes = 0;
 };
 
 enum class VertType
@@ -181,6 +337,10 @@ public:
     
     Texture_ID AttachColourAttachmentToFrameBuffer(Framebuffer_ID buffer, TextureCreateInfo createInfo, int attachmentIndex);
 
+    // Replaces the FBuffer's depth/stencil render buffer with a texture so that it can be sampled later
+    // FBuffers created with this one's depth buffer afterwards share the texture
+    Texture_ID AttachDepthTextureToFrameBuffer(Framebuffer_ID buffer);
+
     Texture_ID LoadTexture(Vec2i size, std::vector<unsigned char> textureData, ColourFormat format, TextureMode minTexMode = TextureMode::LINEAR, TextureMode magTexMode = TextureMode::LINEAR);
     Texture_ID LoadTexture(std::string filePath, TextureMode minTexMode = TextureMode::LINEAR, TextureMode magTexMode = TextureMode::LINEAR);
     
@@ -193,6 +353,12 @@ public:
 
     StaticMesh_ID LoadMesh(const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData);
     StaticMesh_ID LoadMesh(const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData, std::vector<ElementIndex> indices);
+    // Uploads straight from wherever the data already is (a mapped file say) rather than taking copies of it
+    StaticMesh_ID LoadMesh(const VertexBufferFormat& vertBufFormat, const float* vertexData, size_t vertexFloatCount, const ElementIndex* indices, size_t indexCount);
+
+    // Vertex data is given as full Vertex structs and stored in the layout asked for. Reading the data back, 
+    // mapping the vertices and the bounds all still work in terms of Vertex, they're decoded (and re-encoded) as needed
+    StaticMesh_ID LoadCompressedMesh(const CompressedVertexLayout& layout, const std::vector<float>& vertexData, std::vector<ElementIndex> indices);
 
     void DeleteFrameBuffer(Framebuffer_ID fBufferID);
     void DeleteTexture(Texture_ID textureID);
@@ -213,32 +379,88 @@ public:
 
     void SetActiveFBuffer(Framebuffer_ID fBufferID);
     void ResizeFBuffer(Framebuffer_ID fBufferID, Vec2i newSize);
+    
+    // Restrict drawing to a region of the active FBuffer (SetActiveFBuffer resets it to the whole buffer)
+    void SetViewport(Recti viewport);
     void ResetToScreenBuffer();
 
     void SetActiveTexture(Texture_ID textureID, unsigned int textureSlot = 0);
-    void SetActiveTexture(Texture_ID textureID, std::string textureName);
+    void SetActiveTexture(Texture_ID textureID, const std::string& textureName);
+    void SetActiveTexture(Texture_ID textureID, UniformHandle sampler);
     void ResizeTexture(Texture_ID textureID, Vec2i newSize);
 
     void SetActiveFBufferTexture(Framebuffer_ID frameBufferID, unsigned int textureSlot = 0);
-    void SetActiveFBufferTexture(Framebuffer_ID frameBufferID, std::string textureName);
+    void SetActiveFBufferTexture(Framebuffer_ID frameBufferID, const std::string& textureName);
+    void SetActiveFBufferTexture(Framebuffer_ID frameBufferID, UniformHandle sampler);
     
     void SetActiveCubemap(Cubemap_ID cubemapID, unsigned int textureSlot = 0);
-    void SetActiveCubemap(Cubemap_ID cubemapID, std::string textureName);
+    void SetActiveCubemap(Cubemap_ID cubemapID, const std::string& textureName);
+    void SetActiveCubemap(Cubemap_ID cubemapID, UniformHandle sampler);
     
     void SetActiveShader(Shader_ID shaderID);
     
     void DrawMesh(StaticMesh_ID meshID);
-
-    void SetShaderUniformVec2f(Shader_ID shaderID, std::string uniformName, Vec2f vec);
-    void SetShaderUniformVec3f(Shader_ID shaderID, std::string uniformName, Vec3f vec);
-    void SetShaderUniformMat4x4f(Shader_ID shaderID, std::string uniformName, Mat4x4f mat);
-    void SetShaderUniformFloat(Shader_ID shaderID, std::string uniformName, float f);
-    void SetShaderUniformInt(Shader_ID shaderID, std::string uniformName, int i);
-    void SetShaderUniformBool(Shader_ID shaderID, std::string uniformName, bool b);
+    
+    // Draws the mesh once per transform. The transforms are streamed into a shared instance buffer and 
+    // bound as a mat4 attribute at INSTANCE_ATTRIBUTE_LOCATION
+    void DrawMeshInstanced(StaticMesh_ID meshID, const std::vector<Mat4x4f>& instanceTransforms);
+
+    // Geometry that gets rebuilt every frame (UI, text, debug lines) is written straight into a persistently mapped 
+    // ring buffer instead of re-uploading a mesh. The data has to be drawn the same frame it's written
+    DynamicGeometry WriteDynamicGeometry(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData);
+    DynamicGeometry WriteDynamicGeometry(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData, const std::vector<ElementIndex>& indices);
+    void DrawDynamicGeometry(const DynamicGeometry& geometry, DrawType drawType = DrawType::Triangle);
+
+    // These always leave the shader bound, even if it doesn't have the uniform
+    void SetShaderUniformVec2f(Shader_ID shaderID, const std::string& uniformName, Vec2f vec);
+    void SetShaderUniformVec3f(Shader_ID shaderID, const std::string& uniformName, Vec3f vec);
+    void SetShaderUniformMat4x4f(Shader_ID shaderID, const std::string& uniformName, Mat4x4f mat);
+    void SetShaderUniformFloat(Shader_ID shaderID, const std::string& uniformName, float f);
+    void SetShaderUniformInt(Shader_ID shaderID, const std::string& uniformName, int i);
+    void SetShaderUniformBool(Shader_ID shaderID, const std::string& uniformName, bool b);
+
+    // Resolve a uniform (or sampler) once, then set it through the handle from then on
+    UniformHandle GetUniformHandle(Shader_ID shaderID, const std::string& uniformName);
+
+    void SetShaderUniformVec2f(UniformHandle uniform, Vec2f vec);
+    void SetShaderUniformVec3f(UniformHandle uniform, Vec3f vec);
+    void SetShaderUniformMat4x4f(UniformHandle uniform, Mat4x4f mat);
+    void SetShaderUniformFloat(UniformHandle uniform, float f);
+    void SetShaderUniformInt(UniformHandle uniform, int i);
+    void SetShaderUniformBool(UniformHandle uniform, bool b);
+
+    // Uniform buffers back std140 uniform blocks, data shared between shaders (per-frame, per-material etc.) 
+    // gets uploaded once and every shader with the block bound to the same binding point sees it
+    UniformBuffer_ID CreateUniformBuffer(unsigned int size, unsigned int bindingPoint);
+    void UpdateUniformBuffer(UniformBuffer_ID bufferID, const void* data, unsigned int size, unsigned int offset = 0);
+    void DeleteUniformBuffer(UniformBuffer_ID bufferID);
+
+    void BindShaderUniformBlock(Shader_ID shaderID, const std::string& blockName, unsigned int bindingPoint);
+
+    // Buffer textures expose a flat array of data to shaders through texelFetch on a sampler/usamplerBuffer,
+    // used for per-frame data too big or too variable in size for a uniform block (e.g. clustered light lists)
+    BufferTexture_ID CreateBufferTexture(BufferTextureFormat format);
+    void UpdateBufferTexture(BufferTexture_ID bufferTextureID, const void* data, unsigned int size);
+    void SetActiveBufferTexture(BufferTexture_ID bufferTextureID, UniformHandle sampler);
+    void DeleteBufferTexture(BufferTexture_ID bufferTextureID);
+
+    // Timer queries measure how long the GPU spends on everything between Begin and End (they can't be nested).
+    // Results turn up a few frames after they're issued, GetTimerQueryResult gives back false rather than waiting.
+    // Reading a result doesn't use it up, it's the caller that knows whether the query has been issued again since.
+    // Where timer queries aren't supported they can still be created and used, they just never have a result
+    bool AreTimerQueriesSupported();
+    TimerQuery_ID CreateTimerQuery();
+    void BeginTimerQuery(TimerQuery_ID queryID);
+    void EndTimerQuery(TimerQuery_ID queryID);
+    bool GetTimerQueryResult(TimerQuery_ID queryID, uint64_t& outNanoseconds);
+    void DeleteTimerQuery(TimerQuery_ID queryID);
 
     void SetMeshDrawType(StaticMesh_ID meshID, DrawType type);
     void SetMeshColour(StaticMesh_ID meshID, Vec4f colour);
 
+    // Local space bounds of a mesh's vertex positions, false if the mesh has no 3D positions to bound
+    bool GetMeshBounds(StaticMesh_ID meshID, AABB& outBounds);
+
     std::vector<Vertex*> MapMeshVertices(StaticMesh_ID meshID);
     void UnmapMeshVertices(StaticMesh_ID meshID);
 
@@ -250,6 +472,9 @@ public:
 
     void ClearColourBuffer();
     void ClearDepthBuffer();
+
+    // Only clears the depth inside the region, the rest of the active FBuffer is left alone
+    void ClearDepthBufferRegion(Recti region);
     void ClearStencilBuffer();
 
     void EnableDepthTesting();
@@ -271,5 +496,17 @@ public:
 
     Vec2i GetViewportSize();
 
+    // True for the headless renderer (built with HEADLESS_RENDERER), which keeps CPU-side copies of everything
+    // and never draws anything. Meant for servers, tests and benchmarks that need to run without a GPU
+    bool IsHeadless();
+
+    RendererStats GetStats();
+    void ResetStats();
+
+    // While recording, every call gets appended to the log. Off to start with since the log grows until it's cleared
+    void SetCallRecording(bool enabled);
+    const std::vector<RecordedRenderCall>& GetRecordedCalls();
+    void ClearRecordedCalls();
+
     //TODO(fraser): functions for deleting/freeing memory of fbuffers/textures/meshes/shaders/etc
 };
\ No newline at end of file
@@ -0,0 +1,1433 @@
+// A renderer that never touches a GPU, built instead of the OpenGL one when HEADLESS_RENDERER is defined.
+// Meshes and textures are kept as CPU-side copies (so reading mesh data back, mapping vertices and bounds all still work),
+// draws don't do anything, and every call is counted (and optionally logged) so servers, tests and benchmarks
+// can see exactly what was asked of the renderer.
+#ifdef HEADLESS_RENDERER
+
+#include "EnginePlatform.h"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+
+#include <assert.h>
+#include "RendererPlatform.h"
+#include "Utils/SlotMap.h"
+#include "Rendering/VertexCompression.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 26451 6385 6011 6262 6308)
+#endif
+#include <stb_image.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+void VertexBufferFormat::EnableVertexAttributes(unsigned int) const
+{
+}
+
+void PosVertex::ActivateVertexAttributes()
+{
+}
+
+void Vertex::ActivateVertexAttributes()
+{
+}
+
+void UVVertex::ActivateVertexAttributes()
+{
+}
+
+namespace
+{
+    struct HeadlessTexture
+    {
+        Vec2i size;
+        ColourFormat format = ColourFormat::RGBA;
+        DataFormat dataFormat = DataFormat::UNSIGNED_BYTE;
+
+        // Empty for textures that are only ever rendered to
+        std::vector<unsigned char> data;
+    };
+
+    struct HeadlessFBuffer
+    {
+        Vec2i size;
+        FBufferFormat format = FBufferFormat::COLOUR;
+
+        Texture_ID texture = 0;
+        Texture_ID depthTexture = 0;
+        std::vector<Texture_ID> attachments;
+    };
+
+    struct HeadlessCubemap
+    {
+        std::string path;
+    };
+
+    struct HeadlessShader
+    {
+        std::string vertSource;
+        std::string fragSource;
+
+        // Filled in as uniforms get asked for, there's no compiler to ask which ones actually exist
+        std::unordered_map<std::string, int> uniformLocations;
+        std::unordered_map<std::string, int> samplerSlots;
+        std::unordered_set<std::string> samplerNames;
+    };
+
+    struct HeadlessMesh
+    {
+        HeadlessMesh(const VertexBufferFormat& format, bool useElementArray)
+            : format(format)
+            , useElementArray(useElementArray)
+        {
+        }
+
+        int GetVertexCount() const
+        {
+            unsigned int floatStride = format.GetVertexStride() / sizeof(float);
+            return floatStride > 0 ? (int)(vertexData.size() / floatStride) : 0;
+        }
+
+        // Bounds are only tracked for meshes whose first attribute is a 3D position
+        void CalculateBounds()
+        {
+            hasBounds = false;
+
+            const std::vector<VertAttribute>& attributes = format.GetAttributes();
+            if (attributes.empty() || attributes[0] != VertAttribute::Vec3f)
+            {
+                return;
+            }
+
+            size_t floatStride = format.GetVertexStride() / sizeof(float);
+            for (size_t i = 0; i + 2 < vertexData.size(); i += floatStride)
+            {
+                Vec3f point = Vec3f(vertexData[i], vertexData[i + 1], vertexData[i + 2]);
+                if (!hasBounds)
+                {
+                    boundsMin = point;
+                    boundsMax = point;
+                    hasBounds = true;
+                    continue;
+                }
+
+                if (point.x < boundsMin.x) boundsMin.x = point.x;
+                if (point.y < boundsMin.y) boundsMin.y = point.y;
+                if (point.z < boundsMin.z) boundsMin.z = point.z;
+
+                if (point.x > boundsMax.x) boundsMax.x = point.x;
+                if (point.y > boundsMax.y) boundsMax.y = point.y;
+                if (point.z > boundsMax.z) boundsMax.z = point.z;
+            }
+        }
+
+        // Packs the vertices into the requested layout, the same as the OpenGL renderer
+        void SetCompressedVertices(const Vertex* vertices, size_t vertexCount)
+        {
+            CompressedVertices packed = VertexCompression::Encode(requestedLayout, vertices, vertexCount);
+
+            format = VertexCompression::GetFormat(packed.Layout);
+            vertexData = std::move(packed.Data);
+
+            compressed = true;
+            layout = packed.Layout;
+            decode = packed.Decode;
+
+            hasBounds = vertexCount > 0;
+            for (size_t i = 0; i < vertexCount; ++i)
+            {
+                Vec3f point = vertices[i].position;
+                if (i == 0)
+                {
+                    boundsMin = point;
+                    boundsMax = point;
+                    continue;
+                }
+
+                if (point.x < boundsMin.x) boundsMin.x = point.x;
+                if (point.y < boundsMin.y) boundsMin.y = point.y;
+                if (point.z < boundsMin.z) boundsMin.z = point.z;
+
+                if (point.x > boundsMax.x) boundsMax.x = point.x;
+                if (point.y > boundsMax.y) boundsMax.y = point.y;
+                if (point.z > boundsMax.z) boundsMax.z = point.z;
+            }
+        }
+
+        void SetUncompressed(const VertexBufferFormat& newFormat)
+        {
+            format = newFormat;
+            compressed = false;
+            decode = VertexDecode();
+        }
+
+        VertexBufferFormat format;
+        std::vector<float> vertexData;
+        std::vector<ElementIndex> indices;
+        bool useElementArray;
+        DrawType drawType = DrawType::Triangle;
+
+        bool hasBounds = false;
+        Vec3f boundsMin;
+        Vec3f boundsMax;
+
+        // vertexData is packed for compressed meshes, and unpacked whenever it's read back or mapped
+        bool compressed = false;
+        CompressedVertexLayout requestedLayout;
+        CompressedVertexLayout layout;
+        VertexDecode decode;
+
+        std::vector<Vertex> mappedVertices;
+    };
+
+    struct HeadlessUniformBuffer
+    {
+        std::vector<unsigned char> data;
+        unsigned int bindingPoint;
+    };
+
+    struct HeadlessBufferTexture
+    {
+        BufferTextureFormat format;
+        std::vector<unsigned char> data;
+    };
+
+    struct HeadlessTimerQuery
+    {
+    };
+
+    SlotMap<HeadlessFBuffer> fBufferMap;
+    SlotMap<HeadlessTexture> textureMap;
+    SlotMap<HeadlessCubemap> cubemapMap;
+    SlotMap<HeadlessShader> shaderMap;
+    SlotMap<HeadlessMesh> meshMap;
+    SlotMap<HeadlessUniformBuffer> uniformBufferMap;
+    SlotMap<HeadlessBufferTexture> bufferTextureMap;
+    SlotMap<HeadlessTimerQuery> timerQueryMap;
+    Shader_ID currentlyBoundShader = SlotMap<HeadlessShader>::InvalidHandle;
+    Framebuffer_ID currentlyBoundFBuffer = SlotMap<HeadlessFBuffer>::InvalidHandle;
+
+    Recti viewport;
+
+    RendererStats stats;
+    bool recordingCalls = false;
+    std::vector<RecordedRenderCall> recordedCalls;
+
+    template <typename T>
+    T* GetResource(SlotMap<T>& resourceMap, GUID id, const char* resourceName)
+    {
+        T* resource = resourceMap.Get(id);
+        if (!resource && resourceMap.IsStale(id))
+        {
+            Engine::DEBUGPrint("ERROR: Stale " + std::string(resourceName) + " handle <" + std::to_string(id) + ">, the resource has already been deleted.");
+        }
+        return resource;
+    }
+
+    HeadlessFBuffer* GetFBuffer(Framebuffer_ID fBufferID)
+    {
+        return GetResource(fBufferMap, fBufferID, "framebuffer");
+    }
+
+    HeadlessTexture* GetTexture(Texture_ID textureID)
+    {
+        return GetResource(textureMap, textureID, "texture");
+    }
+
+    HeadlessShader* GetShader(Shader_ID shaderID)
+    {
+        return GetResource(shaderMap, shaderID, "shader");
+    }
+
+    HeadlessMesh* GetMesh(StaticMesh_ID meshID)
+    {
+        return GetResource(meshMap, meshID, "mesh");
+    }
+
+    HeadlessUniformBuffer* GetUniformBuffer(UniformBuffer_ID bufferID)
+    {
+        return GetResource(uniformBufferMap, bufferID, "uniform buffer");
+    }
+
+    HeadlessBufferTexture* GetBufferTexture(BufferTexture_ID bufferTextureID)
+    {
+        return GetResource(bufferTextureMap, bufferTextureID, "buffer texture");
+    }
+
+    void Record(const char* function, GUID resource = 0, uint64_t bytes = 0)
+    {
+        stats.Calls++;
+
+        if (bytes > 0)
+        {
+            stats.Uploads++;
+            stats.BytesUploaded += bytes;
+        }
+
+        if (recordingCalls)
+        {
+            RecordedRenderCall call;
+            call.Function = function;
+            call.Resource = resource;
+            call.Bytes = bytes;
+            recordedCalls.push_back(call);
+        }
+    }
+
+    void RecordBind(const char* function, GUID resource)
+    {
+        stats.Binds++;
+        Record(function, resource);
+    }
+
+    void RecordDraw(const char* function, GUID resource, uint64_t vertices, uint64_t instances = 1)
+    {
+        stats.DrawCalls++;
+        stats.Instances += instances;
+        stats.Vertices += vertices * instances;
+        Record(function, resource);
+    }
+
+    unsigned int GetBytesPerPixel(ColourFormat format, DataFormat dataFormat)
+    {
+        unsigned int channelSize = 1;
+        switch (dataFormat)
+        {
+        case DataFormat::FLOAT:
+            channelSize = 4;
+            break;
+        case DataFormat::HALF_FLOAT:
+            channelSize = 2;
+            break;
+        case DataFormat::UNSIGNED_BYTE:
+            channelSize = 1;
+            break;
+        }
+
+        switch (format)
+        {
+        case ColourFormat::RGB:
+            return 3 * channelSize;
+        case ColourFormat::RGBA:
+            return 4 * channelSize;
+        case ColourFormat::RG:
+            return 2 * channelSize;
+        case ColourFormat::Red:
+            return channelSize;
+        case ColourFormat::DEPTH:
+        case ColourFormat::DEPTH_STENCIL:
+        default:
+            return 4;
+        }
+    }
+
+    // Picks the sampler uniforms out of a shader's source, so that only samplers get given a texture slot
+    // like they would with the OpenGL renderer
+    void FindSamplers(const std::string& source, std::unordered_set<std::string>& outSamplerNames)
+    {
+        std::stringstream stream(source);
+        std::string word;
+        while (stream >> word)
+        {
+            if (word != "uniform")
+            {
+                continue;
+            }
+
+            std::string type;
+            std::string name;
+            if (!(stream >> type >> name) || type.find("sampler") == std::string::npos)
+            {
+                continue;
+            }
+
+            size_t nameEnd = name.find_first_of("[;");
+            outSamplerNames.insert(name.substr(0, nameEnd));
+        }
+    }
+
+    StaticMesh_ID InsertMesh(const VertexBufferFormat& vertBufFormat, std::vector<float>& vertexData, std::vector<ElementIndex>* indices)
+    {
+        HeadlessMesh newMesh = HeadlessMesh(vertBufFormat, indices != nullptr);
+        newMesh.vertexData = std::move(vertexData);
+        if (indices)
+        {
+            newMesh.indices = std::move(*indices);
+        }
+        newMesh.CalculateBounds();
+
+        uint64_t bytes = newMesh.vertexData.size() * sizeof(float) + newMesh.indices.size() * sizeof(ElementIndex);
+
+        StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
+        Record("LoadMesh", newID, bytes);
+        return newID;
+    }
+
+    Texture_ID InsertTexture(HeadlessTexture&& newTexture, const char* function)
+    {
+        uint64_t bytes = newTexture.data.size();
+
+        Texture_ID newID = textureMap.Insert(std::move(newTexture));
+        Record(function, newID, bytes);
+        return newID;
+    }
+}
+
+Renderer::Renderer()
+{
+    viewport = Recti(Vec2i(0, 0), Engine::GetClientAreaSize());
+
+    Engine::DEBUGPrint("Using the headless renderer, nothing will be drawn.");
+}
+
+Renderer::~Renderer()
+{
+}
+
+Framebuffer_ID Renderer::CreateFrameBuffer(Vec2i size, FBufferFormat format)
+{
+    HeadlessFBuffer newBuffer;
+    newBuffer.size = size;
+    newBuffer.format = format;
+
+    if (format != FBufferFormat::EMPTY)
+    {
+        HeadlessTexture texture;
+        texture.size = size;
+        texture.format = format == FBufferFormat::DEPTH ? ColourFormat::DEPTH : ColourFormat::RGBA;
+        newBuffer.texture = textureMap.Insert(std::move(texture));
+    }
+
+    Framebuffer_ID newID = fBufferMap.Insert(std::move(newBuffer));
+    Record("CreateFrameBuffer", newID);
+    return newID;
+}
+
+Framebuffer_ID Renderer::CreateFBufferWithExistingDepthBuffer(Framebuffer_ID existingFBuffer, Vec2i size, FBufferFormat format)
+{
+    Texture_ID depthTexture = 0;
+    if (HeadlessFBuffer* fBuffer = GetFBuffer(existingFBuffer))
+    {
+        depthTexture = fBuffer->depthTexture;
+    }
+
+    Framebuffer_ID newID = CreateFrameBuffer(size, format);
+    GetFBuffer(newID)->depthTexture = depthTexture;
+
+    return newID;
+}
+
+void Renderer::AttachTextureToFramebuffer(Texture_ID textureID, Framebuffer_ID fBufferID)
+{
+    HeadlessFBuffer* fBuffer = GetFBuffer(fBufferID);
+    if (fBuffer && GetTexture(textureID))
+    {
+        fBuffer->texture = textureID;
+    }
+
+    Record("AttachTextureToFramebuffer", fBufferID);
+}
+
+Texture_ID Renderer::AttachColourAttachmentToFrameBuffer(Framebuffer_ID buffer, TextureCreateInfo createInfo, int)
+{
+    HeadlessFBuffer* fBuffer = GetFBuffer(buffer);
+    if (!fBuffer)
+    {
+        return 0;
+    }
+
+    HeadlessTexture newTexture;
+    newTexture.size = createInfo.Size;
+    newTexture.format = createInfo.InternalFormat;
+    newTexture.dataFormat = createInfo.DataFormat;
+
+    Texture_ID newID = InsertTexture(std::move(newTexture), "AttachColourAttachmentToFrameBuffer");
+    fBuffer->attachments.push_back(newID);
+
+    return newID;
+}
+
+Texture_ID Renderer::AttachDepthTextureToFrameBuffer(Framebuffer_ID buffer)
+{
+    HeadlessFBuffer* fBuffer = GetFBuffer(buffer);
+    if (!fBuffer)
+    {
+        return 0;
+    }
+
+    HeadlessTexture newTexture;
+    newTexture.size = fBuffer->size;
+    newTexture.format = ColourFormat::DEPTH_STENCIL;
+
+    Texture_ID newID = InsertTexture(std::move(newTexture), "AttachDepthTextureToFrameBuffer");
+    fBuffer->depthTexture = newID;
+
+    return newID;
+}
+
+Texture_ID Renderer::LoadTexture(Vec2i size, std::vector<unsigned char> textureData, ColourFormat format, TextureMode, TextureMode)
+{
+    HeadlessTexture newTexture;
+    newTexture.size = size;
+    newTexture.format = format;
+#ifndef DEDICATED_SERVER
+    newTexture.data = std::move(textureData);
+#endif
+
+    return InsertTexture(std::move(newTexture), "LoadTexture");
+}
+
+Texture_ID Renderer::LoadTexture(std::string filePath, TextureMode, TextureMode)
+{
+    HeadlessTexture newTexture;
+
+    stbi_set_flip_vertically_on_load(true);
+
+    int width, height, channels;
+
+#ifdef DEDICATED_SERVER
+    // Nothing's ever sampled on a dedicated server, so only the header's read and no pixels are kept around.
+    // Keeps the memory of every server running on a machine down to what the simulation needs
+    if (stbi_info(filePath.c_str(), &width, &height, &channels))
+    {
+        newTexture.size = Vec2i(width, height);
+        newTexture.format = channels == 1 ? ColourFormat::Red : channels == 3 ? ColourFormat::RGB : ColourFormat::RGBA;
+    }
+    else
+    {
+        newTexture.size = Vec2i(1, 1);
+        newTexture.format = ColourFormat::RGBA;
+    }
+#else
+    unsigned char* textureData = stbi_load(filePath.c_str(), &width, &height, &channels, 0);
+
+    if (textureData)
+    {
+        switch (channels)
+        {
+        case 1:
+            newTexture.format = ColourFormat::Red;
+            break;
+        case 3:
+            newTexture.format = ColourFormat::RGB;
+            break;
+        case 4:
+        default:
+            newTexture.format = ColourFormat::RGBA;
+            break;
+        }
+
+        newTexture.size = Vec2i(width, height);
+        newTexture.data.assign(textureData, textureData + (size_t)width * height * channels);
+
+        stbi_image_free(textureData);
+    }
+    else
+    {
+        Engine::DEBUGPrint("Couldn't load texture " + filePath + ", using a white pixel instead.");
+
+        newTexture.size = Vec2i(1, 1);
+        newTexture.format = ColourFormat::RGBA;
+        newTexture.data = { 255, 255, 255, 255 };
+    }
+#endif
+
+    return InsertTexture(std::move(newTexture), "LoadTexture");
+}
+
+bool Renderer::IsTextureValid(Texture_ID texID)
+{
+    return textureMap.Contains(texID);
+}
+
+bool Renderer::IsFBufferTextureValid(Framebuffer_ID bufID)
+{
+    HeadlessFBuffer* fBuffer = GetFBuffer(bufID);
+    return fBuffer && textureMap.Contains(fBuffer->texture);
+}
+
+Cubemap_ID Renderer::LoadCubemap(std::string filepath)
+{
+    // The faces never get sampled, so there's no point decoding them
+    HeadlessCubemap newCubemap;
+    newCubemap.path = filepath;
+
+    Cubemap_ID newID = cubemapMap.Insert(std::move(newCubemap));
+    Record("LoadCubemap", newID);
+    return newID;
+}
+
+Shader_ID Renderer::LoadShader(std::string vertShaderSource, std::string fragShaderSource)
+{
+    HeadlessShader newShader;
+    FindSamplers(vertShaderSource, newShader.samplerNames);
+    FindSamplers(fragShaderSource, newShader.samplerNames);
+    newShader.vertSource = std::move(vertShaderSource);
+    newShader.fragSource = std::move(fragShaderSource);
+
+    Shader_ID newID = shaderMap.Insert(std::move(newShader));
+    Record("LoadShader", newID);
+    return newID;
+}
+
+StaticMesh_ID Renderer::LoadMesh(const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData)
+{
+    return InsertMesh(vertBufFormat, vertexData, nullptr);
+}
+
+StaticMesh_ID Renderer::LoadMesh(const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData, std::vector<ElementIndex> indices)
+{
+    return InsertMesh(vertBufFormat, vertexData, &indices);
+}
+
+StaticMesh_ID Renderer::LoadMesh(const VertexBufferFormat& vertBufFormat, const float* vertexData, size_t vertexFloatCount, const ElementIndex* indices, size_t indexCount)
+{
+    // The copy stands in for the upload to the GPU
+    std::vector<float> vertexCopy(vertexData, vertexData + vertexFloatCount);
+    std::vector<ElementIndex> indexCopy(indices, indices + indexCount);
+    return InsertMesh(vertBufFormat, vertexCopy, &indexCopy);
+}
+
+StaticMesh_ID Renderer::LoadCompressedMesh(const CompressedVertexLayout& layout, const std::vector<float>& vertexData, std::vector<ElementIndex> indices)
+{
+    const Vertex* vertices = (const Vertex*)vertexData.data();
+    size_t vertexCount = vertexData.size() * sizeof(float) / sizeof(Vertex);
+
+    HeadlessMesh newMesh = HeadlessMesh(VertexCompression::GetFormat(layout), true);
+    newMesh.requestedLayout = layout;
+    newMesh.indices = std::move(indices);
+    newMesh.SetCompressedVertices(vertices, vertexCount);
+
+    uint64_t bytes = newMesh.vertexData.size() * sizeof(float) + newMesh.indices.size() * sizeof(ElementIndex);
+
+    StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
+    Record("LoadCompressedMesh", newID, bytes);
+    return newID;
+}
+
+void Renderer::DeleteFrameBuffer(Framebuffer_ID fBufferID)
+{
+    HeadlessFBuffer* fBuffer = GetFBuffer(fBufferID);
+
+    if (fBuffer)
+    {
+        if (fBuffer->format != FBufferFormat::EMPTY)
+        {
+            textureMap.Remove(fBuffer->texture);
+        }
+
+        fBufferMap.Remove(fBufferID);
+    }
+
+    Record("DeleteFrameBuffer", fBufferID);
+}
+
+void Renderer::DeleteTexture(Texture_ID textureID)
+{
+    if (GetTexture(textureID))
+    {
+        textureMap.Remove(textureID);
+    }
+
+    Record("DeleteTexture", textureID);
+}
+
+void Renderer::DeleteMesh(StaticMesh_ID meshID)
+{
+    if (GetMesh(meshID))
+    {
+        meshMap.Remove(meshID);
+    }
+
+    Record("DeleteMesh", meshID);
+}
+
+Texture_ID Renderer::CreateEmptyTexture(Vec2i size, ColourFormat format)
+{
+    HeadlessTexture newTexture;
+    newTexture.size = size;
+    newTexture.format = format;
+    newTexture.data.resize((size_t)size.x * size.y * GetBytesPerPixel(format, DataFormat::UNSIGNED_BYTE));
+
+    Texture_ID newID = textureMap.Insert(std::move(newTexture));
+    Record("CreateEmptyTexture", newID);
+    return newID;
+}
+
+StaticMesh_ID Renderer::CreateEmptyMesh(const VertexBufferFormat& vertBufFormat, bool useElementArray)
+{
+    StaticMesh_ID newID = meshMap.Insert(HeadlessMesh(vertBufFormat, useElementArray));
+    Record("CreateEmptyMesh", newID);
+    return newID;
+}
+
+void Renderer::ClearMesh(StaticMesh_ID meshID)
+{
+    if (HeadlessMesh* mesh = GetMesh(meshID))
+    {
+        mesh->vertexData.clear();
+        mesh->indices.clear();
+        mesh->hasBounds = false;
+    }
+
+    Record("ClearMesh", meshID);
+}
+
+void Renderer::UpdateTextureData(Texture_ID textureID, Recti region, std::vector<unsigned char> textureData, ColourFormat format)
+{
+    Record("UpdateTextureData", textureID, textureData.size());
+
+    HeadlessTexture* texture = GetTexture(textureID);
+    if (!texture)
+    {
+        return;
+    }
+
+    unsigned int bytesPerPixel = GetBytesPerPixel(texture->format, texture->dataFormat);
+    if (format != texture->format || texture->data.empty())
+    {
+        // Only keep a copy of data in the format the texture was created with
+        return;
+    }
+
+    for (int y = 0; y < region.size.y; ++y)
+    {
+        int destY = region.location.y + y;
+        if (destY < 0 || destY >= texture->size.y)
+        {
+            continue;
+        }
+
+        for (int x = 0; x < region.size.x; ++x)
+        {
+            int destX = region.location.x + x;
+            if (destX < 0 || destX >= texture->size.x)
+            {
+                continue;
+            }
+
+            size_t source = ((size_t)y * region.size.x + x) * bytesPerPixel;
+            size_t dest = ((size_t)destY * texture->size.x + destX) * bytesPerPixel;
+            if (source + bytesPerPixel <= textureData.size())
+            {
+                memcpy(&texture->data[dest], &textureData[source], bytesPerPixel);
+            }
+        }
+    }
+}
+
+void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData)
+{
+    Record("UpdateMeshData", meshID, vertexData.size() * sizeof(float));
+
+    if (HeadlessMesh* mesh = GetMesh(meshID))
+    {
+        mesh->SetUncompressed(vertBufFormat);
+        mesh->vertexData = std::move(vertexData);
+        mesh->CalculateBounds();
+    }
+}
+
+void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData, std::vector<ElementIndex> indices)
+{
+    Record("UpdateMeshData", meshID, vertexData.size() * sizeof(float) + indices.size() * sizeof(ElementIndex));
+
+    if (HeadlessMesh* mesh = GetMesh(meshID))
+    {
+        mesh->SetUncompressed(vertBufFormat);
+        mesh->vertexData = std::move(vertexData);
+        mesh->indices = std::move(indices);
+        mesh->CalculateBounds();
+    }
+}
+
+std::vector<float> Renderer::GetMeshVertexData(StaticMesh_ID meshID)
+{
+    Record("GetMeshVertexData", meshID);
+
+    HeadlessMesh* mesh = GetMesh(meshID);
+    if (mesh && mesh->compressed)
+    {
+        int vertexCount = mesh->GetVertexCount();
+        std::vector<float> decoded(vertexCount * (sizeof(Vertex) / sizeof(float)));
+        VertexCompression::Decode(mesh->layout, mesh->decode, mesh->vertexData.data(), vertexCount, (Vertex*)decoded.data());
+        return decoded;
+    }
+
+    return mesh ? mesh->vertexData : std::vector<float>();
+}
+
+std::vector<unsigned int> Renderer::GetMeshIndexData(StaticMesh_ID meshID)
+{
+    Record("GetMeshIndexData", meshID);
+
+    HeadlessMesh* mesh = GetMesh(meshID);
+    return mesh ? mesh->indices : std::vector<unsigned int>();
+}
+
+void Renderer::SetActiveFBuffer(Framebuffer_ID fBufferID)
+{
+    RecordBind("SetActiveFBuffer", fBufferID);
+
+    if (HeadlessFBuffer* fBuffer = GetFBuffer(fBufferID))
+    {
+        currentlyBoundFBuffer = fBufferID;
+        viewport = Recti(Vec2i(0, 0), fBuffer->size);
+    }
+}
+
+void Renderer::ResizeFBuffer(Framebuffer_ID fBufferID, Vec2i newSize)
+{
+    Record("ResizeFBuffer", fBufferID);
+
+    HeadlessFBuffer* fBuffer = GetFBuffer(fBufferID);
+    if (!fBuffer)
+    {
+        return;
+    }
+
+    fBuffer->size = newSize;
+    if (HeadlessTexture* texture = GetTexture(fBuffer->texture))
+    {
+        texture->size = newSize;
+    }
+}
+
+void Renderer::SetViewport(Recti newViewport)
+{
+    Record("SetViewport");
+    viewport = newViewport;
+}
+
+void Renderer::ResetToScreenBuffer()
+{
+    RecordBind("ResetToScreenBuffer", 0);
+
+    currentlyBoundFBuffer = SlotMap<HeadlessFBuffer>::InvalidHandle;
+    viewport = Recti(Vec2i(0, 0), Engine::GetClientAreaSize());
+}
+
+void Renderer::SetActiveTexture(Texture_ID texture, unsigned int)
+{
+    if (!GetTexture(texture))
+    {
+        Engine::DEBUGPrint("Invalid texture");
+        return;
+    }
+
+    RecordBind("SetActiveTexture", texture);
+}
+
+void Renderer::SetActiveTexture(Texture_ID textureID, const std::string& textureName)
+{
+    SetActiveTexture(textureID, GetUniformHandle(currentlyBoundShader, textureName));
+}
+
+void Renderer::SetActiveTexture(Texture_ID textureID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        SetActiveTexture(textureID, sampler.TextureSlot);
+    }
+}
+
+void Renderer::ResizeTexture(Texture_ID textureID, Vec2i newSize)
+{
+    Record("ResizeTexture", textureID);
+
+    if (HeadlessTexture* texture = GetTexture(textureID))
+    {
+        texture->size = newSize;
+        if (!texture->data.empty())
+        {
+            texture->data.assign((size_t)newSize.x * newSize.y * GetBytesPerPixel(texture->format, texture->dataFormat), 0);
+        }
+    }
+}
+
+void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, unsigned int)
+{
+    RecordBind("SetActiveFBufferTexture", frameBufferID);
+}
+
+void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, const std::string& textureName)
+{
+    SetActiveFBufferTexture(frameBufferID, GetUniformHandle(currentlyBoundShader, textureName));
+}
+
+void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        SetActiveFBufferTexture(frameBufferID, sampler.TextureSlot);
+    }
+}
+
+void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, unsigned int)
+{
+    RecordBind("SetActiveCubemap", cubemapID);
+}
+
+void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, const std::string& textureName)
+{
+    SetActiveCubemap(cubemapID, GetUniformHandle(currentlyBoundShader, textureName));
+}
+
+void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        SetActiveCubemap(cubemapID, sampler.TextureSlot);
+    }
+}
+
+void Renderer::SetActiveShader(Shader_ID shader)
+{
+    if (currentlyBoundShader == shader)
+        return;
+
+    RecordBind("SetActiveShader", shader);
+    currentlyBoundShader = shader;
+}
+
+void Renderer::DrawMesh(StaticMesh_ID meshID)
+{
+    HeadlessMesh* mesh = GetMesh(meshID);
+    if (!mesh)
+    {
+        return;
+    }
+
+    RecordDraw("DrawMesh", meshID, mesh->useElementArray ? mesh->indices.size() : mesh->GetVertexCount());
+}
+
+void Renderer::DrawMeshInstanced(StaticMesh_ID meshID, const std::vector<Mat4x4f>& instanceTransforms)
+{
+    if (instanceTransforms.empty())
+    {
+        return;
+    }
+
+    HeadlessMesh* mesh = GetMesh(meshID);
+    if (!mesh)
+    {
+        return;
+    }
+
+    // The transforms would have been streamed into the instance buffer
+    Record("StreamInstanceTransforms", meshID, instanceTransforms.size() * sizeof(Mat4x4f));
+
+    RecordDraw("DrawMeshInstanced", meshID, mesh->useElementArray ? mesh->indices.size() : mesh->GetVertexCount(), instanceTransforms.size());
+}
+
+DynamicGeometry Renderer::WriteDynamicGeometry(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData)
+{
+    DynamicGeometry geometry;
+    if (vertBufFormat.GetVertexStride() == 0)
+    {
+        return geometry;
+    }
+
+    geometry.VertexCount = (unsigned int)(vertexData.size() * sizeof(float) / vertBufFormat.GetVertexStride());
+
+    Record("WriteDynamicGeometry", 0, vertexData.size() * sizeof(float));
+    return geometry;
+}
+
+DynamicGeometry Renderer::WriteDynamicGeometry(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData, const std::vector<ElementIndex>& indices)
+{
+    DynamicGeometry geometry;
+    if (vertBufFormat.GetVertexStride() == 0)
+    {
+        return geometry;
+    }
+
+    geometry.VertexCount = (unsigned int)(vertexData.size() * sizeof(float) / vertBufFormat.GetVertexStride());
+    geometry.IndexCount = (unsigned int)indices.size();
+
+    Record("WriteDynamicGeometry", 0, vertexData.size() * sizeof(float) + indices.size() * sizeof(ElementIndex));
+    return geometry;
+}
+
+void Renderer::DrawDynamicGeometry(const DynamicGeometry& geometry, DrawType)
+{
+    if (!geometry.IsValid())
+    {
+        return;
+    }
+
+    RecordDraw("DrawDynamicGeometry", 0, geometry.IndexCount > 0 ? geometry.IndexCount : geometry.VertexCount);
+}
+
+void Renderer::SetShaderUniformVec2f(Shader_ID shaderID, const std::string& uniformName, Vec2f vec)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformVec2f(GetUniformHandle(shaderID, uniformName), vec);
+}
+
+void Renderer::SetShaderUniformVec3f(Shader_ID shaderID, const std::string& uniformName, Vec3f vec)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformVec3f(GetUniformHandle(shaderID, uniformName), vec);
+}
+
+void Renderer::SetShaderUniformMat4x4f(Shader_ID shaderID, const std::string& uniformName, Mat4x4f mat)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformMat4x4f(GetUniformHandle(shaderID, uniformName), mat);
+}
+
+void Renderer::SetShaderUniformFloat(Shader_ID shaderID, const std::string& uniformName, float f)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformFloat(GetUniformHandle(shaderID, uniformName), f);
+}
+
+void Renderer::SetShaderUniformInt(Shader_ID shaderID, const std::string& uniformName, int i)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformInt(GetUniformHandle(shaderID, uniformName), i);
+}
+
+void Renderer::SetShaderUniformBool(Shader_ID shaderID, const std::string& uniformName, bool b)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformBool(GetUniformHandle(shaderID, uniformName), b);
+}
+
+UniformHandle Renderer::GetUniformHandle(Shader_ID shaderID, const std::string& uniformName)
+{
+    UniformHandle handle;
+
+    HeadlessShader* shader = GetShader(shaderID);
+    if (!shader)
+    {
+        return handle;
+    }
+
+    handle.Shader = shaderID;
+
+    auto [it, inserted] = shader->uniformLocations.try_emplace(uniformName, (int)shader->uniformLocations.size());
+    if (inserted)
+    {
+        if (shader->samplerNames.count(uniformName))
+        {
+            shader->samplerSlots.emplace(uniformName, (int)shader->samplerSlots.size());
+        }
+    }
+    handle.Location = it->second;
+
+    auto slot = shader->samplerSlots.find(uniformName);
+    if (slot != shader->samplerSlots.end())
+    {
+        handle.TextureSlot = slot->second;
+    }
+
+    return handle;
+}
+
+void Renderer::SetShaderUniformVec2f(UniformHandle uniform, Vec2f vec)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        Record("SetShaderUniformVec2f", uniform.Shader, sizeof(vec));
+    }
+}
+
+void Renderer::SetShaderUniformVec3f(UniformHandle uniform, Vec3f vec)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        Record("SetShaderUniformVec3f", uniform.Shader, sizeof(vec));
+    }
+}
+
+void Renderer::SetShaderUniformMat4x4f(UniformHandle uniform, Mat4x4f mat)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        Record("SetShaderUniformMat4x4f", uniform.Shader, sizeof(mat));
+    }
+}
+
+void Renderer::SetShaderUniformFloat(UniformHandle uniform, float f)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        Record("SetShaderUniformFloat", uniform.Shader, sizeof(f));
+    }
+}
+
+void Renderer::SetShaderUniformInt(UniformHandle uniform, int i)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        Record("SetShaderUniformInt", uniform.Shader, sizeof(i));
+    }
+}
+
+void Renderer::SetShaderUniformBool(UniformHandle uniform, bool)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        Record("SetShaderUniformBool", uniform.Shader, sizeof(int));
+    }
+}
+
+UniformBuffer_ID Renderer::CreateUniformBuffer(unsigned int size, unsigned int bindingPoint)
+{
+    HeadlessUniformBuffer newBuffer;
+    newBuffer.data.resize(size);
+    newBuffer.bindingPoint = bindingPoint;
+
+    UniformBuffer_ID newID = uniformBufferMap.Insert(std::move(newBuffer));
+    Record("CreateUniformBuffer", newID);
+    return newID;
+}
+
+void Renderer::UpdateUniformBuffer(UniformBuffer_ID bufferID, const void* data, unsigned int size, unsigned int offset)
+{
+    Record("UpdateUniformBuffer", bufferID, size);
+
+    HeadlessUniformBuffer* buffer = GetUniformBuffer(bufferID);
+    if (!buffer || offset + size > buffer->data.size())
+    {
+        return;
+    }
+
+    memcpy(buffer->data.data() + offset, data, size);
+}
+
+void Renderer::DeleteUniformBuffer(UniformBuffer_ID bufferID)
+{
+    if (GetUniformBuffer(bufferID))
+    {
+        uniformBufferMap.Remove(bufferID);
+    }
+
+    Record("DeleteUniformBuffer", bufferID);
+}
+
+void Renderer::BindShaderUniformBlock(Shader_ID shaderID, const std::string&, unsigned int)
+{
+    RecordBind("BindShaderUniformBlock", shaderID);
+}
+
+BufferTexture_ID Renderer::CreateBufferTexture(BufferTextureFormat format)
+{
+    HeadlessBufferTexture newBufferTexture;
+    newBufferTexture.format = format;
+
+    BufferTexture_ID newID = bufferTextureMap.Insert(std::move(newBufferTexture));
+    Record("CreateBufferTexture", newID);
+    return newID;
+}
+
+void Renderer::UpdateBufferTexture(BufferTexture_ID bufferTextureID, const void* data, unsigned int size)
+{
+    Record("UpdateBufferTexture", bufferTextureID, size);
+
+    if (HeadlessBufferTexture* bufferTexture = GetBufferTexture(bufferTextureID))
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        bufferTexture->data.assign(bytes, bytes + size);
+    }
+}
+
+void Renderer::SetActiveBufferTexture(BufferTexture_ID bufferTextureID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        RecordBind("SetActiveBufferTexture", bufferTextureID);
+    }
+}
+
+void Renderer::DeleteBufferTexture(BufferTexture_ID bufferTextureID)
+{
+    if (GetBufferTexture(bufferTextureID))
+    {
+        bufferTextureMap.Remove(bufferTextureID);
+    }
+
+    Record("DeleteBufferTexture", bufferTextureID);
+}
+
+// There's no GPU time to measure, so timer queries behave like they do where they aren't supported
+bool Renderer::AreTimerQueriesSupported()
+{
+    return false;
+}
+
+TimerQuery_ID Renderer::CreateTimerQuery()
+{
+    return timerQueryMap.Insert(HeadlessTimerQuery());
+}
+
+void Renderer::BeginTimerQuery(TimerQuery_ID)
+{
+}
+
+void Renderer::EndTimerQuery(TimerQuery_ID)
+{
+}
+
+bool Renderer::GetTimerQueryResult(TimerQuery_ID, uint64_t&)
+{
+    return false;
+}
+
+void Renderer::DeleteTimerQuery(TimerQuery_ID queryID)
+{
+    timerQueryMap.Remove(queryID);
+}
+
+void Renderer::SetMeshDrawType(StaticMesh_ID meshID, DrawType type)
+{
+    if (HeadlessMesh* mesh = GetMesh(meshID))
+    {
+        mesh->drawType = type;
+    }
+}
+
+void Renderer::SetMeshColour(StaticMesh_ID meshID, Vec4f colour)
+{
+    std::vector<Vertex*> meshVertices = MapMeshVertices(meshID);
+
+    for (size_t i = 0; i < meshVertices.size(); ++i)
+    {
+        meshVertices[i]->colour = colour;
+    }
+
+    UnmapMeshVertices(meshID);
+}
+
+bool Renderer::GetMeshBounds(StaticMesh_ID meshID, AABB& outBounds)
+{
+    HeadlessMesh* mesh = GetMesh(meshID);
+
+    if (!mesh || !mesh->hasBounds)
+    {
+        return false;
+    }
+
+    outBounds = AABB(mesh->boundsMin, mesh->boundsMax);
+    return true;
+}
+
+std::vector<Vertex*> Renderer::MapMeshVertices(StaticMesh_ID meshID)
+{
+    std::vector<Vertex*> vertices;
+
+    HeadlessMesh* mesh = GetMesh(meshID);
+    if (!mesh)
+    {
+        return vertices;
+    }
+
+    if (mesh->compressed)
+    {
+        mesh->mappedVertices.resize(mesh->GetVertexCount());
+        VertexCompression::Decode(mesh->layout, mesh->decode, mesh->vertexData.data(), mesh->mappedVertices.size(), mesh->mappedVertices.data());
+
+        for (Vertex& vertex : mesh->mappedVertices)
+        {
+            vertices.push_back(&vertex);
+        }
+
+        Record("MapMeshVertices", meshID);
+        return vertices;
+    }
+
+    // Same as the OpenGL renderer, this assumes the mesh is made of Vertex
+    Vertex* vertexBuffer = (Vertex*)mesh->vertexData.data();
+    int vertexCount = (int)(mesh->vertexData.size() * sizeof(float) / sizeof(Vertex));
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        vertices.push_back(&vertexBuffer[i]);
+    }
+
+    Record("MapMeshVertices", meshID);
+    return vertices;
+}
+
+void Renderer::UnmapMeshVertices(StaticMesh_ID meshID)
+{
+    HeadlessMesh* mesh = GetMesh(meshID);
+    if (!mesh)
+    {
+        return;
+    }
+
+    // The vertices may have been moved while mapped
+    if (mesh->compressed)
+    {
+        mesh->SetCompressedVertices(mesh->mappedVertices.data(), mesh->mappedVertices.size());
+        mesh->mappedVertices.clear();
+    }
+    else
+    {
+        mesh->CalculateBounds();
+    }
+
+    Record("UnmapMeshVertices", meshID, mesh->vertexData.size() * sizeof(float));
+}
+
+std::vector<unsigned int*> Renderer::MapMeshElements(StaticMesh_ID meshID)
+{
+    std::vector<unsigned int*> elements;
+
+    HeadlessMesh* mesh = GetMesh(meshID);
+    if (!mesh)
+    {
+        return elements;
+    }
+
+    for (ElementIndex& index : mesh->indices)
+    {
+        elements.push_back(&index);
+    }
+
+    Record("MapMeshElements", meshID);
+    return elements;
+}
+
+void Renderer::UnmapMeshElements(StaticMesh_ID meshID)
+{
+    Record("UnmapMeshElements", meshID);
+}
+
+void Renderer::ClearScreenAndDepthBuffer()
+{
+    Record("ClearScreenAndDepthBuffer", currentlyBoundFBuffer);
+}
+
+void Renderer::SwapBuffer()
+{
+    Record("SwapBuffer");
+}
+
+void Renderer::ClearColourBuffer()
+{
+    Record("ClearColourBuffer", currentlyBoundFBuffer);
+}
+
+void Renderer::ClearDepthBuffer()
+{
+    Record("ClearDepthBuffer", currentlyBoundFBuffer);
+}
+
+void Renderer::ClearDepthBufferRegion(Recti)
+{
+    Record("ClearDepthBufferRegion", currentlyBoundFBuffer);
+}
+
+void Renderer::ClearStencilBuffer()
+{
+    Record("ClearStencilBuffer", currentlyBoundFBuffer);
+}
+
+void Renderer::EnableDepthTesting()
+{
+    Record("EnableDepthTesting");
+}
+
+void Renderer::DisableDepthTesting()
+{
+    Record("DisableDepthTesting");
+}
+
+void Renderer::SetDepthFunction(DepthFunc)
+{
+    Record("SetDepthFunction");
+}
+
+void Renderer::SetBlendFunction(BlendFunc)
+{
+    Record("SetBlendFunction");
+}
+
+void Renderer::EnableStencilTesting()
+{
+    Record("EnableStencilTesting");
+}
+
+void Renderer::DisableStencilTesting()
+{
+    Record("DisableStencilTesting");
+}
+
+void Renderer::StartStencilDrawing(StencilCompareFunc, StencilOperationFunc, int)
+{
+    Record("StartStencilDrawing");
+}
+
+void Renderer::EndStencilDrawing()
+{
+    Record("EndStencilDrawing");
+}
+
+void Renderer::StartStencilTesting(StencilCompareFunc, int)
+{
+    Record("StartStencilTesting");
+}
+
+void Renderer::EndStencilTesting()
+{
+    Record("EndStencilTesting");
+}
+
+void Renderer::SetCulling(Cull)
+{
+    Record("SetCulling");
+}
+
+Vec2i Renderer::GetViewportSize()
+{
+    return viewport.size;
+}
+
+bool Renderer::IsHeadless()
+{
+    return true;
+}
+
+RendererStats Renderer::GetStats()
+{
+    return stats;
+}
+
+void Renderer::ResetStats()
+{
+    stats = RendererStats();
+}
+
+void Renderer::SetCallRecording(bool enabled)
+{
+    recordingCalls = enabled;
+}
+
+const std::vector<RecordedRenderCall>& Renderer::GetRecordedCalls()
+{
+    return recordedCalls;
+}
+
+void Renderer::ClearRecordedCalls()
+{
+    recordedCalls.clear();
+}
+
+#endif // HEADLESS_RENDERER
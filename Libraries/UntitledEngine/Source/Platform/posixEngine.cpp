@@ -0,0 +1,529 @@
+// Linux/POSIX engine platform layer. There's no window system here: the engine runs windowless with the
+// headless renderer, which is what servers, simulations and benchmarks running on Linux machines need.
+// Output goes to stdout/stderr rather than message boxes and the debugger.
+
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "../GameEngine.h"
+#include "../Utils/Parallel.h"
+
+#ifndef HEADLESS_RENDERER
+#error The POSIX platform layer only supports the headless renderer (build with UNTITLED_HEADLESS_RENDERER)
+#endif
+
+// Size reported for the client area, there's no window to ask. Anything rendering offscreen gets buffers this big
+#define HEADLESS_CLIENT_AREA_WIDTH 1280
+#define HEADLESS_CLIENT_AREA_HEIGHT 720
+
+// Without vsync to hold it back the main loop would spin as fast as it can, so frames are capped at this rate
+// unless -uncapped is passed on the command line (for benchmarks)
+#define HEADLESS_FRAMES_PER_SECOND 60
+
+// Dedicated servers tick at this rate unless -tickrate <ticks per second> is passed
+#define DEDICATED_SERVER_TICK_RATE 30
+
+// If a dedicated server falls further behind than this many ticks it skips ahead instead of trying to catch up
+#define DEDICATED_SERVER_MAX_CATCH_UP_TICKS 5
+
+static std::atomic<bool> running = true;
+static ModuleManager Modules;
+
+static Vec2i cursorCenter;
+static bool cursorLocked = false;
+
+static timespec StartTime;
+
+// F3/F4 have no keyboard to come from, so the trace is written when the engine shuts down if -profile is passed
+static bool ExportProfileOnExit = false;
+
+// Filled in by a thread that sits blocked reading stdin, started the first time the console's polled
+static std::mutex ConsoleLinesLock;
+static std::queue<std::string> ConsoleLines;
+static bool ConsoleReaderStarted = false;
+
+static double GetSecondsSince(const timespec& since)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)(now.tv_sec - since.tv_sec) + (double)(now.tv_nsec - since.tv_nsec) / 1000000000.0;
+}
+
+static void HandleStopSignal(int)
+{
+    running = false;
+}
+
+float Engine::GetElapsedTime()
+{
+    return (float)GetSecondsSince(StartTime);
+}
+
+Vec2i Engine::GetWindowSize()
+{
+    return GetClientAreaSize();
+}
+
+Vec2i Engine::GetClientAreaSize()
+{
+    return Vec2i(HEADLESS_CLIENT_AREA_WIDTH, HEADLESS_CLIENT_AREA_HEIGHT);
+}
+
+Vec2i Engine::GetMousePosition()
+{
+    return cursorCenter;
+}
+
+void Engine::SetMousePosition(Vec2i)
+{
+}
+
+bool Engine::GetMouseDown(int)
+{
+    return false;
+}
+
+void Engine::DEBUGPrint(std::string string)
+{
+    fprintf(stdout, "%s\n", string.c_str());
+    fflush(stdout);
+}
+
+void Engine::Alert(std::string message)
+{
+    fprintf(stdout, "Alert: %s\n", message.c_str());
+    fflush(stdout);
+}
+
+void Engine::Error(std::string errorMessage)
+{
+    fprintf(stderr, "Error: %s\n", errorMessage.c_str());
+}
+
+void Engine::FatalError(std::string errorMessage)
+{
+    fprintf(stderr, "FatalError: %s\n", errorMessage.c_str());
+    exit(EXIT_FAILURE);
+}
+
+void Engine::SetCursorCenter(Vec2i center)
+{
+    cursorCenter = center;
+}
+
+void Engine::LockCursor()
+{
+    cursorLocked = true;
+}
+
+void Engine::UnlockCursor()
+{
+    cursorLocked = false;
+}
+
+void Engine::HideCursor()
+{
+}
+
+void Engine::ShowCursor()
+{
+}
+
+void Engine::StopGame()
+{
+    running = false;
+}
+
+bool Engine::IsWindowFocused()
+{
+    return false;
+}
+
+// No dialogs without a window, the path gets typed in instead
+static bool ReadPathFromConsole(const char* prompt, std::string& OutFileString)
+{
+    if (!isatty(STDIN_FILENO))
+    {
+        Engine::DEBUGPrint("No file dialogs on this platform and no terminal to ask for a path.");
+        return false;
+    }
+
+    fprintf(stdout, "%s: ", prompt);
+    fflush(stdout);
+
+    char path[4096];
+    if (!fgets(path, sizeof(path), stdin))
+    {
+        return false;
+    }
+
+    OutFileString = path;
+    while (!OutFileString.empty() && (OutFileString.back() == '\n' || OutFileString.back() == '\r'))
+    {
+        OutFileString.pop_back();
+    }
+    return !OutFileString.empty();
+}
+
+bool Engine::FileOpenDialog(std::string& OutFileString)
+{
+    return ReadPathFromConsole("Open level", OutFileString);
+}
+
+bool Engine::FileSaveDialog(std::string& OutFileString)
+{
+    return ReadPathFromConsole("Save level", OutFileString);
+}
+
+void Engine::SetWindowTitleText(std::string)
+{
+}
+
+void Engine::CreateNewWindow()
+{
+    Engine::DEBUGPrint("Can't create a window on this platform.");
+}
+
+void Engine::RunCommand(std::string Command)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execl("/bin/sh", "sh", "-c", Command.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    if (pid < 0)
+    {
+        Engine::Error("Couldn't start command: " + Command);
+        return;
+    }
+
+    // Wait until child process exits.
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+bool Engine::PollConsoleLine(std::string& OutLine)
+{
+    std::lock_guard<std::mutex> Lock(ConsoleLinesLock);
+
+    if (!ConsoleReaderStarted)
+    {
+        ConsoleReaderStarted = true;
+
+        // Left blocked in getline when the engine exits, detaching it means nothing has to wait for that
+        std::thread([]()
+            {
+                std::string Line;
+                while (std::getline(std::cin, Line))
+                {
+                    std::lock_guard<std::mutex> Lock(ConsoleLinesLock);
+                    ConsoleLines.push(Line);
+                }
+            }).detach();
+    }
+
+    if (ConsoleLines.empty())
+    {
+        return false;
+    }
+
+    OutLine = ConsoleLines.front();
+    ConsoleLines.pop();
+    return true;
+}
+
+bool Engine::MapFile(const std::string& FilePath, MappedFile& OutFile)
+{
+    OutFile = MappedFile();
+
+    int File = open(FilePath.c_str(), O_RDONLY);
+    if (File < 0)
+    {
+        return false;
+    }
+
+    struct stat Stat;
+    if (fstat(File, &Stat) != 0)
+    {
+        close(File);
+        return false;
+    }
+
+    // Zero length files can't be mapped
+    if (Stat.st_size == 0)
+    {
+        close(File);
+        return true;
+    }
+
+    // The mapping holds its own reference to the file, so it can be closed straight away
+    void* Data = mmap(nullptr, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+    close(File);
+    if (Data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Files are mostly read front to back, so read ahead aggressively
+    madvise(Data, (size_t)Stat.st_size, MADV_SEQUENTIAL);
+
+    OutFile.Data = (const char*)Data;
+    OutFile.Size = (size_t)Stat.st_size;
+    return true;
+}
+
+void Engine::UnmapFile(MappedFile& File)
+{
+    if (File.Data)
+    {
+        munmap((void*)File.Data, File.Size);
+    }
+
+    File = MappedFile();
+}
+
+#ifndef DEDICATED_SERVER
+
+static int RunWindowless(const std::string& args, bool uncapped)
+{
+    // Set up modules
+    Renderer renderer;
+    NetworkInterface networkInterface;
+
+    GraphicsModule Graphics(renderer);
+    CollisionModule Collisions(renderer);
+    TextModule Text(renderer);
+    InputModule Input;
+    UIModule UI(Graphics, Text, Input, renderer);
+    NetworkModule Network(networkInterface);
+    AudioModule Audio;
+
+    Graphics.Initialize();
+
+    Modules.SetGraphics(&Graphics);
+    Modules.SetCollision(&Collisions);
+    Modules.SetText(&Text);
+    Modules.SetInput(&Input);
+    Modules.SetUI(&UI);
+    Modules.SetNetwork(&Network);
+
+    Vec2i screenSize = Engine::GetClientAreaSize();
+    cursorCenter.x = screenSize.x / 2;
+    cursorCenter.y = screenSize.y / 2;
+
+    Initialize(args);
+    Resize(screenSize);
+
+    const double MinFrameSeconds = uncapped ? 0.0 : 1.0 / HEADLESS_FRAMES_PER_SECOND;
+
+    timespec LastFrameTime;
+    clock_gettime(CLOCK_MONOTONIC, &LastFrameTime);
+
+    while (running)
+    {
+        Profiler::BeginFrame();
+
+        Input.UpdateMousePos(Engine::GetMousePosition());
+        Input.SetMouseLocked(cursorLocked);
+        Input.ResetAllInputState();
+
+        Graphics.OnFrameStart();
+        UI.OnFrameStart();
+
+        double DeltaSeconds = GetSecondsSince(LastFrameTime);
+        clock_gettime(CLOCK_MONOTONIC, &LastFrameTime);
+
+        {
+            PROFILE_SCOPE("Engine::Update");
+            Update(DeltaSeconds);
+        }
+
+        {
+            PROFILE_SCOPE("Engine::Present");
+            Graphics.OnFrameEnd();
+        }
+        UI.OnFrameEnd();
+        Input.OnFrameEnd();
+
+        Profiler::EndFrame();
+
+        double FrameSeconds = GetSecondsSince(LastFrameTime);
+        if (FrameSeconds < MinFrameSeconds)
+        {
+            double SleepSeconds = MinFrameSeconds - FrameSeconds;
+
+            timespec SleepTime;
+            SleepTime.tv_sec = (time_t)SleepSeconds;
+            SleepTime.tv_nsec = (long)((SleepSeconds - (double)SleepTime.tv_sec) * 1000000000.0);
+            nanosleep(&SleepTime, nullptr);
+        }
+    }
+
+    return 0;
+}
+
+#else
+
+static void AddNanoseconds(timespec& time, int64_t nanoseconds)
+{
+    int64_t total = (int64_t)time.tv_nsec + nanoseconds;
+    time.tv_sec += (time_t)(total / 1000000000);
+    time.tv_nsec = (long)(total % 1000000000);
+}
+
+static bool IsBefore(const timespec& lhs, const timespec& rhs)
+{
+    return lhs.tv_sec < rhs.tv_sec || (lhs.tv_sec == rhs.tv_sec && lhs.tv_nsec < rhs.tv_nsec);
+}
+
+// Only what a server needs to simulate a scene and talk to clients: no text or UI modules, and nothing ever drawn.
+// The graphics module is still there because loading a scene goes through it, but it sits on the headless renderer
+// (which in a dedicated server build doesn't keep texture data around) so it doesn't cost much
+static int RunDedicatedServer(const std::string& args, int tickRate)
+{
+    Renderer renderer;
+    NetworkInterface networkInterface;
+
+    GraphicsModule Graphics(renderer);
+    CollisionModule Collisions(renderer);
+    InputModule Input;
+    NetworkModule Network(networkInterface);
+    AudioModule Audio;
+
+    // Materials still want their default textures to point at, and behaviours can still debug draw (it just gets
+    // thrown away every tick)
+    Graphics.Initialize();
+    Graphics.InitializeDebugDraw();
+
+    Modules.SetGraphics(&Graphics);
+    Modules.SetCollision(&Collisions);
+    Modules.SetInput(&Input);
+    Modules.SetNetwork(&Network);
+
+    Initialize(args);
+
+    Engine::DEBUGPrint("Dedicated server running at " + std::to_string(tickRate) + " ticks per second.");
+
+    // Every tick simulates exactly the same amount of time, and is scheduled against an absolute deadline so
+    // time spent in a tick doesn't push every later tick back
+    const int64_t TickNanoseconds = 1000000000 / tickRate;
+    const double TickSeconds = 1.0 / tickRate;
+
+    timespec NextTick;
+    clock_gettime(CLOCK_MONOTONIC, &NextTick);
+
+    while (running)
+    {
+        Profiler::BeginFrame();
+
+        Graphics.OnFrameStart();
+
+        {
+            PROFILE_SCOPE("Engine::Update");
+            Update(TickSeconds);
+        }
+
+        Input.OnFrameEnd();
+
+        Profiler::EndFrame();
+
+        AddNanoseconds(NextTick, TickNanoseconds);
+
+        timespec Now;
+        clock_gettime(CLOCK_MONOTONIC, &Now);
+
+        if (IsBefore(Now, NextTick))
+        {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &NextTick, nullptr);
+            continue;
+        }
+
+        // Behind, the next tick runs straight away. If it's hopelessly behind (the machine was suspended, a tick took
+        // seconds...) drop the backlog rather than running a burst of ticks back to back
+        timespec CatchUpLimit = NextTick;
+        AddNanoseconds(CatchUpLimit, TickNanoseconds * DEDICATED_SERVER_MAX_CATCH_UP_TICKS);
+        if (!IsBefore(Now, CatchUpLimit))
+        {
+            NextTick = Now;
+        }
+    }
+
+    return 0;
+}
+
+#endif // DEDICATED_SERVER
+
+// Program entry point
+int main(int argc, char** argv)
+{
+    clock_gettime(CLOCK_MONOTONIC, &StartTime);
+
+    // Ctrl+C or a kill from whatever's managing the process shuts down cleanly instead of just dying
+    signal(SIGINT, HandleStopSignal);
+    signal(SIGTERM, HandleStopSignal);
+
+    // Same single string of arguments as on Windows
+    std::string args;
+    [[maybe_unused]] bool uncapped = false;
+    int tickRate = DEDICATED_SERVER_TICK_RATE;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-uncapped")
+        {
+            uncapped = true;
+            continue;
+        }
+        else if (arg == "-profile")
+        {
+            ExportProfileOnExit = true;
+            continue;
+        }
+        else if (arg == "-tickrate" && i + 1 < argc)
+        {
+            tickRate = atoi(argv[++i]);
+            if (tickRate <= 0)
+            {
+                Engine::FatalError("-tickrate needs a positive number of ticks per second");
+            }
+            continue;
+        }
+
+        if (!args.empty())
+        {
+            args += " ";
+        }
+        args += arg;
+    }
+
+    Profiler::SetThreadName("Main");
+    Parallel::StartWorkers();
+
+#ifdef DEDICATED_SERVER
+    int result = RunDedicatedServer(args, tickRate);
+#else
+    int result = RunWindowless(args, uncapped);
+#endif
+
+    if (ExportProfileOnExit && !Profiler::ExportChromeTrace("profile.json"))
+    {
+        Engine::DEBUGPrint("Couldn't write profile.json");
+    }
+
+    return result;
+}
@@ -4,7 +4,8 @@
 #include <locale>
 #include <codecvt>
 
-#include "..\GameEngine.h"
+#include "../GameEngine.h"
+#include "../Utils/Parallel.h"
 
 static bool running = true;
 static HWND WindowHandle;
@@ -18,6 +19,9 @@ static bool cursorHidden = false;
 static int64_t TICKS_PER_SECOND;
 static int64_t LAST_FRAME_TICK_COUNT;
 
+// F3 toggles the profiler overlay, F4 writes out a trace of the last few seconds
+static bool ProfilerOverlayVisible = false;
+
 // Convert a wide Unicode string to an UTF8 string
 std::string utf8_encode(const std::wstring& wstr)
 {
@@ -284,6 +288,11 @@ void GetKeyboardState(InputModule& inputs)
     inputs.SetKeyDown(Key::Plus, GetAsyncKeyState(VK_OEM_PLUS));
     inputs.SetKeyDown(Key::Minus, GetAsyncKeyState(VK_OEM_MINUS));
 
+    for (int i = 0; i < 12; ++i)
+    {
+        inputs.SetKeyDown((Key)((int)Key::F1 + i), GetAsyncKeyState(VK_F1 + i));
+    }
+
     inputs.SetKeyDown(Key::Escape, GetAsyncKeyState(VK_ESCAPE));
 
     inputs.GetMouseState().SetMouseButtonDown(MouseButton::LMB, GetAsyncKeyState(VK_LBUTTON));
@@ -542,11 +551,16 @@ int WinMain(_In_ HINSTANCE InInstance, _In_opt_ HINSTANCE InPreviousInstance, _I
 
     std::string args = CommandLine;
 
+    Profiler::SetThreadName("Main");
+    Parallel::StartWorkers();
+
     Initialize(args);
     Resize(screenSize);
 
     while (running)
     {
+        Profiler::BeginFrame();
+
         MSG Message = {};
         while (PeekMessage(&Message, WindowHandle, 0, 0, PM_REMOVE))
         {
@@ -583,10 +597,35 @@ int WinMain(_In_ HINSTANCE InInstance, _In_opt_ HINSTANCE InPreviousInstance, _I
 
         double DeltaSeconds = (double)DELTA_TICKS / (double)TICKS_PER_SECOND;
 
-        Update(DeltaSeconds);
-        Graphics.OnFrameEnd();
+        {
+            PROFILE_SCOPE("Engine::Update");
+            Update(DeltaSeconds);
+        }
+
+        if (Input.GetKeyState(Key::F3).justPressed)
+        {
+            ProfilerOverlayVisible = !ProfilerOverlayVisible;
+        }
+        if (Input.GetKeyState(Key::F4).justPressed)
+        {
+            if (!Profiler::ExportChromeTrace("profile.json"))
+            {
+                Engine::DEBUGPrint("Couldn't write profile.json");
+            }
+        }
+        if (ProfilerOverlayVisible)
+        {
+            Profiler::DrawOverlay(UI, Rect(Vec2f((float)Engine::GetClientAreaSize().x - 410.0f, 10.0f), Vec2f(400.0f, 420.0f)));
+        }
+
+        {
+            PROFILE_SCOPE("Engine::Present");
+            Graphics.OnFrameEnd();
+        }
         UI.OnFrameEnd();
         Input.OnFrameEnd();
+
+        Profiler::EndFrame();
     }
     return 0;
 }
@@ -648,3 +687,63 @@ void Engine::RunCommand(std::string Command)
     CloseHandle(pi.hThread);
 
 }
+
+bool Engine::PollConsoleLine(std::string& OutLine)
+{
+    return false;
+}
+
+bool Engine::MapFile(const std::string& FilePath, MappedFile& OutFile)
+{
+    OutFile = MappedFile();
+
+    HANDLE File = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER Size;
+    if (!GetFileSizeEx(File, &Size))
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    // Zero length files can't be mapped
+    if (Size.QuadPart == 0)
+    {
+        CloseHandle(File);
+        return true;
+    }
+
+    HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(File);
+    if (!Mapping)
+    {
+        return false;
+    }
+
+    const void* View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!View)
+    {
+        CloseHandle(Mapping);
+        return false;
+    }
+
+    OutFile.Data = (const char*)View;
+    OutFile.Size = (size_t)Size.QuadPart;
+    OutFile.Handle = Mapping;
+    return true;
+}
+
+void Engine::UnmapFile(MappedFile& File)
+{
+    if (File.Data)
+    {
+        UnmapViewOfFile(File.Data);
+        CloseHandle((HANDLE)File.Handle);
+    }
+
+    File = MappedFile();
+}
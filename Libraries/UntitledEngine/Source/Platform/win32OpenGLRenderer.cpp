@@ -1,3 +1,6 @@
+// The default renderer, compiled out when the engine is built with the headless renderer instead (see headlessRenderer.cpp)
+#ifndef HEADLESS_RENDERER
+
 #include "EnginePlatform.h"
 
 #define GLEW_STATIC
@@ -14,6 +17,8 @@
 #include <assert.h>
 #include <time.h> 
 #include "RendererPlatform.h"
+#include "Utils/SlotMap.h"
+#include "Rendering/VertexCompression.h"
 
 // TODO(fraser): Use another image loading library or something (million warnings) - or make my own!
 #define STB_IMAGE_IMPLEMENTATION
@@ -24,24 +29,27 @@
 
 #define MAX_SHADER_VARIABLE_NAME_SIZE 40
 
-VertexBufferFormat::VertexBufferFormat(std::initializer_list<VertAttribute> vertAttributes)
-    : _attributes(vertAttributes)
-    , _vertexStride(0)
-{
-    for (auto it = vertAttributes.begin(); it != vertAttributes.end(); ++it)
-    {
-        _vertexStride += GetSize(*it);
-    }
-}
+// Number of frames the dynamic geometry buffer is split into, the CPU can be this many frames ahead of the GPU
+// before writing dynamic geometry has to wait
+#define DYNAMIC_GEOMETRY_FRAMES 3
 
-void VertexBufferFormat::EnableVertexAttributes() const
+void VertexBufferFormat::EnableVertexAttributes(unsigned int firstLocation) const
 {
     size_t offset = 0;
+    unsigned int location = firstLocation;
     for (int i = 0; i < _attributes.size(); ++i)
     {
-        glEnableVertexAttribArray(i);
+        if (_attributes[i] == VertAttribute::Empty)
+        {
+            // Disabled attributes read the current generic value instead
+            glDisableVertexAttribArray(location);
+            glVertexAttrib4f(location, 1.0f, 1.0f, 1.0f, 1.0f);
+            location++;
+            continue;
+        }
 
         GLint type;
+        GLboolean normalized = GL_FALSE;
         switch (_attributes[i])
         {
         case VertAttribute::Int:
@@ -54,62 +62,44 @@ void VertexBufferFormat::EnableVertexAttributes() const
         case VertAttribute::Vec2f:
         case VertAttribute::Vec3f:
         case VertAttribute::Vec4f:
+        case VertAttribute::Mat4x4f:
             type = GL_FLOAT;
             break;
+        case VertAttribute::Vec2ShortNorm:
+            type = GL_SHORT;
+            normalized = GL_TRUE;
+            break;
+        case VertAttribute::Vec4UShortNorm:
+            type = GL_UNSIGNED_SHORT;
+            normalized = GL_TRUE;
+            break;
+        case VertAttribute::Vec4UByteNorm:
+            type = GL_UNSIGNED_BYTE;
+            normalized = GL_TRUE;
+            break;
+        case VertAttribute::Vec2Half:
+        case VertAttribute::Vec4Half:
+            type = GL_HALF_FLOAT;
+            break;
         default:
             type = GL_FLOAT;
             break;
         }
 
-        glVertexAttribPointer(i, GetCount(_attributes[i]), type, GL_FALSE, _vertexStride, (void*)offset);
-        offset += GetSize(_attributes[i]);
-    }
-}
-
-const std::vector<VertAttribute>& VertexBufferFormat::GetAttributes() const
-{
-    return _attributes;
-}
-
-unsigned int VertexBufferFormat::GetVertexStride() const
-{
-    return _vertexStride;
-}
+        // Matrices are split up into one vec4 attribute per column
+        unsigned int locationCount = GetLocationCount(_attributes[i]);
+        unsigned int componentCount = GetCount(_attributes[i]) / locationCount;
+        unsigned int componentSize = GetSize(_attributes[i]) / locationCount;
 
-unsigned int VertexBufferFormat::GetCount(VertAttribute vertAttribute) const
-{
-    switch (vertAttribute)
-    {
-    case VertAttribute::Int:
-    case VertAttribute::UInt:
-    case VertAttribute::Float:
-        return 1;
-    case VertAttribute::Vec2f:
-        return 2;
-    case VertAttribute::Vec3f:
-        return 3;
-    case VertAttribute::Vec4f:
-        return 4;
-    default:
-        return 0;
-    }
-}
+        for (unsigned int j = 0; j < locationCount; ++j)
+        {
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, componentCount, type, normalized, _vertexStride, (void*)offset);
+            glVertexAttribDivisor(location, _instanceDivisor);
 
-unsigned int VertexBufferFormat::GetSize(VertAttribute vertAttribute) const
-{
-    switch (vertAttribute)
-    {
-    case VertAttribute::Int:
-        return sizeof(int);
-    case VertAttribute::UInt:
-        return sizeof(unsigned int);
-    case VertAttribute::Float:
-    case VertAttribute::Vec2f:
-    case VertAttribute::Vec3f:
-    case VertAttribute::Vec4f:
-        return sizeof(float) * GetCount(vertAttribute);
-    default:
-        return 0;
+            offset += componentSize;
+            location++;
+        }
     }
 }
 
@@ -246,10 +236,14 @@ namespace
             return GL_RGB;
         case ColourFormat::RGBA:
             return GL_RGBA;
+        case ColourFormat::RG:
+            return GL_RG;
         case ColourFormat::Red:
             return GL_RED;
         case ColourFormat::DEPTH:
             return GL_DEPTH_COMPONENT;
+        case ColourFormat::DEPTH_STENCIL:
+            return GL_DEPTH_STENCIL;
         default:
             return GL_RGBA;
         }
@@ -261,6 +255,8 @@ namespace
         {
         case DataFormat::FLOAT:
             return GL_FLOAT;
+        case DataFormat::HALF_FLOAT:
+            return GL_HALF_FLOAT;
         case DataFormat::UNSIGNED_BYTE:
             return GL_UNSIGNED_BYTE;
         default:
@@ -268,7 +264,28 @@ namespace
         }
     }
 
-    GLint GetUniformLocation(std::unordered_map<std::string, GLint>& uniformMap, std::string key)
+    GLenum GetSizedInternalFormat(ColourFormat format, DataFormat dataFormat)
+    {
+        switch (format)
+        {
+        case ColourFormat::RGB:
+            return dataFormat == DataFormat::FLOAT ? GL_RGB32F : dataFormat == DataFormat::HALF_FLOAT ? GL_RGB16F : GL_RGB8;
+        case ColourFormat::RGBA:
+            return dataFormat == DataFormat::FLOAT ? GL_RGBA32F : dataFormat == DataFormat::HALF_FLOAT ? GL_RGBA16F : GL_RGBA8;
+        case ColourFormat::RG:
+            return dataFormat == DataFormat::FLOAT ? GL_RG32F : dataFormat == DataFormat::HALF_FLOAT ? GL_RG16F : GL_RG8;
+        case ColourFormat::Red:
+            return dataFormat == DataFormat::FLOAT ? GL_R32F : dataFormat == DataFormat::HALF_FLOAT ? GL_R16F : GL_R8;
+        case ColourFormat::DEPTH:
+            return GL_DEPTH_COMPONENT32F;
+        case ColourFormat::DEPTH_STENCIL:
+            return GL_DEPTH24_STENCIL8;
+        default:
+            return GL_RGBA32F;
+        }
+    }
+
+    GLint GetUniformLocation(const std::unordered_map<std::string, GLint>& uniformMap, const std::string& key)
     {
         auto it = uniformMap.find(key);
         if (it != uniformMap.end())
@@ -282,7 +299,7 @@ namespace
         }
     }
 
-    GLint GetSamplerLocation(std::unordered_map<std::string, GLint>& samplerMap, std::string key)
+    GLint GetSamplerLocation(const std::unordered_map<std::string, GLint>& samplerMap, const std::string& key)
     {
         auto it = samplerMap.find(key);
         if (it != samplerMap.end())
@@ -375,16 +392,24 @@ namespace
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
         
-        OpenGLFBuffer(Vec2i size, FBufferFormat format, GLuint renderBuffer)
+        OpenGLFBuffer(Vec2i size, FBufferFormat format, GLuint renderBuffer, GLuint depthTexture)
             : size(size)
             , format(format)
             , rbo(renderBuffer)
+            , depthTexture(depthTexture)
         {
             glGenFramebuffers(1, &fbo);
 
             glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 
-            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderBuffer);
+            if (depthTexture)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+            }
+            else
+            {
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderBuffer);
+            }
 
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
@@ -395,6 +420,9 @@ namespace
         GLuint rbo;
         Vec2i size;
         FBufferFormat format;
+
+        // Set once the depth/stencil render buffer has been swapped for a texture (owned by the texture map, not the FBuffer)
+        GLuint depthTexture = 0;
     };
 
     struct OpenGLTexture
@@ -610,12 +638,19 @@ namespace
             glBindTexture(GL_TEXTURE_2D, texture);
 
             Vec2i Size = CreateInfo.Size;
-            GLenum InternalFormat = ColourFormatToGLFormat(CreateInfo.InternalFormat);
+            GLenum InternalFormat = GetSizedInternalFormat(CreateInfo.InternalFormat, CreateInfo.DataFormat);
             GLenum ExternalFormat = ColourFormatToGLFormat(CreateInfo.ExternalFormat);
             GLenum DataFormat = DataFormatToGLFormat(CreateInfo.DataFormat);
 
-            // TEMP: FORMAT
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Size.x, Size.y, 0, GL_RGBA, DataFormat, 0);
+            bool IsDepth = CreateInfo.InternalFormat == ColourFormat::DEPTH || CreateInfo.InternalFormat == ColourFormat::DEPTH_STENCIL;
+
+            // Packed depth/stencil only accepts the packed data type
+            if (CreateInfo.InternalFormat == ColourFormat::DEPTH_STENCIL)
+            {
+                DataFormat = GL_UNSIGNED_INT_24_8;
+            }
+
+            glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, Size.x, Size.y, 0, ExternalFormat, DataFormat, 0);
 
             // TODO(fraser) Specify these parameters via the TextureCreateInfo struct as well
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -624,11 +659,14 @@ namespace
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-            float anisotropic = 0.0f;
-            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropic);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropic);
+            if (!IsDepth)
+            {
+                float anisotropic = 0.0f;
+                glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropic);
+                glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropic);
 
-            glGenerateMipmap(GL_TEXTURE_2D);
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
 
             glBindTexture(GL_TEXTURE_2D, 0);
         }
@@ -699,6 +737,14 @@ namespace
         std::unordered_map<std::string, GLint> m_AttributeLocations;
         std::unordered_map<std::string, GLint> m_SamplerLocations;
 
+        // Where the shader takes the VertexDecode of the mesh being drawn, -1 for shaders that don't draw static meshes
+        GLint m_PositionDecodeLocation = -1;
+        GLint m_OctahedralNormalsLocation = -1;
+
+        // Last VertexDecode given to the shader, so it's only set again when it changes
+        VertexDecode m_CurrentDecode;
+        bool m_DecodeSet = false;
+
         OpenGLShader(std::string vertShaderSource, std::string fragShaderSource)
         {
             const char* vertCStr = vertShaderSource.c_str();
@@ -795,7 +841,8 @@ namespace
 
                     // ASSUMPTION: the order that textures are defined in shader code is the same as the order they're gotten in glGetActiveUniform
                     // This might not be true, so I look forward to a fun bug
-                    if (typeEnum == GL_SAMPLER_2D || typeEnum == GL_SAMPLER_CUBE)
+                    if (typeEnum == GL_SAMPLER_2D || typeEnum == GL_SAMPLER_CUBE
+                        || typeEnum == GL_SAMPLER_BUFFER || typeEnum == GL_INT_SAMPLER_BUFFER || typeEnum == GL_UNSIGNED_INT_SAMPLER_BUFFER)
                     {
                         m_SamplerLocations[name] = texIndex;
                         glUniform1i(uniformLoc, texIndex++);
@@ -803,6 +850,9 @@ namespace
                 }
             }
 
+            m_PositionDecodeLocation = glGetUniformLocation(m_ProgramId, "MeshPositionDecode");
+            m_OctahedralNormalsLocation = glGetUniformLocation(m_ProgramId, "MeshOctahedralNormals");
+
             glUseProgram(0);
         }
     };
@@ -836,9 +886,16 @@ namespace
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
             numVertices = (int)vertexData.size() / (vertBufFormat.GetVertexStride() / sizeof(float));
+
+            CalculateBounds(vertBufFormat, vertexData);
         }
 
         OpenGLMesh(const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData, std::vector<ElementIndex> indices)
+            : OpenGLMesh(vertBufFormat, vertexData.data(), vertexData.size(), indices.data(), indices.size())
+        {
+        }
+
+        OpenGLMesh(const VertexBufferFormat& vertBufFormat, const float* vertexData, size_t vertexFloatCount, const ElementIndex* indices, size_t indexCount)
         {
             glGenVertexArrays(1, &VAO);
             glBindVertexArray(VAO);
@@ -849,12 +906,12 @@ namespace
             glGenBuffers(1, &EBO);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 
-            bufferSize = (int)vertexData.size() * sizeof(float);
+            bufferSize = (int)(vertexFloatCount * sizeof(float));
             useElementArray = true;
 
             // TODO: option for dynamic vs static draw (profile difference too)
-            glNamedBufferData(VBO, bufferSize, vertexData.data(), GL_DYNAMIC_DRAW);
-            glNamedBufferData(EBO, indices.size() * sizeof(ElementIndex), indices.data(), GL_DYNAMIC_DRAW);
+            glNamedBufferData(VBO, bufferSize, vertexData, GL_DYNAMIC_DRAW);
+            glNamedBufferData(EBO, indexCount * sizeof(ElementIndex), indices, GL_DYNAMIC_DRAW);
 
             vertBufFormat.EnableVertexAttributes();
 
@@ -862,8 +919,10 @@ namespace
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-            numElements = (int)indices.size();
-            numVertices = (int)vertexData.size() / (vertBufFormat.GetVertexStride() / sizeof(float));
+            numElements = (int)indexCount;
+            numVertices = (int)(vertexFloatCount / (vertBufFormat.GetVertexStride() / sizeof(float)));
+
+            CalculateBounds(vertBufFormat, vertexData, vertexFloatCount);
 
             //Engine::DEBUGPrint("Created mesh with " + std::to_string(numElements) + " elements and " + std::to_string(numVertices) + " vertices.");
             //Engine::DEBUGPrint("VBO: " + std::to_string(VBO) + ", EBO: " + std::to_string(EBO) + ", VAO: " + std::to_string(VAO));
@@ -900,11 +959,110 @@ namespace
             this->useElementArray = useElementArray;
         }
 
+        OpenGLMesh(const CompressedVertexLayout& layout, const Vertex* vertices, size_t vertexCount, std::vector<ElementIndex> indices)
+        {
+            glGenVertexArrays(1, &VAO);
+            glBindVertexArray(VAO);
+
+            glGenBuffers(1, &VBO);
+            glGenBuffers(1, &EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+            glNamedBufferData(EBO, indices.size() * sizeof(ElementIndex), indices.data(), GL_STATIC_DRAW);
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+            numElements = (int)indices.size();
+            useElementArray = true;
+
+            requestedLayout = layout;
+            SetCompressedVertices(vertices, vertexCount);
+        }
+
         ~OpenGLMesh()
         {
 
         }
 
+        // Packs the vertices into the requested layout and replaces the vertex buffer with them.
+        // The layout can change each time (e.g. a colour gets added to a mesh that was all white), so the attributes are set up again too
+        void SetCompressedVertices(const Vertex* vertices, size_t vertexCount)
+        {
+            CompressedVertices packed = VertexCompression::Encode(requestedLayout, vertices, vertexCount);
+
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+            bufferSize = (int)packed.Data.size() * sizeof(float);
+            glBufferData(GL_ARRAY_BUFFER, bufferSize, packed.Data.data(), GL_STATIC_DRAW);
+
+            VertexCompression::GetFormat(packed.Layout).EnableVertexAttributes();
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            numVertices = (int)vertexCount;
+
+            compressed = true;
+            layout = packed.Layout;
+            decode = packed.Decode;
+
+            CalculateBounds(vertices, (int)vertexCount);
+        }
+
+        // Bounds are only tracked for meshes whose first attribute is a 3D position
+        void CalculateBounds(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData)
+        {
+            CalculateBounds(vertBufFormat, vertexData.data(), vertexData.size());
+        }
+
+        void CalculateBounds(const VertexBufferFormat& vertBufFormat, const float* vertexData, size_t vertexFloatCount)
+        {
+            hasBounds = false;
+
+            const std::vector<VertAttribute>& attributes = vertBufFormat.GetAttributes();
+            if (attributes.empty() || attributes[0] != VertAttribute::Vec3f)
+            {
+                return;
+            }
+
+            size_t floatStride = vertBufFormat.GetVertexStride() / sizeof(float);
+            for (size_t i = 0; i + 2 < vertexFloatCount; i += floatStride)
+            {
+                ExpandBounds(Vec3f(vertexData[i], vertexData[i + 1], vertexData[i + 2]));
+            }
+        }
+
+        void CalculateBounds(const Vertex* vertices, int count)
+        {
+            hasBounds = false;
+
+            for (int i = 0; i < count; ++i)
+            {
+                ExpandBounds(vertices[i].position);
+            }
+        }
+
+        void ExpandBounds(Vec3f point)
+        {
+            if (!hasBounds)
+            {
+                boundsMin = point;
+                boundsMax = point;
+                hasBounds = true;
+                return;
+            }
+
+            if (point.x < boundsMin.x) boundsMin.x = point.x;
+            if (point.y < boundsMin.y) boundsMin.y = point.y;
+            if (point.z < boundsMin.z) boundsMin.z = point.z;
+
+            if (point.x > boundsMax.x) boundsMax.x = point.x;
+            if (point.y > boundsMax.y) boundsMax.y = point.y;
+            if (point.z > boundsMax.z) boundsMax.z = point.z;
+        }
+
         GLuint VAO;
         GLuint VBO;
         GLuint EBO;
@@ -913,160 +1071,526 @@ namespace
         int bufferSize;
         bool useElementArray;
 
+        // Whether this mesh's VAO has had the instance buffer attributes hooked up yet
+        bool instanceAttributesEnabled = false;
+
+        // Compressed meshes keep how they were packed so their vertices can be unpacked when they're read back or mapped
+        bool compressed = false;
+        CompressedVertexLayout requestedLayout;
+        CompressedVertexLayout layout;
+        VertexDecode decode;
+
+        // Unpacked copy of a compressed mesh's vertices while they're mapped, packed back up on unmap
+        std::vector<Vertex> mappedVertices;
+
+        // Local space bounds of the vertex positions, kept up to date whenever the vertex data changes
+        bool hasBounds = false;
+        Vec3f boundsMin;
+        Vec3f boundsMax;
+
         DrawType drawType = DrawType::Triangle;
     };
 
-    std::unordered_map<Framebuffer_ID, OpenGLFBuffer> fBufferMap;
-    std::unordered_map<Texture_ID, OpenGLTexture> textureMap;
-    std::unordered_map<Cubemap_ID, OpenGLCubemap> cubemapMap;
-    std::unordered_map<Shader_ID, OpenGLShader> shaderMap;
-    std::unordered_map<StaticMesh_ID, OpenGLMesh> meshMap;
-    Shader_ID currentlyBoundShader;
+    // Per-instance transforms for instanced draws get streamed in here front to back, 
+    // once it's full the storage gets orphaned and we start again from the front
+    struct OpenGLInstanceBuffer
+    {
+        GLuint VBO = 0;
+        GLsizeiptr capacity = 0;
+        GLsizeiptr offset = 0;
+    };
+
+    // Dynamic geometry for the frame gets written into one persistently mapped buffer, split into a region per frame in flight.
+    // A region is only written to again once the fence put down at the end of the last frame that used it has signalled.
+    // Without ARB_buffer_storage the buffer isn't mapped (mappedData is null) and writes go through glNamedBufferSubData instead
+    struct OpenGLDynamicGeometryBuffer
+    {
+        GLuint buffer = 0;
+        unsigned char* mappedData = nullptr;
+
+        GLsizeiptr regionSize = 0;
+        GLsync regionFences[DYNAMIC_GEOMETRY_FRAMES] = {};
+        int region = 0;
+        GLsizeiptr offset = 0;
+
+        // Whether anything has been written to the current region this frame (and so its fence has been waited on)
+        bool regionInUse = false;
+
+        // Total size asked for this frame, including anything that didn't fit. The buffer grows to fit before the next frame
+        GLsizeiptr frameSize = 0;
+        GLsizeiptr requiredRegionSize = 0;
+
+        // One VAO per vertex format, they all read from the same buffer
+        std::vector<std::pair<VertexBufferFormat, GLuint>> VAOs;
+    };
+
+    struct OpenGLUniformBuffer
+    {
+        OpenGLUniformBuffer(unsigned int size, unsigned int bindingPoint)
+            : size(size)
+            , bindingPoint(bindingPoint)
+        {
+            glGenBuffers(1, &UBO);
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, UBO);
+        }
+
+        GLuint UBO;
+        unsigned int size;
+        unsigned int bindingPoint;
+    };
+
+    struct OpenGLBufferTexture
+    {
+        OpenGLBufferTexture(GLenum internalFormat)
+            : internalFormat(internalFormat)
+        {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+        }
+
+        GLuint buffer;
+        GLuint texture;
+        GLenum internalFormat;
+    };
+
+    struct OpenGLTimerQuery
+    {
+        GLuint query = 0;
+
+        // Reading the result of a query that was never issued is an error
+        bool issued = false;
+    };
+
+    // Minimum size of the instance buffer, enough for 1024 transforms
+    const GLsizeiptr minInstanceBufferSize = 1024 * sizeof(Mat4x4f);
+
+    // Minimum size of a single frame's region of the dynamic geometry buffer
+    const GLsizeiptr minDynamicGeometryRegionSize = 1024 * 1024;
+
+    SlotMap<OpenGLFBuffer> fBufferMap;
+    SlotMap<OpenGLTexture> textureMap;
+    SlotMap<OpenGLCubemap> cubemapMap;
+    SlotMap<OpenGLShader> shaderMap;
+    SlotMap<OpenGLMesh> meshMap;
+    SlotMap<OpenGLUniformBuffer> uniformBufferMap;
+    SlotMap<OpenGLBufferTexture> bufferTextureMap;
+    SlotMap<OpenGLTimerQuery> timerQueryMap;
+    Shader_ID currentlyBoundShader = SlotMap<OpenGLShader>::InvalidHandle;
+
+    OpenGLInstanceBuffer instanceBuffer;
+    const VertexBufferFormat instanceTransformFormat = VertexBufferFormat({ VertAttribute::Mat4x4f }, 1);
+
+    OpenGLDynamicGeometryBuffer dynamicGeometryBuffer;
 
     HDC deviceContext;
     HGLRC glContext;
 
+    bool timerQueriesSupported = false;
+    bool bufferStorageSupported = false;
+
     //TEMP (fraser)
     Texture_ID whiteRenderTexture;
     bool renderDebugMesh = false;
 
-    OpenGLFBuffer* GetGLFBufferFromFBufferID(Framebuffer_ID fBufferID)
+    template <typename T>
+    T* GetResource(SlotMap<T>& resourceMap, GUID id, const char* resourceName)
     {
-        auto it = fBufferMap.find(fBufferID);
-        if (it != fBufferMap.end())
-        {
-            return &it->second;
-        }
-        else
+        T* resource = resourceMap.Get(id);
+        if (!resource && resourceMap.IsStale(id))
         {
-            return nullptr;
+            Engine::DEBUGPrint("ERROR: Stale " + std::string(resourceName) + " handle <" + std::to_string(id) + ">, the resource has already been deleted.");
         }
+        return resource;
+    }
+
+    OpenGLFBuffer* GetGLFBufferFromFBufferID(Framebuffer_ID fBufferID)
+    {
+        return GetResource(fBufferMap, fBufferID, "framebuffer");
     }
 
     OpenGLTexture* GetGLTextureFromTextureID(Texture_ID textureID)
     {
-        auto it = textureMap.find(textureID);
-        if (it != textureMap.end())
-        {
-            return &it->second;
-        }
-        else 
-        {
-            return nullptr;
-        }
+        return GetResource(textureMap, textureID, "texture");
     }
     
     OpenGLCubemap* GetGLCubemapFromCubemapID(Cubemap_ID cubemapID)
     {
-        auto it = cubemapMap.find(cubemapID);
-        if (it != cubemapMap.end())
-        {
-            return &it->second;
-        }
-        else
-        {
-            return nullptr;
-        }
+        return GetResource(cubemapMap, cubemapID, "cubemap");
     }
 
     OpenGLShader* GetGLShaderFromShaderID(Shader_ID shaderID)
     {
-        auto it = shaderMap.find(shaderID);
-        if (it != shaderMap.end())
-        {
-            return &it->second;
-        }
-        else {
-            return nullptr;
-        }
+        return GetResource(shaderMap, shaderID, "shader");
     }
 
     OpenGLMesh* GetGLMeshFromMeshID(StaticMesh_ID meshID)
     {
-        auto it = meshMap.find(meshID);
-        if (it != meshMap.end())
-        {
-            return &it->second;
-        }
-        else {
-            return nullptr;
-        }
+        return GetResource(meshMap, meshID, "mesh");
     }
-}
 
-// Error handling
-void GLAPIENTRY
-MessageCallback(GLenum source,
-    GLenum type,
-    GLuint id,
-    GLenum severity,
-    GLsizei length,
-    const GLchar* message,
-    const void* userParam)
-{
-    if (severity == GL_DEBUG_SEVERITY_LOW)
+    OpenGLUniformBuffer* GetGLUniformBufferFromUniformBufferID(UniformBuffer_ID bufferID)
     {
-        Engine::DEBUGPrint("Low severity: " + std::string(message) + "\n");
+        return GetResource(uniformBufferMap, bufferID, "uniform buffer");
     }
-    else if (severity == GL_DEBUG_SEVERITY_MEDIUM)
+
+    OpenGLBufferTexture* GetGLBufferTextureFromBufferTextureID(BufferTexture_ID bufferTextureID)
     {
-        Engine::DEBUGPrint("Medium severity: " + std::string(message) + "\n");
+        return GetResource(bufferTextureMap, bufferTextureID, "buffer texture");
     }
-    else if (severity == GL_DEBUG_SEVERITY_HIGH)
+
+    OpenGLTimerQuery* GetGLTimerQueryFromTimerQueryID(TimerQuery_ID queryID)
     {
-        Engine::DEBUGPrint("High severity: " + std::string(message) + "\n");
+        return GetResource(timerQueryMap, queryID, "timer query");
     }
-    //else
-    //{
-    //    Engine::DEBUGPrint("Low severity: " + std::string(message) + "\n");
-    //}
-}
 
-Renderer::Renderer()
-{
-    HWND window = GetActiveWindow();
+    // Copies the transforms into the instance buffer and returns the index of the first one (to be used as the base instance)
+    GLuint StreamInstanceTransforms(const std::vector<Mat4x4f>& transforms)
+    {
+        GLsizeiptr dataSize = transforms.size() * sizeof(Mat4x4f);
 
-    deviceContext = GetDC(window);
+        if (instanceBuffer.VBO == 0)
+        {
+            glGenBuffers(1, &instanceBuffer.VBO);
+        }
 
-    PIXELFORMATDESCRIPTOR desiredPixelFormat = {};
-    desiredPixelFormat.nSize = sizeof(PIXELFORMATDESCRIPTOR);
-    desiredPixelFormat.nVersion = 1;
-    desiredPixelFormat.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-    desiredPixelFormat.iPixelType = PFD_TYPE_RGBA;
-    desiredPixelFormat.cColorBits = 32;
-    desiredPixelFormat.cDepthBits = 24;
-    desiredPixelFormat.cStencilBits = 8;
-    desiredPixelFormat.cAlphaBits = 8;
-    desiredPixelFormat.iLayerType = PFD_MAIN_PLANE;
+        if (dataSize > instanceBuffer.capacity)
+        {
+            // Grow the buffer, it keeps the same name so VAOs that already point at it stay valid
+            GLsizeiptr newCapacity = instanceBuffer.capacity * 2;
+            if (newCapacity < dataSize) newCapacity = dataSize;
+            if (newCapacity < minInstanceBufferSize) newCapacity = minInstanceBufferSize;
 
-    int pixelFormatIndex = ChoosePixelFormat(deviceContext, &desiredPixelFormat);
+            instanceBuffer.capacity = newCapacity;
+            instanceBuffer.offset = 0;
 
-    if (pixelFormatIndex == 0)
-    {
-        Engine::DEBUGPrint("Unable to pick pixel format.\n");
-        // TODO: Error handling
-    }
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.VBO);
+            glBufferData(GL_ARRAY_BUFFER, instanceBuffer.capacity, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        else if (instanceBuffer.offset + dataSize > instanceBuffer.capacity)
+        {
+            // Orphan the old storage so we don't have to wait on draws which are still reading from it
+            glNamedBufferData(instanceBuffer.VBO, instanceBuffer.capacity, nullptr, GL_STREAM_DRAW);
+            instanceBuffer.offset = 0;
+        }
 
-    SetPixelFormat(deviceContext, pixelFormatIndex, &desiredPixelFormat);
+        // Nothing in flight can be using this range since we only ever write past the last offset, so skip synchronization
+        void* dest = glMapNamedBufferRange(instanceBuffer.VBO, instanceBuffer.offset, dataSize, 
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        memcpy(dest, transforms.data(), dataSize);
+        glUnmapNamedBuffer(instanceBuffer.VBO);
 
-    HGLRC tempGlContext = wglCreateContext(deviceContext);
-    wglMakeCurrent(deviceContext, tempGlContext);
+        GLuint baseInstance = (GLuint)(instanceBuffer.offset / sizeof(Mat4x4f));
+        instanceBuffer.offset += dataSize;
 
-    GLenum err = glewInit();
-    if (err == GLEW_OK)
-    {
-        Engine::DEBUGPrint("Glew was initialized.\n");
-    }
-    else {
-        Engine::DEBUGPrint("Glew was not initialized.\n");
+        return baseInstance;
     }
 
-    int gl34_attribs[] = {
-    WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
-    WGL_CONTEXT_MINOR_VERSION_ARB, 3,
-    WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-    0,
-    };
+    // Hands the bound shader the VertexDecode for whatever's about to be drawn with it
+    void ApplyVertexDecode(const VertexDecode& decode)
+    {
+        OpenGLShader* shader = shaderMap.Get(currentlyBoundShader);
+        if (!shader || (shader->m_DecodeSet && shader->m_CurrentDecode == decode))
+        {
+            return;
+        }
+
+        if (shader->m_PositionDecodeLocation >= 0)
+        {
+            glUniform4f(shader->m_PositionDecodeLocation, decode.PositionOffset.x, decode.PositionOffset.y, decode.PositionOffset.z, decode.PositionScale);
+        }
+        if (shader->m_OctahedralNormalsLocation >= 0)
+        {
+            glUniform1i(shader->m_OctahedralNormalsLocation, decode.OctahedralNormals ? 1 : 0);
+        }
+
+        shader->m_CurrentDecode = decode;
+        shader->m_DecodeSet = true;
+    }
+
+    void WaitForFence(GLsync& fence)
+    {
+        if (!fence)
+        {
+            return;
+        }
+
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    void CreateDynamicGeometryBuffer(GLsizeiptr regionSize)
+    {
+        OpenGLDynamicGeometryBuffer& dynamicBuffer = dynamicGeometryBuffer;
+
+        if (dynamicBuffer.buffer != 0)
+        {
+            // Storage made with glNamedBufferStorage can't be resized, so wait for the GPU to be done with all of it and start over
+            for (int i = 0; i < DYNAMIC_GEOMETRY_FRAMES; ++i)
+            {
+                WaitForFence(dynamicBuffer.regionFences[i]);
+            }
+
+            for (auto& formatVAO : dynamicBuffer.VAOs)
+            {
+                glDeleteVertexArrays(1, &formatVAO.second);
+            }
+            dynamicBuffer.VAOs.clear();
+
+            if (dynamicBuffer.mappedData)
+            {
+                glUnmapNamedBuffer(dynamicBuffer.buffer);
+                dynamicBuffer.mappedData = nullptr;
+            }
+            glDeleteBuffers(1, &dynamicBuffer.buffer);
+        }
+
+        dynamicBuffer.regionSize = regionSize;
+        dynamicBuffer.region = 0;
+        dynamicBuffer.offset = 0;
+
+        glCreateBuffers(1, &dynamicBuffer.buffer);
+
+        if (bufferStorageSupported)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glNamedBufferStorage(dynamicBuffer.buffer, regionSize * DYNAMIC_GEOMETRY_FRAMES, nullptr, flags);
+            dynamicBuffer.mappedData = (unsigned char*)glMapNamedBufferRange(dynamicBuffer.buffer, 0, regionSize * DYNAMIC_GEOMETRY_FRAMES, flags);
+        }
+        else
+        {
+            glNamedBufferData(dynamicBuffer.buffer, regionSize * DYNAMIC_GEOMETRY_FRAMES, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    void WriteDynamicGeometryBuffer(GLsizeiptr offset, GLsizeiptr size, const void* data)
+    {
+        OpenGLDynamicGeometryBuffer& dynamicBuffer = dynamicGeometryBuffer;
+
+        if (dynamicBuffer.mappedData)
+        {
+            memcpy(dynamicBuffer.mappedData + offset, data, size);
+        }
+        else
+        {
+            glNamedBufferSubData(dynamicBuffer.buffer, offset, size, data);
+        }
+    }
+
+    bool IsSameVertexFormat(const VertexBufferFormat& a, const VertexBufferFormat& b)
+    {
+        return a.GetAttributes() == b.GetAttributes() && a.GetInstanceDivisor() == b.GetInstanceDivisor();
+    }
+
+    unsigned int GetDynamicGeometryFormat(const VertexBufferFormat& vertBufFormat)
+    {
+        OpenGLDynamicGeometryBuffer& dynamicBuffer = dynamicGeometryBuffer;
+
+        for (unsigned int i = 0; i < dynamicBuffer.VAOs.size(); ++i)
+        {
+            if (IsSameVertexFormat(dynamicBuffer.VAOs[i].first, vertBufFormat))
+            {
+                return i;
+            }
+        }
+
+        // Attributes all start at the front of the buffer, draws pick out their vertices with a base vertex
+        GLuint VAO;
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, dynamicBuffer.buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dynamicBuffer.buffer);
+        vertBufFormat.EnableVertexAttributes();
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        dynamicBuffer.VAOs.push_back({ vertBufFormat, VAO });
+
+        return (unsigned int)dynamicBuffer.VAOs.size() - 1;
+    }
+
+    // Rounds offset up to the next multiple of alignment
+    GLsizeiptr AlignOffset(GLsizeiptr offset, GLsizeiptr alignment)
+    {
+        return ((offset + alignment - 1) / alignment) * alignment;
+    }
+
+    DynamicGeometry WriteDynamicGeometryData(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData, const ElementIndex* indices, size_t indexCount)
+    {
+        OpenGLDynamicGeometryBuffer& dynamicBuffer = dynamicGeometryBuffer;
+
+        DynamicGeometry geometry;
+
+        GLsizeiptr stride = vertBufFormat.GetVertexStride();
+        GLsizeiptr vertexSize = vertexData.size() * sizeof(float);
+        GLsizeiptr indexSize = indexCount * sizeof(ElementIndex);
+
+        if (vertexSize == 0 || stride == 0)
+        {
+            return geometry;
+        }
+
+        dynamicBuffer.frameSize += vertexSize + stride + indexSize + sizeof(ElementIndex);
+
+        if (dynamicBuffer.buffer == 0 || dynamicBuffer.requiredRegionSize > dynamicBuffer.regionSize)
+        {
+            CreateDynamicGeometryBuffer(Math::Max(dynamicBuffer.requiredRegionSize, minDynamicGeometryRegionSize));
+        }
+
+        if (!dynamicBuffer.regionInUse)
+        {
+            WaitForFence(dynamicBuffer.regionFences[dynamicBuffer.region]);
+            dynamicBuffer.regionInUse = true;
+        }
+
+        // Vertices have to start on a whole vertex from the front of the buffer so they can be reached with a base vertex
+        GLsizeiptr regionStart = dynamicBuffer.region * dynamicBuffer.regionSize;
+        GLsizeiptr vertexStart = AlignOffset(regionStart + dynamicBuffer.offset, stride);
+        GLsizeiptr indexStart = AlignOffset(vertexStart + vertexSize, sizeof(ElementIndex));
+        GLsizeiptr end = indexStart + indexSize;
+
+        if (end > regionStart + dynamicBuffer.regionSize)
+        {
+            // Drop it for this frame, the buffer will have grown by the next one
+            return geometry;
+        }
+
+        WriteDynamicGeometryBuffer(vertexStart, vertexSize, vertexData.data());
+        if (indexSize > 0)
+        {
+            WriteDynamicGeometryBuffer(indexStart, indexSize, indices);
+        }
+
+        dynamicBuffer.offset = end - regionStart;
+
+        geometry.Format = GetDynamicGeometryFormat(vertBufFormat);
+        geometry.BaseVertex = (int)(vertexStart / stride);
+        geometry.VertexCount = (unsigned int)(vertexSize / stride);
+        geometry.IndexOffset = (unsigned int)indexStart;
+        geometry.IndexCount = (unsigned int)indexCount;
+
+        return geometry;
+    }
+
+    // Fences off this frame's region and moves on to the next one
+    void EndDynamicGeometryFrame()
+    {
+        OpenGLDynamicGeometryBuffer& dynamicBuffer = dynamicGeometryBuffer;
+
+        if (dynamicBuffer.frameSize > dynamicBuffer.regionSize)
+        {
+            dynamicBuffer.requiredRegionSize = Math::Max(dynamicBuffer.frameSize, dynamicBuffer.regionSize * 2);
+            Engine::DEBUGPrint("Dynamic geometry didn't fit this frame, growing the buffer to " + std::to_string(dynamicBuffer.requiredRegionSize) + " bytes per frame.");
+        }
+        dynamicBuffer.frameSize = 0;
+
+        if (!dynamicBuffer.regionInUse)
+        {
+            return;
+        }
+
+        dynamicBuffer.regionFences[dynamicBuffer.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        dynamicBuffer.region = (dynamicBuffer.region + 1) % DYNAMIC_GEOMETRY_FRAMES;
+        dynamicBuffer.offset = 0;
+        dynamicBuffer.regionInUse = false;
+    }
+}
+
+// Error handling
+void GLAPIENTRY
+MessageCallback(GLenum source,
+    GLenum type,
+    GLuint id,
+    GLenum severity,
+    GLsizei length,
+    const GLchar* message,
+    const void* userParam)
+{
+    if (severity == GL_DEBUG_SEVERITY_LOW)
+    {
+        Engine::DEBUGPrint("Low severity: " + std::string(message) + "\n");
+    }
+    else if (severity == GL_DEBUG_SEVERITY_MEDIUM)
+    {
+        Engine::DEBUGPrint("Medium severity: " + std::string(message) + "\n");
+    }
+    else if (severity == GL_DEBUG_SEVERITY_HIGH)
+    {
+        Engine::DEBUGPrint("High severity: " + std::string(message) + "\n");
+    }
+    //else
+    //{
+    //    Engine::DEBUGPrint("Low severity: " + std::string(message) + "\n");
+    //}
+}
+
+Renderer::Renderer()
+{
+    HWND window = GetActiveWindow();
+
+    deviceContext = GetDC(window);
+
+    PIXELFORMATDESCRIPTOR desiredPixelFormat = {};
+    desiredPixelFormat.nSize = sizeof(PIXELFORMATDESCRIPTOR);
+    desiredPixelFormat.nVersion = 1;
+    desiredPixelFormat.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+    desiredPixelFormat.iPixelType = PFD_TYPE_RGBA;
+    desiredPixelFormat.cColorBits = 32;
+    desiredPixelFormat.cDepthBits = 24;
+    desiredPixelFormat.cStencilBits = 8;
+    desiredPixelFormat.cAlphaBits = 8;
+    desiredPixelFormat.iLayerType = PFD_MAIN_PLANE;
+
+    int pixelFormatIndex = ChoosePixelFormat(deviceContext, &desiredPixelFormat);
+
+    if (pixelFormatIndex == 0)
+    {
+        Engine::DEBUGPrint("Unable to pick pixel format.\n");
+        // TODO: Error handling
+    }
+
+    SetPixelFormat(deviceContext, pixelFormatIndex, &desiredPixelFormat);
+
+    HGLRC tempGlContext = wglCreateContext(deviceContext);
+    wglMakeCurrent(deviceContext, tempGlContext);
+
+    GLenum err = glewInit();
+    if (err == GLEW_OK)
+    {
+        Engine::DEBUGPrint("Glew was initialized.\n");
+    }
+    else {
+        Engine::DEBUGPrint("Glew was not initialized.\n");
+    }
+
+    int gl34_attribs[] = {
+    WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
+    WGL_CONTEXT_MINOR_VERSION_ARB, 3,
+    WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+    0,
+    };
 
     if (wglewIsSupported("WGL_ARB_create_context") == 1)
     {
@@ -1086,6 +1610,14 @@ Renderer::Renderer()
         wglSwapIntervalEXT(1);
     }
 
+    timerQueriesSupported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    // Persistently mapped dynamic geometry needs 4.4 (we only ask for a 4.3 context)
+    bufferStorageSupported = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if (!bufferStorageSupported)
+    {
+        Engine::DEBUGPrint("ARB_buffer_storage isn't supported, dynamic geometry will be uploaded with glNamedBufferSubData.");
+    }
+
     // Enable various OpenGL features
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_STENCIL_TEST);
@@ -1138,32 +1670,28 @@ Framebuffer_ID Renderer::CreateFrameBuffer(Vec2i size, FBufferFormat format)
 {
     OpenGLFBuffer newBuffer = OpenGLFBuffer(size, format);
 
-    Framebuffer_ID newID = GUIDGen::Generate();
-
-    fBufferMap.insert(std::pair<Framebuffer_ID, OpenGLFBuffer>(newID, newBuffer));
+    Framebuffer_ID newID = fBufferMap.Insert(std::move(newBuffer));
     return newID;
 }
 
 Framebuffer_ID Renderer::CreateFBufferWithExistingDepthBuffer(Framebuffer_ID existingFBuffer, Vec2i size, FBufferFormat format)
 {
-    OpenGLFBuffer fBuffer = *GetGLFBufferFromFBufferID(existingFBuffer);
+    OpenGLFBuffer* fBuffer = GetGLFBufferFromFBufferID(existingFBuffer);
 
-    OpenGLFBuffer newBuffer = OpenGLFBuffer(size, format, fBuffer.rbo);
+    OpenGLFBuffer newBuffer = OpenGLFBuffer(size, format, fBuffer->rbo, fBuffer->depthTexture);
     
-    Framebuffer_ID newID = GUIDGen::Generate();
-
-    fBufferMap.insert(std::pair<Framebuffer_ID, OpenGLFBuffer>(newID, newBuffer));
+    Framebuffer_ID newID = fBufferMap.Insert(std::move(newBuffer));
     return newID;
 }
 
 void Renderer::AttachTextureToFramebuffer(Texture_ID textureID, Framebuffer_ID fBufferID)
 {
-    OpenGLFBuffer fBuffer = *GetGLFBufferFromFBufferID(fBufferID);
-    OpenGLTexture texture = *GetGLTextureFromTextureID(textureID);
+    OpenGLFBuffer* fBuffer = GetGLFBufferFromFBufferID(fBufferID);
+    OpenGLTexture* texture = GetGLTextureFromTextureID(textureID);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fBuffer.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fBuffer->fbo);
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.texture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->texture, 0);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -1190,19 +1718,39 @@ Texture_ID Renderer::AttachColourAttachmentToFrameBuffer(Framebuffer_ID buffer,
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    Texture_ID newID = GUIDGen::Generate();
-    textureMap.insert(std::pair<Texture_ID, OpenGLTexture>(newID, newTexture));
+    Texture_ID newID = textureMap.Insert(std::move(newTexture));
     
     return newID;
 }
 
+Texture_ID Renderer::AttachDepthTextureToFrameBuffer(Framebuffer_ID buffer)
+{
+    OpenGLFBuffer* fBuffer = GetGLFBufferFromFBufferID(buffer);
+
+    TextureCreateInfo createInfo = TextureCreateInfo(fBuffer->size, ColourFormat::DEPTH_STENCIL, ColourFormat::DEPTH_STENCIL, DataFormat::UNSIGNED_BYTE);
+    OpenGLTexture newTexture = OpenGLTexture(createInfo);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fBuffer->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, newTexture.texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (fBuffer->rbo)
+    {
+        glDeleteRenderbuffers(1, &fBuffer->rbo);
+        fBuffer->rbo = 0;
+    }
+    fBuffer->depthTexture = newTexture.texture;
+
+    Texture_ID newID = textureMap.Insert(std::move(newTexture));
+
+    return newID;
+}
+
 Texture_ID Renderer::LoadTexture(Vec2i size, std::vector<unsigned char> textureData, ColourFormat format, TextureMode minTexMode, TextureMode magTexMode)
 {
     OpenGLTexture newTexture = OpenGLTexture(size, textureData, format, minTexMode, magTexMode);
 
-    Texture_ID newID = GUIDGen::Generate();
-
-    textureMap.insert(std::pair<Texture_ID, OpenGLTexture>(newID, newTexture));
+    Texture_ID newID = textureMap.Insert(std::move(newTexture));
     return newID;
 }
 
@@ -1210,9 +1758,7 @@ Texture_ID Renderer::LoadTexture(std::string filePath, TextureMode minTexMode, T
 {
     OpenGLTexture newTexture = OpenGLTexture(filePath, minTexMode, magTexMode);
 
-    Texture_ID newID = GUIDGen::Generate();
-
-    textureMap.insert(std::pair<Texture_ID, OpenGLTexture>(newID, newTexture));
+    Texture_ID newID = textureMap.Insert(std::move(newTexture));
     return newID;
 }
 
@@ -1234,9 +1780,7 @@ Cubemap_ID Renderer::LoadCubemap(std::string filepath)
 {
     OpenGLCubemap newCubemap = OpenGLCubemap(filepath);
 
-    Cubemap_ID newID = GUIDGen::Generate();
-
-    cubemapMap.insert(std::pair<Cubemap_ID, OpenGLCubemap>(newID, newCubemap));
+    Cubemap_ID newID = cubemapMap.Insert(std::move(newCubemap));
     return newID;
 }
 
@@ -1244,9 +1788,7 @@ Shader_ID Renderer::LoadShader(std::string vertShaderSource, std::string fragSha
 {
     OpenGLShader newShader = OpenGLShader(vertShaderSource, fragShaderSource);
 
-    Shader_ID newID = GUIDGen::Generate();
-
-    shaderMap.insert(std::pair<Shader_ID, OpenGLShader>(newID, newShader));
+    Shader_ID newID = shaderMap.Insert(std::move(newShader));
     return newID;
 }
 
@@ -1254,9 +1796,7 @@ StaticMesh_ID Renderer::LoadMesh(const VertexBufferFormat& vertBufFormat, std::v
 {
     OpenGLMesh newMesh = OpenGLMesh(vertBufFormat, vertexData);
 
-    StaticMesh_ID newID = GUIDGen::Generate();
-
-    meshMap.insert(std::pair<StaticMesh_ID, OpenGLMesh>(newID, std::move(newMesh)));
+    StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
     return newID;
 }
 
@@ -1264,13 +1804,30 @@ StaticMesh_ID Renderer::LoadMesh(const VertexBufferFormat& vertBufFormat, std::v
 {
     OpenGLMesh newMesh = OpenGLMesh(vertBufFormat, vertexData, indices);
 
-    StaticMesh_ID newID = GUIDGen::Generate();
-
-    meshMap.insert(std::pair<StaticMesh_ID, OpenGLMesh>(newID, std::move(newMesh)));
+    StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
         
     return newID;
 }
 
+StaticMesh_ID Renderer::LoadMesh(const VertexBufferFormat& vertBufFormat, const float* vertexData, size_t vertexFloatCount, const ElementIndex* indices, size_t indexCount)
+{
+    OpenGLMesh newMesh = OpenGLMesh(vertBufFormat, vertexData, vertexFloatCount, indices, indexCount);
+
+    StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
+    return newID;
+}
+
+StaticMesh_ID Renderer::LoadCompressedMesh(const CompressedVertexLayout& layout, const std::vector<float>& vertexData, std::vector<ElementIndex> indices)
+{
+    const Vertex* vertices = (const Vertex*)vertexData.data();
+    size_t vertexCount = vertexData.size() * sizeof(float) / sizeof(Vertex);
+
+    OpenGLMesh newMesh = OpenGLMesh(layout, vertices, vertexCount, indices);
+
+    StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
+    return newID;
+}
+
 #pragma optimize("", off)
 void Renderer::DeleteFrameBuffer(Framebuffer_ID fBufferID)
 {
@@ -1285,10 +1842,8 @@ void Renderer::DeleteFrameBuffer(Framebuffer_ID fBufferID)
             glDeleteTextures(1, &(fBuffer->texture));
         }
 
-        fBufferMap.erase(fBufferID);
+        fBufferMap.Remove(fBufferID);
     }
-
-    GUIDGen::FreeID(fBufferID);
 }
 #pragma optimize("", on)
 
@@ -1300,10 +1855,8 @@ void Renderer::DeleteTexture(Texture_ID textureID)
     {
         glDeleteTextures(1, &(texture->texture));
 
-        textureMap.erase(textureID);
+        textureMap.Remove(textureID);
     }
-
-    GUIDGen::FreeID(textureID);
 }
 
 void Renderer::DeleteMesh(StaticMesh_ID meshID)
@@ -1316,19 +1869,15 @@ void Renderer::DeleteMesh(StaticMesh_ID meshID)
         glDeleteBuffers(1, &mesh->VBO);
         glDeleteBuffers(1, &mesh->EBO);
 
-        meshMap.erase(meshID);
+        meshMap.Remove(meshID);
     }
-
-    GUIDGen::FreeID(meshID);
 }
 
 Texture_ID Renderer::CreateEmptyTexture(Vec2i size, ColourFormat format)
 {
     OpenGLTexture newTexture = OpenGLTexture(size, format);
 
-    Texture_ID newID = GUIDGen::Generate();
-
-    textureMap.insert(std::pair<Texture_ID, OpenGLTexture>(newID, newTexture));
+    Texture_ID newID = textureMap.Insert(std::move(newTexture));
     return newID;
 }
 
@@ -1336,29 +1885,28 @@ StaticMesh_ID Renderer::CreateEmptyMesh(const VertexBufferFormat& vertBufFormat,
 {
     OpenGLMesh newMesh = OpenGLMesh(vertBufFormat, useElementArray);
 
-    StaticMesh_ID newID = GUIDGen::Generate();
-
-    meshMap.insert(std::pair<StaticMesh_ID, OpenGLMesh>(newID, newMesh));
+    StaticMesh_ID newID = meshMap.Insert(std::move(newMesh));
     return newID;
 }
 
 void Renderer::ClearMesh(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
 
-    //glBindVertexArray(mesh.VAO);
+    //glBindVertexArray(mesh->VAO);
 
-    //glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-    glInvalidateBufferData(mesh.VBO);
-    glInvalidateBufferData(mesh.EBO);
+    //glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glInvalidateBufferData(mesh->VBO);
+    glInvalidateBufferData(mesh->EBO);
     
-    mesh.numVertices = 0;
-    mesh.numElements = 0;
+    mesh->numVertices = 0;
+    mesh->numElements = 0;
+    mesh->hasBounds = false;
 }
 
 void Renderer::UpdateTextureData(Texture_ID textureID, Recti region, std::vector<unsigned char> textureData, ColourFormat format)
 {
-    OpenGLTexture texture = *GetGLTextureFromTextureID(textureID);
+    OpenGLTexture* texture = GetGLTextureFromTextureID(textureID);
 
     GLenum glFormat = 0;
 
@@ -1375,7 +1923,7 @@ void Renderer::UpdateTextureData(Texture_ID textureID, Recti region, std::vector
         break;
     }
 
-    glTextureSubImage2D(texture.texture, 0, region.location.x, region.location.y, region.size.x, region.size.y, glFormat, GL_UNSIGNED_BYTE, textureData.data());
+    glTextureSubImage2D(texture->texture, 0, region.location.x, region.location.y, region.size.x, region.size.y, glFormat, GL_UNSIGNED_BYTE, textureData.data());
 }
 
 void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData)
@@ -1396,6 +1944,12 @@ void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& ve
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     mesh->numVertices = (int)vertexData.size() / (vertBufFormat.GetVertexStride() / sizeof(float));
+
+    // Whatever was there before, the data's in the format given now
+    mesh->compressed = false;
+    mesh->decode = VertexDecode();
+
+    mesh->CalculateBounds(vertBufFormat, vertexData);
 }
 
 void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& vertBufFormat, std::vector<float> vertexData, std::vector<ElementIndex> indices)
@@ -1421,6 +1975,12 @@ void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& ve
     mesh->numElements = (int)indices.size();
     mesh->numVertices = (int)vertexData.size() / (vertBufFormat.GetVertexStride() / sizeof(float));
 
+    // Whatever was there before, the data's in the format given now
+    mesh->compressed = false;
+    mesh->decode = VertexDecode();
+
+    mesh->CalculateBounds(vertBufFormat, vertexData);
+
     // Test: Memory leak?
     //float* bufferData = new float[mesh->bufferSize];
     //glGetNamedBufferSubData(mesh->VBO, 0, mesh->bufferSize, (void*)bufferData);
@@ -1429,29 +1989,36 @@ void Renderer::UpdateMeshData(StaticMesh_ID meshID, const VertexBufferFormat& ve
 
 std::vector<float> Renderer::GetMeshVertexData(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
 
-    float* vertexBuffer = new float[mesh.bufferSize / sizeof(float)];
-    glGetNamedBufferSubData(mesh.VBO, 0, mesh.bufferSize, (void*)vertexBuffer);
+    float* vertexBuffer = new float[mesh->bufferSize / sizeof(float)];
+    glGetNamedBufferSubData(mesh->VBO, 0, mesh->bufferSize, (void*)vertexBuffer);
     std::vector<float> vertices;
-    for (int i = 0; i < mesh.bufferSize / sizeof(float); ++i)
+    for (int i = 0; i < mesh->bufferSize / sizeof(float); ++i)
     {
         vertices.push_back(vertexBuffer[i]);
     }
 
     delete[] vertexBuffer;
 
+    if (mesh->compressed)
+    {
+        std::vector<float> decoded(mesh->numVertices * (sizeof(Vertex) / sizeof(float)));
+        VertexCompression::Decode(mesh->layout, mesh->decode, vertices.data(), mesh->numVertices, (Vertex*)decoded.data());
+        return decoded;
+    }
+
     return vertices;
 }
 
 std::vector<unsigned int> Renderer::GetMeshIndexData(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
 
-    unsigned int* elementBuffer = new unsigned int[mesh.numElements];
-    glGetNamedBufferSubData(mesh.EBO, 0, mesh.numElements * sizeof(unsigned int), (void*)elementBuffer);
+    unsigned int* elementBuffer = new unsigned int[mesh->numElements];
+    glGetNamedBufferSubData(mesh->EBO, 0, mesh->numElements * sizeof(unsigned int), (void*)elementBuffer);
     std::vector<unsigned int> elements;
-    for (int i = 0; i < mesh.numElements; ++i)
+    for (int i = 0; i < mesh->numElements; ++i)
     {
         elements.push_back(elementBuffer[i]);
     }
@@ -1496,18 +2063,29 @@ void Renderer::ResizeFBuffer(Framebuffer_ID fBufferID, Vec2i newSize)
             glBindTexture(GL_TEXTURE_2D, bufferPtr->texture);
 
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, newSize.x, newSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-
-            glBindRenderbuffer(GL_RENDERBUFFER, bufferPtr->rbo);
-            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, newSize.x, newSize.y);
         }
-        if (bufferPtr->format == FBufferFormat::EMPTY)
+        if (bufferPtr->format == FBufferFormat::COLOUR || bufferPtr->format == FBufferFormat::EMPTY)
         {
-            glBindRenderbuffer(GL_RENDERBUFFER, bufferPtr->rbo);
-            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, newSize.x, newSize.y);
+            // Buffers with a depth texture attached don't have a render buffer any more (rbo is 0)
+            if (bufferPtr->depthTexture)
+            {
+                glBindTexture(GL_TEXTURE_2D, bufferPtr->depthTexture);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, newSize.x, newSize.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+            }
+            else
+            {
+                glBindRenderbuffer(GL_RENDERBUFFER, bufferPtr->rbo);
+                glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, newSize.x, newSize.y);
+            }
         }
     }
 }
 
+void Renderer::SetViewport(Recti viewport)
+{
+    glViewport(viewport.location.x, viewport.location.y, viewport.size.x, viewport.size.y);
+}
+
 void Renderer::ResetToScreenBuffer()
 {
     glViewport(0, 0, Engine::GetClientAreaSize().x, Engine::GetClientAreaSize().y);
@@ -1528,7 +2106,7 @@ void Renderer::SetActiveTexture(Texture_ID texture, unsigned int textureSlot)
     glBindTexture(GL_TEXTURE_2D, texturePtr->texture);
 }
 
-void Renderer::SetActiveTexture(Texture_ID textureID, std::string textureName)
+void Renderer::SetActiveTexture(Texture_ID textureID, const std::string& textureName)
 {
     OpenGLShader* shaderPtr = GetGLShaderFromShaderID(currentlyBoundShader);
 
@@ -1536,7 +2114,15 @@ void Renderer::SetActiveTexture(Texture_ID textureID, std::string textureName)
 
     if (sampler >= 0)
     {
-        SetActiveTexture(textureID, shaderPtr->m_SamplerLocations[textureName]);
+        SetActiveTexture(textureID, sampler);
+    }
+}
+
+void Renderer::SetActiveTexture(Texture_ID textureID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        SetActiveTexture(textureID, sampler.TextureSlot);
     }
 }
 
@@ -1546,13 +2132,15 @@ void Renderer::ResizeTexture(Texture_ID textureID, Vec2i newSize)
 
     TextureCreateInfo CreateInfo = texturePtr->createInfo;
 
-    GLenum InternalFormat = ColourFormatToGLFormat(CreateInfo.InternalFormat);
+    GLenum InternalFormat = GetSizedInternalFormat(CreateInfo.InternalFormat, CreateInfo.DataFormat);
     GLenum ExternalFormat = ColourFormatToGLFormat(CreateInfo.ExternalFormat);
-    GLenum DataFormat = DataFormatToGLFormat(CreateInfo.DataFormat);
+    GLenum DataFormat = CreateInfo.InternalFormat == ColourFormat::DEPTH_STENCIL ? GL_UNSIGNED_INT_24_8 : DataFormatToGLFormat(CreateInfo.DataFormat);
 
     glBindTexture(GL_TEXTURE_2D, texturePtr->texture);
     
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, newSize.x, newSize.y, 0, GL_RGBA, DataFormat, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, newSize.x, newSize.y, 0, ExternalFormat, DataFormat, nullptr);
+
+    texturePtr->createInfo.Size = newSize;
 }
 
 void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, unsigned int textureSlot)
@@ -1569,10 +2157,24 @@ void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, unsigned in
     glBindTexture(GL_TEXTURE_2D, bufferPtr->texture);
 }
 
-void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, std::string textureName)
+void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, const std::string& textureName)
 {
     OpenGLShader* shaderPtr = GetGLShaderFromShaderID(currentlyBoundShader);
-    SetActiveFBufferTexture(frameBufferID, shaderPtr->m_SamplerLocations[textureName]);
+
+    GLint sampler = GetSamplerLocation(shaderPtr->m_SamplerLocations, textureName);
+
+    if (sampler >= 0)
+    {
+        SetActiveFBufferTexture(frameBufferID, sampler);
+    }
+}
+
+void Renderer::SetActiveFBufferTexture(Framebuffer_ID frameBufferID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        SetActiveFBufferTexture(frameBufferID, sampler.TextureSlot);
+    }
 }
 
 void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, unsigned int textureSlot)
@@ -1583,7 +2185,7 @@ void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, unsigned int textureSlot)
     glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapPtr->texture);
 }
 
-void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, std::string textureName)
+void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, const std::string& textureName)
 {
     OpenGLShader* shaderPtr = GetGLShaderFromShaderID(currentlyBoundShader);
     
@@ -1595,6 +2197,14 @@ void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, std::string textureName)
     }
 }
 
+void Renderer::SetActiveCubemap(Cubemap_ID cubemapID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot >= 0)
+    {
+        SetActiveCubemap(cubemapID, sampler.TextureSlot);
+    }
+}
+
 void Renderer::SetActiveShader(Shader_ID shader)
 {
     if (currentlyBoundShader == shader)
@@ -1608,30 +2218,32 @@ void Renderer::SetActiveShader(Shader_ID shader)
 
 void Renderer::DrawMesh(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
 
-    glBindVertexArray(mesh.VAO);
+    ApplyVertexDecode(mesh->decode);
+
+    glBindVertexArray(mesh->VAO);
 
-    if (mesh.drawType == DrawType::Triangle)
+    if (mesh->drawType == DrawType::Triangle)
     {
-        if (mesh.useElementArray)
+        if (mesh->useElementArray)
         {   
-            glDrawElements(GL_TRIANGLES, mesh.numElements, GL_UNSIGNED_INT, 0);
+            glDrawElements(GL_TRIANGLES, mesh->numElements, GL_UNSIGNED_INT, 0);
         }
         else
         {
-            glDrawArrays(GL_TRIANGLES, 0, mesh.numVertices);
+            glDrawArrays(GL_TRIANGLES, 0, mesh->numVertices);
         }
     }
-    if (mesh.drawType == DrawType::Line)
+    if (mesh->drawType == DrawType::Line)
     {
-        if (mesh.useElementArray)
+        if (mesh->useElementArray)
         {
-            glDrawElements(GL_LINES, mesh.numElements, GL_UNSIGNED_INT, 0);
+            glDrawElements(GL_LINES, mesh->numElements, GL_UNSIGNED_INT, 0);
         }
         else
         {
-            glDrawArrays(GL_LINES, 0, mesh.numVertices);
+            glDrawArrays(GL_LINES, 0, mesh->numVertices);
         }
     }
 
@@ -1639,89 +2251,380 @@ void Renderer::DrawMesh(StaticMesh_ID meshID)
     glBindVertexArray(0);
 }
 
-void Renderer::SetShaderUniformVec2f(Shader_ID shaderID, std::string uniformName, Vec2f vec)
+void Renderer::DrawMeshInstanced(StaticMesh_ID meshID, const std::vector<Mat4x4f>& instanceTransforms)
 {
-    SetActiveShader(shaderID);
+    if (instanceTransforms.empty())
+    {
+        return;
+    }
+
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
+
+    GLuint baseInstance = StreamInstanceTransforms(instanceTransforms);
+    GLsizei instanceCount = (GLsizei)instanceTransforms.size();
+
+    ApplyVertexDecode(mesh->decode);
 
-    OpenGLShader shader = *GetGLShaderFromShaderID(shaderID);
-    GLfloat arr[] = { vec.x, vec.y };
+    glBindVertexArray(mesh->VAO);
+
+    if (!mesh->instanceAttributesEnabled)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.VBO);
+        instanceTransformFormat.EnableVertexAttributes(INSTANCE_ATTRIBUTE_LOCATION);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        mesh->instanceAttributesEnabled = true;
+    }
 
-    GLint uniform = GetUniformLocation(shader.m_UniformLocations, uniformName);
+    GLenum mode = mesh->drawType == DrawType::Line ? GL_LINES : GL_TRIANGLES;
 
-    if (uniform >= 0)
+    if (mesh->useElementArray)
+    {
+        glDrawElementsInstancedBaseInstance(mode, mesh->numElements, GL_UNSIGNED_INT, 0, instanceCount, baseInstance);
+    }
+    else
     {
-        glUniform2fv(uniform, 1, arr);
+        glDrawArraysInstancedBaseInstance(mode, 0, mesh->numVertices, instanceCount, baseInstance);
     }
+
+    glBindVertexArray(0);
 }
 
-void Renderer::SetShaderUniformVec3f(Shader_ID shaderID, std::string uniformName, Vec3f vec)
+DynamicGeometry Renderer::WriteDynamicGeometry(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData)
 {
-    SetActiveShader(shaderID);
+    return WriteDynamicGeometryData(vertBufFormat, vertexData, nullptr, 0);
+}
+
+DynamicGeometry Renderer::WriteDynamicGeometry(const VertexBufferFormat& vertBufFormat, const std::vector<float>& vertexData, const std::vector<ElementIndex>& indices)
+{
+    return WriteDynamicGeometryData(vertBufFormat, vertexData, indices.data(), indices.size());
+}
+
+void Renderer::DrawDynamicGeometry(const DynamicGeometry& geometry, DrawType drawType)
+{
+    if (!geometry.IsValid() || geometry.Format >= dynamicGeometryBuffer.VAOs.size())
+    {
+        return;
+    }
 
-    OpenGLShader shader = *GetGLShaderFromShaderID(shaderID);
-    GLfloat arr[] = { vec.x, vec.y, vec.z };
+    // Dynamic geometry is never compressed
+    ApplyVertexDecode(VertexDecode());
 
-    GLint uniform = GetUniformLocation(shader.m_UniformLocations, uniformName);
+    glBindVertexArray(dynamicGeometryBuffer.VAOs[geometry.Format].second);
 
-    if (uniform >= 0)
+    GLenum mode = drawType == DrawType::Line ? GL_LINES : GL_TRIANGLES;
+
+    if (geometry.IndexCount > 0)
+    {
+        glDrawElementsBaseVertex(mode, geometry.IndexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)geometry.IndexOffset, geometry.BaseVertex);
+    }
+    else
     {
-        glUniform3fv(uniform, 1, arr);
+        glDrawArrays(mode, geometry.BaseVertex, geometry.VertexCount);
     }
+
+    glBindVertexArray(0);
 }
 
-void Renderer::SetShaderUniformMat4x4f(Shader_ID shaderID, std::string uniformName, Mat4x4f mat)
+void Renderer::SetShaderUniformVec2f(Shader_ID shaderID, const std::string& uniformName, Vec2f vec)
 {
     SetActiveShader(shaderID);
+    SetShaderUniformVec2f(GetUniformHandle(shaderID, uniformName), vec);
+}
 
-    OpenGLShader shader = *GetGLShaderFromShaderID(shaderID);
-    
-    GLint uniform = GetUniformLocation(shader.m_UniformLocations, uniformName);
+void Renderer::SetShaderUniformVec3f(Shader_ID shaderID, const std::string& uniformName, Vec3f vec)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformVec3f(GetUniformHandle(shaderID, uniformName), vec);
+}
+
+void Renderer::SetShaderUniformMat4x4f(Shader_ID shaderID, const std::string& uniformName, Mat4x4f mat)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformMat4x4f(GetUniformHandle(shaderID, uniformName), mat);
+}
+
+void Renderer::SetShaderUniformFloat(Shader_ID shaderID, const std::string& uniformName, float f)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformFloat(GetUniformHandle(shaderID, uniformName), f);
+}
+
+void Renderer::SetShaderUniformInt(Shader_ID shaderID, const std::string& uniformName, int i)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformInt(GetUniformHandle(shaderID, uniformName), i);
+}
+
+void Renderer::SetShaderUniformBool(Shader_ID shaderID, const std::string& uniformName, bool b)
+{
+    SetActiveShader(shaderID);
+    SetShaderUniformBool(GetUniformHandle(shaderID, uniformName), b);
+}
+
+UniformHandle Renderer::GetUniformHandle(Shader_ID shaderID, const std::string& uniformName)
+{
+    UniformHandle handle;
+
+    OpenGLShader* shader = GetGLShaderFromShaderID(shaderID);
+    if (!shader)
+    {
+        return handle;
+    }
 
-    if (uniform >= 0)
+    handle.Shader = shaderID;
+    handle.Location = GetUniformLocation(shader->m_UniformLocations, uniformName);
+
+    // Samplers are uniforms too, so there's no slot to look for if the uniform isn't there
+    if (handle.Location >= 0)
     {
-        glUniformMatrix4fv(uniform, 1, GL_FALSE, &mat[0][0]);
+        auto it = shader->m_SamplerLocations.find(uniformName);
+        if (it != shader->m_SamplerLocations.end())
+        {
+            handle.TextureSlot = it->second;
+        }
     }
+
+    return handle;
 }
 
-void Renderer::SetShaderUniformFloat(Shader_ID shaderID, std::string uniformName, float f)
+void Renderer::SetShaderUniformVec2f(UniformHandle uniform, Vec2f vec)
 {
-    SetActiveShader(shaderID);
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        glUniform2f(uniform.Location, vec.x, vec.y);
+    }
+}
 
-    OpenGLShader shader = *GetGLShaderFromShaderID(shaderID);
-    
-    GLint uniform = GetUniformLocation(shader.m_UniformLocations, uniformName);
-    
-    if (uniform >= 0)
+void Renderer::SetShaderUniformVec3f(UniformHandle uniform, Vec3f vec)
+{
+    if (uniform.IsValid())
     {
-        glUniform1f(uniform, f);
+        SetActiveShader(uniform.Shader);
+        glUniform3f(uniform.Location, vec.x, vec.y, vec.z);
     }
 }
 
-void Renderer::SetShaderUniformInt(Shader_ID shaderID, std::string uniformName, int i)
+void Renderer::SetShaderUniformMat4x4f(UniformHandle uniform, Mat4x4f mat)
 {
-    SetActiveShader(shaderID);
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        glUniformMatrix4fv(uniform.Location, 1, GL_FALSE, &mat[0][0]);
+    }
+}
 
-    OpenGLShader shader = *GetGLShaderFromShaderID(shaderID);
-    
-    GLint uniform = GetUniformLocation(shader.m_UniformLocations, uniformName);
+void Renderer::SetShaderUniformFloat(UniformHandle uniform, float f)
+{
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        glUniform1f(uniform.Location, f);
+    }
+}
 
-    if (uniform >= 0)
+void Renderer::SetShaderUniformInt(UniformHandle uniform, int i)
+{
+    if (uniform.IsValid())
     {
-        glUniform1i(uniform, i);
+        SetActiveShader(uniform.Shader);
+        glUniform1i(uniform.Location, i);
     }
 }
 
-void Renderer::SetShaderUniformBool(Shader_ID shaderID, std::string uniformName, bool b)
+void Renderer::SetShaderUniformBool(UniformHandle uniform, bool b)
 {
-    SetActiveShader(shaderID);
+    if (uniform.IsValid())
+    {
+        SetActiveShader(uniform.Shader);
+        glUniform1i(uniform.Location, b);
+    }
+}
 
-    OpenGLShader shader = *GetGLShaderFromShaderID(shaderID);
-    
-    GLint uniform = GetUniformLocation(shader.m_UniformLocations, uniformName);
+UniformBuffer_ID Renderer::CreateUniformBuffer(unsigned int size, unsigned int bindingPoint)
+{
+    OpenGLUniformBuffer newBuffer = OpenGLUniformBuffer(size, bindingPoint);
+
+    UniformBuffer_ID newID = uniformBufferMap.Insert(std::move(newBuffer));
+    return newID;
+}
+
+void Renderer::UpdateUniformBuffer(UniformBuffer_ID bufferID, const void* data, unsigned int size, unsigned int offset)
+{
+    OpenGLUniformBuffer* buffer = GetGLUniformBufferFromUniformBufferID(bufferID);
+
+    if (!buffer)
+    {
+        Engine::DEBUGPrint("Invalid uniform buffer");
+        return;
+    }
 
-    if (uniform >= 0)
+    assert(offset + size <= buffer->size && "Uniform buffer update out of range");
+
+    glNamedBufferSubData(buffer->UBO, offset, size, data);
+}
+
+void Renderer::DeleteUniformBuffer(UniformBuffer_ID bufferID)
+{
+    OpenGLUniformBuffer* buffer = GetGLUniformBufferFromUniformBufferID(bufferID);
+
+    if (buffer)
+    {
+        glDeleteBuffers(1, &buffer->UBO);
+
+        uniformBufferMap.Remove(bufferID);
+    }
+}
+
+void Renderer::BindShaderUniformBlock(Shader_ID shaderID, const std::string& blockName, unsigned int bindingPoint)
+{
+    OpenGLShader* shader = GetGLShaderFromShaderID(shaderID);
+
+    GLuint blockIndex = glGetUniformBlockIndex(shader->m_ProgramId, blockName.c_str());
+
+    if (blockIndex == GL_INVALID_INDEX)
     {
-        glUniform1i(uniform, b);
+        Engine::DEBUGPrint("ERROR: Could not find uniform block <" + blockName + ">. It may have been optimized out by OpenGL.");
+        return;
+    }
+
+    glUniformBlockBinding(shader->m_ProgramId, blockIndex, bindingPoint);
+}
+
+BufferTexture_ID Renderer::CreateBufferTexture(BufferTextureFormat format)
+{
+    GLenum internalFormat = GL_R32UI;
+    switch (format)
+    {
+    case BufferTextureFormat::R32UI:
+        internalFormat = GL_R32UI;
+        break;
+    case BufferTextureFormat::RG32UI:
+        internalFormat = GL_RG32UI;
+        break;
+    case BufferTextureFormat::RGBA32F:
+        internalFormat = GL_RGBA32F;
+        break;
+    }
+
+    OpenGLBufferTexture newBufferTexture = OpenGLBufferTexture(internalFormat);
+
+    BufferTexture_ID newID = bufferTextureMap.Insert(std::move(newBufferTexture));
+    return newID;
+}
+
+void Renderer::UpdateBufferTexture(BufferTexture_ID bufferTextureID, const void* data, unsigned int size)
+{
+    OpenGLBufferTexture* bufferTexture = GetGLBufferTextureFromBufferTextureID(bufferTextureID);
+
+    // Respecifying the whole store every update lets the driver hand back fresh memory instead of 
+    // waiting on last frame's draws that are still reading the old contents
+    glNamedBufferData(bufferTexture->buffer, size, data, GL_STREAM_DRAW);
+}
+
+void Renderer::SetActiveBufferTexture(BufferTexture_ID bufferTextureID, UniformHandle sampler)
+{
+    if (sampler.TextureSlot < 0)
+    {
+        return;
+    }
+
+    OpenGLBufferTexture* bufferTexture = GetGLBufferTextureFromBufferTextureID(bufferTextureID);
+
+    glActiveTexture(GL_TEXTURE0 + sampler.TextureSlot);
+    glBindTexture(GL_TEXTURE_BUFFER, bufferTexture->texture);
+}
+
+void Renderer::DeleteBufferTexture(BufferTexture_ID bufferTextureID)
+{
+    OpenGLBufferTexture* bufferTexture = GetGLBufferTextureFromBufferTextureID(bufferTextureID);
+
+    if (bufferTexture)
+    {
+        glDeleteTextures(1, &bufferTexture->texture);
+        glDeleteBuffers(1, &bufferTexture->buffer);
+
+        bufferTextureMap.Remove(bufferTextureID);
+    }
+}
+
+bool Renderer::AreTimerQueriesSupported()
+{
+    return timerQueriesSupported;
+}
+
+TimerQuery_ID Renderer::CreateTimerQuery()
+{
+    OpenGLTimerQuery newQuery;
+
+    if (timerQueriesSupported)
+    {
+        glGenQueries(1, &newQuery.query);
+    }
+
+    TimerQuery_ID newID = timerQueryMap.Insert(std::move(newQuery));
+    return newID;
+}
+
+void Renderer::BeginTimerQuery(TimerQuery_ID queryID)
+{
+    OpenGLTimerQuery* query = GetGLTimerQueryFromTimerQueryID(queryID);
+
+    if (query && query->query != 0)
+    {
+        glBeginQuery(GL_TIME_ELAPSED, query->query);
+    }
+}
+
+void Renderer::EndTimerQuery(TimerQuery_ID queryID)
+{
+    OpenGLTimerQuery* query = GetGLTimerQueryFromTimerQueryID(queryID);
+
+    if (query && query->query != 0)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        query->issued = true;
+    }
+}
+
+bool Renderer::GetTimerQueryResult(TimerQuery_ID queryID, uint64_t& outNanoseconds)
+{
+    OpenGLTimerQuery* query = GetGLTimerQueryFromTimerQueryID(queryID);
+
+    if (!query || !query->issued)
+    {
+        return false;
+    }
+
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query->query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (!available)
+    {
+        return false;
+    }
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query->query, GL_QUERY_RESULT, &elapsed);
+
+    outNanoseconds = elapsed;
+
+    return true;
+}
+
+void Renderer::DeleteTimerQuery(TimerQuery_ID queryID)
+{
+    OpenGLTimerQuery* query = GetGLTimerQueryFromTimerQueryID(queryID);
+
+    if (query)
+    {
+        if (query->query != 0)
+        {
+            glDeleteQueries(1, &query->query);
+        }
+
+        timerQueryMap.Remove(queryID);
     }
 }
 
@@ -1743,13 +2646,43 @@ void Renderer::SetMeshColour(StaticMesh_ID meshID, Vec4f colour)
     UnmapMeshVertices(meshID);
 }
 
+bool Renderer::GetMeshBounds(StaticMesh_ID meshID, AABB& outBounds)
+{
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
+
+    if (!mesh || !mesh->hasBounds)
+    {
+        return false;
+    }
+
+    outBounds = AABB(mesh->boundsMin, mesh->boundsMax);
+    return true;
+}
+
 std::vector<Vertex*> Renderer::MapMeshVertices(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
+
+    if (mesh->compressed)
+    {
+        // Nothing to map directly, hand out an unpacked copy instead
+        std::vector<float> packed(mesh->bufferSize / sizeof(float));
+        glGetNamedBufferSubData(mesh->VBO, 0, mesh->bufferSize, (void*)packed.data());
+
+        mesh->mappedVertices.resize(mesh->numVertices);
+        VertexCompression::Decode(mesh->layout, mesh->decode, packed.data(), mesh->numVertices, mesh->mappedVertices.data());
+
+        std::vector<Vertex*> vertices;
+        for (Vertex& vertex : mesh->mappedVertices)
+        {
+            vertices.push_back(&vertex);
+        }
+        return vertices;
+    }
 
-    Vertex* vertexBuffer = (Vertex*)glMapNamedBuffer(mesh.VBO, GL_READ_WRITE);
+    Vertex* vertexBuffer = (Vertex*)glMapNamedBuffer(mesh->VBO, GL_READ_WRITE);
     std::vector<Vertex*> vertices;
-    for (int i = 0; i < mesh.numVertices; ++i)
+    for (int i = 0; i < mesh->numVertices; ++i)
     {
         vertices.push_back(&vertexBuffer[i]);
     }
@@ -1760,23 +2693,39 @@ std::vector<Vertex*> Renderer::MapMeshVertices(StaticMesh_ID meshID)
 
 void Renderer::UnmapMeshVertices(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
-    glUnmapNamedBuffer(mesh.VBO);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
+
+    if (mesh->compressed)
+    {
+        mesh->SetCompressedVertices(mesh->mappedVertices.data(), mesh->mappedVertices.size());
+        mesh->mappedVertices.clear();
+        return;
+    }
+
+    // The vertices may have been moved while mapped
+    Vertex* vertexBuffer = nullptr;
+    glGetNamedBufferPointerv(mesh->VBO, GL_BUFFER_MAP_POINTER, (void**)&vertexBuffer);
+    if (vertexBuffer)
+    {
+        mesh->CalculateBounds(vertexBuffer, mesh->numVertices);
+    }
+
+    glUnmapNamedBuffer(mesh->VBO);
     glFinish();
 }
 
 std::vector<unsigned int*> Renderer::MapMeshElements(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
 
     GLint size = 0;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
     glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
 
     size /= sizeof(ElementIndex);
 
-    unsigned int* elementBuffer = (unsigned int*)glMapNamedBufferRange(mesh.EBO, 0, mesh.numElements, GL_MAP_READ_BIT);
+    unsigned int* elementBuffer = (unsigned int*)glMapNamedBufferRange(mesh->EBO, 0, mesh->numElements, GL_MAP_READ_BIT);
 
     std::vector<unsigned int*> elements;
     for (int i = 0; i < size; ++i)
@@ -1791,9 +2740,9 @@ std::vector<unsigned int*> Renderer::MapMeshElements(StaticMesh_ID meshID)
 
 void Renderer::UnmapMeshElements(StaticMesh_ID meshID)
 {
-    OpenGLMesh mesh = *GetGLMeshFromMeshID(meshID);
+    OpenGLMesh* mesh = GetGLMeshFromMeshID(meshID);
 
-    glUnmapNamedBuffer(mesh.EBO);
+    glUnmapNamedBuffer(mesh->EBO);
 }
 
 void Renderer::ClearScreenAndDepthBuffer()
@@ -1803,6 +2752,8 @@ void Renderer::ClearScreenAndDepthBuffer()
 
 void Renderer::SwapBuffer()
 {
+    EndDynamicGeometryFrame();
+
     SwapBuffers(deviceContext);
 }
 
@@ -1816,6 +2767,14 @@ void Renderer::ClearDepthBuffer()
     glClear(GL_DEPTH_BUFFER_BIT);
 }
 
+void Renderer::ClearDepthBufferRegion(Recti region)
+{
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(region.location.x, region.location.y, region.size.x, region.size.y);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
 void Renderer::ClearStencilBuffer()
 {
     glClear(GL_STENCIL_BUFFER_BIT);
@@ -1971,3 +2930,34 @@ Vec2i Renderer::GetViewportSize()
     glGetIntegerv(GL_VIEWPORT, m_viewport);
     return Vec2i(m_viewport[2] - m_viewport[0], m_viewport[3] - m_viewport[1]);
 }
+
+bool Renderer::IsHeadless()
+{
+    return false;
+}
+
+// Only the headless renderer keeps stats and a call log
+RendererStats Renderer::GetStats()
+{
+    return RendererStats();
+}
+
+void Renderer::ResetStats()
+{
+}
+
+void Renderer::SetCallRecording(bool enabled)
+{
+}
+
+const std::vector<RecordedRenderCall>& Renderer::GetRecordedCalls()
+{
+    static const std::vector<RecordedRenderCall> noCalls;
+    return noCalls;
+}
+
+void Renderer::ClearRecordedCalls()
+{
+}
+
+#endif // HEADLESS_RENDERER
@@ -1,3 +1,6 @@
+// Work in progress, only compiled when asked for
+#ifdef VULKAN_RENDERER
+
 #include "EnginePlatform.h"
 
 #include "RendererPlatform.h"
@@ -31,4 +34,6 @@ Renderer::~Renderer()
 {
 
     vkDestroyInstance(Instance, nullptr);
-}
\ No newline at end of file
+}
+
+#endif // VULKAN_RENDERER
@@ -0,0 +1,402 @@
+#include "Profiler.h"
+
+#include "Modules/UIModule.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+    const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
+    struct ThreadProfile
+    {
+        std::mutex Lock;
+
+        std::vector<Profiler::Event> Events;
+        size_t Next = 0;
+        size_t Count = 0;
+
+        uint32_t ThreadId = 0;
+        std::string ThreadName;
+
+        // Only touched by the owning thread
+        uint32_t Depth = 0;
+
+        // Guarded by ProfilesLock
+        bool InUse = true;
+    };
+
+    std::mutex ProfilesLock;
+    std::vector<std::unique_ptr<ThreadProfile>> Profiles;
+
+    std::atomic<bool> Enabled = true;
+
+    // Only touched by the thread running the main loop
+    int64_t FrameStart = 0;
+    uint64_t FrameIndex = 0;
+    double LastFrameMilliseconds = 0.0;
+    std::vector<Profiler::ZoneStats> LastFrameZones;
+    std::vector<Profiler::CounterStats> LastFrameCounters;
+
+    ThreadProfile* AcquireThreadProfile()
+    {
+        std::lock_guard<std::mutex> Lock(ProfilesLock);
+
+        // Reuse the profile of a thread that's finished, otherwise every short lived thread would
+        // leave another buffer behind
+        for (std::unique_ptr<ThreadProfile>& Profile : Profiles)
+        {
+            if (!Profile->InUse)
+            {
+                Profile->InUse = true;
+                Profile->Depth = 0;
+                return Profile.get();
+            }
+        }
+
+        Profiles.push_back(std::make_unique<ThreadProfile>());
+
+        ThreadProfile* Profile = Profiles.back().get();
+        Profile->Events.resize(PROFILER_EVENTS_PER_THREAD);
+        Profile->ThreadId = (uint32_t)Profiles.size();
+        Profile->ThreadName = "Thread " + std::to_string(Profile->ThreadId);
+
+        return Profile;
+    }
+
+    // Hands the profile back when its thread exits
+    struct ThreadProfileHandle
+    {
+        ThreadProfile* Profile = nullptr;
+
+        ~ThreadProfileHandle()
+        {
+            if (Profile)
+            {
+                std::lock_guard<std::mutex> Lock(ProfilesLock);
+                Profile->InUse = false;
+            }
+        }
+    };
+
+    thread_local ThreadProfileHandle t_ProfileHandle;
+
+    ThreadProfile& GetThreadProfile()
+    {
+        if (!t_ProfileHandle.Profile)
+        {
+            t_ProfileHandle.Profile = AcquireThreadProfile();
+        }
+        return *t_ProfileHandle.Profile;
+    }
+
+    void Record(ThreadProfile& Profile, const Profiler::Event& NewEvent)
+    {
+        std::lock_guard<std::mutex> Lock(Profile.Lock);
+
+        Profile.Events[Profile.Next] = NewEvent;
+        Profile.Next = (Profile.Next + 1) % Profile.Events.size();
+        Profile.Count = std::min(Profile.Count + 1, Profile.Events.size());
+    }
+
+    void WriteJsonString(std::ofstream& File, const char* String)
+    {
+        File << '"';
+        for (const char* c = String; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                File << '\\';
+            }
+            File << *c;
+        }
+        File << '"';
+    }
+}
+
+Profiler::Zone::Zone(const char* Name)
+{
+    if (!Enabled.load(std::memory_order_relaxed))
+    {
+        m_Name = nullptr;
+        m_Start = 0;
+        return;
+    }
+
+    m_Name = Name;
+    GetThreadProfile().Depth++;
+    m_Start = GetTime();
+}
+
+Profiler::Zone::~Zone()
+{
+    if (!m_Name)
+    {
+        return;
+    }
+
+    int64_t End = GetTime();
+
+    ThreadProfile& Profile = GetThreadProfile();
+    Profile.Depth--;
+
+    Record(Profile, Event{ m_Name, m_Start, End - m_Start, 0.0, Profile.Depth, EventType::ZONE });
+}
+
+int64_t Profiler::GetTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+void Profiler::SetEnabled(bool NewEnabled)
+{
+    Enabled = NewEnabled;
+}
+
+bool Profiler::IsEnabled()
+{
+    return Enabled;
+}
+
+void Profiler::SetThreadName(const char* Name)
+{
+    ThreadProfile& Profile = GetThreadProfile();
+
+    std::lock_guard<std::mutex> Lock(Profile.Lock);
+    Profile.ThreadName = Name;
+}
+
+void Profiler::BeginFrame()
+{
+    FrameStart = GetTime();
+}
+
+void Profiler::EndFrame()
+{
+    int64_t FrameEnd = GetTime();
+
+    LastFrameMilliseconds = (double)(FrameEnd - FrameStart) / 1000000.0;
+
+    if (!Enabled)
+    {
+        return;
+    }
+
+    Record(GetThreadProfile(), Event{ "Frame", FrameStart, FrameEnd - FrameStart, (double)FrameIndex++, 0, EventType::FRAME });
+
+    // Zone names are nearly always the same literal, but the same text can end up at different addresses
+    // in different translation units, so totals are keyed on the text itself
+    static std::unordered_map<std::string_view, size_t> ZoneIndices;
+    static std::unordered_map<std::string_view, size_t> CounterIndices;
+
+    ZoneIndices.clear();
+    CounterIndices.clear();
+    LastFrameZones.clear();
+    LastFrameCounters.clear();
+
+    std::lock_guard<std::mutex> ProfilesGuard(ProfilesLock);
+    for (std::unique_ptr<ThreadProfile>& Profile : Profiles)
+    {
+        std::lock_guard<std::mutex> Lock(Profile->Lock);
+
+        // Events are in the order they finished, so walk back until they finished before this frame started
+        for (size_t i = 0; i < Profile->Count; ++i)
+        {
+            size_t Index = (Profile->Next + Profile->Events.size() - 1 - i) % Profile->Events.size();
+            const Event& E = Profile->Events[Index];
+
+            if (E.Start + E.Duration < FrameStart)
+            {
+                break;
+            }
+            if (E.Start < FrameStart)
+            {
+                continue;
+            }
+
+            if (E.Type == EventType::ZONE)
+            {
+                auto Found = ZoneIndices.find(E.Name);
+                if (Found == ZoneIndices.end())
+                {
+                    Found = ZoneIndices.emplace(E.Name, LastFrameZones.size()).first;
+                    LastFrameZones.push_back(ZoneStats{ E.Name });
+                }
+
+                ZoneStats& Stats = LastFrameZones[Found->second];
+                Stats.Milliseconds += (double)E.Duration / 1000000.0;
+                Stats.Calls++;
+            }
+            else if (E.Type == EventType::COUNTER)
+            {
+                // Walking backwards, so the first value seen is the latest one
+                if (CounterIndices.find(E.Name) == CounterIndices.end())
+                {
+                    CounterIndices.emplace(E.Name, LastFrameCounters.size());
+                    LastFrameCounters.push_back(CounterStats{ E.Name, E.Value });
+                }
+            }
+        }
+    }
+
+    std::sort(LastFrameZones.begin(), LastFrameZones.end(), [](const ZoneStats& lhs, const ZoneStats& rhs)
+        {
+            return lhs.Milliseconds > rhs.Milliseconds;
+        });
+}
+
+void Profiler::Counter(const char* Name, double Value)
+{
+    if (!Enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    ThreadProfile& Profile = GetThreadProfile();
+    Record(Profile, Event{ Name, GetTime(), 0, Value, Profile.Depth, EventType::COUNTER });
+}
+
+const std::vector<Profiler::ZoneStats>& Profiler::GetLastFrameZones()
+{
+    return LastFrameZones;
+}
+
+const std::vector<Profiler::CounterStats>& Profiler::GetLastFrameCounters()
+{
+    return LastFrameCounters;
+}
+
+double Profiler::GetLastFrameMilliseconds()
+{
+    return LastFrameMilliseconds;
+}
+
+bool Profiler::ExportChromeTrace(std::string FileName)
+{
+    PROFILE_SCOPE("Profiler::ExportChromeTrace");
+
+    std::ofstream File(FileName);
+    if (!File.is_open())
+    {
+        return false;
+    }
+
+    // Chrome wants microseconds
+    File << std::fixed << std::setprecision(3);
+    File << "{\"traceEvents\":[\n";
+
+    bool First = true;
+    auto NextEvent = [&]()
+        {
+            if (!First)
+            {
+                File << ",\n";
+            }
+            First = false;
+        };
+
+    std::vector<Event> Events;
+
+    std::lock_guard<std::mutex> ProfilesGuard(ProfilesLock);
+    for (std::unique_ptr<ThreadProfile>& Profile : Profiles)
+    {
+        uint32_t ThreadId;
+        {
+            // Copy out so the thread can carry on recording while this one's written
+            std::lock_guard<std::mutex> Lock(Profile->Lock);
+
+            Events.clear();
+            for (size_t i = 0; i < Profile->Count; ++i)
+            {
+                size_t Index = (Profile->Next + Profile->Events.size() - Profile->Count + i) % Profile->Events.size();
+                Events.push_back(Profile->Events[Index]);
+            }
+
+            ThreadId = Profile->ThreadId;
+
+            NextEvent();
+            File << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ThreadId << ",\"args\":{\"name\":";
+            WriteJsonString(File, Profile->ThreadName.c_str());
+            File << "}}";
+        }
+
+        for (const Event& E : Events)
+        {
+            NextEvent();
+            File << "{\"name\":";
+            WriteJsonString(File, E.Name);
+
+            switch (E.Type)
+            {
+            case EventType::ZONE:
+                File << ",\"ph\":\"X\",\"ts\":" << E.Start / 1000.0 << ",\"dur\":" << E.Duration / 1000.0;
+                break;
+            case EventType::FRAME:
+                File << ",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":" << E.Start / 1000.0 << ",\"dur\":" << E.Duration / 1000.0
+                    << ",\"args\":{\"frame\":" << (uint64_t)E.Value << "}";
+                break;
+            case EventType::COUNTER:
+                File << ",\"ph\":\"C\",\"ts\":" << E.Start / 1000.0 << ",\"args\":{\"value\":" << E.Value << "}";
+                break;
+            }
+
+            File << ",\"pid\":1,\"tid\":" << ThreadId << "}";
+        }
+    }
+
+    File << "\n]}\n";
+
+    return true;
+}
+
+void Profiler::DrawOverlay(UIModule& UI, Rect OverlayRect)
+{
+    const float LineHeight = 16.0f;
+    const Vec3f TextColour = Vec3f(1.0f, 1.0f, 1.0f);
+
+    UI.StartFrame("Profiler", OverlayRect, 2.0f, Vec3f(0.1f, 0.1f, 0.1f));
+
+    Vec2f Cursor = Vec2f(4.0f, 4.0f);
+
+    std::stringstream Line;
+    Line << std::fixed << std::setprecision(2) << "Frame: " << LastFrameMilliseconds << " ms";
+
+    UI.Text(Line.str(), Cursor, TextColour);
+    Cursor.y += LineHeight;
+
+    size_t ZoneCount = std::min<size_t>(LastFrameZones.size(), PROFILER_OVERLAY_ZONES);
+    for (size_t i = 0; i < ZoneCount; ++i)
+    {
+        const ZoneStats& Stats = LastFrameZones[i];
+
+        Line.str("");
+        Line << Stats.Name << ": " << Stats.Milliseconds << " ms";
+        if (Stats.Calls > 1)
+        {
+            Line << " (" << Stats.Calls << ")";
+        }
+
+        UI.Text(Line.str(), Cursor, TextColour);
+        Cursor.y += LineHeight;
+    }
+
+    for (const CounterStats& Stats : LastFrameCounters)
+    {
+        Line.str("");
+        Line << std::setprecision(0) << Stats.Name << ": " << Stats.Value << std::setprecision(2);
+
+        UI.Text(Line.str(), Cursor, TextColour);
+        Cursor.y += LineHeight;
+    }
+
+    UI.EndFrame();
+}
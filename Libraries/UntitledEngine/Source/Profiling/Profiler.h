@@ -0,0 +1,112 @@
+#pragma once
+
+// CPU instrumentation for the whole engine.
+// Zones are timed with PROFILE_SCOPE and recorded into a ring buffer belonging to the thread they ran on,
+// so the only lock a zone takes is its own thread's (which nothing else wants outside of EndFrame/export).
+// The ring buffers can be written out as a Chrome trace (open it in chrome://tracing or ui.perfetto.dev),
+// and the last frame's per-zone totals can be drawn over the game with DrawOverlay.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Events each thread keeps before the oldest ones get overwritten
+#define PROFILER_EVENTS_PER_THREAD 65536
+
+// Zones listed by the overlay, the rest are too cheap to care about
+#define PROFILER_OVERLAY_ZONES 20
+
+#define PROFILE_CONCAT_INTERNAL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INTERNAL(a, b)
+
+// Name must outlive the profiler (string literals, __FUNCTION__)
+#ifndef PROFILER_DISABLED
+#define PROFILE_SCOPE(Name) Profiler::Zone PROFILE_CONCAT(ProfileZone, __LINE__)(Name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_COUNTER(Name, Value) Profiler::Counter(Name, (double)(Value))
+#else
+#define PROFILE_SCOPE(Name)
+#define PROFILE_FUNCTION()
+#define PROFILE_COUNTER(Name, Value)
+#endif
+
+class UIModule;
+struct Rect;
+
+namespace Profiler
+{
+    enum class EventType : uint8_t
+    {
+        ZONE,
+        COUNTER,
+        FRAME
+    };
+
+    struct Event
+    {
+        const char* Name;
+
+        // Nanoseconds since the profiler started
+        int64_t Start;
+        int64_t Duration;
+
+        // Counter value, or the frame number for frame events
+        double Value;
+
+        uint32_t Depth;
+        EventType Type;
+    };
+
+    struct ZoneStats
+    {
+        const char* Name;
+        double Milliseconds = 0.0;
+        unsigned int Calls = 0;
+    };
+
+    struct CounterStats
+    {
+        const char* Name;
+        double Value = 0.0;
+    };
+
+    class Zone
+    {
+    public:
+        Zone(const char* Name);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        // nullptr when the profiler was disabled as the zone started
+        const char* m_Name;
+        int64_t m_Start;
+    };
+
+    // Nanoseconds since the profiler started
+    int64_t GetTime();
+
+    void SetEnabled(bool Enabled);
+    bool IsEnabled();
+
+    // Shows up as the thread's name in exported traces
+    void SetThreadName(const char* Name);
+
+    // Called by the engine around each frame of the main loop
+    void BeginFrame();
+    void EndFrame();
+
+    void Counter(const char* Name, double Value);
+
+    // Totals for every zone that ran during the last finished frame (on any thread), most expensive first
+    const std::vector<ZoneStats>& GetLastFrameZones();
+    const std::vector<CounterStats>& GetLastFrameCounters();
+    double GetLastFrameMilliseconds();
+
+    // Writes out everything still in the ring buffers, returns false if the file couldn't be opened
+    bool ExportChromeTrace(std::string FileName);
+
+    void DrawOverlay(UIModule& UI, Rect OverlayRect);
+}
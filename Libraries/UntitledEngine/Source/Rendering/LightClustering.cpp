@@ -0,0 +1,169 @@
+#include "LightClustering.h"
+
+#include <cmath>
+
+namespace
+{
+    struct LightClusterBounds
+    {
+        unsigned int LightIndex;
+
+        unsigned int MinX, MaxX;
+        unsigned int MinY, MaxY;
+        unsigned int MinSlice, MaxSlice;
+    };
+
+    unsigned int NDCToTile(float NDC, unsigned int NumTiles)
+    {
+        float Tile = (NDC * 0.5f + 0.5f) * (float)NumTiles;
+
+        if (Tile <= 0.0f)
+        {
+            return 0;
+        }
+        if (Tile >= (float)(NumTiles - 1))
+        {
+            return NumTiles - 1;
+        }
+        return (unsigned int)Tile;
+    }
+}
+
+void LightClustering::BuildClusters(const ClusterFrustum& Frustum, const std::vector<ClusterLight>& Lights, LightClusterGrid& OutGrid)
+{
+    float LogDepthRange = logf(Frustum.FarPlane / Frustum.NearPlane);
+
+    OutGrid.DepthSliceScale = (float)OutGrid.Slices / LogDepthRange;
+    OutGrid.DepthSliceBias = -(float)OutGrid.Slices * logf(Frustum.NearPlane) / LogDepthRange;
+
+    OutGrid.ClusterRanges.assign(OutGrid.GetClusterCount() * 2, 0);
+    OutGrid.LightIndices.clear();
+
+    float TanHalfFOVY = tanf(Frustum.VerticalFOV * 0.5f);
+    float TanHalfFOVX = TanHalfFOVY * Frustum.AspectRatio;
+
+    std::vector<LightClusterBounds> Bounds;
+    Bounds.reserve(Lights.size());
+
+    for (unsigned int i = 0; i < Lights.size(); ++i)
+    {
+        Vec3f LightPosition = Lights[i].Position;
+
+        Vec3f ToLight = LightPosition - Frustum.Position;
+
+        float X = Math::dot(ToLight, Frustum.Right);
+        float Y = Math::dot(ToLight, Frustum.Up);
+        float Z = Math::dot(ToLight, Frustum.Forward);
+        float R = Lights[i].Radius;
+
+        if (Z + R < Frustum.NearPlane || Z - R > Frustum.FarPlane)
+        {
+            continue;
+        }
+
+        // View space box around the light's sphere, cut off at the near/far planes
+        float MinZ = Math::Max(Z - R, Frustum.NearPlane);
+        float MaxZ = Math::Min(Z + R, Frustum.FarPlane);
+
+        float MinNDCX, MaxNDCX, MinNDCY, MaxNDCY;
+        if (Frustum.Orthographic)
+        {
+            // Depth doesn't change where anything lands on screen
+            MinNDCX = (X - R) / Frustum.OrthoHalfWidth;
+            MaxNDCX = (X + R) / Frustum.OrthoHalfWidth;
+            MinNDCY = (Y - R) / Frustum.OrthoHalfHeight;
+            MaxNDCY = (Y + R) / Frustum.OrthoHalfHeight;
+        }
+        else
+        {
+            // x/z is monotonic in both x and z over the box, so the projected extents come from its corners
+            MinNDCX = Math::Min((X - R) / (MinZ * TanHalfFOVX), (X - R) / (MaxZ * TanHalfFOVX));
+            MaxNDCX = Math::Max((X + R) / (MinZ * TanHalfFOVX), (X + R) / (MaxZ * TanHalfFOVX));
+            MinNDCY = Math::Min((Y - R) / (MinZ * TanHalfFOVY), (Y - R) / (MaxZ * TanHalfFOVY));
+            MaxNDCY = Math::Max((Y + R) / (MinZ * TanHalfFOVY), (Y + R) / (MaxZ * TanHalfFOVY));
+        }
+
+        if (MaxNDCX < -1.0f || MinNDCX > 1.0f || MaxNDCY < -1.0f || MinNDCY > 1.0f)
+        {
+            continue;
+        }
+
+        LightClusterBounds LightBounds;
+        LightBounds.LightIndex = i;
+        LightBounds.MinX = NDCToTile(MinNDCX, OutGrid.TilesX);
+        LightBounds.MaxX = NDCToTile(MaxNDCX, OutGrid.TilesX);
+        LightBounds.MinY = NDCToTile(MinNDCY, OutGrid.TilesY);
+        LightBounds.MaxY = NDCToTile(MaxNDCY, OutGrid.TilesY);
+        LightBounds.MinSlice = GetDepthSlice(OutGrid, MinZ);
+        LightBounds.MaxSlice = GetDepthSlice(OutGrid, MaxZ);
+
+        Bounds.push_back(LightBounds);
+    }
+
+    // Count how many lights land in each cluster...
+    for (const LightClusterBounds& LightBounds : Bounds)
+    {
+        for (unsigned int Slice = LightBounds.MinSlice; Slice <= LightBounds.MaxSlice; ++Slice)
+        {
+            for (unsigned int Y = LightBounds.MinY; Y <= LightBounds.MaxY; ++Y)
+            {
+                for (unsigned int X = LightBounds.MinX; X <= LightBounds.MaxX; ++X)
+                {
+                    OutGrid.ClusterRanges[OutGrid.GetClusterIndex(X, Y, Slice) * 2 + 1]++;
+                }
+            }
+        }
+    }
+
+    // ...turn the counts into offsets...
+    unsigned int TotalIndices = 0;
+    for (unsigned int Cluster = 0; Cluster < OutGrid.GetClusterCount(); ++Cluster)
+    {
+        OutGrid.ClusterRanges[Cluster * 2] = TotalIndices;
+        TotalIndices += OutGrid.ClusterRanges[Cluster * 2 + 1];
+
+        // Reset the count, it gets rebuilt while filling in the indices
+        OutGrid.ClusterRanges[Cluster * 2 + 1] = 0;
+    }
+
+    OutGrid.LightIndices.resize(TotalIndices);
+
+    // ...then fill in the light indices
+    for (const LightClusterBounds& LightBounds : Bounds)
+    {
+        for (unsigned int Slice = LightBounds.MinSlice; Slice <= LightBounds.MaxSlice; ++Slice)
+        {
+            for (unsigned int Y = LightBounds.MinY; Y <= LightBounds.MaxY; ++Y)
+            {
+                for (unsigned int X = LightBounds.MinX; X <= LightBounds.MaxX; ++X)
+                {
+                    unsigned int Cluster = OutGrid.GetClusterIndex(X, Y, Slice);
+                    unsigned int& Count = OutGrid.ClusterRanges[Cluster * 2 + 1];
+
+                    OutGrid.LightIndices[OutGrid.ClusterRanges[Cluster * 2] + Count] = LightBounds.LightIndex;
+                    Count++;
+                }
+            }
+        }
+    }
+}
+
+unsigned int LightClustering::GetDepthSlice(const LightClusterGrid& Grid, float ViewDepth)
+{
+    if (ViewDepth <= 0.0f)
+    {
+        return 0;
+    }
+
+    float Slice = logf(ViewDepth) * Grid.DepthSliceScale + Grid.DepthSliceBias;
+
+    if (Slice <= 0.0f)
+    {
+        return 0;
+    }
+    if (Slice >= (float)(Grid.Slices - 1))
+    {
+        return Grid.Slices - 1;
+    }
+    return (unsigned int)Slice;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// Clustered light assignment for the deferred lighting pass.
+// The view frustum is cut into screen tiles x exponentially spaced depth slices, and every point light
+// gets binned into each cluster its sphere of influence might touch. The lighting shader then only has
+// to loop over the lights in the pixel's own cluster instead of every light in the scene.
+// Nothing in here touches the renderer so it can be run (and tested) on its own.
+
+#include "Math/Math.h"
+
+#include <vector>
+
+#define LIGHT_CLUSTER_TILES_X 16
+#define LIGHT_CLUSTER_TILES_Y 9
+#define LIGHT_CLUSTER_SLICES 24
+
+struct ClusterLight
+{
+    Vec3f Position;
+    float Radius;
+};
+
+// View frustum the clusters are built in, the basis vectors should be orthonormal
+struct ClusterFrustum
+{
+    Vec3f Position;
+    Vec3f Forward;
+    Vec3f Right;
+    Vec3f Up;
+
+    float VerticalFOV;
+    float AspectRatio;
+    float NearPlane;
+    float FarPlane;
+
+    // Orthographic frustums are a box OrthoHalfWidth x OrthoHalfHeight either side of the view direction, the FOV isn't used
+    bool Orthographic = false;
+    float OrthoHalfWidth = 0.0f;
+    float OrthoHalfHeight = 0.0f;
+};
+
+struct LightClusterGrid
+{
+    unsigned int TilesX = LIGHT_CLUSTER_TILES_X;
+    unsigned int TilesY = LIGHT_CLUSTER_TILES_Y;
+    unsigned int Slices = LIGHT_CLUSTER_SLICES;
+
+    // slice = floor(log(viewDepth) * DepthSliceScale + DepthSliceBias)
+    float DepthSliceScale = 0.0f;
+    float DepthSliceBias = 0.0f;
+
+    // Two entries per cluster: offset into LightIndices and number of lights
+    // Clusters are ordered x first, then y, then slice (same as GetClusterIndex)
+    std::vector<unsigned int> ClusterRanges;
+    std::vector<unsigned int> LightIndices;
+
+    unsigned int GetClusterCount() const { return TilesX * TilesY * Slices; }
+
+    unsigned int GetClusterIndex(unsigned int X, unsigned int Y, unsigned int Slice) const
+    {
+        return (Slice * TilesY + Y) * TilesX + X;
+    }
+
+    unsigned int GetClusterLightCount(unsigned int ClusterIndex) const { return ClusterRanges[ClusterIndex * 2 + 1]; }
+    unsigned int GetClusterLightOffset(unsigned int ClusterIndex) const { return ClusterRanges[ClusterIndex * 2]; }
+};
+
+class LightClustering
+{
+public:
+    // Bins every light into OutGrid, the grid's tile/slice counts are used as-is
+    // Lights are conservatively assigned (a light may land in a cluster its sphere just misses, never the other way round)
+    static void BuildClusters(const ClusterFrustum& Frustum, const std::vector<ClusterLight>& Lights, LightClusterGrid& OutGrid);
+
+    static unsigned int GetDepthSlice(const LightClusterGrid& Grid, float ViewDepth);
+};
@@ -0,0 +1,67 @@
+#include "MaterialRegistry.h"
+
+Material::Material(Texture Albedo, Texture Normal, Texture Roughness, Texture Metallic, Texture AO)
+    : m_Albedo(Albedo)
+    , m_Normal(Normal)
+    , m_Roughness(Roughness)
+    , m_Metallic(Metallic)
+    , m_AO(AO)
+{
+}
+
+MaterialRegistry::MaterialRegistry()
+{
+    m_Materials.push_back(Material());
+    m_Textures.push_back(MaterialTextures());
+}
+
+MaterialHandle MaterialRegistry::Register(const Material& Mat)
+{
+    MaterialTextures Textures;
+    Textures.Albedo = Mat.m_Albedo.Id;
+    Textures.Normal = Mat.m_Normal.Id;
+    Textures.Metallic = Mat.m_Metallic.Id;
+    Textures.Roughness = Mat.m_Roughness.Id;
+    Textures.AO = Mat.m_AO.Id;
+
+    MaterialHandle Handle;
+
+    auto Found = m_Lookup.find(Textures);
+    if (Found != m_Lookup.end())
+    {
+        Handle.Id = Found->second;
+        return Handle;
+    }
+
+    Handle.Id = (unsigned int)m_Materials.size();
+
+    m_Materials.push_back(Mat);
+    m_Textures.push_back(Textures);
+    m_Lookup[Textures] = Handle.Id;
+
+    return Handle;
+}
+
+const Material& MaterialRegistry::Get(MaterialHandle Handle) const
+{
+    if (Handle.Id >= m_Materials.size())
+    {
+        return m_Materials[0];
+    }
+    return m_Materials[Handle.Id];
+}
+
+const MaterialTextures& MaterialRegistry::GetTextures(MaterialHandle Handle) const
+{
+    if (Handle.Id >= m_Textures.size())
+    {
+        return m_Textures[0];
+    }
+    return m_Textures[Handle.Id];
+}
+
+size_t MaterialRegistry::Size() const
+{
+    // Not counting the empty material in slot 0
+    return m_Materials.size() - 1;
+}
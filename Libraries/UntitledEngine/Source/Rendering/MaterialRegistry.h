@@ -0,0 +1,105 @@
+#pragma once
+
+// Materials are interned here once and referred to everywhere else (models, render commands, scene saving)
+// by a MaterialHandle, so nothing has to copy the textures (and their paths) around by value.
+// Registering a material with the same textures as one already in the registry hands back the existing handle.
+
+#include "Asset/AssetRegistry.h"
+#include "Utils/Hash.h"
+
+#include <unordered_map>
+#include <vector>
+
+struct Material
+{
+    Material() {}
+    Material(Texture Albedo, Texture Normal, Texture Roughness, Texture Metallic, Texture AO);
+
+    Texture m_Albedo;
+    Texture m_Normal;
+    Texture m_Metallic;
+    Texture m_Roughness;
+    Texture m_AO;
+    Texture m_Height;
+
+    friend bool operator==(const Material& lhs, const Material& rhs)
+    {
+        return lhs.m_Albedo == rhs.m_Albedo
+            && lhs.m_Normal == rhs.m_Normal
+            && lhs.m_Metallic == rhs.m_Metallic
+            && lhs.m_Roughness == rhs.m_Roughness
+            && lhs.m_AO == rhs.m_AO;
+    }
+};
+
+struct MaterialHandle
+{
+    // 0 is never handed out by the registry
+    unsigned int Id = 0;
+
+    bool IsValid() const { return Id != 0; }
+
+    friend bool operator<(const MaterialHandle& lhs, const MaterialHandle& rhs)
+    {
+        return lhs.Id < rhs.Id;
+    }
+
+    friend bool operator==(const MaterialHandle& lhs, const MaterialHandle& rhs)
+    {
+        return lhs.Id == rhs.Id;
+    }
+
+    friend bool operator!=(const MaterialHandle& lhs, const MaterialHandle& rhs)
+    {
+        return lhs.Id != rhs.Id;
+    }
+};
+
+// The part of a material the renderer actually binds, resolved once when the material is registered
+struct MaterialTextures
+{
+    Texture_ID Albedo = 0;
+    Texture_ID Normal = 0;
+    Texture_ID Metallic = 0;
+    Texture_ID Roughness = 0;
+    Texture_ID AO = 0;
+
+    friend size_t Hash_Value(const MaterialTextures& mt)
+    {
+        size_t h = Hash::Hash_Value(mt.Albedo);
+        h = Hash::Combine(h, Hash::Hash_Value(mt.Normal));
+        h = Hash::Combine(h, Hash::Hash_Value(mt.Metallic));
+        h = Hash::Combine(h, Hash::Hash_Value(mt.Roughness));
+        return Hash::Combine(h, Hash::Hash_Value(mt.AO));
+    }
+
+    friend bool operator==(const MaterialTextures& lhs, const MaterialTextures& rhs)
+    {
+        return lhs.Albedo == rhs.Albedo
+            && lhs.Normal == rhs.Normal
+            && lhs.Metallic == rhs.Metallic
+            && lhs.Roughness == rhs.Roughness
+            && lhs.AO == rhs.AO;
+    }
+};
+
+class MaterialRegistry
+{
+public:
+    MaterialRegistry();
+
+    MaterialHandle Register(const Material& Mat);
+
+    // Invalid handles give back an empty material rather than failing
+    const Material& Get(MaterialHandle Handle) const;
+    const MaterialTextures& GetTextures(MaterialHandle Handle) const;
+
+    size_t Size() const;
+
+private:
+    // Slot 0 holds the empty material invalid handles resolve to
+    std::vector<Material> m_Materials;
+    std::vector<MaterialTextures> m_Textures;
+
+    std::unordered_map<MaterialTextures, unsigned int, Hash::Hasher<MaterialTextures>> m_Lookup;
+};
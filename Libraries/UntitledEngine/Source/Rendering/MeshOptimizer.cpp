@@ -0,0 +1,279 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Size of the LRU cache the triangle order is scored against, it doesn't have to match any real GPU's
+#define FORSYTH_CACHE_SIZE 32
+
+// How quickly a vertex's score drops off as it gets pushed further back in the cache
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+
+// Vertices of the last triangle added get a fixed score, so the next triangle doesn't just reuse the same edge
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+
+// Vertices with few triangles left get boosted, so they're finished off instead of leaving lone triangles for later
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+// Valences past this get the same boost, it's tiny by then anyway
+#define FORSYTH_MAX_VALENCE 64
+
+namespace
+{
+    struct VertexScoreTable
+    {
+        float Cache[FORSYTH_CACHE_SIZE];
+        float Valence[FORSYTH_MAX_VALENCE + 1];
+
+        VertexScoreTable()
+        {
+            for (int i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+            {
+                if (i < 3)
+                {
+                    Cache[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+                }
+                else
+                {
+                    float Scaled = 1.0f - (float)(i - 3) / (float)(FORSYTH_CACHE_SIZE - 3);
+                    Cache[i] = powf(Scaled, FORSYTH_CACHE_DECAY_POWER);
+                }
+            }
+
+            Valence[0] = 0.0f;
+            for (int i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+            {
+                Valence[i] = FORSYTH_VALENCE_BOOST_SCALE * powf((float)i, -FORSYTH_VALENCE_BOOST_POWER);
+            }
+        }
+
+        float GetScore(int CachePosition, uint32_t RemainingTriangles) const
+        {
+            // Nothing left to draw with it, it doesn't matter where it is
+            if (RemainingTriangles == 0)
+            {
+                return -1.0f;
+            }
+
+            float Score = Valence[RemainingTriangles < FORSYTH_MAX_VALENCE ? RemainingTriangles : FORSYTH_MAX_VALENCE];
+            if (CachePosition >= 0)
+            {
+                Score += Cache[CachePosition];
+            }
+            return Score;
+        }
+    };
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<ElementIndex>& Indices, size_t VertexCount)
+{
+    static const VertexScoreTable ScoreTable;
+
+    size_t TriangleCount = Indices.size() / 3;
+    if (TriangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles using each vertex, packed into one array. Only the first RemainingTriangles[v] of a vertex's are still to be drawn
+    std::vector<uint32_t> TriangleOffsets(VertexCount + 1, 0);
+    std::vector<uint32_t> RemainingTriangles(VertexCount, 0);
+    for (size_t i = 0; i < TriangleCount * 3; ++i)
+    {
+        RemainingTriangles[Indices[i]]++;
+    }
+    for (size_t v = 0; v < VertexCount; ++v)
+    {
+        TriangleOffsets[v + 1] = TriangleOffsets[v] + RemainingTriangles[v];
+    }
+
+    std::vector<uint32_t> AdjacentTriangles(TriangleCount * 3);
+    {
+        std::vector<uint32_t> Filled(VertexCount, 0);
+        for (size_t i = 0; i < TriangleCount * 3; ++i)
+        {
+            ElementIndex v = Indices[i];
+            AdjacentTriangles[TriangleOffsets[v] + Filled[v]++] = (uint32_t)(i / 3);
+        }
+    }
+
+    std::vector<int> CachePositions(VertexCount, -1);
+    std::vector<float> VertexScores(VertexCount);
+    for (size_t v = 0; v < VertexCount; ++v)
+    {
+        VertexScores[v] = ScoreTable.GetScore(-1, RemainingTriangles[v]);
+    }
+
+    std::vector<float> TriangleScores(TriangleCount);
+    std::vector<bool> Added(TriangleCount, false);
+
+    int BestTriangle = -1;
+    float BestScore = -1.0f;
+    for (size_t t = 0; t < TriangleCount; ++t)
+    {
+        TriangleScores[t] = VertexScores[Indices[t * 3]] + VertexScores[Indices[t * 3 + 1]] + VertexScores[Indices[t * 3 + 2]];
+        if (TriangleScores[t] > BestScore)
+        {
+            BestScore = TriangleScores[t];
+            BestTriangle = (int)t;
+        }
+    }
+
+    std::vector<ElementIndex> Result;
+    Result.reserve(TriangleCount * 3);
+
+    // Room for the whole cache plus the triangle being added, the extra get pushed out the back
+    std::vector<ElementIndex> Cache;
+    std::vector<ElementIndex> NewCache;
+    Cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    NewCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t NextUnadded = 0;
+
+    for (size_t Count = 0; Count < TriangleCount; ++Count)
+    {
+        // Nothing in the cache has triangles left, carry on from wherever's next
+        if (BestTriangle < 0)
+        {
+            while (Added[NextUnadded])
+            {
+                NextUnadded++;
+            }
+            BestTriangle = (int)NextUnadded;
+        }
+
+        const ElementIndex* Triangle = &Indices[BestTriangle * 3];
+        Result.insert(Result.end(), Triangle, Triangle + 3);
+        Added[BestTriangle] = true;
+
+        NewCache.clear();
+        for (int i = 0; i < 3; ++i)
+        {
+            ElementIndex v = Triangle[i];
+
+            // Take the triangle out of the vertex's remaining ones
+            uint32_t* Adjacent = &AdjacentTriangles[TriangleOffsets[v]];
+            for (uint32_t j = 0; j < RemainingTriangles[v]; ++j)
+            {
+                if (Adjacent[j] == (uint32_t)BestTriangle)
+                {
+                    Adjacent[j] = Adjacent[RemainingTriangles[v] - 1];
+                    RemainingTriangles[v]--;
+                    break;
+                }
+            }
+
+            // Degenerate triangles can use the same vertex more than once
+            if ((i < 1 || v != Triangle[0]) && (i < 2 || v != Triangle[1]))
+            {
+                NewCache.push_back(v);
+            }
+        }
+
+        for (ElementIndex v : Cache)
+        {
+            if (v != Triangle[0] && v != Triangle[1] && v != Triangle[2])
+            {
+                NewCache.push_back(v);
+            }
+        }
+
+        // Rescore everything that was or is in the cache, and pass the change on to their triangles
+        for (size_t i = 0; i < NewCache.size(); ++i)
+        {
+            ElementIndex v = NewCache[i];
+            CachePositions[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+
+            float NewScore = ScoreTable.GetScore(CachePositions[v], RemainingTriangles[v]);
+            float Difference = NewScore - VertexScores[v];
+            VertexScores[v] = NewScore;
+
+            const uint32_t* Adjacent = &AdjacentTriangles[TriangleOffsets[v]];
+            for (uint32_t j = 0; j < RemainingTriangles[v]; ++j)
+            {
+                TriangleScores[Adjacent[j]] += Difference;
+            }
+        }
+
+        if (NewCache.size() > FORSYTH_CACHE_SIZE)
+        {
+            NewCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        Cache.swap(NewCache);
+
+        // Only triangles touching the cache are worth looking at for the next one
+        BestTriangle = -1;
+        BestScore = -1.0f;
+        for (ElementIndex v : Cache)
+        {
+            const uint32_t* Adjacent = &AdjacentTriangles[TriangleOffsets[v]];
+            for (uint32_t j = 0; j < RemainingTriangles[v]; ++j)
+            {
+                if (TriangleScores[Adjacent[j]] > BestScore)
+                {
+                    BestScore = TriangleScores[Adjacent[j]];
+                    BestTriangle = (int)Adjacent[j];
+                }
+            }
+        }
+    }
+
+    // Any indices left over that don't make a whole triangle stay on the end
+    Result.insert(Result.end(), Indices.begin() + TriangleCount * 3, Indices.end());
+    Indices.swap(Result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<float>& Vertices, size_t VertexStride, std::vector<ElementIndex>& Indices)
+{
+    const ElementIndex Unused = (ElementIndex)-1;
+
+    size_t VertexCount = Vertices.size() / VertexStride;
+
+    std::vector<ElementIndex> Remap(VertexCount, Unused);
+    ElementIndex NextVertex = 0;
+    for (ElementIndex& Index : Indices)
+    {
+        if (Remap[Index] == Unused)
+        {
+            Remap[Index] = NextVertex++;
+        }
+        Index = Remap[Index];
+    }
+
+    std::vector<float> Result(NextVertex * VertexStride);
+    for (size_t v = 0; v < VertexCount; ++v)
+    {
+        if (Remap[v] != Unused)
+        {
+            std::copy(Vertices.begin() + v * VertexStride, Vertices.begin() + (v + 1) * VertexStride, Result.begin() + Remap[v] * VertexStride);
+        }
+    }
+
+    Vertices.swap(Result);
+}
+
+float MeshOptimizer::CalculateACMR(const std::vector<ElementIndex>& Indices, size_t VertexCount, size_t CacheSize)
+{
+    size_t TriangleCount = Indices.size() / 3;
+    if (TriangleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    // A vertex is in the cache if it was added less than CacheSize misses ago
+    std::vector<size_t> AddedAt(VertexCount, 0);
+    size_t Misses = 0;
+    for (size_t i = 0; i < TriangleCount * 3; ++i)
+    {
+        ElementIndex v = Indices[i];
+        if (AddedAt[v] == 0 || Misses - AddedAt[v] >= CacheSize)
+        {
+            Misses++;
+            AddedAt[v] = Misses;
+        }
+    }
+
+    return (float)Misses / (float)TriangleCount;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Reorders indexed meshes so the GPU does less work drawing them.
+// Triangles are reordered to make the most of the post-transform vertex cache (Forsyth's "Linear-Speed Vertex Cache Optimisation"),
+// so a vertex that's shared between triangles is more likely to only be shaded once. Vertices are then reordered into the order
+// the triangles first use them, so vertex fetches move through memory in order.
+// Nothing in here touches the renderer so it can be run (and tested) on its own.
+
+#include "Platform/RendererPlatform.h"
+
+#include <vector>
+
+// Size of the FIFO cache used to rate index orders, somewhere between what older and newer GPUs have
+#define MESH_OPTIMIZER_SIMULATED_CACHE_SIZE 16
+
+class MeshOptimizer
+{
+public:
+    // Every three indices make a triangle, VertexCount is how many vertices they index into
+    static void OptimizeVertexCache(std::vector<ElementIndex>& Indices, size_t VertexCount);
+
+    // Vertices are VertexStride floats each. Vertices no triangle uses are dropped
+    static void OptimizeVertexFetch(std::vector<float>& Vertices, size_t VertexStride, std::vector<ElementIndex>& Indices);
+
+    // Average cache miss ratio, how many vertices get shaded per triangle drawn (between 0.5 and 3, lower is better)
+    static float CalculateACMR(const std::vector<ElementIndex>& Indices, size_t VertexCount, size_t CacheSize = MESH_OPTIMIZER_SIMULATED_CACHE_SIZE);
+};
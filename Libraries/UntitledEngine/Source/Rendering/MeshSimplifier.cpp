@@ -0,0 +1,514 @@
+#include "MeshSimplifier.h"
+
+#include "Utils/Hash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+
+// Seams and open edges get planes this many times stronger than the surface's, so they're only moved as a last resort
+#define SIMPLIFIER_BOUNDARY_WEIGHT 10.0f
+
+// Collapses that turn a triangle's normal further than this (cosine of the angle) are rejected,
+// anything below zero means the triangle's been flipped over
+#define SIMPLIFIER_MIN_NORMAL_DOT 0.25f
+
+namespace
+{
+    struct Quadric
+    {
+        double XX = 0.0, XY = 0.0, XZ = 0.0, XW = 0.0;
+        double YY = 0.0, YZ = 0.0, YW = 0.0;
+        double ZZ = 0.0, ZW = 0.0;
+        double WW = 0.0;
+
+        // Plane is Normal . p + D = 0, Normal has to be unit length
+        void AddPlane(Vec3f Normal, float D, float Weight)
+        {
+            double A = Normal.x, B = Normal.y, C = Normal.z;
+
+            XX += Weight * A * A; XY += Weight * A * B; XZ += Weight * A * C; XW += Weight * A * D;
+            YY += Weight * B * B; YZ += Weight * B * C; YW += Weight * B * D;
+            ZZ += Weight * C * C; ZW += Weight * C * D;
+            WW += Weight * (double)D * D;
+        }
+
+        void Add(const Quadric& Other)
+        {
+            XX += Other.XX; XY += Other.XY; XZ += Other.XZ; XW += Other.XW;
+            YY += Other.YY; YZ += Other.YZ; YW += Other.YW;
+            ZZ += Other.ZZ; ZW += Other.ZW;
+            WW += Other.WW;
+        }
+
+        // Sum of squared distances from p to every plane added
+        double Evaluate(Vec3f p) const
+        {
+            double X = p.x, Y = p.y, Z = p.z;
+
+            double Result = XX * X * X + 2.0 * XY * X * Y + 2.0 * XZ * X * Z + 2.0 * XW * X
+                + YY * Y * Y + 2.0 * YZ * Y * Z + 2.0 * YW * Y
+                + ZZ * Z * Z + 2.0 * ZW * Z
+                + WW;
+
+            // Rounding can take it just under zero
+            return Result > 0.0 ? Result : 0.0;
+        }
+    };
+
+    // Moving position From onto position To, only valid while neither's changed since it was worked out
+    struct Collapse
+    {
+        double Cost;
+        uint32_t From;
+        uint32_t To;
+        uint32_t FromVersion;
+        uint32_t ToVersion;
+
+        bool operator>(const Collapse& Other) const
+        {
+            return Cost > Other.Cost;
+        }
+    };
+
+    // The first KeySize floats of a vertex, for welding vertices that are the same
+    struct VertexKey
+    {
+        const float* Data;
+        size_t KeySize;
+
+        bool operator==(const VertexKey& Other) const
+        {
+            for (size_t i = 0; i < KeySize; ++i)
+            {
+                if (Data[i] != Other.Data[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    struct VertexKeyHasher
+    {
+        size_t operator()(const VertexKey& Key) const
+        {
+            size_t Result = 0;
+            for (size_t i = 0; i < Key.KeySize; ++i)
+            {
+                Result = Hash::Combine(Result, Hash::Hash_Value(Key.Data[i]));
+            }
+            return Result;
+        }
+    };
+
+    uint64_t GetEdgeKey(uint32_t A, uint32_t B)
+    {
+        return A < B ? ((uint64_t)A << 32) | B : ((uint64_t)B << 32) | A;
+    }
+
+    Vec3f GetTriangleNormal(Vec3f A, Vec3f B, Vec3f C)
+    {
+        return Math::cross(B - A, C - A);
+    }
+}
+
+SimplifiedMesh MeshSimplifier::Simplify(const std::vector<float>& Vertices, size_t VertexStride, const std::vector<ElementIndex>& Indices,
+    size_t TargetTriangles, float MaxError)
+{
+    size_t VertexCount = Vertices.size() / VertexStride;
+
+    // Meshes can have a vertex per triangle corner (generated ones do), so vertices with identical attributes are merged
+    // first (or every triangle would be its own island), then the merged vertices are grouped by position.
+    // Collapses work on positions, a position with more than one vertex sits on a seam
+    std::vector<uint32_t> VertexSources;
+    std::vector<uint32_t> VertexRemap(VertexCount);
+    {
+        std::unordered_map<VertexKey, uint32_t, VertexKeyHasher> Welded;
+        Welded.reserve(VertexCount);
+
+        for (size_t i = 0; i < VertexCount; ++i)
+        {
+            auto Inserted = Welded.emplace(VertexKey{ &Vertices[i * VertexStride], VertexStride }, (uint32_t)VertexSources.size());
+            if (Inserted.second)
+            {
+                VertexSources.push_back((uint32_t)i);
+            }
+            VertexRemap[i] = Inserted.first->second;
+        }
+    }
+
+    std::vector<uint32_t> VertexPositions(VertexSources.size());
+    std::vector<Vec3f> Positions;
+    std::vector<std::vector<uint32_t>> PositionVertices;
+    {
+        std::unordered_map<VertexKey, uint32_t, VertexKeyHasher> Welded;
+        Welded.reserve(VertexSources.size());
+
+        for (size_t i = 0; i < VertexSources.size(); ++i)
+        {
+            const float* Data = &Vertices[VertexSources[i] * VertexStride];
+
+            auto Inserted = Welded.emplace(VertexKey{ Data, 3 }, (uint32_t)Positions.size());
+            if (Inserted.second)
+            {
+                Positions.push_back(Vec3f(Data[0], Data[1], Data[2]));
+                PositionVertices.emplace_back();
+            }
+            VertexPositions[i] = Inserted.first->second;
+            PositionVertices[Inserted.first->second].push_back((uint32_t)i);
+        }
+    }
+
+    size_t PositionCount = Positions.size();
+
+    // Triangles that have collapsed to a line or point before anything's been done aren't worth keeping
+    std::vector<uint32_t> Corners;
+    Corners.reserve(Indices.size());
+    for (size_t i = 0; i + 2 < Indices.size(); i += 3)
+    {
+        uint32_t A = VertexRemap[Indices[i]], B = VertexRemap[Indices[i + 1]], C = VertexRemap[Indices[i + 2]];
+        uint32_t PA = VertexPositions[A], PB = VertexPositions[B], PC = VertexPositions[C];
+
+        if (PA != PB && PB != PC && PA != PC)
+        {
+            Corners.insert(Corners.end(), { A, B, C });
+        }
+    }
+
+    size_t TriangleCount = Corners.size() / 3;
+    std::vector<bool> TriangleRemoved(TriangleCount, false);
+
+    auto CornerPosition = [&](size_t Triangle, int Corner)
+        {
+            return VertexPositions[Corners[Triangle * 3 + Corner]];
+        };
+
+    std::vector<std::vector<uint32_t>> PositionTriangles(PositionCount);
+    std::vector<Quadric> Quadrics(PositionCount);
+
+    struct EdgeInfo
+    {
+        uint32_t Triangle;
+        uint32_t VertexA;
+        uint32_t VertexB;
+        uint32_t Count;
+        bool Seam;
+    };
+    std::unordered_map<uint64_t, EdgeInfo> Edges;
+    Edges.reserve(TriangleCount * 2);
+
+    for (size_t t = 0; t < TriangleCount; ++t)
+    {
+        Vec3f Normal = GetTriangleNormal(Positions[CornerPosition(t, 0)], Positions[CornerPosition(t, 1)], Positions[CornerPosition(t, 2)]);
+        bool HasArea = Math::magnitude(Normal) > 0.0f;
+        if (HasArea)
+        {
+            Normal = Math::normalize(Normal);
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t Position = CornerPosition(t, c);
+            PositionTriangles[Position].push_back((uint32_t)t);
+
+            if (HasArea)
+            {
+                Quadrics[Position].AddPlane(Normal, -Math::dot(Normal, Positions[Position]), 1.0f);
+            }
+
+            // Vertices ordered by position so the same edge from the triangle on the other side matches
+            uint32_t VA = Corners[t * 3 + c], VB = Corners[t * 3 + (c + 1) % 3];
+            if (VertexPositions[VA] > VertexPositions[VB])
+            {
+                std::swap(VA, VB);
+            }
+
+            auto Found = Edges.find(GetEdgeKey(VertexPositions[VA], VertexPositions[VB]));
+            if (Found == Edges.end())
+            {
+                Edges.emplace(GetEdgeKey(VertexPositions[VA], VertexPositions[VB]), EdgeInfo{ (uint32_t)t, VA, VB, 1, false });
+            }
+            else
+            {
+                Found->second.Count++;
+                Found->second.Seam |= Found->second.VertexA != VA || Found->second.VertexB != VB;
+            }
+        }
+    }
+
+    // Edges with only one triangle (or more than two), and edges the triangles either side of don't agree on
+    // the attributes of, get a plane through them at right angles to the surface
+    for (auto& [Key, Edge] : Edges)
+    {
+        if (Edge.Count == 2 && !Edge.Seam)
+        {
+            continue;
+        }
+
+        uint32_t PA = VertexPositions[Edge.VertexA], PB = VertexPositions[Edge.VertexB];
+        size_t t = Edge.Triangle;
+
+        Vec3f Normal = GetTriangleNormal(Positions[CornerPosition(t, 0)], Positions[CornerPosition(t, 1)], Positions[CornerPosition(t, 2)]);
+        Vec3f EdgePlane = Math::cross(Positions[PB] - Positions[PA], Normal);
+
+        if (Math::magnitude(EdgePlane) <= 0.0f)
+        {
+            continue;
+        }
+        EdgePlane = Math::normalize(EdgePlane);
+
+        float D = -Math::dot(EdgePlane, Positions[PA]);
+        Quadrics[PA].AddPlane(EdgePlane, D, SIMPLIFIER_BOUNDARY_WEIGHT);
+        Quadrics[PB].AddPlane(EdgePlane, D, SIMPLIFIER_BOUNDARY_WEIGHT);
+    }
+
+    std::vector<uint32_t> Versions(PositionCount, 0);
+    std::vector<bool> PositionRemoved(PositionCount, false);
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> Queue;
+
+    // Only the cheaper way round is queued, collapsing either end gives the same quadric
+    auto QueueEdge = [&](uint32_t A, uint32_t B)
+        {
+            Quadric Combined = Quadrics[A];
+            Combined.Add(Quadrics[B]);
+
+            double CostAToB = Combined.Evaluate(Positions[B]);
+            double CostBToA = Combined.Evaluate(Positions[A]);
+
+            if (CostAToB <= CostBToA)
+            {
+                Queue.push(Collapse{ CostAToB, A, B, Versions[A], Versions[B] });
+            }
+            else
+            {
+                Queue.push(Collapse{ CostBToA, B, A, Versions[B], Versions[A] });
+            }
+        };
+
+    for (auto& [Key, Edge] : Edges)
+    {
+        QueueEdge((uint32_t)(Key >> 32), (uint32_t)(Key & 0xFFFFFFFF));
+    }
+    Edges.clear();
+
+    auto GatherNeighbours = [&](uint32_t Position, std::vector<uint32_t>& OutNeighbours)
+        {
+            OutNeighbours.clear();
+            for (uint32_t t : PositionTriangles[Position])
+            {
+                if (TriangleRemoved[t])
+                {
+                    continue;
+                }
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint32_t Other = CornerPosition(t, c);
+                    if (Other != Position && std::find(OutNeighbours.begin(), OutNeighbours.end(), Other) == OutNeighbours.end())
+                    {
+                        OutNeighbours.push_back(Other);
+                    }
+                }
+            }
+        };
+
+    auto TriangleHasPosition = [&](size_t t, uint32_t Position)
+        {
+            return CornerPosition(t, 0) == Position || CornerPosition(t, 1) == Position || CornerPosition(t, 2) == Position;
+        };
+
+    std::vector<uint32_t> FromNeighbours;
+    std::vector<uint32_t> ToNeighbours;
+
+    auto CanCollapse = [&](uint32_t From, uint32_t To)
+        {
+            // Collapsing an edge merges the two triangles either side of it. If the ends share any other neighbour
+            // the surface would end up pinched into something that isn't a manifold any more
+            GatherNeighbours(From, FromNeighbours);
+            GatherNeighbours(To, ToNeighbours);
+
+            size_t SharedTriangles = 0;
+            for (uint32_t t : PositionTriangles[From])
+            {
+                if (!TriangleRemoved[t] && TriangleHasPosition(t, To))
+                {
+                    SharedTriangles++;
+                }
+            }
+
+            size_t SharedNeighbours = 0;
+            for (uint32_t Neighbour : FromNeighbours)
+            {
+                if (std::find(ToNeighbours.begin(), ToNeighbours.end(), Neighbour) != ToNeighbours.end())
+                {
+                    SharedNeighbours++;
+                }
+            }
+
+            if (SharedTriangles == 0 || SharedNeighbours > SharedTriangles)
+            {
+                return false;
+            }
+
+            // None of the triangles that stay can turn too far, or flip over
+            for (uint32_t t : PositionTriangles[From])
+            {
+                if (TriangleRemoved[t] || TriangleHasPosition(t, To))
+                {
+                    continue;
+                }
+
+                Vec3f Before[3], After[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    uint32_t Position = CornerPosition(t, c);
+                    Before[c] = Positions[Position];
+                    After[c] = Positions[Position == From ? To : Position];
+                }
+
+                Vec3f NormalBefore = GetTriangleNormal(Before[0], Before[1], Before[2]);
+                Vec3f NormalAfter = GetTriangleNormal(After[0], After[1], After[2]);
+
+                float LengthBefore = Math::magnitude(NormalBefore);
+                float LengthAfter = Math::magnitude(NormalAfter);
+                if (LengthBefore <= 0.0f)
+                {
+                    continue;
+                }
+                if (LengthAfter <= 0.0f || Math::dot(NormalBefore, NormalAfter) < SIMPLIFIER_MIN_NORMAL_DOT * LengthBefore * LengthAfter)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        };
+
+    // Of the vertices at a position, the one with the closest attributes to Vertex
+    auto FindClosestVertex = [&](uint32_t Vertex, uint32_t Position)
+        {
+            const float* Attributes = &Vertices[VertexSources[Vertex] * VertexStride];
+
+            uint32_t Closest = PositionVertices[Position][0];
+            float ClosestDistance = INFINITY;
+
+            for (uint32_t Candidate : PositionVertices[Position])
+            {
+                const float* CandidateAttributes = &Vertices[VertexSources[Candidate] * VertexStride];
+
+                float Distance = 0.0f;
+                for (size_t i = 3; i < VertexStride; ++i)
+                {
+                    float Difference = CandidateAttributes[i] - Attributes[i];
+                    Distance += Difference * Difference;
+                }
+
+                if (Distance < ClosestDistance)
+                {
+                    Closest = Candidate;
+                    ClosestDistance = Distance;
+                }
+            }
+            return Closest;
+        };
+
+    double MaxCost = (double)MaxError * MaxError;
+    double WorstCost = 0.0;
+
+    while (TriangleCount > TargetTriangles && !Queue.empty())
+    {
+        Collapse Next = Queue.top();
+        Queue.pop();
+
+        if (Next.Cost > MaxCost)
+        {
+            break;
+        }
+
+        uint32_t From = Next.From, To = Next.To;
+        if (PositionRemoved[From] || PositionRemoved[To] || Versions[From] != Next.FromVersion || Versions[To] != Next.ToVersion)
+        {
+            continue;
+        }
+
+        if (!CanCollapse(From, To))
+        {
+            continue;
+        }
+
+        for (uint32_t t : PositionTriangles[From])
+        {
+            if (TriangleRemoved[t])
+            {
+                continue;
+            }
+
+            if (TriangleHasPosition(t, To))
+            {
+                TriangleRemoved[t] = true;
+                TriangleCount--;
+                continue;
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                if (CornerPosition(t, c) == From)
+                {
+                    Corners[t * 3 + c] = FindClosestVertex(Corners[t * 3 + c], To);
+                }
+            }
+            PositionTriangles[To].push_back(t);
+        }
+
+        std::vector<uint32_t>& ToTriangles = PositionTriangles[To];
+        ToTriangles.erase(std::remove_if(ToTriangles.begin(), ToTriangles.end(), [&](uint32_t t) { return TriangleRemoved[t]; }), ToTriangles.end());
+
+        PositionTriangles[From].clear();
+        PositionTriangles[From].shrink_to_fit();
+        PositionRemoved[From] = true;
+
+        Quadrics[To].Add(Quadrics[From]);
+        Versions[To]++;
+
+        WorstCost = std::max(WorstCost, Next.Cost);
+
+        GatherNeighbours(To, ToNeighbours);
+        for (uint32_t Neighbour : ToNeighbours)
+        {
+            QueueEdge(To, Neighbour);
+        }
+    }
+
+    // Only the vertices still in use are written out, in the order they're first used
+    SimplifiedMesh Result;
+    Result.Error = (float)sqrt(WorstCost);
+    Result.Indices.reserve(TriangleCount * 3);
+
+    std::vector<uint32_t> OutputIndices(VertexSources.size(), UINT32_MAX);
+    for (size_t t = 0; t < TriangleRemoved.size(); ++t)
+    {
+        if (TriangleRemoved[t])
+        {
+            continue;
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            uint32_t Vertex = Corners[t * 3 + c];
+            if (OutputIndices[Vertex] == UINT32_MAX)
+            {
+                OutputIndices[Vertex] = (uint32_t)(Result.Vertices.size() / VertexStride);
+
+                const float* Data = &Vertices[VertexSources[Vertex] * VertexStride];
+                Result.Vertices.insert(Result.Vertices.end(), Data, Data + VertexStride);
+            }
+            Result.Indices.push_back(OutputIndices[Vertex]);
+        }
+    }
+
+    return Result;
+}
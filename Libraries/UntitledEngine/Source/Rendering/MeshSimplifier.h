@@ -0,0 +1,30 @@
+#pragma once
+
+// Quadric error metric mesh simplification (Garland & Heckbert), used to build the LOD chains of static meshes.
+// Every vertex position keeps a quadric that sums the squared distances to the planes of the triangles around it,
+// and the edge whose collapse adds the least error is collapsed first, over and over until the mesh is small enough.
+// Edges are collapsed onto one of their two ends so no new vertices are made, the attributes (normals, uvs...)
+// of the vertex that's kept are reused. Open edges and uv/normal seams are held in place by extra planes along them.
+// Nothing in here touches the renderer so it can be run (and tested) on its own.
+
+#include "Platform/RendererPlatform.h"
+
+#include <vector>
+
+struct SimplifiedMesh
+{
+    std::vector<float> Vertices;
+    std::vector<ElementIndex> Indices;
+
+    // Roughly how far the simplified surface is from the original, in the mesh's own units
+    float Error = 0.0f;
+};
+
+class MeshSimplifier
+{
+public:
+    // Vertices are VertexStride floats each and start with their position, every three indices make a triangle.
+    // Stops once there are TargetTriangles or fewer left, or when every remaining collapse would be off by more than MaxError
+    static SimplifiedMesh Simplify(const std::vector<float>& Vertices, size_t VertexStride, const std::vector<ElementIndex>& Indices,
+        size_t TargetTriangles, float MaxError);
+};
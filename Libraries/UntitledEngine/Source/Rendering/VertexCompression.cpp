@@ -0,0 +1,451 @@
+#include "VertexCompression.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Packed data is written into float storage a 32 bit word at a time
+    void WriteWord(float*& Out, uint32_t Word)
+    {
+        memcpy(Out++, &Word, sizeof(uint32_t));
+    }
+
+    void WriteWords(float*& Out, uint64_t Words)
+    {
+        WriteWord(Out, (uint32_t)(Words & 0xFFFFFFFF));
+        WriteWord(Out, (uint32_t)(Words >> 32));
+    }
+
+    uint32_t ReadWord(const float*& In)
+    {
+        uint32_t Word;
+        memcpy(&Word, In++, sizeof(uint32_t));
+        return Word;
+    }
+
+    uint64_t ReadWords(const float*& In)
+    {
+        uint64_t Low = ReadWord(In);
+        uint64_t High = ReadWord(In);
+        return Low | (High << 32);
+    }
+
+    bool IsWhite(Vec4f Colour)
+    {
+        return Colour.x == 1.0f && Colour.y == 1.0f && Colour.z == 1.0f && Colour.w == 1.0f;
+    }
+
+    float SignNotZero(float f)
+    {
+        return f >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Halves, unorms and snorms are packed here rather than with glm's packing functions,
+    // which can't be included without its half float code setting off -Wvolatile.
+    // Same layouts as glm (and GL): the first component goes in the lowest bits
+
+    // Rounds halfway cases away from zero (same as glm, so meshes encode the same as they used to),
+    // out of range values become infinity
+    uint16_t FloatToHalf(float Value)
+    {
+        uint32_t Bits;
+        memcpy(&Bits, &Value, sizeof(float));
+
+        uint32_t Sign = (Bits >> 16) & 0x8000;
+        uint32_t Exponent = (Bits >> 23) & 0xFF;
+        uint32_t Mantissa = Bits & 0x7FFFFF;
+
+        // Infinity and NaN
+        if (Exponent == 0xFF)
+        {
+            return (uint16_t)(Sign | 0x7C00 | (Mantissa ? 0x200 : 0));
+        }
+
+        int HalfExponent = (int)Exponent - 127 + 15;
+        if (HalfExponent >= 31)
+        {
+            return (uint16_t)(Sign | 0x7C00);
+        }
+
+        // Too small for a normal half, shift the mantissa (with its implicit 1) down into a denormal
+        uint32_t Shift = 13;
+        uint32_t Half = 0;
+        if (HalfExponent <= 0)
+        {
+            if (HalfExponent < -10)
+            {
+                return (uint16_t)Sign;
+            }
+
+            Mantissa |= 0x800000;
+            Shift = 14 - HalfExponent;
+        }
+        else
+        {
+            Half = (uint32_t)HalfExponent << 10;
+        }
+
+        Half |= Mantissa >> Shift;
+
+        // Rounding up can carry into the exponent, which is still the right answer (up to infinity)
+        uint32_t Remainder = Mantissa & ((1u << Shift) - 1);
+        uint32_t HalfWay = 1u << (Shift - 1);
+        if (Remainder >= HalfWay)
+        {
+            ++Half;
+        }
+
+        return (uint16_t)(Sign | Half);
+    }
+
+    float HalfToFloat(uint16_t Half)
+    {
+        uint32_t Sign = (uint32_t)(Half & 0x8000) << 16;
+        uint32_t Exponent = (Half >> 10) & 0x1F;
+        uint32_t Mantissa = Half & 0x3FF;
+
+        if (Exponent == 0)
+        {
+            float Denormal = ldexpf((float)Mantissa, -24);
+            return Sign ? -Denormal : Denormal;
+        }
+
+        uint32_t Bits = Sign | (Mantissa << 13);
+        Bits |= Exponent == 31 ? 0x7F800000 : (Exponent + 127 - 15) << 23;
+
+        float Value;
+        memcpy(&Value, &Bits, sizeof(float));
+        return Value;
+    }
+
+    uint32_t FloatToUNorm(float Value, float MaxValue)
+    {
+        return (uint32_t)roundf(Math::Clamp(Value, 0.0f, 1.0f) * MaxValue);
+    }
+
+    uint32_t FloatToSNorm16(float Value)
+    {
+        return (uint16_t)(int16_t)roundf(Math::Clamp(Value, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    float SNorm16ToFloat(uint32_t Value)
+    {
+        return Math::Max((float)(int16_t)(uint16_t)Value * (1.0f / 32767.0f), -1.0f);
+    }
+
+    uint64_t PackHalf4(Vec4f Value)
+    {
+        return (uint64_t)FloatToHalf(Value.x) | ((uint64_t)FloatToHalf(Value.y) << 16)
+            | ((uint64_t)FloatToHalf(Value.z) << 32) | ((uint64_t)FloatToHalf(Value.w) << 48);
+    }
+
+    Vec4f UnpackHalf4(uint64_t Packed)
+    {
+        return Vec4f(HalfToFloat((uint16_t)Packed), HalfToFloat((uint16_t)(Packed >> 16)),
+            HalfToFloat((uint16_t)(Packed >> 32)), HalfToFloat((uint16_t)(Packed >> 48)));
+    }
+
+    uint32_t PackHalf2(Vec2f Value)
+    {
+        return (uint32_t)FloatToHalf(Value.x) | ((uint32_t)FloatToHalf(Value.y) << 16);
+    }
+
+    Vec2f UnpackHalf2(uint32_t Packed)
+    {
+        return Vec2f(HalfToFloat((uint16_t)Packed), HalfToFloat((uint16_t)(Packed >> 16)));
+    }
+
+    uint64_t PackUNorm16x4(Vec4f Value)
+    {
+        return (uint64_t)FloatToUNorm(Value.x, 65535.0f) | ((uint64_t)FloatToUNorm(Value.y, 65535.0f) << 16)
+            | ((uint64_t)FloatToUNorm(Value.z, 65535.0f) << 32) | ((uint64_t)FloatToUNorm(Value.w, 65535.0f) << 48);
+    }
+
+    Vec4f UnpackUNorm16x4(uint64_t Packed)
+    {
+        const float Scale = 1.0f / 65535.0f;
+        return Vec4f((float)(Packed & 0xFFFF) * Scale, (float)((Packed >> 16) & 0xFFFF) * Scale,
+            (float)((Packed >> 32) & 0xFFFF) * Scale, (float)(Packed >> 48) * Scale);
+    }
+
+    uint32_t PackUNorm8x4(Vec4f Value)
+    {
+        return FloatToUNorm(Value.x, 255.0f) | (FloatToUNorm(Value.y, 255.0f) << 8)
+            | (FloatToUNorm(Value.z, 255.0f) << 16) | (FloatToUNorm(Value.w, 255.0f) << 24);
+    }
+
+    Vec4f UnpackUNorm8x4(uint32_t Packed)
+    {
+        const float Scale = 1.0f / 255.0f;
+        return Vec4f((float)(Packed & 0xFF) * Scale, (float)((Packed >> 8) & 0xFF) * Scale,
+            (float)((Packed >> 16) & 0xFF) * Scale, (float)(Packed >> 24) * Scale);
+    }
+
+    uint32_t PackSNorm16x2(Vec2f Value)
+    {
+        return FloatToSNorm16(Value.x) | (FloatToSNorm16(Value.y) << 16);
+    }
+
+    Vec2f UnpackSNorm16x2(uint32_t Packed)
+    {
+        return Vec2f(SNorm16ToFloat(Packed & 0xFFFF), SNorm16ToFloat(Packed >> 16));
+    }
+}
+
+VertexBufferFormat VertexCompression::GetFormat(const CompressedVertexLayout& Layout)
+{
+    VertAttribute Position = VertAttribute::Vec3f;
+    switch (Layout.Position)
+    {
+    case PositionEncoding::Half:
+        Position = VertAttribute::Vec4Half;
+        break;
+    case PositionEncoding::UNorm16:
+        Position = VertAttribute::Vec4UShortNorm;
+        break;
+    default:
+        break;
+    }
+
+    VertAttribute Normal = Layout.Normal == NormalEncoding::Octahedral ? VertAttribute::Vec2ShortNorm : VertAttribute::Vec3f;
+
+    VertAttribute Colour = VertAttribute::Vec4f;
+    switch (Layout.Colour)
+    {
+    case ColourEncoding::UNorm8:
+        Colour = VertAttribute::Vec4UByteNorm;
+        break;
+    case ColourEncoding::None:
+        Colour = VertAttribute::Empty;
+        break;
+    default:
+        break;
+    }
+
+    VertAttribute UV = Layout.UV == UVEncoding::Half ? VertAttribute::Vec2Half : VertAttribute::Vec2f;
+
+    return VertexBufferFormat({ Position, Normal, Colour, UV });
+}
+
+CompressedVertices VertexCompression::Encode(const CompressedVertexLayout& Layout, const Vertex* Vertices, size_t VertexCount)
+{
+    CompressedVertices Result;
+    Result.Layout = Layout;
+    Result.VertexCount = VertexCount;
+
+    if (Layout.DropWhiteColour && Layout.Colour != ColourEncoding::None)
+    {
+        bool AllWhite = true;
+        for (size_t i = 0; i < VertexCount && AllWhite; ++i)
+        {
+            AllWhite = IsWhite(Vertices[i].colour);
+        }
+
+        if (AllWhite)
+        {
+            Result.Layout.Colour = ColourEncoding::None;
+        }
+    }
+
+    // Quantised positions are stored relative to a cube around the mesh
+    if (Layout.Position != PositionEncoding::Float && VertexCount > 0)
+    {
+        Vec3f Min = Vertices[0].position;
+        Vec3f Max = Vertices[0].position;
+        for (size_t i = 1; i < VertexCount; ++i)
+        {
+            Vec3f Position = Vertices[i].position;
+            Min = Vec3f(Math::Min(Min.x, Position.x), Math::Min(Min.y, Position.y), Math::Min(Min.z, Position.z));
+            Max = Vec3f(Math::Max(Max.x, Position.x), Math::Max(Max.y, Position.y), Math::Max(Max.z, Position.z));
+        }
+
+        float Extent = Math::Max(Max.x - Min.x, Math::Max(Max.y - Min.y, Max.z - Min.z));
+        if (Extent <= 0.0f)
+        {
+            Extent = 1.0f;
+        }
+
+        if (Layout.Position == PositionEncoding::UNorm16)
+        {
+            // [0, 1] across the cube
+            Result.Decode.PositionOffset = Min;
+            Result.Decode.PositionScale = Extent;
+        }
+        else
+        {
+            // [-1, 1] across the cube, halves are most precise around 0
+            Result.Decode.PositionOffset = (Min + Max) * 0.5f;
+            Result.Decode.PositionScale = Extent * 0.5f;
+        }
+    }
+
+    Result.Decode.OctahedralNormals = Layout.Normal == NormalEncoding::Octahedral;
+
+    VertexBufferFormat Format = GetFormat(Result.Layout);
+    Result.Data.resize(VertexCount * (Format.GetVertexStride() / sizeof(float)));
+
+    float InvScale = 1.0f / Result.Decode.PositionScale;
+
+    float* Out = Result.Data.data();
+    for (size_t i = 0; i < VertexCount; ++i)
+    {
+        const Vertex& Vert = Vertices[i];
+
+        Vec3f Position = Vert.position;
+        switch (Result.Layout.Position)
+        {
+        case PositionEncoding::Float:
+            *Out++ = Position.x;
+            *Out++ = Position.y;
+            *Out++ = Position.z;
+            break;
+        case PositionEncoding::Half:
+            Position = (Position - Result.Decode.PositionOffset) * InvScale;
+            WriteWords(Out, PackHalf4(Vec4f(Position.x, Position.y, Position.z, 1.0f)));
+            break;
+        case PositionEncoding::UNorm16:
+            Position = (Position - Result.Decode.PositionOffset) * InvScale;
+            WriteWords(Out, PackUNorm16x4(Vec4f(Position.x, Position.y, Position.z, 1.0f)));
+            break;
+        }
+
+        if (Result.Layout.Normal == NormalEncoding::Octahedral)
+        {
+            WriteWord(Out, EncodeOctahedral(Vert.normal));
+        }
+        else
+        {
+            *Out++ = Vert.normal.x;
+            *Out++ = Vert.normal.y;
+            *Out++ = Vert.normal.z;
+        }
+
+        switch (Result.Layout.Colour)
+        {
+        case ColourEncoding::Float:
+            *Out++ = Vert.colour.x;
+            *Out++ = Vert.colour.y;
+            *Out++ = Vert.colour.z;
+            *Out++ = Vert.colour.w;
+            break;
+        case ColourEncoding::UNorm8:
+            WriteWord(Out, PackUNorm8x4(Vert.colour));
+            break;
+        case ColourEncoding::None:
+            break;
+        }
+
+        if (Result.Layout.UV == UVEncoding::Half)
+        {
+            WriteWord(Out, PackHalf2(Vert.uv));
+        }
+        else
+        {
+            *Out++ = Vert.uv.x;
+            *Out++ = Vert.uv.y;
+        }
+    }
+
+    return Result;
+}
+
+void VertexCompression::Decode(const CompressedVertices& Compressed, Vertex* OutVertices)
+{
+    Decode(Compressed.Layout, Compressed.Decode, Compressed.Data.data(), Compressed.VertexCount, OutVertices);
+}
+
+void VertexCompression::Decode(const CompressedVertexLayout& Layout, const VertexDecode& VertDecode, const float* Data, size_t VertexCount, Vertex* OutVertices)
+{
+    const float* In = Data;
+    for (size_t i = 0; i < VertexCount; ++i)
+    {
+        Vertex& Vert = OutVertices[i];
+
+        Vec4f Unpacked;
+        switch (Layout.Position)
+        {
+        case PositionEncoding::Float:
+            Vert.position = Vec3f(In[0], In[1], In[2]);
+            In += 3;
+            break;
+        case PositionEncoding::Half:
+            Unpacked = UnpackHalf4(ReadWords(In));
+            Vert.position = Vec3f(Unpacked.x, Unpacked.y, Unpacked.z) * VertDecode.PositionScale + VertDecode.PositionOffset;
+            break;
+        case PositionEncoding::UNorm16:
+            Unpacked = UnpackUNorm16x4(ReadWords(In));
+            Vert.position = Vec3f(Unpacked.x, Unpacked.y, Unpacked.z) * VertDecode.PositionScale + VertDecode.PositionOffset;
+            break;
+        }
+
+        if (Layout.Normal == NormalEncoding::Octahedral)
+        {
+            Vert.normal = DecodeOctahedral(ReadWord(In));
+        }
+        else
+        {
+            Vert.normal = Vec3f(In[0], In[1], In[2]);
+            In += 3;
+        }
+
+        switch (Layout.Colour)
+        {
+        case ColourEncoding::Float:
+            Vert.colour = Vec4f(In[0], In[1], In[2], In[3]);
+            In += 4;
+            break;
+        case ColourEncoding::UNorm8:
+            Vert.colour = UnpackUNorm8x4(ReadWord(In));
+            break;
+        case ColourEncoding::None:
+            Vert.colour = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
+            break;
+        }
+
+        if (Layout.UV == UVEncoding::Half)
+        {
+            Vert.uv = UnpackHalf2(ReadWord(In));
+        }
+        else
+        {
+            Vert.uv = Vec2f(In[0], In[1]);
+            In += 2;
+        }
+    }
+}
+
+uint32_t VertexCompression::EncodeOctahedral(Vec3f Normal)
+{
+    float Length = fabsf(Normal.x) + fabsf(Normal.y) + fabsf(Normal.z);
+    if (Length <= 0.0f)
+    {
+        return PackSNorm16x2(Vec2f(0.0f, 0.0f));
+    }
+
+    // Project onto the octahedron, then fold the lower half out over the corners
+    float X = Normal.x / Length;
+    float Y = Normal.y / Length;
+    if (Normal.z < 0.0f)
+    {
+        float FoldedX = (1.0f - fabsf(Y)) * SignNotZero(X);
+        float FoldedY = (1.0f - fabsf(X)) * SignNotZero(Y);
+        X = FoldedX;
+        Y = FoldedY;
+    }
+
+    return PackSNorm16x2(Vec2f(X, Y));
+}
+
+Vec3f VertexCompression::DecodeOctahedral(uint32_t Packed)
+{
+    Vec2f Folded = UnpackSNorm16x2(Packed);
+
+    // Same as the vertex shaders do it
+    Vec3f Normal = Vec3f(Folded.x, Folded.y, 1.0f - fabsf(Folded.x) - fabsf(Folded.y));
+    float Unfold = Math::Max(-Normal.z, 0.0f);
+    Normal.x += Normal.x >= 0.0f ? -Unfold : Unfold;
+    Normal.y += Normal.y >= 0.0f ? -Unfold : Unfold;
+
+    return Math::normalize(Normal);
+}
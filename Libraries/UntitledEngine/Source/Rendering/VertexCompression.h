@@ -0,0 +1,39 @@
+#pragma once
+
+// Packs full Vertex data (48 bytes each) into the smaller layouts static meshes are stored in on the GPU, and unpacks it again.
+// Positions can be quantised against the mesh's bounds, normals folded onto an octahedron and stored in two 16 bit values,
+// colours cut down to 8 bits a channel (or left out for white meshes) and uvs stored as half floats.
+// The default layout takes 16 bytes a vertex for a white mesh and 20 for a coloured one.
+// Positions are quantised against a cube around the mesh rather than its box, so the scale is uniform and can be undone in the vertex
+// shader without changing how normals get transformed. The renderer does all of this itself, nothing else should need to.
+
+#include "Platform/RendererPlatform.h"
+
+#include <vector>
+
+struct CompressedVertices
+{
+    // Packed vertex data, kept in floats so it can go through the same places as uncompressed vertex data
+    std::vector<float> Data;
+
+    // The layout the vertices were actually packed with (the colour may have been dropped)
+    CompressedVertexLayout Layout;
+    VertexDecode Decode;
+
+    size_t VertexCount = 0;
+};
+
+class VertexCompression
+{
+public:
+    static VertexBufferFormat GetFormat(const CompressedVertexLayout& Layout);
+
+    static CompressedVertices Encode(const CompressedVertexLayout& Layout, const Vertex* Vertices, size_t VertexCount);
+    static void Decode(const CompressedVertices& Compressed, Vertex* OutVertices);
+
+    // Same as above, for data read back from a mesh's vertex buffer
+    static void Decode(const CompressedVertexLayout& Layout, const VertexDecode& VertDecode, const float* Data, size_t VertexCount, Vertex* OutVertices);
+
+    static uint32_t EncodeOctahedral(Vec3f Normal);
+    static Vec3f DecodeOctahedral(uint32_t Packed);
+};
@@ -1,11 +1,14 @@
 #include "Scene.h"
 
 #include "Behaviour/Behaviour.h"
+#include "Profiling/Profiler.h"
+#include "Utils/Parallel.h"
 
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <map>
 #include <numbers>
 #include <set>
 #include <filesystem>
@@ -15,7 +18,7 @@ const std::string Separator = " ";
 
 Texture* Scene::LightBillboardTexture = nullptr;
 StaticMesh* Scene::CameraMesh = nullptr;
-Material* Scene::CameraMaterial = nullptr;
+MaterialHandle Scene::CameraMaterial;
 
 SceneRayCastHit Closer(const SceneRayCastHit& lhs, const SceneRayCastHit& rhs)
 {
@@ -37,7 +40,8 @@ Scene::Scene()
         return;
     }
 
-
+    // The billboards and camera meshes are only ever drawn by the editor, a dedicated server has no use for them
+#ifndef DEDICATED_SERVER
     AssetRegistry* Registry = AssetRegistry::Get();
 
     if (!LightBillboardTexture)
@@ -48,10 +52,11 @@ Scene::Scene()
     {
         CameraMesh = Registry->LoadStaticMesh("Assets/models/CornyCamera.obj");
     }
-    if (!CameraMaterial)
+    if (!CameraMaterial.IsValid())
     {
-        CameraMaterial = new Material(Graphics->CreateMaterial(*(Registry->LoadTexture("Assets/textures/Camera.png"))));
+        CameraMaterial = Graphics->CreateMaterial(*(Registry->LoadTexture("Assets/textures/Camera.png")));
     }
+#endif
 }
 
 Scene::Scene(Scene& other)
@@ -222,6 +227,8 @@ void Scene::InitializeBehaviours()
 
 void Scene::Update(double DeltaTime)
 {
+    PROFILE_SCOPE("Scene::Update");
+
     UpdateBehaviours(DeltaTime);
 }
 
@@ -236,18 +243,19 @@ void Scene::UpdateBehaviours(double DeltaTime)
 
 void Scene::Draw(GraphicsModule& graphics, GBuffer gBuffer, size_t camIndex)
 {
-    PushSceneRenderCommandsInternal(graphics);
-
     assert(camIndex < m_Cameras.size());
 
+    PushSceneRenderCommandsInternal(graphics, m_Cameras[camIndex]);
+
     graphics.Render(gBuffer, m_Cameras[camIndex], m_DirLight);
 }
 
 void Scene::EditorDraw(GraphicsModule& graphics, GBuffer gBuffer, Camera* editorCam)
 {
-    PushSceneRenderCommandsInternal(graphics);
-
     assert(editorCam);
+
+    PushSceneRenderCommandsInternal(graphics, *editorCam);
+
     for (PointLight* Light : m_PointLights)
     {
         BillboardRenderCommand BillboardRC;
@@ -262,7 +270,7 @@ void Scene::EditorDraw(GraphicsModule& graphics, GBuffer gBuffer, Camera* editor
     {
         StaticMeshRenderCommand CamRC;
         CamRC.m_Mesh = CameraMesh->Id;
-        CamRC.m_Material = *CameraMaterial;
+        CamRC.m_Material = CameraMaterial;
         
         Transform CamTrans;
         CamTrans.SetTransformMatrix(Cam.GetCamTransMatrix());
@@ -289,6 +297,8 @@ void Scene::SetDirectionalLight(DirectionalLight light)
 
 SceneRayCastHit Scene::RayCast(Ray ray, std::vector<Model*> IgnoredModels)
 {
+    PROFILE_SCOPE("Scene::RayCast");
+
     CollisionModule& Collision = *CollisionModule::Get();
 
     SceneRayCastHit finalHit;
@@ -309,6 +319,8 @@ SceneRayCastHit Scene::RayCast(Ray ray, std::vector<Model*> IgnoredModels)
 
 Intersection Scene::SphereIntersect(Sphere sphere, std::vector<Model*> IgnoredModels)
 {
+    PROFILE_SCOPE("Scene::SphereIntersect");
+
     CollisionModule& Collision = *CollisionModule::Get();
 
     Intersection Result;
@@ -376,210 +388,53 @@ Model* Scene::MenuListEntities(UIModule& ui, Font& font)
     return result;
 }
 
-void Scene::Save(std::string FileName)
+void Scene::Save(std::string FileName, LevelFormat Format)
 {
-    std::ofstream File(FileName, std::ofstream::out | std::ofstream::trunc);
-
-    if (!File.is_open())
-    {
-        Engine::DEBUGPrint("Failed to save scene :(");
-        return;
-    }
-
-
-
-    // Set of all textures used in the scene
-    std::set<Material> Materials;
-    // Set of all Static Meshes used in the scene
-    std::set<StaticMesh> StaticMeshes;
-
-    for (auto& it : m_UntrackedModels)
-    {
-        Texture tex = it->m_TexturedMeshes[0].m_Material.m_Albedo;
-        StaticMesh mesh = it->m_TexturedMeshes[0].m_Mesh;
-        
-        Material mat = it->m_TexturedMeshes[0].m_Material;
-
-        Materials.insert(mat);
-        if (mesh.LoadedFromFile)
-        {
-            StaticMeshes.insert(it->m_TexturedMeshes[0].m_Mesh);
-        }
-    }
-    for (auto& it : m_Brushes)
-    {
-        Material mat = it->RepModel->m_TexturedMeshes[0].m_Material;
-
-        Materials.insert(mat);
-    }
-
-    std::vector<Material> MatVec(Materials.begin(), Materials.end());
-    std::vector<StaticMesh> MeshVec(StaticMeshes.begin(), StaticMeshes.end());
-
-    json SceneJson;
+    PROFILE_SCOPE("Scene::Save");
 
-    json TextureList;
-    json StaticMeshList;
-    json PointLightList;
-    json ModelList;
-    json BrushList;
+    LevelData Level;
+    SaveLevelData(Level);
 
-    int Index = 0;
-    for (Material Mat : MatVec)
+    if (!LevelFile::Save(FileName, Level, Format))
     {
-        SaveMaterial(TextureList[Index++], Mat);
-    }
-    Index = 0;
-    for (StaticMesh Mesh : MeshVec)
-    {
-        if (!Mesh.LoadedFromFile)
-            continue;
-
-        SaveStaticMesh(StaticMeshList[Index++], Mesh);
-    }
-    Index = 0;
-    for (PointLight* PLight : m_PointLights)
-    {
-        SavePointLight(PointLightList[Index++], *PLight);
-    }
-    Index = 0;
-    for (Model* Mod : m_UntrackedModels)
-    {
-        int64_t StaticMeshIndex = 0;
-        bool GeneratedMesh = false;
-
-        auto MeshIt = std::find(MeshVec.begin(), MeshVec.end(), Mod->m_TexturedMeshes[0].m_Mesh);
-        if (MeshIt != MeshVec.end())
-        {
-            StaticMeshIndex = MeshIt - MeshVec.begin();
-        }
-        else
-        {
-            GeneratedMesh = true;
-        }
-        
-        int64_t MaterialIndex = 0;
-
-        auto MatIt = std::find(MatVec.begin(), MatVec.end(), Mod->m_TexturedMeshes[0].m_Material);
-        if (MatIt != MatVec.end())
-        {
-            MaterialIndex = MatIt - MatVec.begin();
-        }
-        else
-        {
-            Engine::FatalError("Could not find material, this should never happen");
-        }
-
-        if (GeneratedMesh)
-        {
-            SaveRawModel(ModelList[Index++], *Mod, MaterialIndex);
-        }
-        else
-        {
-            SaveModel(ModelList[Index++], *Mod, StaticMeshIndex, MaterialIndex);
-        }
-    }
-    Index = 0;
-    for (Brush* B : m_Brushes)
-    {
-        int64_t MaterialIndex = 0;
-
-        auto MatIt = std::find(MatVec.begin(), MatVec.end(), B->RepModel->m_TexturedMeshes[0].m_Material);
-        if (MatIt != MatVec.end())
-        {
-            MaterialIndex = MatIt - MatVec.begin();
-        }
-        else
-        {
-            Engine::FatalError("Could not find material while saving brush, this should never happen");
-        }
-
-        SaveBrush(BrushList[Index++], *B, MaterialIndex);
+        Engine::DEBUGPrint("Failed to save scene :(");
     }
-
-    SceneJson["Textures"] = TextureList;
-    SceneJson["StaticMeshes"] = StaticMeshList;
-    SceneJson["PointLights"] = PointLightList;
-    SceneJson["Models"] = ModelList;
-    SceneJson["Brushes"] = BrushList;
-
-    // Uncomment to beautify json - makes it easier to debug but makes files much larger
-    File << std::setw(4) << SceneJson;
-
-    // Uncomment to normalness
-    //File << SceneJson;
-
-    File.close();
 }
 
 void Scene::Load(std::string FileName)
 {
-    std::ifstream File(FileName);
+    PROFILE_SCOPE("Scene::Load");
 
-    if (!File.is_open())
+    if (!std::filesystem::exists(FileName))
     {
         Engine::Alert("Failed to open level " + FileName);
         return;
     }
 
-    Clear();
-
-    if (!json::accept(File))
+    LevelData Level;
+    if (LevelFile::IsBinary(FileName))
     {
-        LegacyLoad(FileName);
-        return;
-    }
-
-    File.clear();
-    File.seekg(0, std::ios::beg);
-
-    json SceneJson = json::parse(File);
-
-    File.close();
-
-    std::vector<Material> MaterialVec;
-    std::vector<StaticMesh> StaticMeshVec;
-
-    json TexturesJson = SceneJson["Textures"];
-    json StaticMeshesJson = SceneJson["StaticMeshes"];
-    json PointLightsJson = SceneJson["PointLights"];
-    json ModelsJson = SceneJson["Models"];
-    json BrushesJson = SceneJson["Brushes"];
-
-    for (json& TextureJson : TexturesJson)
-    {
-        MaterialVec.push_back(LoadMaterial(TextureJson));
-    }
-    for (json& StaticMeshJson : StaticMeshesJson)
-    {
-        StaticMeshVec.push_back(LoadStaticMesh(StaticMeshJson));
-    }
-    ///
-    for (json& PointLightJson : PointLightsJson)
-    {
-        AddPointLight(LoadPointLight(PointLightJson));
+        if (!LevelFile::LoadBinary(FileName, Level))
+        {
+            Engine::Alert("Failed to load level " + FileName);
+            return;
+        }
     }
-    for (json& ModelJson : ModelsJson)
+    else if (!LevelFile::LoadJson(FileName, Level))
     {
-        Model* AddedModel;
-        if (ModelJson.contains("Buffer"))
+        if (LevelFile::IsLegacy(FileName))
         {
-            AddedModel = AddModel(LoadRawModel(ModelJson, MaterialVec));
+            LegacyLoad(FileName);
         }
         else
         {
-            AddedModel = AddModel(LoadModel(ModelJson, MaterialVec, StaticMeshVec));
+            Engine::Alert("Failed to load level " + FileName);
         }
-    }
-    
-    for (json& BrushJson : BrushesJson)
-    {
-        // TODO: Brushes can't have behaviours (for now anyway)
-
-        Brush* AddedBrush;
-        AddedBrush = AddBrush(LoadBrush(BrushJson, MaterialVec));
+        return;
     }
 
+    Clear();
+    LoadLevelData(Level);
 }
 
 //void Scene::Save(std::string FileName)
@@ -722,7 +577,7 @@ void Scene::LegacyLoad(std::string FileName)
 
     Clear();
 
-    std::vector<Material> SceneMaterials;
+    std::vector<MaterialHandle> SceneMaterials;
     std::vector<StaticMesh> SceneStaticMeshes;
 
     FileReaderState ReaderState;
@@ -926,34 +781,95 @@ bool Scene::IsIgnored(Model* model, std::vector<Model*> ignoredModels)
     return false;
 }
 
-void Scene::PushSceneRenderCommandsInternal(GraphicsModule& graphics)
+void Scene::UpdateRenderResources(GraphicsModule& graphics)
 {
+    PROFILE_SCOPE("Scene::UpdateRenderResources");
+
+    CollisionModule& Collision = *CollisionModule::Get();
+
+    for (auto& it : m_Brushes)
+    {
+        if (!it->RepModel)
+        {
+            graphics.UpdateBrushModel(it);
+        }
+    }
+
+    // Collision meshes are generated on first use by mapping the mesh buffers, so get that done here
+    // rather than in the middle of a behaviour update (which might be on the ScenePipeline worker)
     for (auto& it : m_UntrackedModels)
     {
-        StaticMeshRenderCommand command;
-        command.m_Material = it->m_TexturedMeshes[0].m_Material;
-        command.m_Mesh = it->m_TexturedMeshes[0].m_Mesh.Id;
-        command.m_TransMat = it->GetTransform().GetTransformMatrix();
+        Collision.GetCollisionMeshFromMesh(it->m_TexturedMeshes[0].m_Mesh);
+    }
+
+    for (auto& it : m_Brushes)
+    {
+        Collision.GetCollisionMeshFromMesh(it->RepModel->m_TexturedMeshes[0].m_Mesh);
+    }
+}
 
-        graphics.AddRenderCommand(command);
+void Scene::BuildRenderSnapshot(SceneRenderSnapshot& Snapshot, size_t camIndex)
+{
+    PROFILE_SCOPE("Scene::BuildRenderSnapshot");
+
+    assert(camIndex < m_Cameras.size());
 
+    Snapshot.Cam = m_Cameras[camIndex];
+    Snapshot.DirLight = m_DirLight;
+
+    Snapshot.StaticMeshCommands.clear();
+    Snapshot.PointLightCommands.clear();
+
+    size_t RangeCount = BuildRenderCommandsInternal(Snapshot.Cam);
+    for (size_t Range = 0; Range < RangeCount; ++Range)
+    {
+        Snapshot.StaticMeshCommands.insert(Snapshot.StaticMeshCommands.end(), m_RenderCommandBuffers[Range].begin(), m_RenderCommandBuffers[Range].end());
+    }
+
+    for (PointLight* Light : m_PointLights)
+    {
+        PointLightRenderCommand LightRC;
+        LightRC.m_Colour = Light->colour;
+        LightRC.m_Position = Light->position;
+        LightRC.m_Intensity = Light->intensity;
+        LightRC.m_Radius = Light->radius;
+        LightRC.m_CastsShadows = Light->castsShadows;
+
+        Snapshot.PointLightCommands.push_back(LightRC);
+    }
+}
+
+void Scene::DrawSnapshot(GraphicsModule& graphics, GBuffer gBuffer, const SceneRenderSnapshot& Snapshot)
+{
+    graphics.AddRenderCommands(Snapshot.StaticMeshCommands);
+
+    for (const PointLightRenderCommand& LightRC : Snapshot.PointLightCommands)
+    {
+        graphics.AddRenderCommand(LightRC);
     }
 
+    graphics.SubmitDebugDrawCapture(Snapshot.DebugLines);
+
+    graphics.Render(gBuffer, Snapshot.Cam, Snapshot.DirLight);
+}
+
+void Scene::PushSceneRenderCommandsInternal(GraphicsModule& graphics, const Camera& Cam)
+{
+    PROFILE_SCOPE("Scene::PushRenderCommands");
+
+    // Building brush models touches the renderer so it has to happen here on the main thread
     for (auto& it : m_Brushes)
     {
         if (!it->RepModel)
         {
             graphics.UpdateBrushModel(it);
         }
+    }
 
-        Model* repModel = it->RepModel;
-        
-        StaticMeshRenderCommand command;
-        command.m_Material = repModel->m_TexturedMeshes[0].m_Material;
-        command.m_Mesh = repModel->m_TexturedMeshes[0].m_Mesh.Id;
-        command.m_TransMat = repModel->GetTransform().GetTransformMatrix();
-
-        graphics.AddRenderCommand(command);
+    size_t RangeCount = BuildRenderCommandsInternal(Cam);
+    for (size_t Range = 0; Range < RangeCount; ++Range)
+    {
+        graphics.AddRenderCommands(m_RenderCommandBuffers[Range]);
     }
 
     for (PointLight* Light : m_PointLights)
@@ -962,11 +878,62 @@ void Scene::PushSceneRenderCommandsInternal(GraphicsModule& graphics)
         LightRC.m_Colour = Light->colour;
         LightRC.m_Position = Light->position;
         LightRC.m_Intensity = Light->intensity;
+        LightRC.m_Radius = Light->radius;
+        LightRC.m_CastsShadows = Light->castsShadows;
 
         graphics.AddRenderCommand(LightRC);
     }
 }
 
+size_t Scene::BuildRenderCommandsInternal(const Camera& Cam)
+{
+    // In the game this runs on the ScenePipeline worker while the main thread draws the previous frame's snapshot,
+    // so the commands built here aren't drawn until the frame after (Draw and EditorDraw still build and draw in the same frame).
+    // Nothing here touches the renderer, brush models and collision meshes are made beforehand in UpdateRenderResources
+    size_t ModelCount = m_UntrackedModels.size() + m_Brushes.size();
+    size_t RangeCount = Parallel::GetRangeCount(ModelCount, SCENE_RENDER_COMMANDS_PER_RANGE);
+
+    if (m_RenderCommandBuffers.size() < RangeCount)
+    {
+        m_RenderCommandBuffers.resize(RangeCount);
+    }
+
+    // Each range only writes to its own buffer and each model is only in one range,
+    // so nothing here needs a lock (models lazily update their transform matrix)
+    Parallel::ForRanges(ModelCount, RangeCount, [this, &Cam](size_t Range, size_t Begin, size_t End)
+        {
+            PROFILE_SCOPE("Scene::BuildRenderCommands");
+
+            std::vector<StaticMeshRenderCommand>& Commands = m_RenderCommandBuffers[Range];
+            Commands.clear();
+
+            for (size_t i = Begin; i < End; ++i)
+            {
+                Model* model = i < m_UntrackedModels.size() ? m_UntrackedModels[i] : m_Brushes[i - m_UntrackedModels.size()]->RepModel;
+
+                // Brushes added since the last UpdateRenderResources won't have a model yet
+                if (!model)
+                {
+                    continue;
+                }
+
+                const StaticMesh& Mesh = model->m_TexturedMeshes[0].m_Mesh;
+
+                StaticMeshRenderCommand command;
+                command.m_Material = model->m_TexturedMeshes[0].m_Material;
+                command.m_TransMat = model->GetTransform().GetTransformMatrix();
+
+                model->m_LOD = GraphicsModule::SelectMeshLOD(Mesh, command.m_TransMat, Cam, model->m_LOD);
+                command.m_Mesh = GraphicsModule::GetMeshLODId(Mesh, model->m_LOD);
+                command.m_Vis = model->m_Vis;
+
+                Commands.push_back(command);
+            }
+        });
+
+    return RangeCount;
+}
+
 bool Scene::GetReaderStateFromToken(std::string Token, FileReaderState& OutState)
 {
     if (Token == "Textures:")
@@ -988,212 +955,221 @@ bool Scene::GetReaderStateFromToken(std::string Token, FileReaderState& OutState
     return false;
 }
 
-void Scene::SaveMaterial(json& JsonObject, Material& Mat)
-{
-    JsonObject[0] = Mat.m_Albedo.Path.GetFullPath();
-    JsonObject[1] = Mat.m_Normal.Path.GetFullPath();
-    JsonObject[2] = Mat.m_Roughness.Path.GetFullPath();
-    JsonObject[3] = Mat.m_Metallic.Path.GetFullPath();
-    JsonObject[4] = Mat.m_AO.Path.GetFullPath();
-}
-
-void Scene::SaveStaticMesh(json& JsonObject, StaticMesh& Mesh)
+void Scene::SaveLevelData(LevelData& OutLevel)
 {
-    JsonObject = { Mesh.Path.GetFullPath() };
-}
-
-void Scene::SavePointLight(json& JsonObject, PointLight& PointLight)
-{
-    JsonObject["Position"] = { PointLight.position.x, PointLight.position.y, PointLight.position.z };
-    JsonObject["Colour"] = { PointLight.colour.x, PointLight.colour.y, PointLight.colour.z };
-    JsonObject["Intensity"] = PointLight.intensity;
-}
-
-void Scene::SaveModel(json& JsonObject, Model& Mod, int64_t MeshIndex, int64_t MatIndex)
-{
-    Mat4x4f ModTrans = Mod.GetTransform().GetTransformMatrix();
-
-    JsonObject["MeshID"] = MeshIndex;
-    JsonObject["MatID"] = MatIndex;
-    JsonObject["Transform"] = { 
-        ModTrans[0].x, ModTrans[0].y, ModTrans[0].z, ModTrans[0].w,
-        ModTrans[1].x, ModTrans[1].y, ModTrans[1].z, ModTrans[1].w,
-        ModTrans[2].x, ModTrans[2].y, ModTrans[2].z, ModTrans[2].w,
-        ModTrans[3].x, ModTrans[3].y, ModTrans[3].z, ModTrans[3].w,
-    };
-
-    std::vector<std::string> Behaviours = BehaviourRegistry::Get()->GetBehavioursAttachedToEntity(&Mod);
+    // Set of all textures used in the scene
+    std::set<MaterialHandle> Materials;
+    // Set of all Static Meshes used in the scene
+    std::set<StaticMesh> StaticMeshes;
 
-    JsonObject["Behaviours"] = Behaviours;
-    JsonObject["Type"] = Mod.Type;
+    for (auto& it : m_UntrackedModels)
+    {
+        StaticMesh mesh = it->m_TexturedMeshes[0].m_Mesh;
 
-}
+        Materials.insert(it->m_TexturedMeshes[0].m_Material);
+        if (mesh.LoadedFromFile)
+        {
+            StaticMeshes.insert(it->m_TexturedMeshes[0].m_Mesh);
+        }
+    }
+    for (auto& it : m_Brushes)
+    {
+        Materials.insert(it->RepModel->m_TexturedMeshes[0].m_Material);
+    }
 
-void Scene::SaveRawModel(json& JsonObject, Model& Mod, int64_t MatIndex)
-{
-    Mat4x4f ModTrans = Mod.GetTransform().GetTransformMatrix();
-    JsonObject["MatID"] = MatIndex;
-    JsonObject["Transform"] = {
-        ModTrans[0].x, ModTrans[0].y, ModTrans[0].z, ModTrans[0].w,
-        ModTrans[1].x, ModTrans[1].y, ModTrans[1].z, ModTrans[1].w,
-        ModTrans[2].x, ModTrans[2].y, ModTrans[2].z, ModTrans[2].w,
-        ModTrans[3].x, ModTrans[3].y, ModTrans[3].z, ModTrans[3].w,
-    };
+    std::vector<MaterialHandle> MatVec(Materials.begin(), Materials.end());
+    std::vector<StaticMesh> MeshVec(StaticMeshes.begin(), StaticMeshes.end());
 
     GraphicsModule* Graphics = GraphicsModule::Get();
 
-    std::vector<float> VertBuf = Graphics->GetModelVertexBuffer(Mod);
-    std::vector<unsigned int> IndexBuf = Graphics->GetModelIndexBuffer(Mod);
-
-    JsonObject["Buffer"][0] = VertBuf;
-    JsonObject["Buffer"][1] = IndexBuf;
-
-    std::vector<std::string> Behaviours = BehaviourRegistry::Get()->GetBehavioursAttachedToEntity(&Mod);
+    // Generated meshes already saved, so models sharing one only read it back from the renderer once
+    std::map<StaticMesh_ID, size_t> GeneratedMeshes;
 
-    JsonObject["Behaviours"] = Behaviours;
-
-    JsonObject["Type"] = Mod.Type;
-}
-
-void Scene::SaveBrush(json& JsonObject, Brush& B, int64_t MatIndex)
-{
-    JsonObject["MatID"] = MatIndex;
-
-    std::vector<float> VertVec;
-
-    for (auto& Vert : B.Vertices)
+    for (MaterialHandle Mat : MatVec)
     {
-        VertVec.insert(VertVec.end(),
-            {
-                Vert.x, Vert.y, Vert.z
-            }
-        );
+        const Material& SceneMat = Graphics->GetMaterial(Mat);
+
+        LevelMaterial LevelMat;
+        LevelMat.Albedo = SceneMat.m_Albedo.Path.GetFullPath();
+        LevelMat.Normal = SceneMat.m_Normal.Path.GetFullPath();
+        LevelMat.Roughness = SceneMat.m_Roughness.Path.GetFullPath();
+        LevelMat.Metallic = SceneMat.m_Metallic.Path.GetFullPath();
+        LevelMat.AO = SceneMat.m_AO.Path.GetFullPath();
+        OutLevel.Materials.push_back(LevelMat);
     }
-
-    JsonObject["Verts"] = VertVec;
-    
-    for (int i = 0; i < B.Faces.size(); i++)
+    for (StaticMesh& Mesh : MeshVec)
     {
-        JsonObject["Faces"][i] = B.Faces[i];
+        LevelMesh FileMesh;
+        FileMesh.Path = Mesh.Path.GetFullPath();
+        OutLevel.Meshes.push_back(FileMesh);
     }
-}
-
-Material Scene::LoadMaterial(json& JsonObject)
-{
-    Texture* Albedo = AssetRegistry::Get()->LoadTexture("Assets/" + JsonObject[0].get<std::string>());
-    Texture* Normal = AssetRegistry::Get()->LoadTexture("Assets/" + JsonObject[1].get<std::string>());
-    Texture* Roughness = AssetRegistry::Get()->LoadTexture("Assets/" + JsonObject[2].get<std::string>());
-    Texture* Metallic = AssetRegistry::Get()->LoadTexture("Assets/" + JsonObject[3].get<std::string>());
-    Texture* AO = AssetRegistry::Get()->LoadTexture("Assets/" + JsonObject[4].get<std::string>());
-
-    return Material(*Albedo, *Normal, *Roughness, *Metallic, *AO);
-}
-
-StaticMesh Scene::LoadStaticMesh(json& JsonObject)
-{
-    return *AssetRegistry::Get()->LoadStaticMesh("Assets/" + JsonObject[0].get<std::string>());
-}
-
-PointLight Scene::LoadPointLight(json& JsonObject)
-{
-    auto Pos = JsonObject["Position"];
-    auto Colour = JsonObject["Colour"];
+    for (PointLight* PLight : m_PointLights)
+    {
+        OutLevel.PointLights.push_back(*PLight);
+    }
+    for (Model* Mod : m_UntrackedModels)
+    {
+        LevelModel Saved;
 
-    Vec3f VecPos = Vec3f(Pos[0], Pos[1], Pos[2]);
-    Vec3f VecColour = Vec3f(Colour[0], Colour[1], Colour[2]);
-    
-    float Intensity = JsonObject["Intensity"];
+        auto MeshIt = std::find(MeshVec.begin(), MeshVec.end(), Mod->m_TexturedMeshes[0].m_Mesh);
+        if (MeshIt != MeshVec.end())
+        {
+            Saved.Mesh = MeshIt - MeshVec.begin();
+        }
+        else
+        {
+            StaticMesh_ID MeshID = Mod->m_TexturedMeshes[0].m_Mesh.Id;
 
-    PointLight PLight;
-    PLight.position = VecPos;
-    PLight.colour = VecColour;
-    PLight.intensity = Intensity;
+            auto SavedIt = GeneratedMeshes.find(MeshID);
+            if (SavedIt != GeneratedMeshes.end())
+            {
+                Saved.Mesh = SavedIt->second;
+            }
+            else
+            {
+                // Generated meshes have to be read back from the renderer. Different meshes with the same geometry (like boxes of the same
+                // size) are only stored once
+                std::vector<float> VertBuf = Graphics->GetModelVertexBuffer(*Mod);
+                std::vector<unsigned int> IndexBuf = Graphics->GetModelIndexBuffer(*Mod);
 
-    return PLight;
-}
+                Saved.Mesh = OutLevel.AddGeneratedMesh(VertBuf.data(), VertBuf.size(), IndexBuf.data(), IndexBuf.size());
+                GeneratedMeshes[MeshID] = Saved.Mesh;
+            }
+        }
 
-Model* Scene::LoadModel(json& JsonObject, std::vector<Material>& MaterialVector, std::vector<StaticMesh>& StaticMeshVector)
-{
-    Material ModelMat = MaterialVector[JsonObject["MatID"]];
-    StaticMesh ModelMesh = StaticMeshVector[JsonObject["MeshID"]];
+        auto MatIt = std::find(MatVec.begin(), MatVec.end(), Mod->m_TexturedMeshes[0].m_Material);
+        if (MatIt != MatVec.end())
+        {
+            Saved.Material = MatIt - MatVec.begin();
+        }
+        else
+        {
+            Engine::FatalError("Could not find material, this should never happen");
+        }
 
-    auto Trans = JsonObject["Transform"];
+        Saved.Transform = Mod->GetTransform().GetTransformMatrix();
+        Saved.Behaviours = BehaviourRegistry::Get()->GetBehavioursAttachedToEntity(Mod);
+        Saved.Type = Mod->Type;
+        Saved.Visibility = Mod->m_Vis;
 
-    Mat4x4f TransMat;
-    TransMat[0] = { Trans[0], Trans[1], Trans[2], Trans[3]};
-    TransMat[1] = { Trans[4], Trans[5], Trans[6], Trans[7] };
-    TransMat[2] = { Trans[8], Trans[9], Trans[10], Trans[11] };
-    TransMat[3] = { Trans[12], Trans[13], Trans[14], Trans[15] };
+        OutLevel.Models.push_back(Saved);
+    }
+    for (Brush* B : m_Brushes)
+    {
+        LevelBrush Saved;
 
-    Model* NewModel = new Model(TexturedMesh(ModelMesh, ModelMat));
-    NewModel->GetTransform().SetTransformMatrix(TransMat);
+        auto MatIt = std::find(MatVec.begin(), MatVec.end(), B->RepModel->m_TexturedMeshes[0].m_Material);
+        if (MatIt != MatVec.end())
+        {
+            Saved.Material = MatIt - MatVec.begin();
+        }
+        else
+        {
+            Engine::FatalError("Could not find material while saving brush, this should never happen");
+        }
 
-    for (std::string Behaviour : JsonObject["Behaviours"])
-    {
-        BehaviourRegistry::Get()->AttachNewBehaviour(Behaviour, NewModel);
-    }
+        Saved.Vertices = B->Vertices;
+        Saved.Faces = B->Faces;
 
-    if (JsonObject.contains("Type"))
-    {
-        NewModel->Type = JsonObject["Type"];
+        OutLevel.Brushes.push_back(Saved);
     }
-
-    return NewModel;
 }
 
-Model* Scene::LoadRawModel(json& JsonObject, std::vector<Material>& MaterialVector)
+void Scene::LoadLevelData(const LevelData& Level)
 {
-    Material ModelMat = MaterialVector[JsonObject["MatID"]];
-    std::vector<float> MeshBuffer = JsonObject["Buffer"][0];
-    std::vector<unsigned int> IndexBuffer = JsonObject["Buffer"][1];
-
-    auto Trans = JsonObject["Transform"];
-
-    Mat4x4f TransMat;
-    TransMat[0] = { Trans[0], Trans[1], Trans[2], Trans[3] };
-    TransMat[1] = { Trans[4], Trans[5], Trans[6], Trans[7] };
-    TransMat[2] = { Trans[8], Trans[9], Trans[10], Trans[11] };
-    TransMat[3] = { Trans[12], Trans[13], Trans[14], Trans[15] };
-
+    AssetRegistry* Registry = AssetRegistry::Get();
     GraphicsModule* Graphics = GraphicsModule::Get();
 
-    Model* NewModel = new Model(Graphics->LoadModel(MeshBuffer, IndexBuffer, ModelMat));
-
-    NewModel->GetTransform().SetTransformMatrix(TransMat);
+    std::vector<MaterialHandle> MaterialVec;
+    std::vector<StaticMesh> StaticMeshVec;
 
-    for (std::string Behaviour : JsonObject["Behaviours"])
+    for (const LevelMaterial& Mat : Level.Materials)
     {
-        BehaviourRegistry::Get()->AttachNewBehaviour(Behaviour, NewModel);
+        Texture* Albedo = Registry->LoadTexture("Assets/" + Mat.Albedo);
+        Texture* Normal = Registry->LoadTexture("Assets/" + Mat.Normal);
+        Texture* Roughness = Registry->LoadTexture("Assets/" + Mat.Roughness);
+        Texture* Metallic = Registry->LoadTexture("Assets/" + Mat.Metallic);
+        Texture* AO = Registry->LoadTexture("Assets/" + Mat.AO);
+
+        MaterialVec.push_back(Graphics->RegisterMaterial(Material(*Albedo, *Normal, *Roughness, *Metallic, *AO)));
     }
 
-    if (JsonObject.contains("Type"))
+    // Planes get sculpted by writing straight into their mesh, so each one gets its own copy instead of sharing.
+    // Generated meshes only planes use aren't uploaded here at all
+    std::vector<bool> MeshShared(Level.Meshes.size(), false);
+    for (const LevelModel& Loaded : Level.Models)
     {
-        NewModel->Type = JsonObject["Type"];
+        if (Loaded.Type != ModelType::PLANE)
+        {
+            MeshShared[Loaded.Mesh] = true;
+        }
     }
 
-    return NewModel;
-}
+    for (size_t i = 0; i < Level.Meshes.size(); ++i)
+    {
+        const LevelMesh& Mesh = Level.Meshes[i];
+        if (Mesh.Path.empty())
+        {
+            const float* Vertices = Level.GetVertices(Mesh);
+            const ElementIndex* Indices = Level.GetIndices(Mesh);
 
-Brush* Scene::LoadBrush(json& JsonObject, std::vector<Material>& MaterialVector)
-{
-    std::vector<float> ReadVerts = JsonObject["Verts"];
+            // Levels don't normally have the same generated mesh twice, but if they do it's only uploaded once
+            size_t Same = Level.FindGeneratedMesh(Mesh.Hash, Vertices, Mesh.VertexFloatCount, Indices, Mesh.IndexCount);
+            if (!MeshShared[i])
+            {
+                StaticMeshVec.push_back(StaticMesh());
+            }
+            else if (Same < i && MeshShared[Same])
+            {
+                StaticMeshVec.push_back(StaticMeshVec[Same]);
+            }
+            else
+            {
+                StaticMeshVec.push_back(Graphics->LoadGeneratedMesh(Vertices, Mesh.VertexFloatCount, Indices, Mesh.IndexCount));
+            }
+        }
+        else
+        {
+            StaticMeshVec.push_back(*Registry->LoadStaticMesh("Assets/" + Mesh.Path));
+        }
+    }
+    for (const PointLight& PLight : Level.PointLights)
+    {
+        AddPointLight(PLight);
+    }
+    for (const LevelModel& Loaded : Level.Models)
+    {
+        StaticMesh ModelMesh = StaticMeshVec[Loaded.Mesh];
 
-    // I'll see if this works...
-    std::vector<std::vector<unsigned int>> ReadFaces = JsonObject["Faces"];
+        const LevelMesh& Mesh = Level.Meshes[Loaded.Mesh];
+        if (Loaded.Type == ModelType::PLANE && Mesh.Path.empty())
+        {
+            ModelMesh = Graphics->LoadGeneratedMesh(Level.GetVertices(Mesh), Mesh.VertexFloatCount, Level.GetIndices(Mesh), Mesh.IndexCount);
+        }
 
+        Model* NewModel = new Model(TexturedMesh(ModelMesh, MaterialVec[Loaded.Material]));
+        NewModel->GetTransform().SetTransformMatrix(Loaded.Transform);
 
-    std::vector<Vec3f> Vertices;
+        for (const std::string& Behaviour : Loaded.Behaviours)
+        {
+            BehaviourRegistry::Get()->AttachNewBehaviour(Behaviour, NewModel);
+        }
 
-    for (int i = 0; i < ReadVerts.size(); i += 3)
-    {
-        Vertices.emplace_back(ReadVerts[i], ReadVerts[i + 1], ReadVerts[i + 2]);
+        NewModel->Type = Loaded.Type;
+        NewModel->m_Vis = Loaded.Visibility;
+
+        AddModel(NewModel);
     }
+    for (const LevelBrush& Loaded : Level.Brushes)
+    {
+        // TODO: Brushes can't have behaviours (for now anyway)
 
-    GraphicsModule* Graphics = GraphicsModule::Get();
-    
-    Brush* NewBrush = new Brush(Vertices, ReadFaces);
+        std::vector<Vec3f> Vertices = Loaded.Vertices;
+        std::vector<std::vector<unsigned int>> Faces = Loaded.Faces;
 
-    Graphics->UpdateBrushModel(NewBrush);
+        Brush* NewBrush = new Brush(Vertices, Faces);
+        Graphics->UpdateBrushModel(NewBrush);
 
-    return NewBrush;
+        AddBrush(NewBrush);
+    }
 }
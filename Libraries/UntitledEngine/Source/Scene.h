@@ -4,6 +4,7 @@
 #include "Modules/CollisionModule.h"
 #include "Modules/GraphicsModule.h"
 #include "Modules/UIModule.h"
+#include "LevelFile.h"
 
 #include <string>
 
@@ -13,6 +14,9 @@ using json = nlohmann::json;
 
 typedef uint64_t Entity_ID;
 
+// Fewer models than this per thread and it's quicker to just build the render commands on one thread
+#define SCENE_RENDER_COMMANDS_PER_RANGE 512
+
 // TODO(Fraser): Move this to some reader/asset manager file
 enum FileReaderState
 {
@@ -45,6 +49,19 @@ struct EditorRayCastHit
 
 SceneRayCastHit Closer(const SceneRayCastHit& lhs, const SceneRayCastHit& rhs);
 
+// Everything needed to draw one frame of a scene, copied out of it so the scene can get on with
+// simulating the next frame while this one is drawn (see ScenePipeline)
+struct SceneRenderSnapshot
+{
+    Camera Cam;
+    DirectionalLight DirLight;
+
+    std::vector<StaticMeshRenderCommand> StaticMeshCommands;
+    std::vector<PointLightRenderCommand> PointLightCommands;
+
+    DebugDrawCapture DebugLines;
+};
+
 class Scene
 {
 public:
@@ -87,6 +104,13 @@ public:
     void Draw(GraphicsModule& graphics, GBuffer gBuffer, size_t camIndex = 0);
     void EditorDraw(GraphicsModule& graphics, GBuffer gBuffer, Camera* editorCam);
 
+    // Does the renderer work (brush models, collision meshes) that can't happen off the main thread,
+    // has to be called before BuildRenderSnapshot or before updating the scene on another thread
+    void UpdateRenderResources(GraphicsModule& graphics);
+    // Doesn't touch the renderer, so can be called from any thread
+    void BuildRenderSnapshot(SceneRenderSnapshot& Snapshot, size_t camIndex = 0);
+    static void DrawSnapshot(GraphicsModule& graphics, GBuffer gBuffer, const SceneRenderSnapshot& Snapshot);
+
     void SetDirectionalLight(DirectionalLight light);
 
     SceneRayCastHit RayCast(Ray ray, std::vector<Model*> IgnoredModels = std::vector<Model*>());
@@ -95,7 +119,9 @@ public:
 
     Model* MenuListEntities(UIModule& ui, Font& font);
 
-    void Save(std::string FileName);
+    // Binary levels load much faster, JSON ones are for reading and diffing (both kinds load with Load).
+    // JSON by default so saving over a level never changes its format, binary levels come from the LevelConverter
+    void Save(std::string FileName, LevelFormat Format = LevelFormat::Json);
 
     void Load(std::string FileName);
     void LegacyLoad(std::string FileName);
@@ -121,27 +147,22 @@ private:
 
     bool m_Paused = false;
 
-    void PushSceneRenderCommandsInternal(GraphicsModule& graphics);
+    void PushSceneRenderCommandsInternal(GraphicsModule& graphics, const Camera& Cam);
+    // Returns how many of m_RenderCommandBuffers were filled, mesh LODs are picked for Cam
+    size_t BuildRenderCommandsInternal(const Camera& Cam);
+
+    // One command buffer per range of models, filled in parallel then concatenated in order. Only valid until the
+    // next build, so anything that keeps the commands (the render snapshot) has to copy them out
+    std::vector<std::vector<StaticMeshRenderCommand>> m_RenderCommandBuffers;
 
     static bool GetReaderStateFromToken(std::string Token, FileReaderState& OutState);
 
-    // Utility functions for scene serialization/deserialization
-    void SaveMaterial(json& JsonObject, Material& Mat);
-    void SaveStaticMesh(json& JsonObject, StaticMesh& Mesh);
-    void SavePointLight(json& JsonObject, PointLight& PointLight);
-    void SaveModel(json& JsonObject, Model& Mod, int64_t MeshIndex, int64_t MatIndex);
-    void SaveRawModel(json& JsonObject, Model& Mod, int64_t MatIndex);
-    void SaveBrush(json& JsonObject, Brush& B, int64_t MatIndex);
-
-    Material LoadMaterial(json& JsonObject);
-    StaticMesh LoadStaticMesh(json& JsonObject);
-    PointLight LoadPointLight(json& JsonObject);
-    Model* LoadModel(json& JsonObject, std::vector<Material>& MaterialVector, std::vector<StaticMesh>& StaticMeshVector);
-    Model* LoadRawModel(json& JsonObject, std::vector<Material>& MaterialVector);
-    Brush* LoadBrush(json& JsonObject, std::vector<Material>& MaterialVector);
+    // Converting between the scene and what's saved in level files
+    void SaveLevelData(LevelData& OutLevel);
+    void LoadLevelData(const LevelData& Level);
 
     // Editor specific rendering stuff
     static Texture* LightBillboardTexture;
     static StaticMesh* CameraMesh;
-    static Material* CameraMaterial;
+    static MaterialHandle CameraMaterial;
 };
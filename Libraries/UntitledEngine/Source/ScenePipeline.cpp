@@ -0,0 +1,124 @@
+#include "ScenePipeline.h"
+
+#include "Profiling/Profiler.h"
+
+ScenePipeline::ScenePipeline()
+{
+}
+
+ScenePipeline::~ScenePipeline()
+{
+    Stop();
+}
+
+void ScenePipeline::Start(Scene* InScene, GraphicsModule& Graphics, size_t CamIndex)
+{
+    Stop();
+
+    m_Scene = InScene;
+    m_CamIndex = CamIndex;
+    m_DrawIndex = 0;
+
+    for (SceneRenderSnapshot& Snapshot : m_Snapshots)
+    {
+        Snapshot.DebugLines.Clear();
+    }
+
+    m_Scene->UpdateRenderResources(Graphics);
+
+    // The first StartFrame moves on to the next snapshot, so that's where the first one goes
+    m_Scene->BuildRenderSnapshot(m_Snapshots[(m_DrawIndex + 1) % SCENE_PIPELINE_SNAPSHOTS], m_CamIndex);
+
+    m_HasWork = false;
+    m_Quit = false;
+    m_Worker = std::thread(&ScenePipeline::WorkerLoop, this);
+}
+
+void ScenePipeline::Stop()
+{
+    if (!m_Worker.joinable())
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        m_Condition.wait(Lock, [this]() { return !m_HasWork; });
+        m_Quit = true;
+    }
+    m_Condition.notify_all();
+
+    m_Worker.join();
+    m_Scene = nullptr;
+}
+
+bool ScenePipeline::IsRunning() const
+{
+    return m_Worker.joinable();
+}
+
+void ScenePipeline::StartFrame(GraphicsModule& Graphics, GBuffer Buffer, double DeltaTime)
+{
+    assert(IsRunning());
+
+    // The previous update has to be done before we go poking at the scene or its snapshot
+    FinishFrame();
+
+    m_DrawIndex = (m_DrawIndex + 1) % SCENE_PIPELINE_SNAPSHOTS;
+
+    // Worker's idle, so this is the one point in the frame where the scene can safely use the renderer
+    m_Scene->UpdateRenderResources(Graphics);
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_DeltaTime = DeltaTime;
+        m_HasWork = true;
+    }
+    m_Condition.notify_all();
+
+    Scene::DrawSnapshot(Graphics, Buffer, m_Snapshots[m_DrawIndex]);
+}
+
+void ScenePipeline::FinishFrame()
+{
+    PROFILE_SCOPE("ScenePipeline::Wait");
+
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    m_Condition.wait(Lock, [this]() { return !m_HasWork; });
+}
+
+void ScenePipeline::WorkerLoop()
+{
+    Profiler::SetThreadName("Scene Pipeline");
+
+    while (true)
+    {
+        double DeltaTime;
+        {
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+            m_Condition.wait(Lock, [this]() { return m_HasWork || m_Quit; });
+
+            if (m_Quit)
+            {
+                return;
+            }
+            DeltaTime = m_DeltaTime;
+        }
+
+        SceneRenderSnapshot& Snapshot = m_Snapshots[(m_DrawIndex + 1) % SCENE_PIPELINE_SNAPSHOTS];
+
+        Snapshot.DebugLines.Clear();
+        GraphicsModule::SetDebugDrawCapture(&Snapshot.DebugLines);
+
+        m_Scene->Update(DeltaTime);
+        m_Scene->BuildRenderSnapshot(Snapshot, m_CamIndex);
+
+        GraphicsModule::SetDebugDrawCapture(nullptr);
+
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            m_HasWork = false;
+        }
+        m_Condition.notify_all();
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Scene.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// One snapshot being drawn on the main thread while the worker fills in the other
+#define SCENE_PIPELINE_SNAPSHOTS 2
+
+// Runs a scene's update for frame N+1 on a worker thread while the main thread draws frame N from a snapshot,
+// so a frame costs roughly the longer of the two rather than both added together.
+// Everything that talks to GL (drawing, UI, text) stays on the main thread. While the worker is running,
+// behaviours must not touch the renderer (creating meshes, textures, materials...); debug draw is fine
+// since it gets captured into the snapshot and drawn with it.
+// What's on screen is a frame behind the simulation.
+class ScenePipeline
+{
+public:
+    ScenePipeline();
+    ~ScenePipeline();
+
+    // Builds the first snapshot straight away so there's something to draw on the first frame
+    void Start(Scene* InScene, GraphicsModule& Graphics, size_t CamIndex = 0);
+    void Stop();
+
+    bool IsRunning() const;
+
+    // Once per frame on the main thread: starts updating the scene by DeltaTime on the worker and draws
+    // the snapshot from the previous update into Buffer
+    void StartFrame(GraphicsModule& Graphics, GBuffer Buffer, double DeltaTime);
+    // Waits for the update started in StartFrame to finish, the scene is safe to touch again afterwards
+    void FinishFrame();
+
+private:
+    void WorkerLoop();
+
+    Scene* m_Scene = nullptr;
+    size_t m_CamIndex = 0;
+
+    std::thread m_Worker;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+
+    bool m_HasWork = false;
+    bool m_Quit = false;
+    double m_DeltaTime = 0.0;
+
+    SceneRenderSnapshot m_Snapshots[SCENE_PIPELINE_SNAPSHOTS];
+    // The snapshot the main thread draws from, the worker only ever writes the one after it
+    size_t m_DrawIndex = 0;
+};
@@ -159,6 +159,7 @@ bool SelectedLight::DrawInspectorPanel()
 
     static std::string ColourString = "Colour";
     static std::string IntensityString = "Intensity";
+    static std::string RadiusString = "Radius";
 
     UI->TextEntry("Colour", ColourString, Vec2f(250.0f, 20.0f), c_InspectorColour);
 
@@ -170,6 +171,15 @@ bool SelectedLight::DrawInspectorPanel()
 
     UI->FloatSlider("Intensity", Vec2f(400.0f, 20.0f), PointLightPtr->intensity, 0.0f, 10.0f);
 
+    UI->TextEntry("Radius", RadiusString, Vec2f(250.0f, 20.0f), c_InspectorColour);
+
+    UI->FloatSlider("Radius", Vec2f(400.0f, 20.0f), PointLightPtr->radius, 0.1f, 100.0f);
+
+    if (UI->TextButton(PointLightPtr->castsShadows ? "Shadows: On" : "Shadows: Off", Vec2f(250.0f, 20.0f), 4.0f, c_InspectorColour))
+    {
+        PointLightPtr->castsShadows = !PointLightPtr->castsShadows;
+    }
+
     return false;
 }
 
@@ -339,7 +349,7 @@ void CursorState::Update(double DeltaTime)
         Vec2i MousePos = Input->GetMouseState().GetMousePos();
         if (Input->GetMouseState().GetMouseButtonState(MouseButton::LMB).pressed)
         {
-            UI->ImgPanel(DraggingMaterialPtr->m_Albedo, Rect(Vec2f(MousePos), Vec2f(40.0f, 40.0f)));
+            UI->ImgPanel(GraphicsModule::Get()->GetMaterial(DraggingMaterial).m_Albedo, Rect(Vec2f(MousePos), Vec2f(40.0f, 40.0f)));
         }
         else
         {
@@ -349,10 +359,10 @@ void CursorState::Update(double DeltaTime)
 
             if (SceneHit.rayCastHit.hit)
             {
-                SceneHit.hitModel->SetMaterial(*DraggingMaterialPtr);
+                SceneHit.hitModel->SetMaterial(DraggingMaterial);
             }
 
-            DraggingMaterialPtr = nullptr;
+            DraggingMaterial = MaterialHandle();
 
             Dragging = DraggingMode::None;
         }
@@ -457,7 +467,7 @@ void CursorState::ResetAllState()
 
     DraggingModelPtr = nullptr;
     DraggingPointLightPtr = nullptr;
-    DraggingMaterialPtr = nullptr;
+    DraggingMaterial = MaterialHandle();
     DraggingBehaviourName = "";
 
     //for (ISelectedObject* SelectedObj : SelectedObjects)
@@ -606,7 +616,7 @@ void CursorState::StartDraggingNewPointLight(PointLight* NewPointLight)
     DraggingPointLightPtr = NewPointLight;
 }
 
-void CursorState::StartDraggingNewMaterial(Material* NewMaterial)
+void CursorState::StartDraggingNewMaterial(MaterialHandle NewMaterial)
 {
     if (Dragging != DraggingMode::None)
     {
@@ -615,7 +625,7 @@ void CursorState::StartDraggingNewMaterial(Material* NewMaterial)
 
     Dragging = DraggingMode::NewTexture;
 
-    DraggingMaterialPtr = NewMaterial;
+    DraggingMaterial = NewMaterial;
 }
 
 void CursorState::StartDraggingNewBehaviour(std::string NewBehaviourName)
@@ -205,7 +205,7 @@ public:
 
     void StartDraggingNewModel(Model* NewModel);
     void StartDraggingNewPointLight(PointLight* NewPointLight);
-    void StartDraggingNewMaterial(Material* NewMaterial);
+    void StartDraggingNewMaterial(MaterialHandle NewMaterial);
     void StartDraggingNewBehaviour(std::string NewBehaviourName);
 
     void DrawTransientModels();
@@ -257,7 +257,7 @@ private:
     Model* DraggingModelPtr = nullptr;
     PointLight* DraggingPointLightPtr = nullptr;
 
-    Material* DraggingMaterialPtr = nullptr;
+    MaterialHandle DraggingMaterial;
     std::string DraggingBehaviourName;
 
     Transform SelectedProxyTransform;
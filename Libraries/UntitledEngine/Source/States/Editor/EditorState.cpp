@@ -427,16 +427,15 @@ std::vector<Model> EditorState::LoadModels(GraphicsModule& graphics)
     return LoadedModels;
 }
 
-std::vector<Material> EditorState::LoadMaterials(GraphicsModule& graphics)
+std::vector<MaterialHandle> EditorState::LoadMaterials(GraphicsModule& graphics)
 {
-    std::clock_t start;
-    double duration;
+    PROFILE_SCOPE("Editor::LoadMaterials");
 
-    start = std::clock();
+    int64_t Start = Profiler::GetTime();
 
     AssetRegistry* Registry = AssetRegistry::Get();
 
-    std::vector<Material> LoadedMaterials;
+    std::vector<MaterialHandle> LoadedMaterials;
 
     std::string path = "Assets/textures";
 
@@ -468,26 +467,26 @@ std::vector<Material> EditorState::LoadMaterials(GraphicsModule& graphics)
             }
 
 
-            Material newMaterial = LoadMaterial(entry);
+            MaterialHandle newMaterial = LoadMaterial(entry);
 
             LoadedMaterials.push_back(newMaterial);
         }
     }
 
-    duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+    double Duration = (double)(Profiler::GetTime() - Start) / 1000000000.0;
 
-    Engine::DEBUGPrint("Took " + std::to_string(duration) + " seconds to load all textures.");
+    Engine::DEBUGPrint("Took " + std::to_string(Duration) + " seconds to load all textures.");
 
     return LoadedMaterials;
 
 }
 
-Material EditorState::LoadMaterial(std::filesystem::path materialPath)
+MaterialHandle EditorState::LoadMaterial(std::filesystem::path materialPath)
 {
     AssetRegistry* Registry = AssetRegistry::Get();
     GraphicsModule* Graphics = GraphicsModule::Get();
 
-    Material newMaterial;
+    MaterialHandle newMaterial;
 
     std::filesystem::path ext = materialPath.extension();
     std::string extensionString = ext.string();
@@ -948,14 +947,14 @@ void EditorState::DrawResourcesPanel()
 
             UI->StartTab("Materials", c_Tab);
             {
-                for (auto& Mat : LoadedMaterials)
+                for (MaterialHandle Mat : LoadedMaterials)
                 {
-                    if (UI->ImgButton(Mat.m_Albedo.Path.GetFileNameNoExt(), Mat.m_Albedo, Vec2f(80, 80), 5.0f, c_ResourceButton).clicking)
+                    const Material& MatData = Graphics->GetMaterial(Mat);
+                    if (UI->ImgButton(MatData.m_Albedo.Path.GetFileNameNoExt(), MatData.m_Albedo, Vec2f(80, 80), 5.0f, c_ResourceButton).clicking)
                     {
                         if (!Cursor.IsDraggingSomething())
                         {
-                            Material* MatPtr = &Mat;
-                            Cursor.StartDraggingNewMaterial(MatPtr);
+                            Cursor.StartDraggingNewMaterial(Mat);
                         }
 
                     }
@@ -45,8 +45,8 @@ private:
 
     std::vector<Model> LoadModels(GraphicsModule& graphics);
 
-    std::vector<Material> LoadMaterials(GraphicsModule& graphics);
-    Material LoadMaterial(std::filesystem::path materialPath);
+    std::vector<MaterialHandle> LoadMaterials(GraphicsModule& graphics);
+    MaterialHandle LoadMaterial(std::filesystem::path materialPath);
 
     void MoveCamera(Camera* Camera, float PixelToRadians, double DeltaTime);
 
@@ -106,7 +106,7 @@ private:
     Texture brainEntityTexture;
     Texture billboardEntityTexture;
 
-    Material WhiteMaterial;
+    MaterialHandle WhiteMaterial;
 
     //--------------------
     // Editor Fonts
@@ -134,7 +134,7 @@ private:
     //--------------------
     // Resources loaded from folders
     //--------------------
-    std::vector<Material> LoadedMaterials;
+    std::vector<MaterialHandle> LoadedMaterials;
     std::vector<Model> LoadedModels;
 
     //--------------------
@@ -15,12 +15,16 @@ void GameState::OnInitialized()
     TestFont = TextModule::Get()->LoadFont("Assets/fonts/ARLRDBD.TTF", 30);
 
     RuntimeScene.Initialize();
+
+    RuntimePipeline.Start(&RuntimeScene, *Graphics);
 }
 
 void GameState::OnUninitialized()
 {
     GraphicsModule* Graphics = GraphicsModule::Get();
 
+    RuntimePipeline.Stop();
+
     RuntimeScene.Clear();
     Graphics->DeleteGBuffer(ViewportBuffer);
 }
@@ -39,9 +43,7 @@ void GameState::Update(double DeltaTime)
     UIModule* UI = UIModule::Get();
     InputModule* Input = InputModule::Get();
 
-    RuntimeScene.Update(DeltaTime);
-
-    RuntimeScene.Draw(*Graphics, ViewportBuffer);
+    RuntimePipeline.StartFrame(*Graphics, ViewportBuffer, DeltaTime);
 
     Graphics->ResetFrameBuffer();
 
@@ -62,6 +64,9 @@ void GameState::Update(double DeltaTime)
 
     TextModule::Get()->DrawText("FPS: " + std::to_string(PrevAveFPS), &TestFont, Vec2f(0.0f, 30.0f));
 
+    // Scene's only safe to touch again once this is done
+    RuntimePipeline.FinishFrame();
+
     if (Input->GetKeyState(Key::Escape))
     {
         Machine->PopState();
@@ -82,15 +87,26 @@ void GameState::OnResize()
 
 void GameState::LoadScene(Scene& InScene)
 {
+    bool WasPipelineRunning = RuntimePipeline.IsRunning();
+    RuntimePipeline.Stop();
+
     RuntimeScene = Scene(InScene);
     //RuntimeScene.Initialize();
 
     ViewportCamera = RuntimeScene.GetCamera();
     ViewportCamera->SetScreenSize(GetViewportRect().size);
+
+    if (WasPipelineRunning)
+    {
+        RuntimePipeline.Start(&RuntimeScene, *GraphicsModule::Get());
+    }
 }
 
 void GameState::LoadScene(FilePath path)
 {
+    bool WasPipelineRunning = RuntimePipeline.IsRunning();
+    RuntimePipeline.Stop();
+
     RuntimeScene.Load(path.GetFullPath());
     //RuntimeScene.Initialize();
 
@@ -98,6 +114,11 @@ void GameState::LoadScene(FilePath path)
     ViewportCamera->SetScreenSize(GetViewportRect().size);
 
     RuntimeScene.SetDirectionalLight(DirectionalLight{ Math::normalize(Vec3f(0.5f, 1.0f, -1.0f)), Vec3f(1.0f, 1.0f, 1.0f) });
+
+    if (WasPipelineRunning)
+    {
+        RuntimePipeline.Start(&RuntimeScene, *GraphicsModule::Get());
+    }
 }
 
 Rect GameState::GetViewportRect()
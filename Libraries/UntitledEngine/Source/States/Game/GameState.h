@@ -2,6 +2,7 @@
 #include "State/BaseState.h"
 
 #include "GameEngine.h"
+#include "ScenePipeline.h"
 
 class GameState : public BaseState
 {
@@ -34,6 +35,8 @@ private:
     //--------------------
 private:
     Scene RuntimeScene;
+    // Updates the scene for the next frame while this one's being drawn
+    ScenePipeline RuntimePipeline;
 
     Camera* ViewportCamera;
     GBuffer ViewportBuffer;
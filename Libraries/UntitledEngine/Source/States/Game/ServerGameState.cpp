@@ -2,15 +2,36 @@
 
 #include <json.hpp>
 
+#include <algorithm>
+
+#define SERVER_LEVELS_DIRECTORY "levels"
+
+ServerGameState::ServerGameState(std::string StartLevel)
+    : StartLevel(StartLevel)
+{
+}
+
 void ServerGameState::OnInitialized()
 {
     NetworkModule* network = NetworkModule::Get();
-    GraphicsModule* graphics = GraphicsModule::Get();
 
     network->StartServer();
 
+#ifndef DEDICATED_SERVER
+    GraphicsModule* graphics = GraphicsModule::Get();
+
     ViewportBuffer = graphics->CreateGBuffer(Vec2i(800, 600));
     graphics->InitializeDebugDraw(ViewportBuffer.FinalOutput);
+#endif
+
+    RefreshLevels();
+
+    if (!StartLevel.empty())
+    {
+        LoadLevel(StartLevel);
+    }
+
+    Engine::DEBUGPrint("Server started, type help for a list of commands.");
 }
 
 void ServerGameState::OnUninitialized()
@@ -27,77 +48,46 @@ void ServerGameState::OnExit()
 
 void ServerGameState::Update(double DeltaTime)
 {
-    InputModule* input = InputModule::Get();
-    UIModule* ui = UIModule::Get();
     NetworkModule* network = NetworkModule::Get();
-    GraphicsModule* graphics = GraphicsModule::Get();
+
+    TickCount++;
 
     ClientPacket packet;
     while (network->ServerPollData(packet))
     {
-        if (packet.packet.Data._Starts_with("Name:"))
+        if (packet.packet.Data.starts_with("Name:"))
         {
             ClientNames[packet.id] = packet.packet.Data.substr(5);
         }
         else
         {
             std::string NamedMessage = ClientNames[packet.id] + ": " + packet.packet.Data;
-            ReceivedMessages.push_back(NamedMessage);
+            LogMessage(NamedMessage);
             network->ServerSendDataAll(NamedMessage);
         }
     }
 
-    ui->BufferPanel(ViewportBuffer.FinalOutput, Vec2f(800.0f, 600.0f));
-    
-    if (true)
+    std::string Line;
+    while (Engine::PollConsoleLine(Line))
     {
-        ui->StartFrame("Levels", Vec2f(500.0f, 800.0f), 12.0f, MakeColour(125, 200, 255));
-        {
-            std::string path = "levels";
-
-            for (const auto& entry : std::filesystem::directory_iterator(path))
-            {
-                std::filesystem::path ext = entry.path().extension();
-                if (ext.string() == ".lvl")
-                {
-                    std::string fileName = entry.path().generic_string();
-
-                    if (ui->TextButton(fileName, Vec2f(400.0f, 50.0f), 8.0f, MakeColour(200, 100, 75)))
-                    {
-                        SendLevelChangePacket(fileName);
-                        CurrentScene.Load(fileName);
-                        CurrentScene.Initialize();
-                        ViewportCamera = CurrentScene.GetCamera();
-
-                        ViewportCamera->SetScreenSize(Vec2f(800.0f, 600.0f));
-
-                        CurrentScene.SetDirectionalLight(DirectionalLight{ Math::normalize(Vec3f(0.5f, 1.0f, -1.0f)), Vec3f(1.0f, 1.0f, 1.0f) });
-
-                        InScene = true;
-                    }
-                }
-            }
-        }
-        ui->EndFrame();
-
-        ui->StartFrame("Messages", Vec2f(500.0f, 800.0f), 12.0f, MakeColour(200, 235, 255));
-        {
-            for (std::string& m : ReceivedMessages)
-            {
-                ui->TextButton(m, Vec2f(400.0f, 50.0f), 8.0f, MakeColour(255, 235, 200));
-            }
-        }
-        ui->EndFrame();
+        HandleConsoleCommand(Line);
     }
 
+#ifndef DEDICATED_SERVER
+    DrawUI();
+#endif
 
     if (InScene)
     {
         CurrentScene.Update(DeltaTime);
+
+#ifndef DEDICATED_SERVER
+        GraphicsModule* graphics = GraphicsModule::Get();
+
         CurrentScene.Draw(*graphics, ViewportBuffer);
         graphics->ResetFrameBuffer();
+#endif
     }
-
 }
 
 void ServerGameState::OnResize()
@@ -118,3 +108,174 @@ void ServerGameState::SendLevelChangePacket(std::string levelName)
     network->ServerSendDataAll(packetStr);
 
 }
+
+void ServerGameState::LogMessage(const std::string& Message)
+{
+#ifdef DEDICATED_SERVER
+    // Nowhere to show a message history, and a long running server would keep growing it
+    Engine::DEBUGPrint(Message);
+#else
+    ReceivedMessages.push_back(Message);
+#endif
+}
+
+void ServerGameState::RefreshLevels()
+{
+    Levels.clear();
+
+    std::error_code Error;
+    for (const auto& entry : std::filesystem::directory_iterator(SERVER_LEVELS_DIRECTORY, Error))
+    {
+        if (entry.path().extension().string() == ".lvl")
+        {
+            Levels.push_back(entry.path().generic_string());
+        }
+    }
+
+    if (Error)
+    {
+        Engine::DEBUGPrint("Couldn't read the " SERVER_LEVELS_DIRECTORY " directory: " + Error.message());
+    }
+
+    // directory_iterator doesn't promise any order
+    std::sort(Levels.begin(), Levels.end());
+}
+
+bool ServerGameState::LoadLevel(std::string LevelName)
+{
+    // Levels can be given by their name alone ("arena" for "levels/arena.lvl")
+    std::string FileName = LevelName;
+    for (const std::string& Level : Levels)
+    {
+        if (std::filesystem::path(Level).stem().string() == LevelName)
+        {
+            FileName = Level;
+            break;
+        }
+    }
+
+    if (!std::filesystem::exists(FileName))
+    {
+        Engine::DEBUGPrint("No level called " + LevelName);
+        return false;
+    }
+
+    SendLevelChangePacket(FileName);
+    CurrentScene.Load(FileName);
+    CurrentScene.Initialize();
+    ViewportCamera = CurrentScene.GetCamera();
+
+    ViewportCamera->SetScreenSize(Vec2f(800.0f, 600.0f));
+
+    CurrentScene.SetDirectionalLight(DirectionalLight{ Math::normalize(Vec3f(0.5f, 1.0f, -1.0f)), Vec3f(1.0f, 1.0f, 1.0f) });
+
+    CurrentLevel = FileName;
+    InScene = true;
+
+    Engine::DEBUGPrint("Loaded " + FileName);
+    return true;
+}
+
+void ServerGameState::HandleConsoleCommand(const std::string& Line)
+{
+    std::vector<std::string> Words = StringUtils::Split(Line, " ");
+    Words.erase(std::remove(Words.begin(), Words.end(), ""), Words.end());
+
+    if (Words.empty())
+    {
+        return;
+    }
+
+    const std::string& Command = Words[0];
+    std::string Rest = Line.substr(std::min(Line.find(Command) + Command.size() + 1, Line.size()));
+
+    if (Command == "help")
+    {
+        Engine::DEBUGPrint("levels            list the levels that can be loaded");
+        Engine::DEBUGPrint("refresh           rescan the " SERVER_LEVELS_DIRECTORY " directory");
+        Engine::DEBUGPrint("load <level>      load a level and send every client to it");
+        Engine::DEBUGPrint("say <message>     send a message to every client");
+        Engine::DEBUGPrint("clients           list the connected clients");
+        Engine::DEBUGPrint("status            show what the server's doing");
+        Engine::DEBUGPrint("quit              shut the server down");
+    }
+    else if (Command == "levels")
+    {
+        for (const std::string& Level : Levels)
+        {
+            Engine::DEBUGPrint(Level);
+        }
+    }
+    else if (Command == "refresh")
+    {
+        RefreshLevels();
+        Engine::DEBUGPrint(std::to_string(Levels.size()) + " levels found");
+    }
+    else if (Command == "load" && Words.size() > 1)
+    {
+        LoadLevel(Words[1]);
+    }
+    else if (Command == "say" && !Rest.empty())
+    {
+        std::string NamedMessage = "Server: " + Rest;
+        LogMessage(NamedMessage);
+        NetworkModule::Get()->ServerSendDataAll(NamedMessage);
+    }
+    else if (Command == "clients")
+    {
+        for (auto& [ID, Name] : ClientNames)
+        {
+            Engine::DEBUGPrint(std::to_string(ID) + ": " + Name);
+        }
+    }
+    else if (Command == "status")
+    {
+        Engine::DEBUGPrint("Level: " + (InScene ? CurrentLevel : std::string("none")));
+        Engine::DEBUGPrint("Clients: " + std::to_string(ClientNames.size()));
+        Engine::DEBUGPrint("Ticks: " + std::to_string(TickCount));
+        Engine::DEBUGPrint("Last tick: " + std::to_string(Profiler::GetLastFrameMilliseconds()) + " ms");
+    }
+    else if (Command == "quit")
+    {
+        Engine::StopGame();
+    }
+    else
+    {
+        Engine::DEBUGPrint("Unknown command: " + Line);
+    }
+}
+
+#ifndef DEDICATED_SERVER
+void ServerGameState::DrawUI()
+{
+    UIModule* ui = UIModule::Get();
+
+    ui->BufferPanel(ViewportBuffer.FinalOutput, Vec2f(800.0f, 600.0f));
+
+    ui->StartFrame("Levels", Vec2f(500.0f, 800.0f), 12.0f, MakeColour(125, 200, 255));
+    {
+        if (ui->TextButton("Refresh", Vec2f(400.0f, 50.0f), 8.0f, MakeColour(100, 200, 75)))
+        {
+            RefreshLevels();
+        }
+
+        for (const std::string& Level : Levels)
+        {
+            if (ui->TextButton(Level, Vec2f(400.0f, 50.0f), 8.0f, MakeColour(200, 100, 75)))
+            {
+                LoadLevel(Level);
+            }
+        }
+    }
+    ui->EndFrame();
+
+    ui->StartFrame("Messages", Vec2f(500.0f, 800.0f), 12.0f, MakeColour(200, 235, 255));
+    {
+        for (std::string& m : ReceivedMessages)
+        {
+            ui->TextButton(m, Vec2f(400.0f, 50.0f), 8.0f, MakeColour(255, 235, 200));
+        }
+    }
+    ui->EndFrame();
+}
+#endif
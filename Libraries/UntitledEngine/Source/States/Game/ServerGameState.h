@@ -7,6 +7,10 @@
 class ServerGameState
     : public BaseState
 {
+public:
+    // StartLevel is loaded as soon as the server's up, so a dedicated server can be started straight into a level
+    ServerGameState(std::string StartLevel = "");
+
     //--------------------
     // BaseState Implementation
     //--------------------
@@ -22,13 +26,29 @@ private:
 
     void SendLevelChangePacket(std::string levelName);
 
+    // Rescans the levels directory, the list's only refreshed when asked for rather than every frame
+    void RefreshLevels();
+    bool LoadLevel(std::string LevelName);
+
+    void HandleConsoleCommand(const std::string& Line);
+    void LogMessage(const std::string& Message);
+
+#ifndef DEDICATED_SERVER
+    void DrawUI();
+#endif
+
     bool InScene = false;
     Scene CurrentScene;
     Camera* ViewportCamera;
     GBuffer ViewportBuffer;
 
+    std::string StartLevel;
+    std::string CurrentLevel;
+    std::vector<std::string> Levels;
+
+    uint64_t TickCount = 0;
+
     std::vector<std::string> ReceivedMessages;
 
     std::unordered_map<ClientID, std::string> ClientNames;
 };
-
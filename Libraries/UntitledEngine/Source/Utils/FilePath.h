@@ -27,18 +27,18 @@ public:
         Path = InPath;
     }
 
-    std::string GetFullPath()
+    std::string GetFullPath() const
     {
         return Path;
     }
 
-    std::string GetFileName()
+    std::string GetFileName() const
     {
         size_t LastSlash = Path.find_last_of('/');
         return Path.substr(LastSlash + 1);
     }
 
-    std::string GetFileNameNoExt()
+    std::string GetFileNameNoExt() const
     {
         size_t LastSlash = Path.find_last_of('/');
         size_t LastPeriod = Path.find_last_of('.');
@@ -46,7 +46,7 @@ public:
         return Path.substr(LastSlash + 1, LastPeriod - (LastSlash + 1));
     }
 
-    std::string GetExt()
+    std::string GetExt() const
     {
         size_t LastPeriod = Path.find_last_of('.');
         return Path.substr(LastPeriod);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 
 #include <functional>
 
@@ -37,6 +39,24 @@ namespace Hash
         return h;
     }
 
+    // Same as Combine but always 64 bit, for hashes that get saved and have to match on every platform
+    inline uint64_t Combine64(uint64_t h, uint64_t k)
+    {
+        const uint64_t m = 0xc6a4a7935bd1e995ull;
+        const int r = 47;
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+
+        h += 0xe6546b64;
+
+        return h;
+    }
+
     template <typename T>
     inline size_t Hash_Value(T v)
     {
@@ -61,4 +81,30 @@ namespace Hash
         size_t h = Hash_Value(v.location);
         return Combine(h, Hash_Value(v.size));
     }
-}
\ No newline at end of file
+
+    // For big blocks of plain data like mesh geometry, goes through it 8 bytes at a time
+    inline uint64_t Hash_Bytes(const void* data, size_t size, uint64_t h = 0)
+    {
+        // Nothing to read (data may well be null), same result as an empty tail and a size of 0
+        if (size == 0)
+        {
+            return Combine64(Combine64(h, 0), 0);
+        }
+
+        const unsigned char* bytes = (const unsigned char*)data;
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t k;
+            memcpy(&k, bytes + i, sizeof(uint64_t));
+            h = Combine64(h, k);
+        }
+
+        uint64_t tail = 0;
+        memcpy(&tail, bytes + i, size - i);
+        h = Combine64(h, tail);
+
+        return Combine64(h, (uint64_t)size);
+    }
+}
@@ -0,0 +1,163 @@
+#include "Parallel.h"
+
+#include "../Profiling/Profiler.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // One job at a time, the thread that submitted it hands out ranges to the workers and itself
+    class WorkerPool
+    {
+    public:
+        WorkerPool()
+        {
+            // The calling thread works on its own jobs, so one fewer worker than there are cores
+            size_t WorkerCount = std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1;
+
+            m_Workers.reserve(WorkerCount);
+            for (size_t i = 0; i < WorkerCount; ++i)
+            {
+                m_Workers.emplace_back(&WorkerPool::WorkerLoop, this, i + 1);
+            }
+        }
+
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> Lock(m_Mutex);
+                m_Stopping = true;
+            }
+            m_WorkAvailable.notify_all();
+
+            for (std::thread& Worker : m_Workers)
+            {
+                Worker.join();
+            }
+        }
+
+        void Run(size_t Count, size_t RangeCount, Parallel::RangeFunc Func, void* Context)
+        {
+            std::unique_lock<std::mutex> JobLock(m_JobMutex, std::try_to_lock);
+
+            if (!JobLock.owns_lock() || m_Workers.empty())
+            {
+                RunInline(Count, RangeCount, Func, Context);
+                return;
+            }
+
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+
+            m_Func = Func;
+            m_Context = Context;
+            m_Count = Count;
+            m_RangeSize = (Count + RangeCount - 1) / RangeCount;
+            m_RangeCount = RangeCount;
+            m_NextRange = 0;
+            m_RangesLeft = RangeCount;
+
+            Lock.unlock();
+            m_WorkAvailable.notify_all();
+            Lock.lock();
+
+            while (m_NextRange < m_RangeCount)
+            {
+                RunNextRange(Lock);
+            }
+
+            m_JobDone.wait(Lock, [this]() { return m_RangesLeft == 0; });
+        }
+
+    private:
+        static void RunInline(size_t Count, size_t RangeCount, Parallel::RangeFunc Func, void* Context)
+        {
+            size_t RangeSize = (Count + RangeCount - 1) / RangeCount;
+
+            for (size_t Range = 0; Range < RangeCount; ++Range)
+            {
+                size_t Begin = std::min(Range * RangeSize, Count);
+                size_t End = std::min(Begin + RangeSize, Count);
+
+                Func(Context, Range, Begin, End);
+            }
+        }
+
+        // Takes the next range of the current job and runs it with the lock released
+        void RunNextRange(std::unique_lock<std::mutex>& Lock)
+        {
+            size_t Range = m_NextRange++;
+            size_t Begin = std::min(Range * m_RangeSize, m_Count);
+            size_t End = std::min(Begin + m_RangeSize, m_Count);
+
+            Parallel::RangeFunc Func = m_Func;
+            void* Context = m_Context;
+
+            Lock.unlock();
+            Func(Context, Range, Begin, End);
+            Lock.lock();
+
+            if (--m_RangesLeft == 0)
+            {
+                m_JobDone.notify_all();
+            }
+        }
+
+        void WorkerLoop(size_t WorkerIndex)
+        {
+            std::string ThreadName = "Worker " + std::to_string(WorkerIndex);
+            Profiler::SetThreadName(ThreadName.c_str());
+
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+
+            while (true)
+            {
+                m_WorkAvailable.wait(Lock, [this]() { return m_Stopping || m_NextRange < m_RangeCount; });
+
+                if (m_Stopping)
+                {
+                    return;
+                }
+
+                RunNextRange(Lock);
+            }
+        }
+
+        std::vector<std::thread> m_Workers;
+
+        // Held by whoever's job is running, for the whole job
+        std::mutex m_JobMutex;
+
+        // Guards everything below
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkAvailable;
+        std::condition_variable m_JobDone;
+        bool m_Stopping = false;
+
+        Parallel::RangeFunc m_Func = nullptr;
+        void* m_Context = nullptr;
+        size_t m_Count = 0;
+        size_t m_RangeSize = 0;
+        size_t m_RangeCount = 0;
+        size_t m_NextRange = 0;
+        size_t m_RangesLeft = 0;
+    };
+
+    WorkerPool& GetWorkerPool()
+    {
+        static WorkerPool Pool;
+        return Pool;
+    }
+}
+
+void Parallel::StartWorkers()
+{
+    GetWorkerPool();
+}
+
+void Parallel::RunRanges(size_t Count, size_t RangeCount, RangeFunc Func, void* Context)
+{
+    GetWorkerPool().Run(Count, RangeCount, Func, Context);
+}
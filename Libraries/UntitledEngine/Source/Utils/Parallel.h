@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+
+// Splitting a loop over [0, Count) into contiguous ranges that run on separate threads.
+// Each range gets its own index so callers can give every range its own output buffer and merge them
+// afterwards, rather than having the ranges fight over a shared container.
+// The ranges run on a pool of worker threads that lives as long as the program, so nothing gets
+// started or joined per call.
+namespace Parallel
+{
+    // How many ranges to split Count items into, never more than there are cores and never so many that
+    // a range ends up with fewer than MinPerRange items (not worth the cost of handing it to another thread)
+    inline size_t GetRangeCount(size_t Count, size_t MinPerRange)
+    {
+        size_t MaxRanges = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        size_t Ranges = (Count + MinPerRange - 1) / std::max<size_t>(MinPerRange, 1);
+
+        return std::max<size_t>(std::min(Ranges, MaxRanges), 1);
+    }
+
+    // Starts the worker threads, called once by the engine at startup (the first ForRanges does it otherwise)
+    void StartWorkers();
+
+    using RangeFunc = void(*)(void* Context, size_t Range, size_t Begin, size_t End);
+
+    // Non-template part of ForRanges
+    void RunRanges(size_t Count, size_t RangeCount, RangeFunc Func, void* Context);
+
+    // Calls Callback(RangeIndex, Begin, End) once per range and returns when every range is done.
+    // The calling thread works through ranges alongside the workers.
+    // Calls made while the workers are busy (from inside another ForRanges, or another thread) run every range on the calling thread
+    template <typename Func>
+    void ForRanges(size_t Count, size_t RangeCount, Func&& Callback)
+    {
+        if (RangeCount <= 1)
+        {
+            Callback((size_t)0, (size_t)0, Count);
+            return;
+        }
+
+        using CallbackType = std::remove_reference_t<Func>;
+
+        RunRanges(Count, RangeCount, [](void* Context, size_t Range, size_t Begin, size_t End)
+            {
+                (*static_cast<CallbackType*>(Context))(Range, Begin, End);
+            }, (void*)&Callback);
+    }
+}
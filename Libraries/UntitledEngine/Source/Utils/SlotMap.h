@@ -0,0 +1,146 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Array-backed storage addressed by generational handles.
+// A handle packs the slot index into the low bits and the slot's generation into the high bits.
+// Every time a slot is freed its generation goes up, so old handles to it stop resolving instead of
+// silently pointing at whatever gets put in the slot next.
+template <typename T>
+class SlotMap
+{
+public:
+    typedef unsigned int Handle;
+
+    static const unsigned int IndexBits = 20;
+    static const unsigned int IndexMask = (1u << IndexBits) - 1;
+    static const unsigned int MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+    // Generations start at 1 so a valid handle is never 0
+    static const Handle InvalidHandle = 0;
+
+    Handle Insert(T&& Value)
+    {
+        unsigned int Index;
+        if (!m_FreeSlots.empty())
+        {
+            Index = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            Index = (unsigned int)m_Values.size();
+            if (Index > IndexMask)
+            {
+                return InvalidHandle;
+            }
+            m_Values.emplace_back();
+            m_Generations.push_back(1);
+        }
+
+        m_Values[Index].emplace(std::move(Value));
+        m_Count++;
+
+        return MakeHandle(Index, m_Generations[Index]);
+    }
+
+    Handle Insert(const T& Value)
+    {
+        T Copy = Value;
+        return Insert(std::move(Copy));
+    }
+
+    T* Get(Handle InHandle)
+    {
+        unsigned int Index = GetIndex(InHandle);
+        if (Index >= m_Values.size() || m_Generations[Index] != GetGeneration(InHandle) || !m_Values[Index].has_value())
+        {
+            return nullptr;
+        }
+        return &(*m_Values[Index]);
+    }
+
+    const T* Get(Handle InHandle) const
+    {
+        return const_cast<SlotMap<T>*>(this)->Get(InHandle);
+    }
+
+    bool Contains(Handle InHandle) const
+    {
+        return Get(InHandle) != nullptr;
+    }
+
+    // True if the handle used to refer to something in this map which has since been removed
+    bool IsStale(Handle InHandle) const
+    {
+        unsigned int Index = GetIndex(InHandle);
+        unsigned int Generation = GetGeneration(InHandle);
+        return Index < m_Values.size() && Generation != 0 && Generation < m_Generations[Index];
+    }
+
+    bool Remove(Handle InHandle)
+    {
+        if (!Contains(InHandle))
+        {
+            return false;
+        }
+
+        unsigned int Index = GetIndex(InHandle);
+
+        m_Values[Index].reset();
+        m_Count--;
+
+        // Once a slot runs out of generations it's retired for good rather than wrapping around
+        if (m_Generations[Index] < MaxGeneration)
+        {
+            m_Generations[Index]++;
+            m_FreeSlots.push_back(Index);
+        }
+        else
+        {
+            m_Generations[Index] = MaxGeneration + 1;
+        }
+
+        return true;
+    }
+
+    size_t Size() const
+    {
+        return m_Count;
+    }
+
+    template <typename Func>
+    void ForEach(Func&& Callback)
+    {
+        for (unsigned int i = 0; i < m_Values.size(); ++i)
+        {
+            if (m_Values[i].has_value())
+            {
+                Callback(MakeHandle(i, m_Generations[i]), *m_Values[i]);
+            }
+        }
+    }
+
+    static unsigned int GetIndex(Handle InHandle)
+    {
+        return InHandle & IndexMask;
+    }
+
+    static unsigned int GetGeneration(Handle InHandle)
+    {
+        return InHandle >> IndexBits;
+    }
+
+private:
+    static Handle MakeHandle(unsigned int Index, unsigned int Generation)
+    {
+        return (Generation << IndexBits) | Index;
+    }
+
+    std::vector<std::optional<T>> m_Values;
+    std::vector<unsigned int> m_Generations;
+    std::vector<unsigned int> m_FreeSlots;
+    size_t m_Count = 0;
+};
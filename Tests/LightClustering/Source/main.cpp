@@ -0,0 +1,202 @@
+#include "Rendering/LightClustering.h"
+#include "Platform/EnginePlatform.h"
+
+#include <cmath>
+#include <cstdio>
+
+// Standalone checks for LightClustering::BuildClusters, returns non-zero if any of them fail
+
+// The math library logs through the engine, which isn't linked in here
+void Engine::DEBUGPrint(std::string string)
+{
+    printf("%s\n", string.c_str());
+}
+
+namespace
+{
+    int Failures = 0;
+
+    void Check(bool Condition, const char* Description)
+    {
+        if (!Condition)
+        {
+            printf("FAILED: %s\n", Description);
+            Failures++;
+        }
+    }
+
+    // Camera at the origin looking down +y with z up, same as the engine's default camera
+    ClusterFrustum MakePerspectiveFrustum()
+    {
+        ClusterFrustum Frustum;
+        Frustum.Position = Vec3f(0.0f, 0.0f, 0.0f);
+        Frustum.Forward = Vec3f(0.0f, 1.0f, 0.0f);
+        Frustum.Right = Vec3f(1.0f, 0.0f, 0.0f);
+        Frustum.Up = Vec3f(0.0f, 0.0f, 1.0f);
+        Frustum.VerticalFOV = 3.14159265f / 2.0f;
+        Frustum.AspectRatio = 16.0f / 9.0f;
+        Frustum.NearPlane = 0.1f;
+        Frustum.FarPlane = 100.0f;
+        return Frustum;
+    }
+
+    bool ClusterHasLight(const LightClusterGrid& Grid, unsigned int X, unsigned int Y, unsigned int Slice, unsigned int LightIndex)
+    {
+        unsigned int Cluster = Grid.GetClusterIndex(X, Y, Slice);
+        unsigned int Offset = Grid.GetClusterLightOffset(Cluster);
+
+        for (unsigned int i = 0; i < Grid.GetClusterLightCount(Cluster); ++i)
+        {
+            if (Grid.LightIndices[Offset + i] == LightIndex)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Inclusive tile/slice range the light ended up in, false if it isn't in any cluster
+    bool GetLightExtents(const LightClusterGrid& Grid, unsigned int LightIndex,
+        unsigned int& MinX, unsigned int& MaxX, unsigned int& MinY, unsigned int& MaxY, unsigned int& MinSlice, unsigned int& MaxSlice)
+    {
+        bool Found = false;
+        MinX = MinY = MinSlice = ~0u;
+        MaxX = MaxY = MaxSlice = 0;
+
+        for (unsigned int Slice = 0; Slice < Grid.Slices; ++Slice)
+        {
+            for (unsigned int Y = 0; Y < Grid.TilesY; ++Y)
+            {
+                for (unsigned int X = 0; X < Grid.TilesX; ++X)
+                {
+                    if (!ClusterHasLight(Grid, X, Y, Slice, LightIndex))
+                    {
+                        continue;
+                    }
+                    Found = true;
+                    MinX = Math::Min(MinX, X); MaxX = Math::Max(MaxX, X);
+                    MinY = Math::Min(MinY, Y); MaxY = Math::Max(MaxY, Y);
+                    MinSlice = Math::Min(MinSlice, Slice); MaxSlice = Math::Max(MaxSlice, Slice);
+                }
+            }
+        }
+        return Found;
+    }
+
+    void TestDepthSlices()
+    {
+        ClusterFrustum Frustum = MakePerspectiveFrustum();
+        LightClusterGrid Grid;
+        LightClustering::BuildClusters(Frustum, {}, Grid);
+
+        Check(LightClustering::GetDepthSlice(Grid, Frustum.NearPlane) == 0, "near plane is in the first slice");
+        Check(LightClustering::GetDepthSlice(Grid, Frustum.FarPlane) == Grid.Slices - 1, "far plane is in the last slice");
+        Check(LightClustering::GetDepthSlice(Grid, Frustum.FarPlane * 10.0f) == Grid.Slices - 1, "depth past the far plane clamps to the last slice");
+        Check(LightClustering::GetDepthSlice(Grid, 0.0f) == 0, "zero depth clamps to the first slice");
+
+        // Slices are spaced exponentially, so the geometric mean of near and far is exactly half way
+        float MidDepth = sqrtf(Frustum.NearPlane * Frustum.FarPlane) * 1.01f;
+        Check(LightClustering::GetDepthSlice(Grid, MidDepth) == Grid.Slices / 2, "geometric middle depth is in the middle slice");
+
+        unsigned int PreviousSlice = 0;
+        bool Monotonic = true;
+        for (float Depth = Frustum.NearPlane; Depth < Frustum.FarPlane; Depth *= 1.1f)
+        {
+            unsigned int Slice = LightClustering::GetDepthSlice(Grid, Depth);
+            Monotonic &= Slice >= PreviousSlice;
+            PreviousSlice = Slice;
+        }
+        Check(Monotonic, "slices increase with depth");
+        Check(Grid.LightIndices.empty(), "no lights means no light indices");
+    }
+
+    void TestPerspectiveAssignment()
+    {
+        ClusterFrustum Frustum = MakePerspectiveFrustum();
+
+        std::vector<ClusterLight> Lights =
+        {
+            { Vec3f(0.0f, 10.0f, 0.0f), 0.5f },     // 0: straight ahead
+            { Vec3f(0.0f, -10.0f, 0.0f), 2.0f },    // 1: behind the camera
+            { Vec3f(0.0f, 150.0f, 0.0f), 10.0f },   // 2: past the far plane
+            { Vec3f(100.0f, 10.0f, 0.0f), 1.0f },   // 3: off to the right of the frustum
+            { Vec3f(17.0f, 10.0f, 0.0f), 0.5f },    // 4: on the right edge of the screen
+            { Vec3f(0.0f, 0.0f, 0.0f), 1.0f },      // 5: around the camera
+        };
+
+        LightClusterGrid Grid;
+        LightClustering::BuildClusters(Frustum, Lights, Grid);
+
+        unsigned int MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice;
+
+        Check(GetLightExtents(Grid, 0, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light ahead is assigned");
+        Check(MinX == Grid.TilesX / 2 - 1 && MaxX == Grid.TilesX / 2, "light ahead covers the two centre columns");
+        Check(MinY == Grid.TilesY / 2 && MaxY == Grid.TilesY / 2, "light ahead covers the centre row");
+        Check(MinSlice == LightClustering::GetDepthSlice(Grid, 9.5f) && MaxSlice == LightClustering::GetDepthSlice(Grid, 10.5f), "light ahead covers the slices of its depth range");
+
+        Check(!GetLightExtents(Grid, 1, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light behind the camera is culled");
+        Check(!GetLightExtents(Grid, 2, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light past the far plane is culled");
+        Check(!GetLightExtents(Grid, 3, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light outside the side planes is culled");
+
+        Check(GetLightExtents(Grid, 4, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light on the screen edge is assigned");
+        Check(MaxX == Grid.TilesX - 1 && MinX >= Grid.TilesX - 2, "light on the screen edge is in the last columns");
+
+        Check(GetLightExtents(Grid, 5, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light around the camera is assigned");
+        Check(MinX == 0 && MaxX == Grid.TilesX - 1 && MinY == 0 && MaxY == Grid.TilesY - 1 && MinSlice == 0, "light around the camera covers the whole screen from the near plane");
+
+        // Every index should belong to exactly one cluster range
+        unsigned int TotalCount = 0;
+        for (unsigned int Cluster = 0; Cluster < Grid.GetClusterCount(); ++Cluster)
+        {
+            Check(Grid.GetClusterLightOffset(Cluster) == TotalCount, "cluster ranges are packed in order");
+            TotalCount += Grid.GetClusterLightCount(Cluster);
+        }
+        Check(TotalCount == Grid.LightIndices.size(), "cluster ranges cover every light index");
+    }
+
+    void TestOrthographicAssignment()
+    {
+        ClusterFrustum Frustum = MakePerspectiveFrustum();
+        Frustum.Orthographic = true;
+        Frustum.OrthoHalfWidth = 16.0f;
+        Frustum.OrthoHalfHeight = 9.0f;
+
+        std::vector<ClusterLight> Lights =
+        {
+            { Vec3f(13.0f, 50.0f, 0.5f), 0.25f },   // 0: three quarters of the way to the right edge, far away
+            { Vec3f(13.0f, 1.0f, 0.5f), 0.25f },    // 1: the same spot on screen, close up
+            { Vec3f(17.0f, 50.0f, 0.0f), 0.5f },    // 2: off the right edge
+        };
+
+        LightClusterGrid Grid;
+        LightClustering::BuildClusters(Frustum, Lights, Grid);
+
+        unsigned int MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice;
+
+        // x = 13 of 16 is ndc 0.8125 -> tile 14.5 of 16, y = 0.5 of 9 is ndc 0.055 -> tile 4.75 of 9
+        Check(GetLightExtents(Grid, 0, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "orthographic far light is assigned");
+        Check(MinX == 14 && MaxX == 14 && MinY == 4 && MaxY == 4, "orthographic far light lands in the tile under it");
+
+        Check(GetLightExtents(Grid, 1, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "orthographic near light is assigned");
+        Check(MinX == 14 && MaxX == 14 && MinY == 4 && MaxY == 4, "orthographic tiles don't depend on depth");
+        Check(MinSlice == LightClustering::GetDepthSlice(Grid, 0.75f) && MaxSlice == LightClustering::GetDepthSlice(Grid, 1.25f), "orthographic near light covers the slices of its depth range");
+
+        Check(!GetLightExtents(Grid, 2, MinX, MaxX, MinY, MaxY, MinSlice, MaxSlice), "light outside the orthographic box is culled");
+    }
+}
+
+int main()
+{
+    TestDepthSlices();
+    TestPerspectiveAssignment();
+    TestOrthographicAssignment();
+
+    if (Failures > 0)
+    {
+        printf("%d light clustering check(s) failed\n", Failures);
+        return 1;
+    }
+
+    printf("All light clustering checks passed\n");
+    return 0;
+}
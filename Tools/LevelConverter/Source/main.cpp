@@ -0,0 +1,110 @@
+#include "GameEngine.h"
+
+#include "LevelFile.h"
+
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+// Converts levels between the JSON and binary formats, without loading anything they use (so behaviours don't need to be registered).
+// Run from the repository root: LevelConverter <input> <output> [-json | -binary]
+// Without a format, JSON levels are converted to binary and binary ones to JSON.
+
+namespace
+{
+    double ToMilliseconds(int64_t Nanoseconds)
+    {
+        return Nanoseconds / 1000000.0;
+    }
+
+    bool Convert(const std::string& Input, const std::string& Output, LevelFormat Format)
+    {
+        LevelData Level;
+
+        int64_t StartTime = Profiler::GetTime();
+        if (!LevelFile::Load(Input, Level))
+        {
+            Engine::DEBUGPrint("Couldn't load " + Input + (LevelFile::IsLegacy(Input) ? " (legacy levels need to be loaded and saved in the editor)" : ""));
+            return false;
+        }
+        int64_t LoadedTime = Profiler::GetTime();
+
+        if (!LevelFile::Save(Output, Level, Format))
+        {
+            Engine::DEBUGPrint("Couldn't write " + Output);
+            return false;
+        }
+        int64_t SavedTime = Profiler::GetTime();
+
+        std::error_code Error;
+        uintmax_t InputSize = std::filesystem::file_size(Input, Error);
+        uintmax_t OutputSize = std::filesystem::file_size(Output, Error);
+
+        std::ostringstream Report;
+        Report << std::fixed << std::setprecision(2);
+        Report << Input << " (" << InputSize / 1024.0 << " KB, read in " << ToMilliseconds(LoadedTime - StartTime) << "ms) -> "
+            << Output << " (" << OutputSize / 1024.0 << " KB, written in " << ToMilliseconds(SavedTime - LoadedTime) << "ms): "
+            << Level.Models.size() << " models, " << Level.Meshes.size() << " meshes, " << Level.Brushes.size() << " brushes, " << Level.PointLights.size() << " lights";
+        Engine::DEBUGPrint(Report.str());
+
+        return true;
+    }
+}
+
+void Initialize(ArgsList args)
+{
+    std::vector<std::string> Files;
+    bool FormatGiven = false;
+    LevelFormat Format = LevelFormat::Binary;
+
+    for (const std::string& Arg : StringUtils::Split(args, " "))
+    {
+        if (Arg == "-json")
+        {
+            Format = LevelFormat::Json;
+            FormatGiven = true;
+        }
+        else if (Arg == "-binary")
+        {
+            Format = LevelFormat::Binary;
+            FormatGiven = true;
+        }
+        else if (!Arg.empty())
+        {
+            Files.push_back(Arg);
+        }
+    }
+
+    if (Files.size() != 2)
+    {
+        Engine::DEBUGPrint("Usage: LevelConverter <input> <output> [-json | -binary]");
+        Engine::StopGame();
+        return;
+    }
+
+    // Saving truncates the output while the input is still mapped, so they can't be the same file
+    std::error_code Error;
+    if (std::filesystem::equivalent(Files[0], Files[1], Error))
+    {
+        Engine::DEBUGPrint("Input and output are the same file, convert to a new file instead");
+        Engine::StopGame();
+        return;
+    }
+
+    if (!FormatGiven)
+    {
+        Format = LevelFile::IsBinary(Files[0]) ? LevelFormat::Json : LevelFormat::Binary;
+    }
+
+    Convert(Files[0], Files[1], Format);
+
+    Engine::StopGame();
+}
+
+void Update(double deltaTime)
+{
+}
+
+void Resize(Vec2i newSize)
+{
+}
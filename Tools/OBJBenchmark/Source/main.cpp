@@ -0,0 +1,127 @@
+#include "GameEngine.h"
+
+#include "FileLoader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+// Loads every OBJ file in a directory a few times over and reports how fast they parse.
+// Run from the repository root: OBJBenchmark [directory] [-iterations N]
+
+#define OBJ_BENCHMARK_DEFAULT_DIRECTORY "Assets/models"
+#define OBJ_BENCHMARK_DEFAULT_ITERATIONS 10
+
+namespace
+{
+    double Median(std::vector<double> Values)
+    {
+        if (Values.empty())
+        {
+            return 0.0;
+        }
+
+        std::sort(Values.begin(), Values.end());
+        return Values[Values.size() / 2];
+    }
+
+    double MegabytesPerSecond(size_t Bytes, double Milliseconds)
+    {
+        return Milliseconds > 0.0 ? (Bytes / (1024.0 * 1024.0)) / (Milliseconds / 1000.0) : 0.0;
+    }
+}
+
+void Initialize(ArgsList args)
+{
+    std::string Directory = OBJ_BENCHMARK_DEFAULT_DIRECTORY;
+    int Iterations = OBJ_BENCHMARK_DEFAULT_ITERATIONS;
+
+    std::vector<std::string> Args = StringUtils::Split(args, " ");
+    for (size_t i = 0; i < Args.size(); ++i)
+    {
+        if (Args[i] == "-iterations" && i + 1 < Args.size())
+        {
+            Iterations = std::max(atoi(Args[++i].c_str()), 1);
+        }
+        else if (!Args[i].empty())
+        {
+            Directory = Args[i];
+        }
+    }
+
+    // directory_iterator doesn't promise any order
+    std::vector<std::string> Files;
+    std::error_code Error;
+    for (const auto& Entry : std::filesystem::directory_iterator(Directory, Error))
+    {
+        if (Entry.is_regular_file() && Entry.path().extension() == ".obj")
+        {
+            Files.push_back(Entry.path().generic_string());
+        }
+    }
+    std::sort(Files.begin(), Files.end());
+
+    if (Files.empty())
+    {
+        Engine::DEBUGPrint("No .obj files found in " + Directory);
+        Engine::StopGame();
+        return;
+    }
+
+    std::ostringstream Report;
+    Report << std::fixed << std::setprecision(2);
+    Report << "Median of " << Iterations << " loads per file (parse / optimize ms, parse MB/s)\n";
+
+    size_t TotalBytes = 0;
+    double TotalParse = 0.0;
+    double TotalOptimize = 0.0;
+
+    std::vector<float> Vertices;
+    std::vector<ElementIndex> Indices;
+    for (const std::string& File : Files)
+    {
+        std::vector<double> ParseTimes;
+        std::vector<double> OptimizeTimes;
+        OBJLoadStats Stats;
+        for (int i = 0; i < Iterations; ++i)
+        {
+            if (!FileLoader::LoadOBJData(File, Vertices, Indices, &Stats))
+            {
+                break;
+            }
+            ParseTimes.push_back(Stats.ParseMilliseconds);
+            OptimizeTimes.push_back(Stats.OptimizeMilliseconds);
+        }
+
+        if (ParseTimes.empty())
+        {
+            Report << File << ": couldn't open\n";
+            continue;
+        }
+
+        double Parse = Median(ParseTimes);
+        double Optimize = Median(OptimizeTimes);
+
+        Report << File << ": " << Stats.FileSize / 1024.0 << " KB, " << Stats.VertexCount << " vertices, " << Stats.TriangleCount << " triangles, "
+            << Parse << " / " << Optimize << " ms, " << MegabytesPerSecond(Stats.FileSize, Parse) << " MB/s\n";
+
+        TotalBytes += Stats.FileSize;
+        TotalParse += Parse;
+        TotalOptimize += Optimize;
+    }
+
+    Report << "Total: " << TotalBytes / 1024.0 << " KB, " << TotalParse << " / " << TotalOptimize << " ms, "
+        << MegabytesPerSecond(TotalBytes, TotalParse) << " MB/s";
+    Engine::DEBUGPrint(Report.str());
+
+    Engine::StopGame();
+}
+
+void Update(double deltaTime)
+{
+}
+
+void Resize(Vec2i newSize)
+{
+}
@@ -1,5 +1,5 @@
 #pragma once
-#include "Behaviour\Behaviour.h"
+#include "Behaviour/Behaviour.h"
 class RCCar :
     public Behaviour
 {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Behaviour\Behaviour.h"
+#include "Behaviour/Behaviour.h"
 
 class SphereController :
     public Behaviour
@@ -108,7 +108,7 @@ Texture vertexToolTexture;
 Texture sculptToolTexture;
 Texture lightToolTexture;
 
-Material tempWhiteMaterial;
+MaterialHandle tempWhiteMaterial;
 
 Texture gridTexture;
 Model gridModel;
@@ -128,7 +128,7 @@ bool cursorLocked = false;
 
 bool gridEnabled = true;
 
-std::vector<Material> loadedMaterials;
+std::vector<MaterialHandle> loadedMaterials;
 std::vector<Model> loadedModels;
 
 std::vector<Framebuffer_ID> modelFBuffers;
@@ -141,7 +141,7 @@ bool draggingNewModel = false;
 Model* draggingModel = nullptr;
 
 bool draggingNewTexture = false;
-Material draggingMaterial;
+MaterialHandle draggingMaterial;
 
 bool draggingNewBehaviour = false;
 std::string draggingBehaviourName;
@@ -439,11 +439,11 @@ std::vector<Model> LoadModels(GraphicsModule& graphics)
     return loadedModels;
 }
 
-std::vector<Material> LoadMaterials(GraphicsModule& graphics)
+std::vector<MaterialHandle> LoadMaterials(GraphicsModule& graphics)
 {
     AssetRegistry* Registry = AssetRegistry::Get();
 
-    std::vector<Material> loadedMaterials;
+    std::vector<MaterialHandle> loadedMaterials;
 
     std::string path = "textures";
 
@@ -1839,7 +1839,8 @@ void UpdateEditor(double deltaTime)
     ui.StartTab("Textures");
     for (int i = 0; i < loadedMaterials.size(); ++i)
     {
-        if (ui.ImgButton(loadedMaterials[i].m_Albedo.Path.GetFileName(), loadedMaterials[i].m_Albedo, Vec2f(40, 80), 2.5f, Black).clicking)
+        const Material& loadedMaterial = graphics.GetMaterial(loadedMaterials[i]);
+        if (ui.ImgButton(loadedMaterial.m_Albedo.Path.GetFileName(), loadedMaterial.m_Albedo, Vec2f(40, 80), 2.5f, Black).clicking)
         {
             if (!draggingNewTexture)
             {
@@ -1949,7 +1950,7 @@ void UpdateEditor(double deltaTime)
 
     if (draggingNewTexture)
     {
-        ui.ImgPanel(draggingMaterial.m_Albedo, Rect(Engine::GetMousePosition(), Vec2f(80.0f, 80.0f)));
+        ui.ImgPanel(graphics.GetMaterial(draggingMaterial).m_Albedo, Rect(Engine::GetMousePosition(), Vec2f(80.0f, 80.0f)));
     }
 
     if (draggingNewBehaviour)